@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/async_writer.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::AsyncWriter class header.
+
+#ifndef BE_BED_ASYNC_WRITER_H_
+#define BE_BED_ASYNC_WRITER_H_
+
+#include "be/bed/db.h"
+#include "be/bed/db_options.h"
+#include "be/bed/stmt_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The default maximum number of jobs which an AsyncWriter will
+///         commit in a single transaction.
+#define BE_BED_ASYNC_WRITER_DEFAULT_MAX_BATCH_SIZE 256
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The number of times an AsyncWriter will retry a transaction which
+///         fails because the database is busy before giving up.
+#define BE_BED_ASYNC_WRITER_MAX_RETRIES 10
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  AsyncWriter   be/bed/async_writer.h "be/bed/async_writer.h"
+///
+/// \brief  Executes database write jobs on a background thread.
+/// \details An AsyncWriter owns a writable connection to a database file and
+///         a thread which is the only user of that connection.  Jobs are
+///         function objects which receive the connection and a StmtCache
+///         for it; they are submitted from any thread using submit(), which
+///         returns immediately with a std::future that becomes ready once
+///         the job's changes have been committed (or have failed).
+///
+///         Submitted jobs are pushed onto a lock-free list.  Whenever the
+///         writer thread wakes up, it takes every pending job and runs up to
+///         the maximum batch size of them, in submission order, inside one
+///         IMMEDIATE transaction (group commit).  Each job runs inside its
+///         own savepoint, so a job which throws only rolls back its own
+///         changes; its future receives the exception and the rest of the
+///         batch is still committed.
+///
+///         If the transaction cannot be started or committed because another
+///         connection has the database locked (SQLITE_BUSY or SQLITE_LOCKED),
+///         the whole batch is rolled back and retried with exponential
+///         backoff, up to #BE_BED_ASYNC_WRITER_MAX_RETRIES times.  Jobs may
+///         therefore run more than once, and should not have side effects
+///         outside the database.
+///
+///         The writer keeps statistics on the number of queued jobs and on
+///         commit latency (the time from when the oldest job in a batch was
+///         submitted until the batch was committed) which can be used to
+///         confirm that writes are keeping up.
+///
+///         When the AsyncWriter is destroyed, all pending jobs are committed
+///         before its thread exits.  Changes are not visible to other
+///         connections until they are committed; use flush() to wait for
+///         all previously submitted jobs.
+/// \ingroup db
+class AsyncWriter
+{
+public:
+   typedef std::function<void(Db&, StmtCache&)> Job;   ///< The type of write jobs.
+
+   explicit AsyncWriter(const std::string& path);
+   AsyncWriter(const std::string& path, const DbOptions& options);
+   ~AsyncWriter();
+
+   std::future<void> submit(const Job& job);
+   void flush();
+
+   void setMaxBatchSize(size_t max_batch_size);
+   size_t getMaxBatchSize() const;
+
+   size_t getQueueDepth() const;
+   size_t getMaxQueueDepth() const;
+   size_t getJobs() const;
+   size_t getFailures() const;
+   size_t getCommits() const;
+   size_t getRetries() const;
+   std::chrono::microseconds getLastLatency() const;
+   std::chrono::microseconds getMaxLatency() const;
+   void resetStats();
+
+private:
+   struct Node;
+
+   void run_();
+   void take_(std::vector<Node*>& pending);
+   void commit_(Node** batch, size_t size);
+
+   Db db_;
+   StmtCache stmt_cache_;
+
+   std::atomic<Node*> head_;   ///< Most recently submitted job; jobs are linked from newest to oldest.
+
+   std::mutex mutex_;          ///< Only used to sleep/wake the writer thread.
+   std::condition_variable wake_;
+   bool stopping_;
+
+   std::atomic<size_t> max_batch_size_;
+
+   std::atomic<size_t> queue_depth_;
+   std::atomic<size_t> max_queue_depth_;
+   std::atomic<size_t> jobs_;
+   std::atomic<size_t> failures_;
+   std::atomic<size_t> commits_;
+   std::atomic<size_t> retries_;
+   std::atomic<long long> last_latency_;   ///< In microseconds.
+   std::atomic<long long> max_latency_;    ///< In microseconds.
+
+   std::thread thread_;
+
+   AsyncWriter(const AsyncWriter&);
+   void operator=(const AsyncWriter&);
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/blob_reader.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::BlobReader class header.
+
+#ifndef BE_BED_BLOB_READER_H_
+#define BE_BED_BLOB_READER_H_
+#include "be/_be.h"
+
+#include "sqlite3.h"
+
+#include "be/bed/db.h"
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  BlobReader   be/bed/blob_reader.h "be/bed/blob_reader.h"
+///
+/// \brief  RAII wrapper for SQLite's incremental blob I/O API which allows a
+///         blob to be read in chunks.
+/// \details Unlike Stmt::getBlob() or Stmt::getBlobView(), the blob is never
+///         loaded into memory all at once, so large assets can be fed
+///         directly to a decoder while only the decoder's working set and
+///         one chunk are resident.
+///
+///         BlobReader objects are non-copyable and must be destroyed before
+///         the Db they were opened on.  If the row is modified or deleted
+///         while the reader is open, further reads will throw.
+/// \ingroup db
+class BlobReader
+{
+public:
+   BlobReader(Db& db, const char* table, const char* column, sqlite3_int64 rowid);
+   ~BlobReader();
+
+   void reopen(sqlite3_int64 rowid);
+
+   int size() const;
+   int tell() const;
+   bool eof() const;
+
+   int read(void* dest, int bytes);
+   int skip(int bytes);
+   void seek(int offset);
+
+private:
+   Db& db_;
+   sqlite3_blob* blob_;
+   int size_;
+   int offset_;
+
+   BlobReader(const BlobReader&);
+   void operator=(const BlobReader&);
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
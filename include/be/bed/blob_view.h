@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/blob_view.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::BlobView class header.
+
+#ifndef BE_BED_BLOB_VIEW_H_
+#define BE_BED_BLOB_VIEW_H_
+#include "be/_be.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace be {
+namespace bed {
+
+class Stmt;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  BlobView   be/bed/blob_view.h "be/bed/blob_view.h"
+///
+/// \brief  Non-owning view of a blob column in a Stmt's current row.
+/// \details BlobViews are returned by Stmt::getBlobView() and refer directly
+///         to the memory owned by SQLite, so no copy is made.  That memory is
+///         only valid until the statement is stepped, reset, or destroyed.
+///         A BlobView remembers which row it was created from, and holds a
+///         weak reference to the statement's row counter, so it can detect
+///         both a statement which has moved to a different row and one which
+///         has been destroyed.  Accessing the data in either case is a
+///         programming error which results in an assertion failure.
+///
+///         Use Stmt::getBlob(int) if a copy of the data is required, or
+///         BlobReader if the blob is too large to comfortably load all at
+///         once.
+/// \ingroup db
+class BlobView
+{
+   friend class Stmt;
+public:
+   BlobView();
+
+   const void* data() const;
+   size_t size() const;
+   bool empty() const;
+
+   bool valid() const;
+
+private:
+   BlobView(const Stmt& stmt, const void* data, size_t size);
+
+   std::weak_ptr<const unsigned int> stmt_row_;   ///< Expires when the statement is destroyed.
+   unsigned int row_;
+   bool from_stmt_;
+   const void* data_;
+   size_t size_;
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
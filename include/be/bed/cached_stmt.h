@@ -9,6 +9,7 @@
 
 #include "be/bed/stmt.h"
 
+#include <chrono>
 #include <ostream>
 
 namespace be {
@@ -16,6 +17,12 @@ namespace bed {
 
 class StmtCache;
 
+namespace detail {
+
+struct StmtCacheEntry;
+
+} // namespace be::bed::detail
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \class  CachedStmt   be/bed/cached_stmt.h "be/bed/cached_stmt.h"
 ///
@@ -66,6 +73,15 @@ public:
    void bindBlob_s(int parameter, const void* value, int length);
    void bindColor(int parameter, const glm::vec4& color);
 
+   template <typename T>
+   void bindRow(const T& row);
+
+   template <typename Iterator>
+   int executeMany(Iterator begin, Iterator end);
+
+   template <typename Iterator, typename Binder>
+   int executeMany(Iterator begin, Iterator end, Binder binder);
+
    bool step();
    void reset();
 
@@ -83,13 +99,22 @@ public:
    const char* getText(int column);
    std::string getBlob(int column);
    int getBlob(int column, const void*& dest);
+   BlobView getBlobView(int column);
    glm::vec4 getColor(int column);
 
+   template <typename T>
+   T get(int column);
+
+   template <typename T>
+   Rows<T> rows();
+
 private:
-   CachedStmt(StmtCache* cache, Stmt& stmt);
+   CachedStmt(StmtCache* cache, detail::StmtCacheEntry& entry);
 
    StmtCache* cache_;
+   detail::StmtCacheEntry& entry_;
    Stmt& stmt_;
+   std::chrono::high_resolution_clock::time_point held_;   ///< Only set if the query profiler is enabled.
 
    CachedStmt(const CachedStmt&);
    void operator=(const CachedStmt&);
@@ -100,4 +125,6 @@ std::ostream& operator<<(std::ostream& os, const CachedStmt& s);
 } // namespace be::bed
 } // namespace be
 
+#include "be/bed/cached_stmt.inl"
+
 #endif
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/cached_stmt.inl
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::CachedStmt template functions.
+
+#if !defined(BE_BED_CACHED_STMT_H_) && !defined(DOXYGEN)
+#include "be/bed/cached_stmt.h"
+#elif !defined(BE_BED_CACHED_STMT_INL_)
+#define BE_BED_CACHED_STMT_INL_
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \copydoc   Stmt::bindRow(const T&)
+template <typename T>
+void CachedStmt::bindRow(const T& row)
+{
+   stmt_.bindRow(row);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \copydoc   Stmt::executeMany(Iterator, Iterator)
+template <typename Iterator>
+int CachedStmt::executeMany(Iterator begin, Iterator end)
+{
+   return stmt_.executeMany(begin, end);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \copydoc   Stmt::executeMany(Iterator, Iterator, Binder)
+template <typename Iterator, typename Binder>
+int CachedStmt::executeMany(Iterator begin, Iterator end, Binder binder)
+{
+   return stmt_.executeMany(begin, end, binder);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \copydoc   Stmt::get(int)
+template <typename T>
+T CachedStmt::get(int column)
+{
+   return stmt_.get<T>(column);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \copydoc   Stmt::rows()
+template <typename T>
+Rows<T> CachedStmt::rows()
+{
+   return stmt_.rows<T>();
+}
+
+} // namespace be::bed
+} // namespace be
+
+#endif
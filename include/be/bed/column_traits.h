@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/column_traits.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::ColumnTraits template and specializations.
+
+#ifndef BE_BED_COLUMN_TRAITS_H_
+#define BE_BED_COLUMN_TRAITS_H_
+
+#include "be/bed/stmt.h"
+
+#include <glm/glm.hpp>
+
+#include <tuple>
+#include <utility>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \struct ColumnTraits   be/bed/column_traits.h "be/bed/column_traits.h"
+///
+/// \brief  Describes how a value of type T is read from a Stmt's current row.
+/// \details Each specialization provides a \c columns constant, the number of
+///         consecutive result columns used by the type, and a static
+///         <tt>T get(Stmt& stmt, int column)</tt> function which reads the
+///         value starting at the specified column.
+///
+///         Specializations are provided for the fundamental types returned by
+///         Stmt's getters, Id, glm::vec2, glm::ivec2, std::pair, and
+///         std::tuple (up to 5 elements) of any of those types.  Other types
+///         (usually plain structs which represent an entire row) can be read
+///         with Stmt::get() and Stmt::rows() by specializing ColumnTraits in
+///         the be::bed namespace.
+///
+///         None of the provided specializations allocate memory.
+///
+/// \sa     Stmt::get()
+/// \sa     Stmt::rows()
+/// \ingroup db
+template <typename T>
+struct ColumnTraits;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as a bool.
+/// \sa     Stmt::getBool()
+template <>
+struct ColumnTraits<bool>
+{
+   static const int columns = 1;
+   static bool get(Stmt& stmt, int column) { return stmt.getBool(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as an int.
+/// \sa     Stmt::getInt()
+template <>
+struct ColumnTraits<int>
+{
+   static const int columns = 1;
+   static int get(Stmt& stmt, int column) { return stmt.getInt(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as an unsigned int.
+/// \sa     Stmt::getUInt()
+template <>
+struct ColumnTraits<unsigned int>
+{
+   static const int columns = 1;
+   static unsigned int get(Stmt& stmt, int column) { return stmt.getUInt(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as a 64-bit integer.
+/// \sa     Stmt::getInt64()
+template <>
+struct ColumnTraits<sqlite3_int64>
+{
+   static const int columns = 1;
+   static sqlite3_int64 get(Stmt& stmt, int column) { return stmt.getInt64(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as an unsigned 64-bit integer.
+/// \sa     Stmt::getUInt64()
+template <>
+struct ColumnTraits<sqlite3_uint64>
+{
+   static const int columns = 1;
+   static sqlite3_uint64 get(Stmt& stmt, int column) { return stmt.getUInt64(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as a float.
+/// \sa     Stmt::getDouble()
+template <>
+struct ColumnTraits<float>
+{
+   static const int columns = 1;
+   static float get(Stmt& stmt, int column) { return float(stmt.getDouble(column)); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as a double.
+/// \sa     Stmt::getDouble()
+template <>
+struct ColumnTraits<double>
+{
+   static const int columns = 1;
+   static double get(Stmt& stmt, int column) { return stmt.getDouble(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single column as a text string.
+/// \details The pointer returned is only valid until the statement is stepped,
+///         reset, or destroyed.
+/// \sa     Stmt::getText()
+template <>
+struct ColumnTraits<const char*>
+{
+   static const int columns = 1;
+   static const char* get(Stmt& stmt, int column) { return stmt.getText(column); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a single integer column as an Id.
+/// \sa     Stmt::getUInt64()
+template <>
+struct ColumnTraits<Id>
+{
+   static const int columns = 1;
+   static Id get(Stmt& stmt, int column) { return Id(stmt.getUInt64(column)); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads two consecutive real columns as a glm::vec2.
+template <>
+struct ColumnTraits<glm::vec2>
+{
+   static const int columns = 2;
+   static glm::vec2 get(Stmt& stmt, int column)
+   {
+      return glm::vec2(float(stmt.getDouble(column)), float(stmt.getDouble(column + 1)));
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads two consecutive integer columns as a glm::ivec2.
+template <>
+struct ColumnTraits<glm::ivec2>
+{
+   static const int columns = 2;
+   static glm::ivec2 get(Stmt& stmt, int column)
+   {
+      return glm::ivec2(stmt.getInt(column), stmt.getInt(column + 1));
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads consecutive columns as a std::pair.
+template <typename A, typename B>
+struct ColumnTraits<std::pair<A, B> >
+{
+   static const int columns = ColumnTraits<A>::columns + ColumnTraits<B>::columns;
+   static std::pair<A, B> get(Stmt& stmt, int column)
+   {
+      return std::pair<A, B>(ColumnTraits<A>::get(stmt, column),
+                             ColumnTraits<B>::get(stmt, column + ColumnTraits<A>::columns));
+   }
+};
+
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads elements I through N-1 of a std::tuple from consecutive
+///         columns.
+template <typename Tuple, size_t I, size_t N>
+struct TupleColumns
+{
+   typedef typename std::tuple_element<I, Tuple>::type element_type;
+
+   static const int columns = ColumnTraits<element_type>::columns + TupleColumns<Tuple, I + 1, N>::columns;
+
+   static void get(Stmt& stmt, int column, Tuple& dest)
+   {
+      std::get<I>(dest) = ColumnTraits<element_type>::get(stmt, column);
+      TupleColumns<Tuple, I + 1, N>::get(stmt, column + ColumnTraits<element_type>::columns, dest);
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Terminates TupleColumns recursion.
+template <typename Tuple, size_t N>
+struct TupleColumns<Tuple, N, N>
+{
+   static const int columns = 0;
+   static void get(Stmt&, int, Tuple&) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  ColumnTraits implementation shared by all std::tuple
+///         specializations.
+template <typename Tuple>
+struct TupleColumnTraits
+{
+   typedef TupleColumns<Tuple, 0, std::tuple_size<Tuple>::value> elements;
+
+   static const int columns = elements::columns;
+   static Tuple get(Stmt& stmt, int column)
+   {
+      Tuple value;
+      elements::get(stmt, column, value);
+      return value;
+   }
+};
+
+} // namespace be::bed::detail
+
+// VC11 does not support variadic templates, and std::tuple supports at most
+// 5 elements by default, so each arity is specialized separately.
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads consecutive columns as a std::tuple.
+template <typename A>
+struct ColumnTraits<std::tuple<A> >
+   : detail::TupleColumnTraits<std::tuple<A> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads consecutive columns as a std::tuple.
+template <typename A, typename B>
+struct ColumnTraits<std::tuple<A, B> >
+   : detail::TupleColumnTraits<std::tuple<A, B> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads consecutive columns as a std::tuple.
+template <typename A, typename B, typename C>
+struct ColumnTraits<std::tuple<A, B, C> >
+   : detail::TupleColumnTraits<std::tuple<A, B, C> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads consecutive columns as a std::tuple.
+template <typename A, typename B, typename C, typename D>
+struct ColumnTraits<std::tuple<A, B, C, D> >
+   : detail::TupleColumnTraits<std::tuple<A, B, C, D> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads consecutive columns as a std::tuple.
+template <typename A, typename B, typename C, typename D, typename E>
+struct ColumnTraits<std::tuple<A, B, C, D, E> >
+   : detail::TupleColumnTraits<std::tuple<A, B, C, D, E> > { };
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/connection_pool.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::ConnectionPool class header.
+
+#ifndef BE_BED_CONNECTION_POOL_H_
+#define BE_BED_CONNECTION_POOL_H_
+
+#include "be/bed/detail/connection_pool_entry.h"
+#include "be/bed/pooled_db.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  ConnectionPool   be/bed/connection_pool.h "be/bed/connection_pool.h"
+///
+/// \brief  Maintains a set of connections to a single database file which can
+///         be checked out by worker threads.
+/// \details A single Db object can only be used by one thread at a time, so
+///         all queries made through it are serialized.  A ConnectionPool
+///         allows up to capacity threads to query the same database file at
+///         once, each using its own connection and StmtCache.
+///
+///         By default, connections are opened with
+///         <tt>SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX</tt>.  Since a
+///         connection is only ever used by the thread which has checked it
+///         out, SQLite's per-connection mutex is unnecessary.
+///
+///         Connections are opened lazily the first time acquire() is called
+///         while all existing connections are held, so an unused pool costs
+///         nothing.  Once opened, connections remain open (along with their
+///         compiled statements) until the pool is destroyed.  Released
+///         connections are reused most-recently-released first so that their
+///         statement caches stay warm.
+///
+///         If all connections are held and the pool is at capacity,
+///         acquire() blocks until a connection is released.
+///
+///         DbOptions can be applied to each connection as it is opened using
+///         setOptions().
+///
+///         Read-only connections do not see changes made by another
+///         connection until they have been committed.
+/// \ingroup db
+class ConnectionPool
+{
+   friend class PooledDb;
+public:
+   ConnectionPool(const std::string& path, size_t capacity);
+   ConnectionPool(const std::string& path, size_t capacity, int flags);
+   ConnectionPool(const std::string& path, size_t capacity, int flags, const std::string& vfs_name);
+   ~ConnectionPool();
+
+   const std::string& getPath() const;
+   const std::string& getVfsName() const;
+   size_t getCapacity() const;
+
+   void setOptions(const DbOptions& options);
+   DbOptions getOptions();
+
+   size_t getSize();
+   size_t getHeldSize();
+
+   PooledDb acquire();
+
+private:
+   void release_(detail::ConnectionPoolEntry& entry);
+
+   std::mutex mutex_;
+   std::condition_variable released_;
+
+   std::string path_;
+   int flags_;
+   std::string vfs_name_;
+   DbOptions options_;
+   size_t capacity_;
+   size_t size_;        ///< The number of connections open or being opened.
+   size_t held_size_;
+
+   std::vector<std::unique_ptr<detail::ConnectionPoolEntry> > entries_;
+   std::vector<detail::ConnectionPoolEntry*> free_;   ///< Unheld entries; the most recently released is at the back.
+
+   ConnectionPool(const ConnectionPool&);
+   void operator=(const ConnectionPool&);
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -9,6 +9,7 @@
 #include "be/_be.h"
 
 #include <string>
+#include <vector>
 #include "sqlite3.h"
 
 #include "be/bed/detail/db_error.h"
@@ -18,6 +19,7 @@ namespace be {
 namespace bed {
 
 class Stmt;
+class BlobReader;
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \class  Db   be/bed/db.h "be/bed/db.h"
@@ -29,6 +31,7 @@ class Stmt;
 class Db
 {
    friend class Stmt;
+   friend class BlobReader;
 public:
    typedef detail::db_error error; ///< Exception type thrown when an SQLite function fails.  If related to a SQL query, it can be retrieved using Db::error::sql().
 
@@ -43,11 +46,22 @@ public:
    void rollback();
 
    void vacuum();
+   void backup(Db& destination);
+
+   sqlite3_int64 getCacheUsed();
 
    void exec(const std::string& sql);
 
    int getInt(const std::string& sql, int default_value);
 
+   std::vector<std::string> getQueryPlan(const std::string& sql);
+
+   template <typename Iterator>
+   int executeMany(const std::string& sql, Iterator begin, Iterator end);
+
+   template <typename Iterator, typename Binder>
+   int executeMany(const std::string& sql, Iterator begin, Iterator end, Binder binder);
+
 private:
    sqlite3* db_;
 
@@ -58,4 +72,7 @@ private:
 } // namespace be::bed
 } // namespace be
 
+// Db::executeMany() is implemented in stmt.inl, since it requires Stmt.
+#include "be/bed/stmt.h"
+
 #endif
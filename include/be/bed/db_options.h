@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/db_options.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::DbOptions class header.
+
+#ifndef BE_BED_DB_OPTIONS_H_
+#define BE_BED_DB_OPTIONS_H_
+#include "be/_be.h"
+
+#include <string>
+
+namespace be {
+namespace bed {
+
+class Db;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  DbOptions   be/bed/db_options.h "be/bed/db_options.h"
+///
+/// \brief  A set of SQLite tuning PRAGMAs which can be applied to a
+///         connection after it is opened.
+/// \details Each option holds the value to assign to the PRAGMA of the same
+///         name.  Options which are empty are not applied, so the
+///         connection keeps SQLite's default (or whatever the database file
+///         has persisted, in the case of journal_mode).
+///
+///         Values may come from untrusted sources (sandwich properties), so
+///         set() and apply() only accept values made up of letters, digits,
+///         underscores and an optional leading minus sign.
+///
+///         See SQLite's [PRAGMA](http://www.sqlite.org/pragma.html) page for
+///         the meaning of each option.
+/// \ingroup db
+struct DbOptions
+{
+   std::string locking_mode;
+   std::string journal_mode;
+   std::string synchronous;
+   std::string cache_size;
+   std::string mmap_size;
+
+   static DbOptions readOnly();
+   static DbOptions writable();
+
+   bool set(const std::string& pragma, const std::string& value);
+
+   void apply(Db& db) const;
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
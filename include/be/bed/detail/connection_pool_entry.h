@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/connection_pool_entry.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::detail::ConnectionPoolEntry class header.
+
+#ifndef BE_BED_DETAIL_CONNECTION_POOL_ENTRY_H_
+#define BE_BED_DETAIL_CONNECTION_POOL_ENTRY_H_
+
+#include "be/bed/db.h"
+#include "be/bed/db_options.h"
+#include "be/bed/stmt_cache.h"
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  ConnectionPoolEntry   be/bed/detail/connection_pool_entry.h "be/bed/detail/connection_pool_entry.h"
+///
+/// \brief  Used by ConnectionPool to hold one database connection along with
+///         the statement cache used with it.
+/// \details The statement cache is declared after the connection so that it
+///         is always destroyed first.
+struct ConnectionPoolEntry
+{
+   ConnectionPoolEntry(const std::string& path, int flags, const std::string& vfs_name, const DbOptions& options);
+
+   bool held;
+   Db db;
+   StmtCache stmt_cache;
+
+private:
+   ConnectionPoolEntry(const ConnectionPoolEntry&);
+   void operator=(const ConnectionPoolEntry&);
+};
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -29,10 +29,15 @@ public:
    explicit db_error(const std::string& what_arg, const std::string& sql);
    explicit db_error(const char* what_arg, const char* sql);
 
+   explicit db_error(const std::string& what_arg, int code);
+   explicit db_error(const std::string& what_arg, const std::string& sql, int code);
+
    const std::string& sql() const;
+   int code() const;
 
 private:
    std::string sql_;
+   int code_;
 };
 
 } // namespace be::bed::detail
@@ -0,0 +1,31 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/pack_entry.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::detail::PackEntry struct header.
+
+#ifndef BE_BED_DETAIL_PACK_ENTRY_H_
+#define BE_BED_DETAIL_PACK_ENTRY_H_
+
+#include "sqlite3.h"
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \struct PackEntry   be/bed/detail/pack_entry.h "be/bed/detail/pack_entry.h"
+///
+/// \brief  Used by PackVfs to locate one database image within a memory
+///         mapped pack file.
+struct PackEntry
+{
+   const char* data;    ///< The first byte of the image.
+   sqlite3_int64 size;  ///< The size of the image in bytes.
+};
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
+
+#endif
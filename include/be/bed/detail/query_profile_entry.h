@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/query_profile_entry.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::detail::QueryProfileEntry class header.
+
+#ifndef BE_BED_DETAIL_QUERY_PROFILE_ENTRY_H_
+#define BE_BED_DETAIL_QUERY_PROFILE_ENTRY_H_
+
+#include "be/id.h"
+
+#include <atomic>
+#include <string>
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  QueryProfileEntry   be/bed/detail/query_profile_entry.h "be/bed/detail/query_profile_entry.h"
+///
+/// \brief  Used by the query profiler to accumulate statistics for all
+///         statements with a particular Id.
+/// \details Entries are never destroyed once created (resetting the profiler
+///         only zeroes their counters) so Stmt objects can keep a pointer to
+///         their entry.  Times are stored in nanoseconds.
+struct QueryProfileEntry
+{
+   QueryProfileEntry(const Id& id, const char* sql);
+
+   void reset();
+
+   const Id id;
+   const std::string sql;
+
+   std::atomic<long long> compiles;
+   std::atomic<long long> compile_ns;
+   std::atomic<long long> steps;
+   std::atomic<long long> rows;
+   std::atomic<long long> blob_bytes;
+   std::atomic<long long> step_ns;
+   std::atomic<long long> holds;
+   std::atomic<long long> held_ns;
+
+private:
+   QueryProfileEntry(const QueryProfileEntry&);
+   void operator=(const QueryProfileEntry&);
+};
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -19,20 +19,28 @@ namespace detail {
 /// \class  StmtCacheEntry   be/bed/detail/stmt_cache_entry.h "be/bed/detail/stmt_cache_entry.h"
 ///
 /// \brief  Used by StmtCache to keep track of which statements are currently
-///         held or unheld, and how recently each statement was held.
+///         held or unheld, and how recently each statement was released.
+/// \details Entries are intrusive list nodes.  Every entry is linked into
+///         the cache's entry list using prev_entry and next_entry.  An unheld
+///         entry which is not in a thread's front cache is also linked into
+///         the cache's LRU list using prev and next, and into the free list
+///         for its Id using prev_free and next_free.  This allows an entry to
+///         be held, released, or evicted without searching the cache.
 struct StmtCacheEntry
 {
 public:
-   StmtCacheEntry();
-   StmtCacheEntry(Stmt* stmt);
-
-   StmtCacheEntry(StmtCacheEntry&& other);
-   void operator=(StmtCacheEntry&& other);
+   explicit StmtCacheEntry(Stmt* stmt);
 
    bool held;
-   size_t access_index;
    std::unique_ptr<Stmt> stmt;
 
+   StmtCacheEntry* prev;         ///< Previous (more recently released) entry in the LRU list.
+   StmtCacheEntry* next;         ///< Next (less recently released) entry in the LRU list.
+   StmtCacheEntry* prev_free;    ///< Previous unheld entry with the same Id.
+   StmtCacheEntry* next_free;    ///< Next unheld entry with the same Id.
+   StmtCacheEntry* prev_entry;   ///< Previous entry owned by the cache.
+   StmtCacheEntry* next_entry;   ///< Next entry owned by the cache.
+
 private:
    StmtCacheEntry(const StmtCacheEntry&);
    void operator=(const StmtCacheEntry&);
@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/stmt_cache_shard.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::detail::StmtCacheShard class header.
+
+#ifndef BE_BED_DETAIL_STMT_CACHE_SHARD_H_
+#define BE_BED_DETAIL_STMT_CACHE_SHARD_H_
+
+#include "be/bed/detail/stmt_cache_entry.h"
+
+#include <mutex>
+#include <vector>
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  StmtCacheShard   be/bed/detail/stmt_cache_shard.h "be/bed/detail/stmt_cache_shard.h"
+///
+/// \brief  Used by StmtCache to keep a small front cache of unheld
+///         statements for the threads whose ids hash to it.
+/// \details The shard's mutex is only contended when two threads which hash
+///         to the same shard use the cache at once, or when the StmtCache
+///         evicts statements from it.  Entries are ordered from least
+///         recently released (front) to most recently released (back).
+///         Entries in a shard are not linked into the StmtCache's LRU list
+///         or free lists.
+struct StmtCacheShard
+{
+   StmtCacheShard();
+
+   std::mutex mutex;
+   std::vector<StmtCacheEntry*> entries;
+
+private:
+   StmtCacheShard(const StmtCacheShard&);
+   void operator=(const StmtCacheShard&);
+};
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
+
+#endif
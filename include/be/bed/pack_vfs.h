@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/pack_vfs.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::PackVfs class header.
+
+#ifndef BE_BED_PACK_VFS_H_
+#define BE_BED_PACK_VFS_H_
+#include "be/_be.h"
+
+#include "be/bed/detail/pack_entry.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  PackVfs   be/bed/pack_vfs.h "be/bed/pack_vfs.h"
+///
+/// \brief  Read-only SQLite VFS which serves database images out of a single
+///         memory-mapped pack file.
+/// \details A pack file is a directory of named database images followed by
+///         the images themselves, each aligned to a 4 KiB boundary.  Packs
+///         are created with PackVfs::write().
+///
+///         Constructing a PackVfs maps the whole pack into memory and
+///         registers a VFS with SQLite.  Any of the pack's images can then be
+///         opened (read-only) by passing its name and the VFS name to the
+///         Db(path, flags, vfs_name) constructor.  Opening an image never
+///         touches the file system, and when memory-mapped I/O is enabled
+///         (PRAGMA mmap_size) SQLite reads pages directly from the mapping,
+///         so all connections to all of the images in a pack share the same
+///         physical memory.
+///
+///         Temporary files (for instance, those used for large sorts) are
+///         delegated to the default VFS.  Images are immutable, so journals,
+///         write-ahead logs, and locking are not supported.
+///
+///         A PackVfs must outlive every Db opened with it.
+/// \ingroup db
+class PackVfs
+{
+public:
+   PackVfs(const std::string& path, const std::string& vfs_name);
+   ~PackVfs();
+
+   const std::string& getPath() const;
+   const std::string& getVfsName() const;
+   size_t getSize() const;
+
+   std::vector<std::string> getFilenames() const;
+   const detail::PackEntry* find(const std::string& filename) const;
+
+   sqlite3_vfs* getBaseVfs() const;
+
+   static void write(const std::string& path, const std::vector<std::string>& files);
+
+private:
+   void map_();
+   void unmap_();
+   void readDirectory_();
+
+   std::string path_;
+   std::string vfs_name_;
+
+   const char* data_;
+   size_t size_;
+
+   std::unordered_map<std::string, detail::PackEntry> entries_;
+
+   sqlite3_vfs vfs_;
+   sqlite3_vfs* base_;
+
+   PackVfs(const PackVfs&);
+   void operator=(const PackVfs&);
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
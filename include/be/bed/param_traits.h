@@ -0,0 +1,263 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/param_traits.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::ParamTraits template and specializations.
+
+#ifndef BE_BED_PARAM_TRAITS_H_
+#define BE_BED_PARAM_TRAITS_H_
+
+#include "be/bed/stmt.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \struct ParamTraits   be/bed/param_traits.h "be/bed/param_traits.h"
+///
+/// \brief  Describes how a value of type T is bound to a Stmt's parameters.
+/// \details ParamTraits is the counterpart of ColumnTraits.  Each
+///         specialization provides a \c parameters constant, the number of
+///         consecutive parameters used by the type, and a static
+///         <tt>void bind(Stmt& stmt, int parameter, const T& value)</tt>
+///         function which binds the value starting at the specified
+///         parameter.
+///
+///         Specializations are provided for the fundamental types accepted by
+///         Stmt's bind functions, std::string, Id, glm::vec2, glm::ivec2,
+///         std::pair, and std::tuple (up to 5 elements) of any of those
+///         types.  Other types (usually plain structs which represent an
+///         entire row) can be bound with Stmt::bindRow() and
+///         Stmt::executeMany() by specializing ParamTraits in the be::bed
+///         namespace.
+///
+/// \sa     Stmt::bindRow()
+/// \sa     Stmt::executeMany()
+/// \ingroup db
+template <typename T>
+struct ParamTraits;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a bool to a single parameter.
+template <>
+struct ParamTraits<bool>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, bool value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds an int to a single parameter.
+template <>
+struct ParamTraits<int>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, int value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds an unsigned int to a single parameter.
+template <>
+struct ParamTraits<unsigned int>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, unsigned int value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a 64-bit integer to a single parameter.
+template <>
+struct ParamTraits<sqlite3_int64>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, sqlite3_int64 value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds an unsigned 64-bit integer to a single parameter.
+template <>
+struct ParamTraits<sqlite3_uint64>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, sqlite3_uint64 value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a float to a single parameter.
+template <>
+struct ParamTraits<float>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, float value) { stmt.bind(parameter, double(value)); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a double to a single parameter.
+template <>
+struct ParamTraits<double>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, double value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a copy of a null-terminated string to a single parameter.
+/// \details A null pointer is bound as NULL.
+template <>
+struct ParamTraits<const char*>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, const char* value)
+   {
+      if (value)
+         stmt.bind(parameter, value);
+      else
+         stmt.bind(parameter);
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a copy of a string to a single parameter.
+template <>
+struct ParamTraits<std::string>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, const std::string& value) { stmt.bind(parameter, value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds an Id's value to a single integer parameter.
+template <>
+struct ParamTraits<Id>
+{
+   static const int parameters = 1;
+   static void bind(Stmt& stmt, int parameter, const Id& value) { stmt.bind(parameter, static_cast<sqlite3_uint64>(value.value())); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a glm::vec2 to two consecutive real parameters.
+template <>
+struct ParamTraits<glm::vec2>
+{
+   static const int parameters = 2;
+   static void bind(Stmt& stmt, int parameter, const glm::vec2& value)
+   {
+      stmt.bind(parameter, double(value.x));
+      stmt.bind(parameter + 1, double(value.y));
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a glm::ivec2 to two consecutive integer parameters.
+template <>
+struct ParamTraits<glm::ivec2>
+{
+   static const int parameters = 2;
+   static void bind(Stmt& stmt, int parameter, const glm::ivec2& value)
+   {
+      stmt.bind(parameter, value.x);
+      stmt.bind(parameter + 1, value.y);
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a std::pair to consecutive parameters.
+template <typename A, typename B>
+struct ParamTraits<std::pair<A, B> >
+{
+   static const int parameters = ParamTraits<A>::parameters + ParamTraits<B>::parameters;
+   static void bind(Stmt& stmt, int parameter, const std::pair<A, B>& value)
+   {
+      ParamTraits<A>::bind(stmt, parameter, value.first);
+      ParamTraits<B>::bind(stmt, parameter + ParamTraits<A>::parameters, value.second);
+   }
+};
+
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds elements I through N-1 of a std::tuple to consecutive
+///         parameters.
+template <typename Tuple, size_t I, size_t N>
+struct TupleParams
+{
+   typedef typename std::tuple_element<I, Tuple>::type element_type;
+
+   static const int parameters = ParamTraits<element_type>::parameters + TupleParams<Tuple, I + 1, N>::parameters;
+
+   static void bind(Stmt& stmt, int parameter, const Tuple& value)
+   {
+      ParamTraits<element_type>::bind(stmt, parameter, std::get<I>(value));
+      TupleParams<Tuple, I + 1, N>::bind(stmt, parameter + ParamTraits<element_type>::parameters, value);
+   }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Terminates TupleParams recursion.
+template <typename Tuple, size_t N>
+struct TupleParams<Tuple, N, N>
+{
+   static const int parameters = 0;
+   static void bind(Stmt&, int, const Tuple&) { }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  ParamTraits implementation shared by all std::tuple
+///         specializations.
+template <typename Tuple>
+struct TupleParamTraits
+{
+   typedef TupleParams<Tuple, 0, std::tuple_size<Tuple>::value> elements;
+
+   static const int parameters = elements::parameters;
+   static void bind(Stmt& stmt, int parameter, const Tuple& value)
+   {
+      elements::bind(stmt, parameter, value);
+   }
+};
+
+} // namespace be::bed::detail
+
+// VC11 does not support variadic templates, and std::tuple supports at most
+// 5 elements by default, so each arity is specialized separately.
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a std::tuple to consecutive parameters.
+template <typename A>
+struct ParamTraits<std::tuple<A> >
+   : detail::TupleParamTraits<std::tuple<A> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a std::tuple to consecutive parameters.
+template <typename A, typename B>
+struct ParamTraits<std::tuple<A, B> >
+   : detail::TupleParamTraits<std::tuple<A, B> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a std::tuple to consecutive parameters.
+template <typename A, typename B, typename C>
+struct ParamTraits<std::tuple<A, B, C> >
+   : detail::TupleParamTraits<std::tuple<A, B, C> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a std::tuple to consecutive parameters.
+template <typename A, typename B, typename C, typename D>
+struct ParamTraits<std::tuple<A, B, C, D> >
+   : detail::TupleParamTraits<std::tuple<A, B, C, D> > { };
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a std::tuple to consecutive parameters.
+template <typename A, typename B, typename C, typename D, typename E>
+struct ParamTraits<std::tuple<A, B, C, D, E> >
+   : detail::TupleParamTraits<std::tuple<A, B, C, D, E> > { };
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/pooled_db.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::PooledDb class header.
+
+#ifndef BE_BED_POOLED_DB_H_
+#define BE_BED_POOLED_DB_H_
+
+#include "be/bed/cached_stmt.h"
+#include "be/bed/db.h"
+#include "be/bed/stmt_cache.h"
+#include "be/id.h"
+
+#include <string>
+
+namespace be {
+namespace bed {
+
+class ConnectionPool;
+
+namespace detail {
+
+struct ConnectionPoolEntry;
+
+} // namespace be::bed::detail
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  PooledDb   be/bed/pooled_db.h "be/bed/pooled_db.h"
+///
+/// \brief  RAII handle representing a database connection checked out from a
+///         ConnectionPool.
+/// \details PooledDb objects cannot be directly constructed.  Instead, they
+///         are returned from ConnectionPool::acquire().  While the handle
+///         exists, no other thread will be given the same connection, so the
+///         connection and its StmtCache may be used without any additional
+///         synchronization.  When the handle is destroyed, the connection is
+///         returned to the pool.  Any CachedStmts held from the connection's
+///         cache must be destroyed before the PooledDb.
+///
+///         Like CachedStmt, PooledDbs may be move-constructed, but not
+///         move-assigned or default constructed.
+/// \ingroup db
+class PooledDb
+{
+   friend class ConnectionPool;
+public:
+   PooledDb(PooledDb&& other);
+   ~PooledDb();
+
+   Db& getDb();
+   StmtCache& getStmtCache();
+
+   CachedStmt hold(const Id& id, const char* sql);
+
+private:
+   PooledDb(ConnectionPool* pool, detail::ConnectionPoolEntry& entry);
+
+   ConnectionPool* pool_;
+   detail::ConnectionPoolEntry& entry_;
+
+   PooledDb(const PooledDb&);
+   void operator=(const PooledDb&);
+};
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/query_profiler.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed query profiler functions.
+
+#ifndef BE_BED_QUERY_PROFILER_H_
+#define BE_BED_QUERY_PROFILER_H_
+#include "be/_be.h"
+
+#include "be/bed/detail/query_profile_entry.h"
+#include "be/id.h"
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "sqlite3.h"
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \struct QueryProfile   be/bed/query_profiler.h "be/bed/query_profiler.h"
+///
+/// \brief  Statistics collected by the query profiler for all statements
+///         with a particular Id.
+/// \details Step time is the time spent inside Stmt::step().  Held time is
+///         the total time CachedStmt objects with this Id were held,
+///         including time spent by the caller between steps.
+/// \sa     getQueryProfiles()
+/// \ingroup db
+struct QueryProfile
+{
+   Id id;                                       ///< The statement Id.
+   std::string sql;                             ///< The SQL text of the statement.
+   size_t compiles;                             ///< The number of times a statement with this Id was compiled.
+   std::chrono::microseconds compile_time;      ///< The total time spent compiling.
+   size_t steps;                                ///< The number of calls to step().
+   size_t rows;                                 ///< The number of rows returned by step().
+   sqlite3_uint64 blob_bytes;                   ///< The number of bytes of blob data retrieved.
+   std::chrono::microseconds step_time;         ///< The total time spent in step().
+   size_t holds;                                ///< The number of times a CachedStmt with this Id was held.
+   std::chrono::microseconds held_time;         ///< The total time CachedStmts with this Id were held.
+
+   std::chrono::microseconds getTotalTime() const;
+};
+
+void setQueryProfilingEnabled(bool enabled);
+
+std::vector<QueryProfile> getQueryProfiles();
+void resetQueryProfiles();
+void printQueryProfiles(std::ostream& os);
+
+namespace detail {
+
+extern std::atomic<bool> query_profiling_enabled;
+
+QueryProfileEntry& getQueryProfileEntry(const Id& id, const char* sql);
+long long getQueryProfileNanoseconds(std::chrono::high_resolution_clock::duration duration);
+
+} // namespace be::bed::detail
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines whether statements are currently being profiled.
+///
+/// \details This is checked by Stmt and CachedStmt before doing any
+///         profiling work, so when profiling is disabled the only cost is a
+///         relaxed atomic load and a well-predicted branch.
+///
+/// \return \c true if profiling is enabled.
+inline bool isQueryProfilingEnabled()
+{
+   return detail::query_profiling_enabled.load(std::memory_order_relaxed);
+}
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/rows.h
+/// \author Benjamin Crist
+///
+/// \brief  be::bed::Rows class template.
+
+#ifndef BE_BED_ROWS_H_
+#define BE_BED_ROWS_H_
+
+#include "be/bed/column_traits.h"
+
+#include <iterator>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  Rows   be/bed/rows.h "be/bed/rows.h"
+///
+/// \brief  Single-pass range over the result rows of a Stmt, where each row is
+///         decoded into a T using ColumnTraits<T>.
+/// \details Rows objects are returned by Stmt::rows() and are intended to be
+///         used in range-based for loops:
+///
+/// \code
+///    stmt.bind(1, map_id.value());
+///    for (auto& row : stmt.rows<std::tuple<Id, float, glm::vec2> >())
+///    {
+///       ...
+///    }
+/// \endcode
+///
+///         Each row is decoded into a single T owned by the Rows object, so
+///         iterating does not allocate memory (as long as decoding a T does
+///         not allocate).  The reference returned when dereferencing an
+///         iterator is only valid until the iterator is incremented.
+///
+///         Calling begin() steps the statement to its first (or next) row, so
+///         a Rows object can only be iterated once.  T must be default
+///         constructible and assignable.
+/// \ingroup db
+template <typename T>
+class Rows
+{
+public:
+   ////////////////////////////////////////////////////////////////////////////
+   /// \brief  Input iterator over the rows of a Rows object.
+   class iterator : public std::iterator<std::input_iterator_tag, T>
+   {
+   public:
+      iterator();
+      explicit iterator(Rows* rows);
+
+      const T& operator*() const;
+      const T* operator->() const;
+
+      iterator& operator++();
+
+      bool operator==(const iterator& other) const;
+      bool operator!=(const iterator& other) const;
+
+   private:
+      Rows* rows_;
+   };
+
+   explicit Rows(Stmt& stmt);
+
+   iterator begin();
+   iterator end();
+
+private:
+   bool next_();
+
+   Stmt* stmt_;
+   T row_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an end iterator.
+template <typename T>
+Rows<T>::iterator::iterator()
+   : rows_(nullptr)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an iterator referring to the current row of a Rows
+///         object.
+///
+/// \param  rows The Rows object which has decoded the current row.
+template <typename T>
+Rows<T>::iterator::iterator(Rows* rows)
+   : rows_(rows)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the decoded current row.
+///
+/// \return The current row.
+template <typename T>
+const T& Rows<T>::iterator::operator*() const
+{
+   assert(rows_);
+   return rows_->row_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the decoded current row.
+///
+/// \return A pointer to the current row.
+template <typename T>
+const T* Rows<T>::iterator::operator->() const
+{
+   assert(rows_);
+   return &rows_->row_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Steps the statement and decodes the next row.
+///
+/// \details If there are no more rows, the iterator becomes equal to end().
+///
+/// \return *this
+template <typename T>
+typename Rows<T>::iterator& Rows<T>::iterator::operator++()
+{
+   if (rows_ && !rows_->next_())
+      rows_ = nullptr;
+
+   return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compares two iterators.
+///
+/// \param  other The iterator to compare to.
+/// \return \c true if both iterators refer to the same Rows object, or both
+///         are end iterators.
+template <typename T>
+bool Rows<T>::iterator::operator==(const iterator& other) const
+{
+   return rows_ == other.rows_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compares two iterators.
+///
+/// \param  other The iterator to compare to.
+/// \return \c false if both iterators refer to the same Rows object, or both
+///         are end iterators.
+template <typename T>
+bool Rows<T>::iterator::operator!=(const iterator& other) const
+{
+   return rows_ != other.rows_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a range over the rows returned by a statement.
+///
+/// \details The statement is not stepped until begin() is called.  Any
+///         parameters should be bound before calling begin().
+///
+/// \param  stmt The statement whose rows will be decoded.
+template <typename T>
+Rows<T>::Rows(Stmt& stmt)
+   : stmt_(&stmt),
+     row_()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Steps the statement and returns an iterator to the first row.
+///
+/// \return An iterator to the first row, or end() if there are no rows.
+template <typename T>
+typename Rows<T>::iterator Rows<T>::begin()
+{
+   return next_() ? iterator(this) : iterator();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns an iterator which indicates there are no more rows.
+///
+/// \return An end iterator.
+template <typename T>
+typename Rows<T>::iterator Rows<T>::end()
+{
+   return iterator();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to step the statement and decode the new row.
+///
+/// \return \c true if a row was decoded.
+template <typename T>
+bool Rows<T>::next_()
+{
+   if (!stmt_->step())
+      return false;
+
+   row_ = ColumnTraits<T>::get(*stmt_, 0);
+   return true;
+}
+
+} // namespace be::bed
+} // namespace be
+
+#endif
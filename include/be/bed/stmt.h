@@ -17,12 +17,18 @@
 #include <ostream>
 #include "sqlite3.h"
 
+#include "be/bed/blob_view.h"
 #include "be/bed/db.h"
+#include "be/bed/query_profiler.h"
 #include "be/id.h"
 
 namespace be {
 namespace bed {
 
+template <typename T> struct ColumnTraits;
+template <typename T> struct ParamTraits;
+template <typename T> class Rows;
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \class  Stmt   be/bed/stmt.h "be/bed/stmt.h"
 ///
@@ -34,6 +40,8 @@ namespace bed {
 /// \ingroup db
 class Stmt
 {
+   friend class BlobView;
+   friend class CachedStmt;
 public:
    Stmt(Db& db, const std::string& sql);
    Stmt(Db& db, const Id& id, const std::string& sql);
@@ -64,6 +72,15 @@ public:
    void bindBlob_s(int parameter, const void* value, int length);
    void bindColor(int parameter, const glm::vec4& color);
 
+   template <typename T>
+   void bindRow(const T& row);
+
+   template <typename Iterator>
+   int executeMany(Iterator begin, Iterator end);
+
+   template <typename Iterator, typename Binder>
+   int executeMany(Iterator begin, Iterator end, Binder binder);
+
    bool step();
    void reset();
 
@@ -81,12 +98,25 @@ public:
    const char* getText(int column);
    std::string getBlob(int column);
    int getBlob(int column, const void*& dest);
+   BlobView getBlobView(int column);
    glm::vec4 getColor(int column);
 
+   template <typename T>
+   T get(int column);
+
+   template <typename T>
+   Rows<T> rows();
+
 private:
+   void prepare_(const std::string& sql);
+   bool step_();
+   detail::QueryProfileEntry& getProfile_();
+
    Db& db_;
    Id id_;
    sqlite3_stmt* stmt_;
+   std::shared_ptr<unsigned int> row_;   ///< Incremented whenever the current row changes; BlobViews hold a weak_ptr to it.
+   detail::QueryProfileEntry* profile_;   ///< Only looked up if the query profiler is enabled.
    std::unique_ptr<std::unordered_map<std::string, int> > col_names_;
 
    Stmt(const Stmt&);
@@ -98,4 +128,6 @@ std::ostream& operator<<(std::ostream& os, const Stmt& s);
 } // namespace be::bed
 } // namespace be
 
+#include "be/bed/stmt.inl"
+
 #endif
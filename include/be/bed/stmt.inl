@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/stmt.inl
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::Stmt template functions.
+
+#if !defined(BE_BED_STMT_H_) && !defined(DOXYGEN)
+#include "be/bed/stmt.h"
+#elif !defined(BE_BED_STMT_INL_)
+#define BE_BED_STMT_INL_
+
+#include "be/bed/column_traits.h"
+#include "be/bed/param_traits.h"
+#include "be/bed/rows.h"
+#include "be/bed/transaction.h"
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the value starting at the specified column, decoded using
+///         ColumnTraits<T>.
+///
+/// \details Types which span multiple columns (glm::vec2, std::tuple, user
+///         structs, etc.) are read from consecutive columns starting at the
+///         one specified.
+///
+/// \param  column The first column to read.
+/// \return The decoded value.
+template <typename T>
+T Stmt::get(int column)
+{
+   return ColumnTraits<T>::get(*this, column);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns a single-pass range over the rows which will be returned
+///         by this statement, decoded using ColumnTraits<T>.
+///
+/// \details The statement will be stepped when the range is iterated; any
+///         parameters should be bound beforehand.
+///
+/// \return A Rows range which can be used in a range-based for loop.
+template <typename T>
+Rows<T> Stmt::rows()
+{
+   return Rows<T>(*this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Binds a value to this statement's parameters, starting with the
+///         first parameter, using ParamTraits<T>.
+///
+/// \details Types which span multiple parameters (glm::vec2, std::tuple, user
+///         structs, etc.) are bound to consecutive parameters.
+///
+/// \param  row The value to bind.
+template <typename T>
+void Stmt::bindRow(const T& row)
+{
+   ParamTraits<T>::bind(*this, 1, row);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Executes this statement once for each value in a range, binding
+///         each value using ParamTraits.
+///
+/// \details The statement is reset before each value is bound, so it can be
+///         called on a statement which has already been stepped.  Any result
+///         rows are ignored.  Parameters which are not bound by bindRow()
+///         keep their existing values.
+///
+///         No transaction is started; wrap the call in a Transaction (or use
+///         Db::executeMany()) so that the whole batch is committed at once.
+///
+/// \param  begin An iterator to the first value to bind.
+/// \param  end An iterator past the last value to bind.
+/// \return The number of times the statement was executed.
+template <typename Iterator>
+int Stmt::executeMany(Iterator begin, Iterator end)
+{
+   int executed = 0;
+   for (; begin != end; ++begin, ++executed)
+   {
+      reset();
+      bindRow(*begin);
+      step();
+   }
+   reset();
+   return executed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Executes this statement once for each value in a range, binding
+///         each value using a function object.
+///
+/// \details This overload is useful when the values being saved are not
+///         simple rows (for instance when some columns must be derived or
+///         bound to NULL):
+///
+/// \code
+///    stmt.executeMany(entities.begin(), entities.end(),
+///       [&](Stmt& s, Entity* entity)
+///       {
+///          s.bind(1, entity->getId().value());
+///          ...
+///       });
+/// \endcode
+///
+///         The statement is reset before each value is bound.  Any result
+///         rows are ignored.  No transaction is started.
+///
+/// \param  begin An iterator to the first value to bind.
+/// \param  end An iterator past the last value to bind.
+/// \param  binder A function object called as <tt>binder(stmt, *it)</tt>
+///         for each value, which binds the statement's parameters.
+/// \return The number of times the statement was executed.
+template <typename Iterator, typename Binder>
+int Stmt::executeMany(Iterator begin, Iterator end, Binder binder)
+{
+   int executed = 0;
+   for (; begin != end; ++begin, ++executed)
+   {
+      reset();
+      binder(*this, *begin);
+      step();
+   }
+   reset();
+   return executed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compiles a statement and executes it once for each value in a
+///         range, inside a single immediate transaction.
+///
+/// \details Values are bound using ParamTraits.  If any execution fails,
+///         the transaction is rolled back and the exception is propagated, so
+///         either all rows are written or none are.
+///
+///         This must not be called while another transaction is active on
+///         this connection.  Use Stmt::executeMany() inside an existing
+///         Transaction instead.
+///
+/// \param  sql The SQL statement to execute.
+/// \param  begin An iterator to the first value to bind.
+/// \param  end An iterator past the last value to bind.
+/// \return The number of times the statement was executed.
+template <typename Iterator>
+int Db::executeMany(const std::string& sql, Iterator begin, Iterator end)
+{
+   Transaction transaction(*this, Transaction::Immediate);
+   Stmt stmt(*this, sql);
+   int executed = stmt.executeMany(begin, end);
+   transaction.commit();
+   return executed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compiles a statement and executes it once for each value in a
+///         range, inside a single immediate transaction.
+///
+/// \details If any execution fails, the transaction is rolled back and the
+///         exception is propagated.
+///
+/// \param  sql The SQL statement to execute.
+/// \param  begin An iterator to the first value to bind.
+/// \param  end An iterator past the last value to bind.
+/// \param  binder A function object called as <tt>binder(stmt, *it)</tt>
+///         for each value, which binds the statement's parameters.
+/// \return The number of times the statement was executed.
+/// \sa     Stmt::executeMany(Iterator, Iterator, Binder)
+template <typename Iterator, typename Binder>
+int Db::executeMany(const std::string& sql, Iterator begin, Iterator end, Binder binder)
+{
+   Transaction transaction(*this, Transaction::Immediate);
+   Stmt stmt(*this, sql);
+   int executed = stmt.executeMany(begin, end, binder);
+   transaction.commit();
+   return executed;
+}
+
+} // namespace be::bed
+} // namespace be
+
+#endif
@@ -8,14 +8,25 @@
 #define BE_BED_STMT_CACHE_H_
 
 #include "be/bed/detail/stmt_cache_entry.h"
+#include "be/bed/detail/stmt_cache_shard.h"
 #include "be/bed/cached_stmt.h"
 #include "be/id.h"
+#include "be/id_map.h"
 
+#include <atomic>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <string>
+#include <utility>
+#include <vector>
 
 #define BE_BED_STMT_CACHE_DEFAULT_MAX_SIZE 24
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The default number of unheld statements each shard of a sharded
+///         StmtCache keeps in its front cache.
+#define BE_BED_STMT_CACHE_DEFAULT_SHARD_SIZE 4
+
 namespace be {
 namespace bed {
 
@@ -29,18 +40,46 @@ class Db;
 ///        objects) which can be checked out (held) by clients of the database.
 ///        The cache has a specific capacity.  When the size of the cache
 ///        increases beyond capacity, the cache will attempt to destroy the
-///        least recently held statements until the cache's capacity is
+///        least recently released statements until the cache's capacity is
 ///        reached.  Note that if there are no unheld statements the cache's
 ///        capacity may increase beyond its capacity.
 ///
+///        Unheld statements are kept in an intrusive LRU list as well as in a
+///        free list for their Id, so holding, releasing, and evicting a
+///        statement never requires searching the cache.
+///
 ///        When a database client wants a particular statement, they call one
 ///        of the hold() functions.  When the client is finished using the
 ///        statement that was returned, they let it go out of scope, which
 ///        causes it to inform the cache the underlying Stmt object can be
 ///        used again.
 ///
+///        The cache counts hits (holds satisfied by an unheld statement),
+///        misses (holds which required a new statement), compiles, and
+///        evictions.  These can be used to choose an appropriate capacity.
+///        It also remembers the Id and SQL text of every distinct statement
+///        it has compiled (see getCompiledStatements()), so that a list of
+///        the statements a client needs can be saved and later compiled
+///        ahead of time using prepare(), usually on a background thread.
+///
 ///        The cache is synchronized for concurrent access from multiple
-///        threads.
+///        threads.  By default all accesses take a single mutex.  If the
+///        cache is constructed with one or more shards, each thread uses the
+///        shard its thread id hashes to, which keeps a small front cache of
+///        the statements most recently released by the threads which use
+///        it.  Holding a statement found in the front cache, and releasing a
+///        statement into it, only locks that shard's mutex, which is only
+///        contended by threads which hash to the same shard, or when
+///        statements are evicted.  The shared mutex is only taken on a front
+///        cache miss, when the front cache overflows into the shared LRU
+///        list, or when the cache is over capacity.  Shards aren't claimed,
+///        so any number of threads can use the cache, and nothing needs to
+///        be cleaned up when a thread exits.
+///
+///        Statements in front caches count towards the cache's size.  When
+///        the cache is over capacity, statements in the shared LRU list are
+///        evicted first, then the least recently released statements in
+///        front caches.
 ///
 ///        Users of StmtCache must ensure that the lifetime of the StmtCache
 ///        (and the Stmt objects owned by it) is shorter than the lifetime of
@@ -55,35 +94,71 @@ class StmtCache
 public:
    StmtCache(Db& db);
    StmtCache(Db& db, size_t capacity);
+   StmtCache(Db& db, size_t capacity, size_t shards, size_t shard_size);
    ~StmtCache();
 
    void setCapacity(size_t capacity);
    size_t getCapacity();
 
+   size_t getShards() const;
+   size_t getShardSize() const;
+
    size_t getSize();
    size_t getHeldSize();
 
+   size_t getHits();
+   size_t getMisses();
+   size_t getCompiles();
+   size_t getEvictions();
+   void resetStats();
+
    CachedStmt hold(const std::string& sql);
    CachedStmt hold(const char* sql);
    CachedStmt hold(const Id& id, const std::string& sql);
    CachedStmt hold(const Id& id, const char* sql);
 
+   bool prepare(const Id& id, const std::string& sql);
+   bool prepare(const Id& id, const char* sql);
+
+   std::vector<std::pair<Id, std::string> > getCompiledStatements();
+
 private:
-   void hold_(detail::StmtCacheEntry& entry);
-   void release_(Stmt& stmt);
+   void release_(detail::StmtCacheEntry& entry);
    void checkSize_();
 
+   detail::StmtCacheShard* getShard_(std::unique_lock<std::mutex>& shard_lock);
+
+   void linkEntry_(detail::StmtCacheEntry& entry);
+   void unlinkEntry_(detail::StmtCacheEntry& entry);
+   void linkFree_(detail::StmtCacheEntry& entry);
+   void unlinkFree_(detail::StmtCacheEntry& entry);
+
    std::mutex mutex_;
 
    Db& db_;
 
-   size_t capacity_;
-   size_t held_size_;
+   std::atomic<size_t> capacity_;   ///< Only modified while mutex_ is locked.
+   std::atomic<size_t> size_;       ///< Only modified while mutex_ is locked.
+   std::atomic<size_t> held_size_;
+
+   std::atomic<size_t> hits_;
+   std::atomic<size_t> misses_;
+   std::atomic<size_t> compiles_;
+   std::atomic<size_t> evictions_;
+
+   size_t shard_count_;
+   size_t shard_size_;
+   std::unique_ptr<detail::StmtCacheShard[]> shards_;
+
+   detail::StmtCacheEntry* entries_;     ///< All entries owned by the cache, in no particular order.
+   detail::StmtCacheEntry* lru_head_;    ///< Most recently released unheld entry.
+   detail::StmtCacheEntry* lru_tail_;    ///< Least recently released unheld entry.
 
-   size_t next_index_;
-   size_t oldest_index_;
+   IdMap<detail::StmtCacheEntry*> free_;   ///< Head of the free list for each Id.
+   IdMap<std::string> compiled_;           ///< SQL text of every statement which has been compiled.
 
-   std::unordered_multimap<Id, detail::StmtCacheEntry> cache_;
+   StmtCache(const StmtCache&);
+   void operator=(const StmtCache&);
 };
 
 } // namespace be::bed
@@ -0,0 +1,66 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/file_watcher.h
+/// \author Benjamin Crist
+///
+/// \brief  be::FileWatcher class header.
+
+#ifndef BE_FILE_WATCHER_H_
+#define BE_FILE_WATCHER_H_
+#include "be/_be.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace be {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  FileWatcher   be/file_watcher.h "be/file_watcher.h"
+///
+/// \brief  Reports files which have been modified in a set of directories.
+/// \details On Linux, each watched directory gets an inotify watch, and a file
+///         is reported once it has been closed after writing or moved into
+///         the directory (so files are never reported while a tool is still
+///         in the middle of writing them).  On Windows, a change notification
+///         handle is opened for each directory, and when it is signalled the
+///         directory is rescanned and files whose last write time has changed
+///         are reported.
+///
+///         Watching is entirely passive; nothing happens until poll() is
+///         called, and poll() never blocks, so it can be called once per
+///         frame from the main loop.
+///
+///         FileWatcher is not thread-safe.
+class FileWatcher
+{
+public:
+   FileWatcher();
+   ~FileWatcher();
+
+   bool watch(const std::string& directory);
+   bool isWatching(const std::string& directory) const;
+
+   std::vector<std::string> poll();
+
+private:
+   struct Directory
+   {
+      std::string path;
+      int watch;
+      void* handle;
+      std::unordered_map<std::string, uint64_t> write_times;
+   };
+
+   void scan_(Directory& dir, std::vector<std::string>& modified);
+
+   int fd_;
+   std::vector<Directory> directories_;
+
+   FileWatcher(const FileWatcher&);
+   void operator=(const FileWatcher&);
+};
+
+} // namespace be
+
+#endif
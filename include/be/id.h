@@ -11,6 +11,8 @@
 
 #include <cstdint>
 #include <ostream>
+#include <string>
+#include <vector>
 
 #ifdef DOXYGEN
 
@@ -104,6 +106,11 @@ private:
 
 std::ostream& operator<<(std::ostream& os, const Id& id);
 
+void hashIds(const std::string* names, size_t count, Id* ids);
+std::vector<Id> hashIds(const std::vector<std::string>& names);
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = BE_ID_FNV_OFFSET_BASIS);
+
 } // namespace be
 
 #include "be/id.inl"
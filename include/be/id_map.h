@@ -0,0 +1,150 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/id_map.h
+/// \author Benjamin Crist
+///
+/// \brief  be::IdMap class template.
+
+#ifndef BE_ID_MAP_H_
+#define BE_ID_MAP_H_
+#include "be/_be.h"
+
+#include "be/id.h"
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace be {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  IdMap   be/id_map.h "be/id_map.h"
+///
+/// \brief  Hash map from Ids (or other Id-like keys) to T, using open
+///         addressing.
+/// \details IdMap is intended as a drop-in replacement for
+///         \c std::unordered_map<Id, T> in places where lookups are frequent.
+///         All elements are stored in a single array (there is no per-element
+///         allocation), and collisions are resolved by linear probing.  A
+///         separate array holds one control byte per slot: zero for empty
+///         slots, or 7 bits of the element's hash for full slots, so probing
+///         usually only touches the (small) control array and the one slot
+///         which actually holds the key.  Erasing uses backward-shift
+///         deletion, so there are no tombstones and lookups never slow down
+///         after many erasures.
+///
+///         Key hashes are further mixed by multiplying with a 64-bit odd
+///         constant (Fibonacci hashing) and taking the high bits, so keys with
+///         poorly distributed low bits (like small integer Ids) still spread
+///         out over the table.
+///
+///         Unlike \c std::unordered_map, inserting may move existing elements
+///         (invalidating references and iterators to them) and erasing may
+///         move other elements.  Store pointers (e.g. \c std::unique_ptr<T>)
+///         when references must stay valid.
+/// \ingroup ids
+template <typename T, typename Key = Id, typename Hash = std::hash<Key> >
+class IdMap
+{
+public:
+   typedef Key key_type;
+   typedef T mapped_type;
+   typedef std::pair<const Key, T> value_type;
+   typedef size_t size_type;
+   typedef Hash hasher;
+
+   ////////////////////////////////////////////////////////////////////////////
+   /// \brief  Forward iterator over the elements of an IdMap.
+   template <typename V>
+   class basic_iterator : public std::iterator<std::forward_iterator_tag, V>
+   {
+      friend class IdMap;
+      template <typename U> friend class basic_iterator;
+   public:
+      basic_iterator();
+      template <typename U>
+      basic_iterator(const basic_iterator<U>& other);
+
+      V& operator*() const;
+      V* operator->() const;
+
+      basic_iterator& operator++();
+      basic_iterator operator++(int);
+
+      template <typename U>
+      bool operator==(const basic_iterator<U>& other) const;
+      template <typename U>
+      bool operator!=(const basic_iterator<U>& other) const;
+
+   private:
+      basic_iterator(const uint8_t* ctrl, V* slots, size_type index, size_type capacity);
+      void skip_();
+
+      const uint8_t* ctrl_;
+      V* slots_;
+      size_type index_;
+      size_type capacity_;
+   };
+
+   typedef basic_iterator<value_type> iterator;
+   typedef basic_iterator<const value_type> const_iterator;
+
+   IdMap();
+   explicit IdMap(size_type capacity);
+   IdMap(const IdMap& other);
+   IdMap(IdMap&& other);
+   IdMap& operator=(IdMap other);
+   ~IdMap();
+
+   void swap(IdMap& other);
+
+   bool empty() const;
+   size_type size() const;
+   size_type capacity() const;
+
+   void reserve(size_type size);
+   void clear();
+
+   iterator begin();
+   iterator end();
+   const_iterator begin() const;
+   const_iterator end() const;
+
+   iterator find(const Key& key);
+   const_iterator find(const Key& key) const;
+   size_type count(const Key& key) const;
+
+   T& operator[](const Key& key);
+
+   std::pair<iterator, bool> insert(const value_type& value);
+   std::pair<iterator, bool> insert(value_type&& value);
+
+   size_type erase(const Key& key);
+   void erase(const_iterator position);
+
+private:
+   uint64_t mix_(const Key& key) const;
+   size_type home_(uint64_t mixed) const;
+   uint8_t tag_(uint64_t mixed) const;
+
+   size_type find_(const Key& key) const;
+   size_type claim_(const Key& key);
+   void erase_(size_type index);
+   void rehash_(size_type capacity);
+   void release_();
+
+   std::vector<uint8_t> ctrl_;   ///< One control byte per slot; 0 means empty.
+   value_type* slots_;           ///< Uninitialized storage for capacity_ elements.
+   size_type size_;
+   size_type capacity_;          ///< Always 0 or a power of two.
+   int shift_;                   ///< 64 - log2(capacity_).
+   Hash hash_;
+};
+
+} // namespace be
+
+#include "be/id_map.inl"
+
+#endif
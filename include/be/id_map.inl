@@ -0,0 +1,571 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/id_map.inl
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::IdMap template functions.
+
+#if !defined(BE_ID_MAP_H_) && !defined(DOXYGEN)
+#include "be/id_map.h"
+#elif !defined(BE_ID_MAP_INL_)
+#define BE_ID_MAP_INL_
+
+#include <algorithm>
+#include <new>
+
+namespace be {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an iterator which doesn't refer to any map.
+template <typename T, typename Key, typename Hash>
+template <typename V>
+IdMap<T, Key, Hash>::basic_iterator<V>::basic_iterator()
+   : ctrl_(nullptr),
+     slots_(nullptr),
+     index_(0),
+     capacity_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Converts an iterator to a const_iterator.
+template <typename T, typename Key, typename Hash>
+template <typename V>
+template <typename U>
+IdMap<T, Key, Hash>::basic_iterator<V>::basic_iterator(const basic_iterator<U>& other)
+   : ctrl_(other.ctrl_),
+     slots_(other.slots_),
+     index_(other.index_),
+     capacity_(other.capacity_)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an iterator referring to the first full slot at or
+///         after index.
+template <typename T, typename Key, typename Hash>
+template <typename V>
+IdMap<T, Key, Hash>::basic_iterator<V>::basic_iterator(const uint8_t* ctrl, V* slots, size_type index, size_type capacity)
+   : ctrl_(ctrl),
+     slots_(slots),
+     index_(index),
+     capacity_(capacity)
+{
+   skip_();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+template <typename V>
+V& IdMap<T, Key, Hash>::basic_iterator<V>::operator*() const
+{
+   return slots_[index_];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+template <typename V>
+V* IdMap<T, Key, Hash>::basic_iterator<V>::operator->() const
+{
+   return slots_ + index_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+template <typename V>
+typename IdMap<T, Key, Hash>::template basic_iterator<V>& IdMap<T, Key, Hash>::basic_iterator<V>::operator++()
+{
+   ++index_;
+   skip_();
+   return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+template <typename V>
+typename IdMap<T, Key, Hash>::template basic_iterator<V> IdMap<T, Key, Hash>::basic_iterator<V>::operator++(int)
+{
+   basic_iterator old(*this);
+   ++*this;
+   return old;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Iterators are equal if they refer to the same slot.  Comparing
+///         iterators from different maps is undefined.
+template <typename T, typename Key, typename Hash>
+template <typename V>
+template <typename U>
+bool IdMap<T, Key, Hash>::basic_iterator<V>::operator==(const basic_iterator<U>& other) const
+{
+   return index_ == other.index_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+template <typename V>
+template <typename U>
+bool IdMap<T, Key, Hash>::basic_iterator<V>::operator!=(const basic_iterator<U>& other) const
+{
+   return index_ != other.index_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Advances the iterator past any empty slots.
+template <typename T, typename Key, typename Hash>
+template <typename V>
+void IdMap<T, Key, Hash>::basic_iterator<V>::skip_()
+{
+   while (index_ < capacity_ && ctrl_[index_] == 0)
+      ++index_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an empty map.  No memory is allocated until the first
+///         element is inserted.
+template <typename T, typename Key, typename Hash>
+IdMap<T, Key, Hash>::IdMap()
+   : slots_(nullptr),
+     size_(0),
+     capacity_(0),
+     shift_(64)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an empty map which can hold at least capacity elements
+///         before it needs to grow.
+template <typename T, typename Key, typename Hash>
+IdMap<T, Key, Hash>::IdMap(size_type capacity)
+   : slots_(nullptr),
+     size_(0),
+     capacity_(0),
+     shift_(64)
+{
+   reserve(capacity);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Copies another map.  Elements keep the same positions, so no
+///         rehashing is necessary.
+template <typename T, typename Key, typename Hash>
+IdMap<T, Key, Hash>::IdMap(const IdMap& other)
+   : ctrl_(other.ctrl_),
+     slots_(nullptr),
+     size_(other.size_),
+     capacity_(other.capacity_),
+     shift_(other.shift_),
+     hash_(other.hash_)
+{
+   if (capacity_ == 0)
+      return;
+
+   slots_ = std::allocator<value_type>().allocate(capacity_);
+
+   size_type i = 0;
+   try
+   {
+      for (; i < capacity_; ++i)
+         if (ctrl_[i] != 0)
+            new (slots_ + i) value_type(other.slots_[i]);
+   }
+   catch (...)
+   {
+      while (i > 0)
+         if (ctrl_[--i] != 0)
+            slots_[i].~value_type();
+
+      std::allocator<value_type>().deallocate(slots_, capacity_);
+      throw;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Takes ownership of another map's elements, leaving it empty.
+template <typename T, typename Key, typename Hash>
+IdMap<T, Key, Hash>::IdMap(IdMap&& other)
+   : ctrl_(std::move(other.ctrl_)),
+     slots_(other.slots_),
+     size_(other.size_),
+     capacity_(other.capacity_),
+     shift_(other.shift_),
+     hash_(other.hash_)
+{
+   other.ctrl_.clear();
+   other.slots_ = nullptr;
+   other.size_ = 0;
+   other.capacity_ = 0;
+   other.shift_ = 64;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Replaces the contents of this map with a copy of (or, for
+///         rvalues, the contents of) another map.
+template <typename T, typename Key, typename Hash>
+IdMap<T, Key, Hash>& IdMap<T, Key, Hash>::operator=(IdMap other)
+{
+   swap(other);
+   return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys all elements and frees the map's storage.
+template <typename T, typename Key, typename Hash>
+IdMap<T, Key, Hash>::~IdMap()
+{
+   release_();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Exchanges the contents of two maps without moving any elements.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::swap(IdMap& other)
+{
+   std::swap(ctrl_, other.ctrl_);
+   std::swap(slots_, other.slots_);
+   std::swap(size_, other.size_);
+   std::swap(capacity_, other.capacity_);
+   std::swap(shift_, other.shift_);
+   std::swap(hash_, other.hash_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+bool IdMap<T, Key, Hash>::empty() const
+{
+   return size_ == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::size() const
+{
+   return size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of slots in the map.
+/// \details The map grows when it would otherwise become more than 3/4 full.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::capacity() const
+{
+   return capacity_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Ensures that at least size elements can be stored without the map
+///         needing to grow.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::reserve(size_type size)
+{
+   size_type capacity = 8;
+   while (capacity / 4 * 3 < size)
+      capacity *= 2;
+
+   if (capacity > capacity_)
+      rehash_(capacity);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys all elements, but keeps the map's storage.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::clear()
+{
+   for (size_type i = 0; i < capacity_; ++i)
+      if (ctrl_[i] != 0)
+      {
+         slots_[i].~value_type();
+         ctrl_[i] = 0;
+      }
+
+   size_ = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::iterator IdMap<T, Key, Hash>::begin()
+{
+   return iterator(ctrl_.data(), slots_, 0, capacity_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::iterator IdMap<T, Key, Hash>::end()
+{
+   return iterator(ctrl_.data(), slots_, capacity_, capacity_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::const_iterator IdMap<T, Key, Hash>::begin() const
+{
+   return const_iterator(ctrl_.data(), slots_, 0, capacity_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::const_iterator IdMap<T, Key, Hash>::end() const
+{
+   return const_iterator(ctrl_.data(), slots_, capacity_, capacity_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the element with the specified key.
+/// \return An iterator referring to the element, or end() if there is no
+///         such element.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::iterator IdMap<T, Key, Hash>::find(const Key& key)
+{
+   return iterator(ctrl_.data(), slots_, find_(key), capacity_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the element with the specified key.
+/// \return An iterator referring to the element, or end() if there is no
+///         such element.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::const_iterator IdMap<T, Key, Hash>::find(const Key& key) const
+{
+   return const_iterator(ctrl_.data(), slots_, find_(key), capacity_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns 1 if the map contains an element with the specified key,
+///         or 0 otherwise.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::count(const Key& key) const
+{
+   return find_(key) == capacity_ ? 0 : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the value associated with a key, inserting a
+///         value-initialized T first if the key is not yet in the map.
+template <typename T, typename Key, typename Hash>
+T& IdMap<T, Key, Hash>::operator[](const Key& key)
+{
+   size_type index = find_(key);
+   if (index == capacity_)
+   {
+      index = claim_(key);
+      new (slots_ + index) value_type(key, T());
+      ++size_;
+   }
+
+   return slots_[index].second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Inserts a copy of value if its key is not already in the map.
+/// \return An iterator referring to the element with value's key, and true
+///         if value was inserted.
+template <typename T, typename Key, typename Hash>
+std::pair<typename IdMap<T, Key, Hash>::iterator, bool> IdMap<T, Key, Hash>::insert(const value_type& value)
+{
+   size_type index = find_(value.first);
+   bool inserted = false;
+   if (index == capacity_)
+   {
+      index = claim_(value.first);
+      new (slots_ + index) value_type(value);
+      ++size_;
+      inserted = true;
+   }
+
+   return std::make_pair(iterator(ctrl_.data(), slots_, index, capacity_), inserted);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Moves value into the map if its key is not already in the map.
+/// \return An iterator referring to the element with value's key, and true
+///         if value was inserted.
+template <typename T, typename Key, typename Hash>
+std::pair<typename IdMap<T, Key, Hash>::iterator, bool> IdMap<T, Key, Hash>::insert(value_type&& value)
+{
+   size_type index = find_(value.first);
+   bool inserted = false;
+   if (index == capacity_)
+   {
+      index = claim_(value.first);
+      new (slots_ + index) value_type(std::move(value));
+      ++size_;
+      inserted = true;
+   }
+
+   return std::make_pair(iterator(ctrl_.data(), slots_, index, capacity_), inserted);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Removes the element with the specified key, if there is one.
+/// \return The number of elements removed (0 or 1).
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::erase(const Key& key)
+{
+   size_type index = find_(key);
+   if (index == capacity_)
+      return 0;
+
+   erase_(index);
+   return 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Removes the element an iterator refers to.
+/// \details Other elements may be moved to fill the gap, so all iterators are
+///         invalidated.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::erase(const_iterator position)
+{
+   erase_(position.index_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Hashes a key and multiplies the result by 2^64 / phi, so that the
+///         high bits depend on all of the hash's bits.
+template <typename T, typename Key, typename Hash>
+uint64_t IdMap<T, Key, Hash>::mix_(const Key& key) const
+{
+   return static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ull;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines the slot where probing for a key starts.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::home_(uint64_t mixed) const
+{
+   return static_cast<size_type>(mixed >> shift_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines the control byte for a key: the high bit, plus the 7
+///         bits of the mixed hash just below those used by home_().
+template <typename T, typename Key, typename Hash>
+uint8_t IdMap<T, Key, Hash>::tag_(uint64_t mixed) const
+{
+   return static_cast<uint8_t>(0x80 | ((mixed >> (shift_ - 7)) & 0x7F));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the slot containing key.
+/// \return The slot's index, or capacity_ if the key is not in the map.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::find_(const Key& key) const
+{
+   if (size_ == 0)
+      return capacity_;
+
+   uint64_t mixed = mix_(key);
+   uint8_t tag = tag_(mixed);
+   size_type mask = capacity_ - 1;
+
+   for (size_type i = home_(mixed); ; i = (i + 1) & mask)
+   {
+      uint8_t ctrl = ctrl_[i];
+      if (ctrl == 0)
+         return capacity_;
+
+      if (ctrl == tag && slots_[i].first == key)
+         return i;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds an empty slot for a key which is not in the map, growing
+///         the map first if necessary, and marks it as full.
+/// \details The caller must construct an element in the slot and increment
+///         size_.
+template <typename T, typename Key, typename Hash>
+typename IdMap<T, Key, Hash>::size_type IdMap<T, Key, Hash>::claim_(const Key& key)
+{
+   if (capacity_ == 0 || size_ + 1 > capacity_ / 4 * 3)
+      rehash_(capacity_ == 0 ? 8 : capacity_ * 2);
+
+   uint64_t mixed = mix_(key);
+   size_type mask = capacity_ - 1;
+
+   size_type i = home_(mixed);
+   while (ctrl_[i] != 0)
+      i = (i + 1) & mask;
+
+   ctrl_[i] = tag_(mixed);
+   return i;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys the element in a slot, then shifts any following
+///         elements in the same cluster back towards their home slots so that
+///         no probe sequence is broken by the hole.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::erase_(size_type index)
+{
+   size_type mask = capacity_ - 1;
+
+   slots_[index].~value_type();
+
+   for (size_type i = (index + 1) & mask; ctrl_[i] != 0; i = (i + 1) & mask)
+   {
+      size_type home = home_(mix_(slots_[i].first));
+
+      // the element in slot i can fill the hole if the hole lies between
+      // its home slot and slot i.
+      if (((i - home) & mask) >= ((i - index) & mask))
+      {
+         new (slots_ + index) value_type(std::move(slots_[i]));
+         slots_[i].~value_type();
+         ctrl_[index] = ctrl_[i];
+         index = i;
+      }
+   }
+
+   ctrl_[index] = 0;
+   --size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Moves all elements into a new array with the specified number of
+///         slots.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::rehash_(size_type capacity)
+{
+   IdMap other;
+   other.ctrl_.resize(capacity, 0);
+   other.slots_ = std::allocator<value_type>().allocate(capacity);
+   other.capacity_ = capacity;
+   other.hash_ = hash_;
+
+   other.shift_ = 64;
+   for (size_type c = capacity; c > 1; c >>= 1)
+      --other.shift_;
+
+   for (size_type i = 0; i < capacity_; ++i)
+   {
+      if (ctrl_[i] == 0)
+         continue;
+
+      size_type index = other.claim_(slots_[i].first);
+      new (other.slots_ + index) value_type(std::move(slots_[i]));
+      ++other.size_;
+   }
+
+   swap(other);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys all elements and frees the map's storage.
+template <typename T, typename Key, typename Hash>
+void IdMap<T, Key, Hash>::release_()
+{
+   if (!slots_)
+      return;
+
+   clear();
+   std::allocator<value_type>().deallocate(slots_, capacity_);
+
+   slots_ = nullptr;
+   ctrl_.clear();
+   capacity_ = 0;
+   shift_ = 64;
+}
+
+} // namespace be
+
+#endif
@@ -63,6 +63,78 @@
 /// \brief  Equivalent to Id("__pbjconfig__").value().
 #define PBJ_ID_PBJCONFIG 0x554eba1957a0b731
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("bullet").value().
+#define PBJ_ID_BULLET 0x27fd172670080039
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("spawnpoint").value().
+#define PBJ_ID_SPAWNPOINT 0xddfd165eca1acbee
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_font").value().
+#define PBJ_ID_STD_FONT 0x94e05d678941227e
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("wpnfire").value().
+#define PBJ_ID_WPNFIRE 0x04eb7a6a090d7e78
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("dmg").value().
+#define PBJ_ID_DMG 0xcab54b18f478ffc7
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("death").value().
+#define PBJ_ID_DEATH 0xf405a475b731576d
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.normal").value().
+#define PBJ_ID_STD_BTN_NORMAL 0xbafa94ec71995356
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.hovered").value().
+#define PBJ_ID_STD_BTN_HOVERED 0xff5c6c3a83f4d468
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.active").value().
+#define PBJ_ID_STD_BTN_ACTIVE 0xc23f90534354c7ab
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.focused").value().
+#define PBJ_ID_STD_BTN_FOCUSED 0x51d3a861220399c6
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.focused_hovered").value().
+#define PBJ_ID_STD_BTN_FOCUSED_HOVERED 0xe89d0c527a9c985a
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.focused_active").value().
+#define PBJ_ID_STD_BTN_FOCUSED_ACTIVE 0x0ccfc42f8d5dd795
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("std_btn.disabled").value().
+#define PBJ_ID_STD_BTN_DISABLED 0x50e1c8dab59f1549
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("player1_outline").value().
+#define PBJ_ID_PLAYER1_OUTLINE 0x9a8a98b000061f62
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("player2_outline").value().
+#define PBJ_ID_PLAYER2_OUTLINE 0x512adc87b71bdacf
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("player3_outline").value().
+#define PBJ_ID_PLAYER3_OUTLINE 0xd82f9d26b506309c
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("player4_outline").value().
+#define PBJ_ID_PLAYER4_OUTLINE 0x0aec0414649a7779
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Equivalent to Id("player5_outline").value().
+#define PBJ_ID_PLAYER5_OUTLINE 0x1ee6f8436d05b8e6
+
 namespace be {
 
 class Id;
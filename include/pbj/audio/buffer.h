@@ -16,6 +16,8 @@
 namespace pbj {
 namespace audio {
 
+class SoundData;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \class  Buffer
 ///
@@ -29,18 +31,56 @@ class Buffer
 {
 public:
     Buffer(const ALubyte* data, size_t size);
+    Buffer(ALenum format, const ALvoid* data, ALsizei size, ALsizei frequency);
+    explicit Buffer(const SoundData& data);
     ~Buffer();
 
-    ALuint getBufferID();
+    ALuint getBufferID() const;
+    size_t getSize() const;
+
+    void swap(Buffer& other);
 
 private:
+    void upload_(ALenum format, const ALvoid* data, ALsizei size, ALsizei frequency);
+
     ALuint buffer_id_;
 
     Buffer(const Buffer&);
     void operator=(const Buffer&);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \class  SoundData
+///
+/// \brief  Decoded PCM audio which is ready to be copied into a Buffer.
+///
+/// \details Decoding doesn't need to touch any OpenAL objects, so SoundData
+///         can be created on worker threads and then passed to the
+///         Buffer(const SoundData&) constructor on the main thread.
+class SoundData
+{
+public:
+    SoundData(const ALubyte* data, size_t size);
+    ~SoundData();
+
+    ALenum getFormat() const;
+    const ALvoid* getData() const;
+    ALsizei getSize() const;
+    ALsizei getFrequency() const;
+
+private:
+    ALvoid* data_;
+    ALenum format_;
+    ALsizei size_;
+    ALfloat frequency_;
+
+    SoundData(const SoundData&);
+    void operator=(const SoundData&);
+};
+
 std::unique_ptr<Buffer> loadSound(sw::Sandwich& sandwich, const Id& id);
+std::unique_ptr<SoundData> decodeSound(sw::Sandwich& sandwich, const Id& id);
+U64 getSoundContentHash(sw::Sandwich& sandwich, const Id& id);
 
 } // namespace pbj::audio
 } // namespace pbj
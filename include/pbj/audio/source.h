@@ -66,8 +66,8 @@ public:
     void updatePosition();
     void updateVelocity();
 
-    void addBuffer(const std::string&, Buffer*);
-    Buffer* getBuffer(const std::string&);
+    void addBuffer(const std::string&, const Buffer*);
+    const Buffer* getBuffer(const std::string&);
     void play(const std::string&);
     void playAt(const std::string&, F32);
     void stop();
@@ -80,7 +80,7 @@ public:
 private:
     scene::Entity* _owner;
     ALuint _srcId;
-    std::unordered_map<std::string, Buffer*> _buffers;
+    std::unordered_map<std::string, const Buffer*> _buffers;
     std::string _curPlaying;
 
     Source(const Source&);
@@ -11,12 +11,13 @@
 #include "pbj/engine.h"
 #include "pbj/window.h"
 #include "be/id.h"
+#include "be/id_map.h"
 #include "pbj/_pbj.h"
 #include "pbj/scene/scene.h"
 #include "pbj/scene/ui_button.h"
 
+#include <future>
 #include <memory>
-#include <unordered_map>
 
 namespace pbj {
 
@@ -56,6 +57,8 @@ public:
 
 private:
     void onContextResized_(I32 width, I32 height);
+    void checkSaves_(bool wait);
+    void checkSave_(std::future<void>& result, const char* what, bool wait);
     scene::UIButton* newButton_(const Id& id,
                                 const std::string& text,
                                 const vec2& position,
@@ -79,7 +82,7 @@ private:
     sw::ResourceId map_id_;
 
     scene::UIRoot ui_;
-    std::unordered_map<Id, scene::UIElement*> ui_elements_;
+    be::IdMap<scene::UIElement*> ui_elements_;
     scene::UIPanel* menu_;
     bool menu_toggled_;
     U32 menu_visible_counter_;      // When this is above 0, the menu should be visible.
@@ -97,6 +100,9 @@ private:
     EditorMode* mouse_down_mode_[3];            ///< The editing mode we were in when each mouse button was pressed.
     ivec2 mouse_position_;                      ///< The mouse position the last time the cursor moved.
 
+    std::future<void> scene_saved_;             ///< Becomes ready when the last saveMap()'s scene has been written.
+    std::future<void> manifest_saved_;          ///< Becomes ready when the last saveMap()'s query manifest has been written.
+
     // prevent copy/assign
     Editor(const Editor&);
     void operator=(const Editor&);
@@ -132,6 +132,10 @@ private:
 
 	bool _loadRandomSceneNextFrame;
 
+    bool _streaming;            ///< True until the current scene's resources have all been uploaded.
+    U32 _streamingFrames;       ///< Frames drawn while the current scene was streaming.
+    F64 _worstStreamingFrame;   ///< The longest of those frames, in seconds.
+
     GameControls _controls;
 };
 
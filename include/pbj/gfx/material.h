@@ -9,6 +9,7 @@
 #include "pbj/_pbj.h"
 #include "pbj/_math.h"
 #include "pbj/gfx/texture.h"
+#include "pbj/sw/resource_handle.h"
 
 namespace pbj {
 
@@ -29,28 +30,46 @@ namespace gfx {
 class Material
 {
 public:
-    Material(const sw::ResourceId& id, const color4& color, const Texture* texture, GLenum texture_mode);
+    Material(const sw::ResourceId& id, const color4& color, const sw::ResourceHandle<Texture>& texture, GLenum texture_mode);
     ~Material();
 
     const color4& getColor() const;
     const Texture* getTexture() const;
+    const sw::ResourceHandle<Texture>& getTextureHandle() const;
     GLenum getTextureMode() const;
 
     void use() const;
 
+    void swap(Material& other);
+
     const sw::ResourceId& getId() const;
 
 private:
     sw::ResourceId id_;
     color4 color_;
-    const Texture* tex_;
+    sw::ResourceHandle<Texture> tex_;
     GLenum tex_mode_;
 
     Material(const Material&);
     void operator=(const Material&);
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  The properties of a material, as stored in a sandwich.
+///
+/// \details Used to read materials on worker threads; the Material itself is
+///         constructed later, once its texture can be requested from a
+///         ResourceManager.
+struct MaterialData
+{
+    color4 color;
+    bool has_texture;
+    Id texture_id;
+    GLenum texture_mode;
+};
+
 std::unique_ptr<Material> loadMaterial(sw::Sandwich& sandwich, const Id& id, sw::ResourceManager& rm);
+std::unique_ptr<MaterialData> readMaterial(sw::Sandwich& sandwich, const Id& id);
 
 } //namespace gfx
 } //namespace pbj
@@ -16,10 +16,13 @@
 #include "pbj/sw/resource_id.h"
 
 #include "pbj/sw/sandwich.h"
+#include "be/bed/blob_reader.h"
 
 namespace pbj {
 namespace gfx {
 
+class TextureImage;
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Represents an OpenGL texture object stored on the graphics card.
 ///
@@ -42,17 +45,25 @@ public:
     };
 
     Texture(const GLubyte* data, size_t size, InternalFormat format, bool srgb_color, FilterMode mag_mode, FilterMode min_mode);
+    Texture(db::BlobReader& data, InternalFormat format, bool srgb_color, FilterMode mag_mode, FilterMode min_mode);
+    explicit Texture(const TextureImage& image);
     ~Texture();
 
     GLuint getGlId() const;
     const ivec2& getDimensions() const;
+    size_t getSize() const;
+
+    void swap(Texture& other);
 
     void enable(GLenum blend_mode) const;
     static void disable();
 
 private:
+    void upload_(const TextureImage& image);
+
     ivec2 dimensions_;
     GLuint gl_id_;
+    size_t size_;
 
     static bool texture_enabled_;
     static GLuint active_texture_;
@@ -62,7 +73,45 @@ private:
     void operator=(const Texture&);
 };
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  A decoded image which is ready to be uploaded to the GPU.
+///
+/// \details Decoding doesn't touch OpenGL, so TextureImages can be created on
+///         worker threads and then passed to the Texture(const TextureImage&)
+///         constructor on the thread which owns the GL context.
+///
+/// \author Benjamin Crist
+class TextureImage
+{
+public:
+    TextureImage(const GLubyte* data, size_t size, Texture::InternalFormat format, bool srgb_color, Texture::FilterMode mag_mode, Texture::FilterMode min_mode);
+    TextureImage(db::BlobReader& data, Texture::InternalFormat format, bool srgb_color, Texture::FilterMode mag_mode, Texture::FilterMode min_mode);
+    ~TextureImage();
+
+    const GLubyte* getPixels() const;
+    const ivec2& getDimensions() const;
+    Texture::InternalFormat getFormat() const;
+    bool isSrgb() const;
+    Texture::FilterMode getMagMode() const;
+    Texture::FilterMode getMinMode() const;
+
+private:
+    void decode_(const GLubyte* data, size_t size, db::BlobReader* reader);
+
+    GLubyte* pixels_;
+    ivec2 dimensions_;
+    Texture::InternalFormat format_;
+    bool srgb_;
+    Texture::FilterMode mag_mode_;
+    Texture::FilterMode min_mode_;
+
+    TextureImage(const TextureImage&);
+    void operator=(const TextureImage&);
+};
+
 std::unique_ptr<Texture> loadTexture(sw::Sandwich& sandwich, const Id& texture_id);
+std::unique_ptr<TextureImage> decodeTexture(sw::Sandwich& sandwich, const Id& texture_id);
+U64 getTextureContentHash(sw::Sandwich& sandwich, const Id& texture_id);
 
 } // namespace pbj::gfx
 } // namespace pbj
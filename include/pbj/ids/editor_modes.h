@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/ids/editor_modes.h
+/// \author Benjamin Crist
+///
+/// \brief  Perfect hash table of precalculated Ids.
+/// \details Generated by idgen --table (see tools/generate.cmd); do not
+///         edit.  Looking up an Id takes two multiplications and a single
+///         comparison.
+
+#ifndef PBJ_IDS_EDITOR_MODES_H_
+#define PBJ_IDS_EDITOR_MODES_H_
+
+#include "be/id.h"
+
+#include <cstddef>
+
+namespace pbj {
+namespace ids {
+namespace editor_modes {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The slot containing each Id.
+enum Index
+{
+   none = -1,
+   id_EditorMode_decorate = 0,
+   id_EditorMode_add_clobber = 1,
+   id_EditorMode_dupe = 2,
+   id_EditorMode_rotate = 3,
+   id_EditorMode_mimic = 4,
+   id_EditorMode_move = 5,
+   id_EditorMode_look = 6,
+   id_EditorMode_scale = 7,
+};
+
+const size_t count = 8;   ///< The number of Ids in the table.
+const size_t size = 8;    ///< The number of slots in the table.
+const uint64_t multiplier = 0x61d1b02ea388e63bULL;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The Id value in each slot.  Empty slots contain a value which
+///         belongs in a different slot.
+const uint64_t values[size] =
+{
+   0x1c1ff726ea758b74ULL,
+   0xb9343bbe40f7e0d6ULL,
+   0x119b717cf8640ef3ULL,
+   0xee0749d272ec44ecULL,
+   0xe3196974078d1238ULL,
+   0xbc01bf30674cf796ULL,
+   0x7d16893b145b2b24ULL,
+   0x13effe57a1395abfULL,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The name hashed to create the Id in each slot.
+const char* const names[size] =
+{
+   "EditorMode.decorate",
+   "EditorMode.add_clobber",
+   "EditorMode.dupe",
+   "EditorMode.rotate",
+   "EditorMode.mimic",
+   "EditorMode.move",
+   "EditorMode.look",
+   "EditorMode.scale",
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the slot containing an Id value.
+/// \return The slot's Index, or none if the value is not in the table.
+inline Index find(uint64_t value)
+{
+   size_t slot = static_cast<size_t>((((value * multiplier) >> 32) * size) >> 32);
+   return values[slot] == value ? static_cast<Index>(slot) : none;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the slot containing an Id.
+/// \return The slot's Index, or none if the Id is not in the table.
+inline Index find(const be::Id& id)
+{
+   return find(id.value());
+}
+
+} // namespace pbj::ids::editor_modes
+} // namespace pbj::ids
+} // namespace pbj
+
+#endif
@@ -6,6 +6,7 @@
 #define PBJ_SCENE_SCENE_H_
 
 #include <vector>
+#include <future>
 #include <map>
 #include <random>
 #include <queue>
@@ -20,6 +21,7 @@
 #include "pbj/scene/entity.h"
 #include "pbj/sw/sandwich.h"
 #include "be\id.h"
+#include "be/id_map.h"
 
 namespace pbj {
 
@@ -45,6 +47,7 @@ class Scene : public b2ContactListener
 {
     friend class Editor;
     friend void loadEntity(sw::Sandwich&, const Id&, const Id&, Scene&);
+    friend std::unique_ptr<Scene> loadScene(sw::Sandwich&, const Id&);
 public:
     Scene();
     void makeHud();
@@ -53,6 +56,7 @@ public:
     void update(F32 delta_t);
     void physUpdate(F32 delta_t);
 
+    sw::ResourceManager& getResourceManager();
     b2World* getWorld();
 
     void setName(const std::string& name);
@@ -82,7 +86,7 @@ public:
     void disableBullet(U32 id);
     void respawnPlayer(U32 id);
 
-    void saveScene(const Id& sandwich_id, const Id& map_id);
+    std::future<void> saveScene(const Id& sandwich_id, const Id& map_id);
 
 private:
     virtual void BeginContact(b2Contact* contact);
@@ -90,6 +94,8 @@ private:
     virtual void PreSolve(b2Contact* contact, const b2Manifold* manifold);
     virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse);
 
+    void checkManifestSaved();
+
     static const I32 _physVelocityIterations = 8;
     static const I32 _physPositionIterations = 3;
     static const size_t _maxBullets = 500;
@@ -103,7 +109,7 @@ private:
     Engine& _engine;
     Window& _window;
 
-    sw::ResourceManager _resources;
+    be::IdMap<sw::ResourceHandle<gfx::Material>, sw::ResourceId> _materials;
     const gfx::Material* _bulletMaterial;
     const gfx::Material* _spawnPointMaterial;
 
@@ -112,6 +118,7 @@ private:
     b2World _physWorld;
 
     std::string _name;
+    std::future<void> _manifestSaved;   ///< Set if loading the scene refreshed its map's resource manifest.
 
     //as we get more Entity types this may have to expand/change entirely
     EntityMap _spawnPoints;
@@ -134,7 +141,7 @@ private:
     I32 _curRingIndex;
 
     UIRoot _ui;
-    std::unordered_map<Id, UIElement*> _ui_elements;
+    be::IdMap<UIElement*> _ui_elements;
     UILabel* _player_health_lbl[5];
     UILabel* _player_kd_lbl[5];
 
@@ -144,8 +151,12 @@ private:
 };
 
 std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich, const Id& map_id);
+std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich, const Id& map_id, const vec2& min, const vec2& max);
+std::vector<Id> getEntitiesInRegion(sw::Sandwich& sandwich, const Id& map_id, const vec2& min, const vec2& max);
 void loadEntity(sw::Sandwich& sandwich, const Id& map_id, const Id& entity_id, Scene& scene);
-void saveEntity(const Id& sandwich_id, const Id& map_id, Entity* entity);
+std::future<void> saveEntity(const Id& sandwich_id, const Id& map_id, Entity* entity);
+std::vector<sw::ManifestEntry> loadMapManifest(sw::Sandwich& sandwich, const Id& map_id);
+std::future<void> saveMapManifest(const Id& sandwich_id, const Id& map_id, const std::vector<sw::ManifestEntry>& manifest);
 
 } // namespace pbj::scene
 } // namespace pbj
@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/detail/resource_table.h
+/// \author Benjamin Crist
+///
+/// \brief  pbj::sw::detail::ResourceTable class template header.
+
+#ifndef PBJ_SW_DETAIL_RESOURCE_TABLE_H_
+#define PBJ_SW_DETAIL_RESOURCE_TABLE_H_
+
+#include "pbj/sw/manifest.h"
+#include "pbj/sw/resource_handle.h"
+#include "pbj/sw/resource_id.h"
+#include "pbj/_pbj.h"
+#include "be/id_map.h"
+
+#include <memory>
+#include <vector>
+
+namespace pbj {
+namespace sw {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines how much of the budget a resource uses.
+///
+/// \details By default, the resource's getSize() function is used.
+///         Resources which don't count toward the budget specialize this to
+///         return 0.
+template <typename T>
+struct ResourceSize
+{
+    static size_t get(const T& resource);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Tracks the object loaded for a particular content hash, so that
+///         resources with identical content can share it.
+template <typename T>
+struct SharedContent
+{
+    std::weak_ptr<T> resource;                  ///< Expires once no slot holds it.
+    std::vector<ResourceSlot<T>*> waiting;      ///< Slots waiting for this content to stream in.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  An unreferenced resource which could be evicted.
+struct EvictionCandidate
+{
+    EvictionCandidate(U64 last_used, const ManifestEntry& entry);
+
+    bool operator<(const EvictionCandidate& other) const;
+
+    U64 last_used;
+    ManifestEntry entry;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  ResourceTable   pbj/sw/detail/resource_table.h "pbj/sw/detail/resource_table.h"
+///
+/// \brief  Holds the ResourceSlots of one type of resource for a
+///         ResourceManager.
+/// \details The table does the ResourceManager's bookkeeping; it never
+///         loads anything itself.  It owns the slots (which never move, so
+///         ResourceHandles can point to them), orders them by when they were
+///         last used, reports each use to a ManifestRecorder, and counts the
+///         memory used by loaded resources.
+///
+///         Resources with a non-zero content hash share a single object
+///         with every other slot with the same content.  That object is
+///         only counted once, and its memory is only released when the
+///         last slot sharing it is evicted.  While the content is streaming
+///         in, slots waiting for it are remembered so that the streamed
+///         object can be given to all of them.
+///
+///         Like ResourceSlot, a table may only be used from the thread which
+///         owns its ResourceManager.
+template <typename T>
+class ResourceTable
+{
+    typedef be::IdMap<std::unique_ptr<ResourceSlot<T> >, ResourceId> map_type;
+
+public:
+    typedef typename map_type::iterator iterator;
+
+    ResourceTable(ManifestEntry::ResourceType type, U64& use_clock, ManifestRecorder& recorder);
+
+    ManifestEntry::ResourceType getType() const;
+
+    ResourceSlot<T>* find(const ResourceId& id);
+    ResourceSlot<T>& insert(const ResourceId& id, const T* placeholder, U64 content);
+    void touch(ResourceSlot<T>& slot);
+
+    std::shared_ptr<T> findContent(U64 content) const;
+    bool waitForContent(ResourceSlot<T>& slot);
+    std::vector<ResourceSlot<T>*> takeWaiting(ResourceSlot<T>& slot);
+
+    void setResource(ResourceSlot<T>& slot, std::unique_ptr<T>&& ptr);
+    void shareResource(ResourceSlot<T>& slot, const std::shared_ptr<T>& ptr);
+    void replaceResource(ResourceSlot<T>& slot, std::unique_ptr<T>&& ptr, U64 content);
+
+    void findEvictable(std::vector<EvictionCandidate>& candidates) const;
+    void evict(const ResourceId& id);
+    void clear();
+
+    size_t getBytes() const;
+    size_t getLoadedCount() const;
+    size_t getEvictableCount() const;
+    size_t getDeduplicated() const;
+
+    iterator begin();
+    iterator end();
+
+private:
+    void releaseContent_(const ResourceSlot<T>& slot);
+
+    ManifestEntry::ResourceType type_;
+    U64& use_clock_;            ///< Shared by every table of a ResourceManager, so evictions can be ordered across them.
+    ManifestRecorder& recorder_;
+
+    map_type slots_;
+    be::IdMap<SharedContent<T> > content_;  ///< Keyed by content hash.
+
+    size_t bytes_;
+    size_t deduplicated_;
+
+    ResourceTable(const ResourceTable&);
+    void operator=(const ResourceTable&);
+};
+
+template <typename A, typename B, typename C>
+size_t evictLeastRecentlyUsed(size_t budget, ResourceTable<A>& a, ResourceTable<B>& b, ResourceTable<C>& c);
+
+} // namespace pbj::sw::detail
+} // namespace pbj::sw
+} // namespace pbj
+
+#include "pbj/sw/detail/resource_table.inl"
+
+#endif
@@ -0,0 +1,462 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/detail/resource_table.inl
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of pbj::sw::detail::ResourceTable template
+///         functions.
+
+#if !defined(PBJ_SW_DETAIL_RESOURCE_TABLE_H_) && !defined(DOXYGEN)
+#include "pbj/sw/detail/resource_table.h"
+#elif !defined(PBJ_SW_DETAIL_RESOURCE_TABLE_INL_)
+#define PBJ_SW_DETAIL_RESOURCE_TABLE_INL_
+
+#include <algorithm>
+
+namespace pbj {
+namespace sw {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the memory used by a resource.
+///
+/// \param  resource The loaded resource.
+/// \return The resource's size, in bytes.
+template <typename T>
+size_t ResourceSize<T>::get(const T& resource)
+{
+    return resource.getSize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if a resource could be evicted.
+///
+/// \details Resources referenced by a ResourceHandle, pinned by one of the
+///         get functions, or waiting for a streamed load to finish must stay
+///         loaded.
+template <typename T>
+bool isEvictable(const ResourceSlot<T>& slot)
+{
+    return slot.refs == 0 && !slot.pinned && !slot.pending;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an EvictionCandidate.
+///
+/// \param  last_used When the resource was last used.
+/// \param  entry Identifies the resource.
+inline EvictionCandidate::EvictionCandidate(U64 last_used, const ManifestEntry& entry)
+    : last_used(last_used),
+      entry(entry)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Orders candidates from least to most recently used.
+inline bool EvictionCandidate::operator<(const EvictionCandidate& other) const
+{
+    return last_used < other.last_used;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an empty table.
+///
+/// \param  type The type of resource stored in the table; used when
+///         recording and evicting.
+/// \param  use_clock Incremented each time a resource is used.
+/// \param  recorder Notified each time a resource is used.
+template <typename T>
+ResourceTable<T>::ResourceTable(ManifestEntry::ResourceType type, U64& use_clock, ManifestRecorder& recorder)
+    : type_(type),
+      use_clock_(use_clock),
+      recorder_(recorder),
+      bytes_(0),
+      deduplicated_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the type of resource stored in this table.
+template <typename T>
+ManifestEntry::ResourceType ResourceTable<T>::getType() const
+{
+    return type_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the slot for a resource, if there is one.
+///
+/// \details The slot may still be streaming in, or may have failed to load.
+///         Finding a slot does not count as using it; see touch().
+///
+/// \param  id The ResourceId of the resource.
+/// \return The resource's slot, or nullptr.
+template <typename T>
+ResourceSlot<T>* ResourceTable<T>::find(const ResourceId& id)
+{
+    auto i = slots_.find(id);
+    return i == slots_.end() ? nullptr : i->second.get();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds or creates the slot for a resource, and marks it as used.
+///
+/// \param  id The ResourceId of the resource.
+/// \param  placeholder The object the slot returns until it is loaded, if a
+///         new slot is created.  May be nullptr.
+/// \param  content The resource's content hash, or 0 if it is unknown or
+///         the resource should never be shared.
+/// \return The resource's slot.
+template <typename T>
+ResourceSlot<T>& ResourceTable<T>::insert(const ResourceId& id, const T* placeholder, U64 content)
+{
+    std::unique_ptr<ResourceSlot<T> >& slot = slots_[id];
+    if (!slot)
+        slot.reset(new ResourceSlot<T>(id, placeholder));
+
+    slot->content = content;
+    touch(*slot);
+    return *slot;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Marks a resource as the most recently used, and records it if
+///         the ManifestRecorder is recording.
+///
+/// \param  slot The resource's slot.
+template <typename T>
+void ResourceTable<T>::touch(ResourceSlot<T>& slot)
+{
+    slot.last_used = ++use_clock_;
+    recorder_.record(type_, slot.id);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds the object which has already been loaded for a content
+///         hash, if it is still alive.
+///
+/// \param  content The content hash.
+/// \return The loaded object, or an empty pointer.
+template <typename T>
+std::shared_ptr<T> ResourceTable<T>::findContent(U64 content) const
+{
+    if (content == 0)
+        return std::shared_ptr<T>();
+
+    auto i = content_.find(Id(content));
+    if (i == content_.end())
+        return std::shared_ptr<T>();
+
+    return i->second.resource.lock();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Marks a slot as waiting for a streamed load.
+///
+/// \details If another slot with the same content is already waiting, this
+///         slot is given the same object when that load finishes (see
+///         takeWaiting()), so there's no need to start another.
+///
+/// \param  slot The slot.
+/// \return \c true if a load has already been started for the slot's
+///         content; \c false if the caller must start one.
+template <typename T>
+bool ResourceTable<T>::waitForContent(ResourceSlot<T>& slot)
+{
+    slot.pending = true;
+    if (slot.content == 0)
+        return false;
+
+    std::vector<ResourceSlot<T>*>& waiting = content_[Id(slot.content)].waiting;
+    waiting.push_back(&slot);
+    return waiting.size() > 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the slots which were waiting for a streamed load to
+///         finish, and marks them as no longer pending.
+///
+/// \details Resources without a content hash don't share their loads, so
+///         the only slot waiting is the one which was requested.
+///
+/// \param  slot The slot the load was started for.
+/// \return The slots waiting for the load, in the order they started
+///         waiting.
+template <typename T>
+std::vector<ResourceSlot<T>*> ResourceTable<T>::takeWaiting(ResourceSlot<T>& slot)
+{
+    std::vector<ResourceSlot<T>*> slots;
+    if (slot.content == 0)
+    {
+        slots.push_back(&slot);
+    }
+    else
+    {
+        auto i = content_.find(Id(slot.content));
+        if (i != content_.end())
+            slots.swap(i->second.waiting);
+    }
+
+    for (auto i(slots.begin()), end(slots.end()); i != end; ++i)
+        (*i)->pending = false;
+
+    return slots;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stores a newly loaded resource in its slot and counts its memory.
+///
+/// \details If the slot's content hash is known, the resource can then be
+///         shared with other slots which have the same content.
+///
+/// \param  slot The slot to store the resource in.  Must not already hold a
+///         loaded resource, unless that resource is shared with other slots.
+/// \param  ptr The loaded resource.
+template <typename T>
+void ResourceTable<T>::setResource(ResourceSlot<T>& slot, std::unique_ptr<T>&& ptr)
+{
+    slot.setResource(std::move(ptr));
+    slot.bytes = ResourceSize<T>::get(*slot.resource);
+    bytes_ += slot.bytes;
+
+    if (slot.content != 0)
+        content_[Id(slot.content)].resource = slot.resource;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stores a resource which is already loaded for another slot with
+///         the same content.
+///
+/// \details The resource's memory is already counted, so it is not counted
+///         again.
+///
+/// \param  slot The slot to store the resource in.  Must not already hold a
+///         loaded resource.
+/// \param  ptr The shared resource.
+template <typename T>
+void ResourceTable<T>::shareResource(ResourceSlot<T>& slot, const std::shared_ptr<T>& ptr)
+{
+    slot.setResource(ptr);
+    slot.bytes = ResourceSize<T>::get(*ptr);
+    ++deduplicated_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Replaces a loaded resource with a new version of it.
+///
+/// \details If no other slot shares the old object, the new version is
+///         swapped into it, so existing references to it see the new
+///         version.  Otherwise the other slots keep the old object and this
+///         slot gets a new one.
+///
+/// \param  slot The slot to update.  Must hold a loaded resource.
+/// \param  ptr The new version of the resource.
+/// \param  content The new version's content hash.
+template <typename T>
+void ResourceTable<T>::replaceResource(ResourceSlot<T>& slot, std::unique_ptr<T>&& ptr, U64 content)
+{
+    if (slot.resource.use_count() == 1)
+    {
+        releaseContent_(slot);
+        bytes_ -= slot.bytes;
+        slot.resource->swap(*ptr);
+        slot.bytes = ResourceSize<T>::get(*slot.resource);
+        bytes_ += slot.bytes;
+
+        slot.content = content;
+        if (content != 0)
+            content_[Id(content)].resource = slot.resource;
+    }
+    else
+    {
+        slot.content = content;
+        setResource(slot, std::move(ptr));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Adds every evictable resource in this table to a list of
+///         eviction candidates.
+///
+/// \param  candidates The list to add to.
+template <typename T>
+void ResourceTable<T>::findEvictable(std::vector<EvictionCandidate>& candidates) const
+{
+    for (auto i(slots_.begin()), end(slots_.end()); i != end; ++i)
+    {
+        if (isEvictable(*i->second))
+            candidates.push_back(EvictionCandidate(i->second->last_used, ManifestEntry(type_, i->first)));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys a resource's slot.
+///
+/// \details A resource shared with other slots stays loaded, and its memory
+///         stays counted, until the last of them is evicted.
+///
+/// \param  id The ResourceId of the resource.  It must be evictable.
+template <typename T>
+void ResourceTable<T>::evict(const ResourceId& id)
+{
+    auto i = slots_.find(id);
+    if (i == slots_.end())
+        return;
+
+    ResourceSlot<T>& slot = *i->second;
+    assert(isEvictable(slot));
+
+    if (slot.resource.use_count() == 1)
+    {
+        bytes_ -= slot.bytes;
+        releaseContent_(slot);
+    }
+
+    slots_.erase(id);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys every slot.
+///
+/// \details No ResourceHandles may refer to any of them.
+template <typename T>
+void ResourceTable<T>::clear()
+{
+    slots_.clear();
+    content_.clear();
+    bytes_ = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the memory used by the resources in this table, counting
+///         shared objects once.
+template <typename T>
+size_t ResourceTable<T>::getBytes() const
+{
+    return bytes_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Counts the slots which hold a loaded resource.
+template <typename T>
+size_t ResourceTable<T>::getLoadedCount() const
+{
+    size_t count = 0;
+    for (auto i(slots_.begin()), end(slots_.end()); i != end; ++i)
+    {
+        if (i->second->resource)
+            ++count;
+    }
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Counts the slots which could be evicted.
+template <typename T>
+size_t ResourceTable<T>::getEvictableCount() const
+{
+    size_t count = 0;
+    for (auto i(slots_.begin()), end(slots_.end()); i != end; ++i)
+    {
+        if (isEvictable(*i->second))
+            ++count;
+    }
+    return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the number of times a slot was given an object which was
+///         already loaded for another slot with the same content.
+template <typename T>
+size_t ResourceTable<T>::getDeduplicated() const
+{
+    return deduplicated_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns an iterator to the first (ResourceId, slot) pair.
+template <typename T>
+typename ResourceTable<T>::iterator ResourceTable<T>::begin()
+{
+    return slots_.begin();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns an iterator past the last (ResourceId, slot) pair.
+template <typename T>
+typename ResourceTable<T>::iterator ResourceTable<T>::end()
+{
+    return slots_.end();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Forgets the object loaded for a slot's content hash.
+///
+/// \details Must only be called when the slot holds the last reference to
+///         its object, or when the object's content is about to change.
+template <typename T>
+void ResourceTable<T>::releaseContent_(const ResourceSlot<T>& slot)
+{
+    if (slot.content == 0)
+        return;
+
+    auto i = content_.find(Id(slot.content));
+    if (i != content_.end() && i->second.waiting.empty() && i->second.resource.lock() == slot.resource)
+        content_.erase(Id(slot.content));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Evicts unreferenced resources from three tables, least recently
+///         used first, until the memory they use fits within a budget.
+///
+/// \details Evicting a resource may release handles it holds to resources
+///         in another table (for instance, a material's texture), which may
+///         then be evicted in turn if the tables are still over budget.
+///         Evicting a resource which shares its object with other slots
+///         frees no memory until the last of them is evicted.  Pinned,
+///         referenced, and pending resources are never evicted, so the
+///         tables may still be over budget afterwards.
+///
+///         The tables must share a use clock, and must store different types
+///         of resource.
+///
+/// \param  budget The memory the tables may use, in bytes.
+/// \return The number of resources evicted.
+template <typename A, typename B, typename C>
+size_t evictLeastRecentlyUsed(size_t budget, ResourceTable<A>& a, ResourceTable<B>& b, ResourceTable<C>& c)
+{
+    size_t evicted = 0;
+    std::vector<EvictionCandidate> candidates;
+
+    while (a.getBytes() + b.getBytes() + c.getBytes() > budget)
+    {
+        candidates.clear();
+        a.findEvictable(candidates);
+        b.findEvictable(candidates);
+        c.findEvictable(candidates);
+
+        if (candidates.empty())
+            break;
+
+        std::sort(candidates.begin(), candidates.end());
+
+        for (auto i(candidates.begin()), end(candidates.end()); i != end && a.getBytes() + b.getBytes() + c.getBytes() > budget; ++i)
+        {
+            if (i->entry.type == a.getType())
+                a.evict(i->entry.id);
+            else if (i->entry.type == b.getType())
+                b.evict(i->entry.id);
+            else
+                c.evict(i->entry.id);
+
+            ++evicted;
+        }
+    }
+
+    return evicted;
+}
+
+} // namespace pbj::sw::detail
+} // namespace pbj::sw
+} // namespace pbj
+
+#endif
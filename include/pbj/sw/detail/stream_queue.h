@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/detail/stream_queue.h
+/// \author Benjamin Crist
+///
+/// \brief  pbj::sw::detail::StreamQueue class header.
+
+#ifndef PBJ_SW_DETAIL_STREAM_QUEUE_H_
+#define PBJ_SW_DETAIL_STREAM_QUEUE_H_
+
+#include "pbj/_pbj.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pbj {
+namespace sw {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  StreamQueue   pbj/sw/detail/stream_queue.h "pbj/sw/detail/stream_queue.h"
+///
+/// \brief  Runs a ResourceManager's streamed loads on worker threads, and
+///         hands the results back to the thread which owns the manager.
+/// \details Each load is a task run on one of the worker threads, which must
+///         call queueUpload() exactly once, with a task that finishes the
+///         load (creating GL or AL objects, for instance).  Upload tasks are
+///         only ever run by processUploads() or waitForUpload(), on the
+///         calling thread, in the order they were queued.
+///
+///         No worker threads are started until the first load is queued.
+class StreamQueue
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit StreamQueue(size_t worker_count = 0);
+    ~StreamQueue();
+
+    size_t getWorkerCount() const;
+
+    void queueLoad(const Task& task);
+    void queueUpload(const Task& task);
+
+    size_t processUploads(std::chrono::microseconds budget);
+    void waitForUpload();
+    size_t getStreamingCount() const;
+
+    void stop();
+
+private:
+    void workerMain_();
+
+    size_t worker_count_;
+    size_t streaming_;          ///< Loads which haven't been uploaded yet.
+
+    std::mutex mutex_;
+    std::condition_variable load_queued_;
+    std::condition_variable upload_queued_;
+    std::deque<Task> loads_;    ///< Run on worker threads.
+    std::deque<Task> uploads_;  ///< Run by processUploads().
+    std::vector<std::thread> workers_;
+    bool stopping_;
+
+    StreamQueue(const StreamQueue&);
+    void operator=(const StreamQueue&);
+};
+
+} // namespace pbj::sw::detail
+} // namespace pbj::sw
+} // namespace pbj
+
+#endif
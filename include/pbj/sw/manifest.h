@@ -0,0 +1,82 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/manifest.h
+/// \author Benjamin Crist
+///
+/// \brief  pbj::sw::ManifestEntry struct and pbj::sw::ManifestRecorder class
+///         header.
+
+#ifndef PBJ_SW_MANIFEST_H_
+#define PBJ_SW_MANIFEST_H_
+
+#include "pbj/sw/resource_id.h"
+#include "pbj/_pbj.h"
+
+#include <vector>
+
+namespace pbj {
+namespace sw {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Identifies a resource used by a ResourceManager, as recorded in a
+///         resource manifest.
+///
+/// \details The values of ResourceType are stored in sandwiches, so they
+///         must never change.
+///
+/// \author Ben Crist
+struct ManifestEntry
+{
+    enum ResourceType
+    {
+        Texture = 0,
+        Material = 1,
+        Sound = 2
+    };
+
+    ManifestEntry();
+    ManifestEntry(ResourceType type, const ResourceId& id);
+
+    ResourceType type;
+    ResourceId id;
+
+    bool operator==(const ManifestEntry& other) const;
+    bool operator!=(const ManifestEntry& other) const;
+    bool operator<(const ManifestEntry& other) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Collects the resources used between calls to start() and stop().
+///
+/// \details While paused (see pause()), nothing is recorded, so resources
+///         which are only being loaded ahead of time (see
+///         ResourceManager::prefetch()) don't end up in the manifest unless
+///         something actually uses them.
+///
+/// \author Ben Crist
+class ManifestRecorder
+{
+public:
+    ManifestRecorder();
+
+    void start();
+    std::vector<ManifestEntry> stop();
+    bool isRecording() const;
+
+    void pause();
+    void resume();
+
+    void record(ManifestEntry::ResourceType type, const ResourceId& id);
+
+private:
+    bool recording_;
+    size_t paused_;         ///< The number of calls to pause() not yet matched by resume().
+    std::vector<ManifestEntry> recorded_;
+
+    ManifestRecorder(const ManifestRecorder&);
+    void operator=(const ManifestRecorder&);
+};
+
+} // namespace pbj::sw
+} // namespace pbj
+
+#endif
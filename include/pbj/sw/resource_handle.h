@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/resource_handle.h
+/// \author Benjamin Crist
+///
+/// \brief  pbj::sw::ResourceHandle class template header.
+
+#ifndef PBJ_SW_RESOURCE_HANDLE_H_
+#define PBJ_SW_RESOURCE_HANDLE_H_
+
+#include "pbj/sw/resource_id.h"
+#include "pbj/_pbj.h"
+
+#include <cassert>
+#include <memory>
+
+namespace pbj {
+namespace sw {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Holds a resource which is owned by a ResourceManager and may still
+///         be streaming in.
+/// \details Slots are only ever accessed from the thread which owns the
+///         ResourceManager, and they are never moved, so ResourceHandles can
+///         simply point to them.  A slot is only destroyed (evicting its
+///         resource) when no handles refer to it, it is not pinned, and it
+///         is not waiting for a streamed load to finish.
+///
+///         Resources with identical content (see ResourceManager) share a
+///         single object between their slots, which is destroyed along with
+///         the last slot referring to it.
+template <typename T>
+struct ResourceSlot
+{
+    ResourceSlot(const ResourceId& id, const T* placeholder);
+
+    void setResource(std::unique_ptr<T>&& ptr);
+    void setResource(const std::shared_ptr<T>& ptr);
+
+    ResourceId id;
+    std::shared_ptr<T> resource;    ///< Empty until the resource is loaded.
+    const T* current;               ///< resource.get() once loaded, otherwise the placeholder.
+    bool failed;                    ///< True if the resource could not be loaded.
+
+    mutable size_t refs;            ///< The number of ResourceHandles referring to this slot.
+    bool pinned;                    ///< True if a reference was returned without a handle.
+    bool pending;                   ///< True while a streamed load refers to this slot.
+    size_t bytes;                   ///< The memory used by the resource, once loaded.
+    U64 last_used;                  ///< When the resource was last retrieved or requested.
+    U64 content;                    ///< Identifies the resource's content, or 0 if unknown.
+
+private:
+    ResourceSlot(const ResourceSlot&);
+    void operator=(const ResourceSlot&);
+};
+
+} // namespace pbj::sw::detail
+
+///////////////////////////////////////////////////////////////////////////////
+/// \class  ResourceHandle   pbj/sw/resource_handle.h "pbj/sw/resource_handle.h"
+///
+/// \brief  Lightweight reference to a resource requested from a
+///         ResourceManager which may not have finished loading yet.
+///
+/// \details Handles are returned by the ResourceManager's request functions.
+///         Until the resource has been decoded and uploaded, get() returns a
+///         placeholder (which may be nullptr, depending on the resource type)
+///         and afterwards it returns the resource itself, so a handle can be
+///         stored and used every frame without checking isReady().
+///
+///         Handles are reference counted; while any handle to a resource
+///         exists, the ResourceManager will not evict it.  Handles must be
+///         destroyed before the ResourceManager that created them, and
+///         should only be used from the thread which owns that
+///         ResourceManager.
+///
+/// \author Ben Crist
+template <typename T>
+class ResourceHandle
+{
+public:
+    ResourceHandle();
+    explicit ResourceHandle(const detail::ResourceSlot<T>& slot);
+    ResourceHandle(const ResourceHandle& other);
+    ResourceHandle& operator=(const ResourceHandle& other);
+    ~ResourceHandle();
+
+    bool isNull() const;
+    bool isReady() const;
+    bool isFailed() const;
+
+    const ResourceId& getId() const;
+    const T* get() const;
+
+    bool operator==(const ResourceHandle& other) const;
+    bool operator!=(const ResourceHandle& other) const;
+
+private:
+    void release_();
+
+    const detail::ResourceSlot<T>* slot_;
+};
+
+} // namespace pbj::sw
+} // namespace pbj
+
+#include "pbj/sw/resource_handle.inl"
+
+#endif
@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/resource_handle.inl
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of pbj::sw::ResourceHandle template functions.
+
+#if !defined(PBJ_SW_RESOURCE_HANDLE_H_) && !defined(DOXYGEN)
+#include "pbj/sw/resource_handle.h"
+#elif !defined(PBJ_SW_RESOURCE_HANDLE_INL_)
+#define PBJ_SW_RESOURCE_HANDLE_INL_
+
+namespace pbj {
+namespace sw {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a slot for a resource which has not been loaded yet.
+///
+/// \param  id The ResourceId of the resource which will be stored here.
+/// \param  placeholder The object to use in place of the resource until it
+///         is loaded.  May be nullptr.
+template <typename T>
+ResourceSlot<T>::ResourceSlot(const ResourceId& id, const T* placeholder)
+    : id(id),
+      current(placeholder),
+      failed(false),
+      refs(0),
+      pinned(false),
+      pending(false),
+      bytes(0),
+      last_used(0),
+      content(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stores the loaded resource, replacing the placeholder.
+///
+/// \param  ptr The loaded resource.
+template <typename T>
+void ResourceSlot<T>::setResource(std::unique_ptr<T>&& ptr)
+{
+    resource = std::move(ptr);
+    current = resource.get();
+    failed = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stores a resource which is already loaded (and may be stored in
+///         other slots), replacing the placeholder.
+///
+/// \param  ptr The loaded resource.
+template <typename T>
+void ResourceSlot<T>::setResource(const std::shared_ptr<T>& ptr)
+{
+    resource = ptr;
+    current = resource.get();
+    failed = false;
+}
+
+} // namespace pbj::sw::detail
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a null handle which doesn't refer to any resource.
+template <typename T>
+ResourceHandle<T>::ResourceHandle()
+    : slot_(nullptr)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a handle referring to the resource in the provided
+///         slot.
+///
+/// \param  slot The ResourceManager-owned slot which holds the resource.
+template <typename T>
+ResourceHandle<T>::ResourceHandle(const detail::ResourceSlot<T>& slot)
+    : slot_(&slot)
+{
+    ++slot_->refs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a handle referring to the same resource as another.
+///
+/// \param  other The handle to copy.
+template <typename T>
+ResourceHandle<T>::ResourceHandle(const ResourceHandle& other)
+    : slot_(other.slot_)
+{
+    if (slot_)
+        ++slot_->refs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Makes this handle refer to the same resource as another.
+///
+/// \param  other The handle to copy.
+/// \return This handle.
+template <typename T>
+ResourceHandle<T>& ResourceHandle<T>::operator=(const ResourceHandle& other)
+{
+    if (slot_ != other.slot_)
+    {
+        release_();
+        slot_ = other.slot_;
+        if (slot_)
+            ++slot_->refs;
+    }
+
+    return *this;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Releases this handle's reference to its resource.
+///
+/// \details If this was the last handle, the resource may be evicted the
+///         next time its ResourceManager is over budget.
+template <typename T>
+ResourceHandle<T>::~ResourceHandle()
+{
+    release_();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if this handle refers to a resource at all.
+///
+/// \return \c true if this handle was default-constructed.
+template <typename T>
+bool ResourceHandle<T>::isNull() const
+{
+    return slot_ == nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if the resource has finished loading.
+///
+/// \return \c true if get() will return the resource rather than a
+///         placeholder.
+template <typename T>
+bool ResourceHandle<T>::isReady() const
+{
+    return slot_ && slot_->resource;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if the resource could not be loaded.
+///
+/// \details When loading fails, get() will continue to return the
+///         placeholder object indefinitely.
+///
+/// \return \c true if loading the resource failed.
+template <typename T>
+bool ResourceHandle<T>::isFailed() const
+{
+    return slot_ && slot_->failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the ResourceId of the resource this handle refers to.
+///
+/// \details Must not be called on a null handle.
+///
+/// \return The resource's ResourceId.
+template <typename T>
+const ResourceId& ResourceHandle<T>::getId() const
+{
+    assert(slot_);
+    return slot_->id;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the resource, or its placeholder if it hasn't finished
+///         loading.
+///
+/// \return A pointer to the resource or placeholder, or nullptr if this is a
+///         null handle or the resource type has no placeholder.
+template <typename T>
+const T* ResourceHandle<T>::get() const
+{
+    return slot_ ? slot_->current : nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if two handles refer to the same resource.
+///
+/// \param  other The handle to compare to.
+/// \return \c true if both handles refer to the same slot.
+template <typename T>
+bool ResourceHandle<T>::operator==(const ResourceHandle& other) const
+{
+    return slot_ == other.slot_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if two handles refer to different resources.
+///
+/// \param  other The handle to compare to.
+/// \return \c true if the handles refer to different slots.
+template <typename T>
+bool ResourceHandle<T>::operator!=(const ResourceHandle& other) const
+{
+    return slot_ != other.slot_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Releases this handle's reference to its resource, if any.
+template <typename T>
+void ResourceHandle<T>::release_()
+{
+    if (slot_)
+    {
+        assert(slot_->refs > 0);
+        --slot_->refs;
+        slot_ = nullptr;
+    }
+}
+
+} // namespace pbj::sw
+} // namespace pbj
+
+#endif
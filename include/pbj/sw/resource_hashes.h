@@ -0,0 +1,37 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/resource_hashes.h
+/// \author Benjamin Crist
+///
+/// \brief  pbj::sw::ResourceHashes struct header.
+
+#ifndef PBJ_SW_RESOURCE_HASHES_H_
+#define PBJ_SW_RESOURCE_HASHES_H_
+
+#include "pbj/sw/sandwich.h"
+#include "pbj/_pbj.h"
+#include "be/id_map.h"
+
+namespace pbj {
+namespace sw {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Content hashes of the texture, material, and sound rows in a
+///         sandwich, keyed by resource Id.
+///
+/// \details Comparing the hashes taken before and after a sandwich is
+///         modified identifies exactly which resources need to be reloaded.
+///
+/// \author Ben Crist
+struct ResourceHashes
+{
+    be::IdMap<U64> textures;
+    be::IdMap<U64> materials;
+    be::IdMap<U64> sounds;
+};
+
+ResourceHashes hashResources(Sandwich& sandwich);
+
+} // namespace pbj::sw
+} // namespace pbj
+
+#endif
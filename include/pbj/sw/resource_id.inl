@@ -20,16 +20,20 @@ public:
     ////////////////////////////////////////////////////////////////////////////
     /// \brief  Calculates the hashcode of the provided ResourceId.
     ///
-    /// \details Just XORs the \c std::hash values of the two Ids that make up
-    ///         the ResourceId.
+    /// \details Combines the values of the two Ids that make up the ResourceId
+    ///         in the style of boost::hash_combine.  Unlike XORing the two
+    ///         hashes, this is not symmetric, so swapping the sandwich and
+    ///         resource Ids (or using the same Id for both) doesn't produce
+    ///         colliding (or zero) hashcodes.
     ///
     /// \param  id The ResourceId to hash.
     /// \return A hashcode suitable for use in hashtable-based data structures.
     size_t operator()(const pbj::sw::ResourceId& id) const
     {
-        std::hash<be::Id> hash_id;
+        pbj::U64 value = id.sandwich.value();
+        value ^= id.resource.value() + 0x9E3779B97F4A7C15ull + (value << 6) + (value >> 2);
 
-        return hash_id(id.sandwich) ^ hash_id(id.resource);
+        return std::hash<be::Id>()(be::Id(value));
     }
 };
 
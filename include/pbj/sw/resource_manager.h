@@ -7,19 +7,71 @@
 #ifndef PBJ_SW_RESOURCE_MANAGER_H_
 #define PBJ_SW_RESOURCE_MANAGER_H_
 
+#include "pbj/sw/detail/resource_table.h"
+#include "pbj/sw/detail/stream_queue.h"
+#include "pbj/sw/manifest.h"
+#include "pbj/sw/resource_handle.h"
+#include "pbj/sw/resource_hashes.h"
 #include "pbj/sw/resource_id.h"
 #include "pbj/sw/sandwich.h"
 #include "pbj/scene/ui_styles.h"
 #include "pbj/_pbj.h"
 #include "pbj/audio/buffer.h"
 #include "pbj/gfx/material.h"
+#include "be/id_map.h"
 
-#include <unordered_map>
+#include <chrono>
 #include <memory>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The default amount of time ResourceManager::processUploads() may
+///         spend uploading streamed resources each frame, in microseconds.
+#define PBJ_SW_RESOURCE_UPLOAD_BUDGET 2000
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  The default amount of memory a ResourceManager may use for
+///         textures and sounds before it starts evicting unreferenced
+///         resources, in bytes.
+#define PBJ_SW_RESOURCE_BUDGET (128 * 1024 * 1024)
 
 namespace pbj {
 namespace sw {
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  A snapshot of the resources resident in a ResourceManager.
+///
+/// \details Only texture and sound memory counts toward the budget; the
+///         other resource types are small, and are only counted.
+///
+/// \author Ben Crist
+struct ResidencyStats
+{
+    size_t budget;              ///< The current budget, in bytes.
+    size_t textures;            ///< The number of textures loaded.
+    size_t texture_bytes;       ///< Approximate GPU memory used by textures.
+    size_t sounds;              ///< The number of sounds loaded.
+    size_t sound_bytes;         ///< Memory used by PCM sound data.
+    size_t materials;           ///< The number of materials loaded.
+    size_t texture_fonts;       ///< The number of texture fonts loaded.
+    size_t unreferenced;        ///< Textures, materials, and sounds which could be evicted.
+    size_t evicted;             ///< Resources evicted since the manager was created.
+    size_t deduplicated;        ///< Textures and sounds which shared an identical copy instead of loading their own.
+};
+
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Materials don't count toward a ResourceManager's budget, but they
+///         keep their textures loaded.
+template <>
+struct ResourceSize<gfx::Material>
+{
+    static size_t get(const gfx::Material& material);
+};
+
+} // namespace pbj::sw::detail
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  A ResourceManager owns resource objects loaded from sandwiches.
 ///
@@ -28,15 +80,71 @@ namespace sw {
 ///         it will try to load the resource from a sandwich and add it to
 ///         its collection of resources before returning it.
 ///
-///         Any sandwiches that are loaded from will remain open, and any
-///         resources loaded from them will remain valid, until the
-///         ResourceManager is destroyed.
+///         Any sandwiches that are loaded from will remain open until the
+///         ResourceManager is destroyed.  Resources returned by reference
+///         from the get functions are pinned: they remain valid until the
+///         ResourceManager is destroyed.  Textures, materials, and sounds can
+///         instead be retrieved with acquireTexture(), acquireMaterial(),
+///         and acquireSound(), which return reference counted
+///         ResourceHandles.  Once no handles refer to a resource that hasn't
+///         been pinned, it stays loaded (so reloading a map is cheap) until
+///         the texture and sound memory used exceeds the budget (see
+///         setBudget()), at which point unreferenced resources are evicted
+///         in least recently used order.
+///
+///         Textures, materials, and sounds can also be streamed in without
+///         blocking using requestTexture(), requestMaterial(), and
+///         requestSound().  These return a ResourceHandle immediately, and
+///         the resource is read and decoded on a pool of worker threads.
+///         Creating the GL or AL object from the decoded data must happen on
+///         the main thread, so finished resources wait in a queue until
+///         processUploads() is called, which uploads as many as it can within
+///         a time budget; calling it once per frame spreads the cost of a
+///         large set of new resources over several frames instead of
+///         stalling one.  Until a resource is uploaded, its handle returns a
+///         placeholder: an untextured grey material, a silent sound buffer,
+///         or (for textures) nullptr.
+///
+///         Materials loaded with getMaterial() request their textures this
+///         way, so loading a map only blocks on the (small) material rows;
+///         texture decoding happens in the background.  The synchronous
+///         getters still return fully loaded resources, finishing any
+///         pending request on the calling thread if necessary.
+///
+///         Between calls to startRecording() and stopRecording(), every
+///         texture, material, and sound which is retrieved or requested is
+///         recorded.  The resulting manifest can later be passed to
+///         prefetch() to stream all of those resources in at once, on every
+///         worker thread, before they are needed.
+///
+///         The bookkeeping (which resources are loaded, when they were last
+///         used, how much memory they use, and which share content) is done
+///         by a detail::ResourceTable for each of textures, materials, and
+///         sounds, and the worker threads and upload queue are managed by a
+///         detail::StreamQueue; the ResourceManager itself only loads
+///         resources and creates their GL and AL objects.
+///
+///         Textures and sounds are also keyed by the content hash stored
+///         alongside their blobs (see hashContent()).  When a resource is
+///         needed whose content is identical to one which is already loaded
+///         or streaming in (for instance, the same image imported into
+///         several sandwiches), the existing object is shared instead of
+///         decoding and uploading another copy.  Shared objects only count
+///         toward the budget once.
+///
+///         When hot reloading is enabled (see setHotReload()), calling
+///         reloadModified() picks up changes made to sandwich files while
+///         the program is running.  Only textures, materials, and sounds
+///         whose rows have actually changed are reloaded, and they are
+///         replaced in place, so existing references, pointers, and handles
+///         to them remain valid.
 ///
 /// \author Ben Crist
 class ResourceManager
 {
 public:
     ResourceManager();
+    ~ResourceManager();
 
     audio::Buffer* getSound(const ResourceId& id);
     const gfx::Material& getMaterial(const ResourceId& id);
@@ -45,17 +153,65 @@ public:
     const scene::UIPanelStyle& getUIPanelStyle(const ResourceId& id);
     const scene::UIButtonStyle& getUIButtonStyle(const ResourceId& id);
 
+    ResourceHandle<audio::Buffer> acquireSound(const ResourceId& id);
+    ResourceHandle<gfx::Material> acquireMaterial(const ResourceId& id);
+    ResourceHandle<gfx::Texture> acquireTexture(const ResourceId& id);
+
+    ResourceHandle<audio::Buffer> requestSound(const ResourceId& id);
+    ResourceHandle<gfx::Material> requestMaterial(const ResourceId& id);
+    ResourceHandle<gfx::Texture> requestTexture(const ResourceId& id);
+
+    size_t processUploads(std::chrono::microseconds budget = std::chrono::microseconds(PBJ_SW_RESOURCE_UPLOAD_BUDGET));
+    size_t getStreamingCount() const;
+
+    void prefetch(const std::vector<ManifestEntry>& manifest);
+    void startRecording();
+    std::vector<ManifestEntry> stopRecording();
+
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+    ResidencyStats getResidencyStats() const;
+
+    void setHotReload(bool enabled);
+    bool isHotReloadEnabled() const;
+    size_t reloadModified();
+
 private:
     Sandwich& getSandwich(const Id& sandwich_id);
 
-    std::unordered_map<Id, std::shared_ptr<Sandwich> > sandwiches_;
+    detail::ResourceSlot<audio::Buffer>& loadSound_(const ResourceId& id);
+    detail::ResourceSlot<gfx::Material>& loadMaterial_(const ResourceId& id);
+    detail::ResourceSlot<gfx::Texture>& loadTexture_(const ResourceId& id);
+
+    size_t evict_();
+
+    size_t reloadSandwich_(const Id& sandwich_id);
+
+    void recordTexture_(const gfx::Material& material);
+
+    be::IdMap<std::shared_ptr<Sandwich> > sandwiches_;
+    be::IdMap<ResourceHashes> resource_hashes_;  ///< Only populated when hot reloading is enabled.
+
+    ManifestRecorder recorder_;
+    U64 use_clock_;             ///< Incremented each time a resource is used; orders evictions.
+
+    // Materials hold handles to textures, so textures_ must outlive them.
+    detail::ResourceTable<gfx::Texture> textures_;
+    detail::ResourceTable<gfx::Material> materials_;
+    detail::ResourceTable<audio::Buffer> sounds_;
+    be::IdMap<std::unique_ptr<gfx::TextureFont>, ResourceId> texture_fonts_;
+    be::IdMap<std::unique_ptr<scene::UIPanelStyle>, ResourceId> panel_styles_;
+    be::IdMap<std::unique_ptr<scene::UIButtonStyle>, ResourceId> button_styles_;
+
+    std::unique_ptr<gfx::Material> placeholder_material_;
+    std::unique_ptr<audio::Buffer> placeholder_sound_;
+
+    size_t budget_;
+    size_t evicted_;
+
+    bool hot_reload_;
 
-    std::unordered_map<ResourceId, std::unique_ptr<audio::Buffer> > sounds_;
-    std::unordered_map<ResourceId, std::unique_ptr<gfx::Material> > materials_;
-    std::unordered_map<ResourceId, std::unique_ptr<gfx::TextureFont> > texture_fonts_;
-    std::unordered_map<ResourceId, std::unique_ptr<gfx::Texture> > textures_;
-    std::unordered_map<ResourceId, scene::UIPanelStyle> panel_styles_;
-    std::unordered_map<ResourceId, scene::UIButtonStyle> button_styles_;
+    detail::StreamQueue stream_;
 
     ResourceManager(const ResourceManager&);
     void operator=(const ResourceManager&);
@@ -7,13 +7,19 @@
 #ifndef PBJ_SW_SANDWICH_H_
 #define PBJ_SW_SANDWICH_H_
 
+#include "be/bed/connection_pool.h"
 #include "be/bed/db.h"
+#include "be/bed/db_options.h"
 #include "be/bed/stmt.h"
 #include "be/bed/stmt_cache.h"
 #include "be/id.h"
 #include "pbj/_pbj.h"
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <thread>
 
 namespace pbj {
 namespace sw {
@@ -23,20 +29,58 @@ namespace sw {
 ///
 /// \brief  Represents a database file which can be used to access persistent
 ///         game data.
+/// \details Each sandwich has a primary connection (getDb() and
+///         getStmtCache()) which should only be used by one thread at a time,
+///         and a ConnectionPool of read-only connections which can be used to
+///         query the sandwich from worker threads in parallel.
+///
+///         Read-only sandwiches can be opened as snapshots, in which case the
+///         primary connection and the ConnectionPool both use an in-memory
+///         copy of the sandwich file.
+///
+///         Sandwiches may contain a manifest of the statements they are
+///         usually queried with (the sw_sandwich_queries table).  Those
+///         statements can be compiled into the primary connection's
+///         StmtCache on a background thread with startPrewarm().
 class Sandwich : public std::enable_shared_from_this<Sandwich>
 {
 public:
-    Sandwich(const std::string& path, bool read_only);
+    Sandwich(const std::string& path, bool read_only, bool snapshot = false, const std::string& vfs_name = std::string());
+    ~Sandwich();
 
     const Id& getId() const;
 
+    bool isSnapshot() const;
+    bool isSnapshotRequested() const;
+    std::chrono::microseconds getOpenTime() const;
+    sqlite3_int64 getResidentSize();
+
     db::Db& getDb();
     db::StmtCache& getStmtCache();
 
+    const db::DbOptions& getOptions(bool read_only) const;
+    db::ConnectionPool& getConnectionPool();
+
+    size_t prewarm();
+    void startPrewarm();
+    void waitForPrewarm();
+    size_t getPrewarmed() const;
+
 private:
     Id id_;
+    bool snapshot_;
+    bool snapshot_requested_;
+    std::chrono::microseconds open_time_;
+    std::string snapshot_uri_;  ///< Names the in-memory copy used by db_ and pool_ if this is a snapshot.
     db::Db db_;
     db::StmtCache stmt_cache_;
+    db::ConnectionPool pool_;
+    db::DbOptions read_only_options_;
+    db::DbOptions writable_options_;
+
+    std::thread prewarm_thread_;
+    std::atomic<bool> stop_prewarm_;
+    std::atomic<size_t> prewarmed_;
 
     Sandwich(const Sandwich&);
     void operator=(const Sandwich&);
@@ -9,19 +9,29 @@
 #define PBJ_SW_SANDWICH_OPEN_H_
 
 #include "pbj/sw/sandwich.h"
+#include "be/bed/async_writer.h"
 
+#include <future>
 #include <unordered_map>
 
 namespace pbj {
 namespace sw {
 
 void readDirectory(const std::string& path);
+std::vector<Id> pollModifiedSandwiches();
 
 std::vector<Id> getSandwichIds();
 
+void setSnapshot(const Id& id, bool snapshot);
+
 std::shared_ptr<Sandwich> open(const Id& id);
 std::shared_ptr<Sandwich> openWritable(const Id& id);
 
+std::shared_ptr<db::AsyncWriter> getWriter(const Id& id);
+std::shared_ptr<db::AsyncWriter> findWriter(const Id& id);
+
+std::future<void> saveQueryManifest(const Id& id);
+
 } // namespace pbj::sw
 } // namespace pbj
 
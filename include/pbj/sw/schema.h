@@ -0,0 +1,28 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/schema.h
+/// \author Benjamin Crist
+///
+/// \brief  Functions for creating and upgrading the tables in a sandwich.
+
+#ifndef PBJ_SW_SCHEMA_H_
+#define PBJ_SW_SCHEMA_H_
+
+#include "pbj/sw/sandwich.h"
+
+namespace pbj {
+namespace sw {
+
+int getSchemaVersion(db::Db& db);
+int getLatestSchemaVersion();
+
+int migrateSchema(Sandwich& sandwich);
+int migrateSchema(Sandwich& sandwich, int target_version);
+
+size_t checkQueryPlans(Sandwich& sandwich);
+
+U64 hashContent(const void* data, size_t size);
+
+} // namespace pbj::sw
+} // namespace pbj
+
+#endif
@@ -11,6 +11,8 @@
 #include "pbj/_math.h"
 #include "pbj/_pbj.h"
 
+#include <future>
+
 namespace pbj {
 namespace sw {
 
@@ -165,8 +167,8 @@ struct WindowSettings
 
 WindowSettings loadWindowSettings(sw::Sandwich& sandwich, const Id& id);
 
-bool saveWindowSettings(const WindowSettings& window_settings);
-bool updateSavedPosition(const WindowSettings& window_settings);
+std::future<void> saveWindowSettings(const WindowSettings& window_settings);
+std::future<void> updateSavedPosition(const WindowSettings& window_settings);
 WindowSettings revertWindowSettings(const sw::ResourceId& id);
 void truncateWindowSettingsHistory(const sw::ResourceId& id, int max_history_entries);
 
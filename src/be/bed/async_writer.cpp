@@ -0,0 +1,406 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/async_writer.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::AsyncWriter functions.
+
+#include "be/bed/async_writer.h"
+
+#include "be/bed/transaction.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  A job which has been submitted but not yet committed.
+struct AsyncWriter::Node
+{
+   Job job;
+   std::promise<void> promise;
+   std::chrono::steady_clock::time_point submitted;
+   Node* next;
+};
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Determines if an error was caused by another
+///         connection holding a lock on the database.
+bool isBusy(const Db::error& err)
+{
+   int code = err.code() & 0xFF;   // ignore extended result code
+   return code == SQLITE_BUSY || code == SQLITE_LOCKED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Atomically raises a maximum value.
+template <typename T>
+void updateMax(std::atomic<T>& max, T value)
+{
+   T current = max.load();
+   while (value > current && !max.compare_exchange_weak(current, value)) ;
+}
+
+} // namespace be::bed::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Opens a writable connection to the specified database file and
+///         starts the writer thread.
+///
+/// \details The connection is configured using DbOptions::writable().
+///
+/// \param  path The path to the database file.  It will be created if it
+///         does not exist.
+/// \throws Db::error if the database cannot be opened.
+AsyncWriter::AsyncWriter(const std::string& path)
+   : db_(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE),
+     stmt_cache_(db_),
+     head_(nullptr),
+     stopping_(false),
+     max_batch_size_(BE_BED_ASYNC_WRITER_DEFAULT_MAX_BATCH_SIZE),
+     queue_depth_(0),
+     max_queue_depth_(0),
+     jobs_(0),
+     failures_(0),
+     commits_(0),
+     retries_(0),
+     last_latency_(0),
+     max_latency_(0)
+{
+   DbOptions::writable().apply(db_);
+   thread_ = std::thread(&AsyncWriter::run_, this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Opens a writable connection to the specified database file,
+///         configures it, and starts the writer thread.
+///
+/// \param  path The path to the database file.  It will be created if it
+///         does not exist.
+/// \param  options The options to apply to the connection.
+/// \throws Db::error if the database cannot be opened or configured.
+AsyncWriter::AsyncWriter(const std::string& path, const DbOptions& options)
+   : db_(path, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE),
+     stmt_cache_(db_),
+     head_(nullptr),
+     stopping_(false),
+     max_batch_size_(BE_BED_ASYNC_WRITER_DEFAULT_MAX_BATCH_SIZE),
+     queue_depth_(0),
+     max_queue_depth_(0),
+     jobs_(0),
+     failures_(0),
+     commits_(0),
+     retries_(0),
+     last_latency_(0),
+     max_latency_(0)
+{
+   options.apply(db_);
+   thread_ = std::thread(&AsyncWriter::run_, this);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Commits all pending jobs, then stops the writer thread and closes
+///         the connection.
+///
+/// \details No jobs may be submitted once the destructor has been called.
+AsyncWriter::~AsyncWriter()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+   }
+   wake_.notify_one();
+   thread_.join();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Queues a job to be run on the writer thread.
+///
+/// \details This function never blocks on the writer thread or the database.
+///
+/// \param  job The job to run.  It must be safe to run the job more than once
+///         (see the AsyncWriter class documentation).
+/// \return A future which becomes ready when the job's changes have been
+///         committed, or holds the exception which caused the job to fail.
+std::future<void> AsyncWriter::submit(const Job& job)
+{
+   Node* node = new Node();
+   node->job = job;
+   node->submitted = std::chrono::steady_clock::now();
+   std::future<void> future(node->promise.get_future());
+
+   node->next = head_.load();
+   while (!head_.compare_exchange_weak(node->next, node)) ;
+
+   updateMax(max_queue_depth_, ++queue_depth_);
+
+   // Taking the mutex ensures the writer thread is either waiting or has not
+   // yet checked head_, so the notification cannot be lost.
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+   }
+   wake_.notify_one();
+
+   return future;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Blocks until all jobs submitted before flush() was called have
+///         been committed.
+///
+/// \details Must not be called from inside a job.
+void AsyncWriter::flush()
+{
+   submit([](Db&, StmtCache&) { }).wait();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Sets the maximum number of jobs which will be committed in a
+///         single transaction.
+///
+/// \param  max_batch_size The new maximum batch size.  If 0, the batch size
+///         will be 1.
+void AsyncWriter::setMaxBatchSize(size_t max_batch_size)
+{
+   max_batch_size_ = std::max(max_batch_size, size_t(1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the maximum number of jobs which will be committed in a
+///         single transaction.
+///
+/// \return The maximum batch size.
+size_t AsyncWriter::getMaxBatchSize() const
+{
+   return max_batch_size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of jobs which have been submitted but not yet
+///         committed.
+///
+/// \return The current queue depth.
+size_t AsyncWriter::getQueueDepth() const
+{
+   return queue_depth_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the largest queue depth seen since the statistics were
+///         last reset.
+///
+/// \return The maximum queue depth.
+size_t AsyncWriter::getMaxQueueDepth() const
+{
+   return max_queue_depth_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of jobs which have completed (successfully or
+///         not) since the statistics were last reset.
+///
+/// \return The number of completed jobs.
+size_t AsyncWriter::getJobs() const
+{
+   return jobs_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of jobs which have failed since the
+///         statistics were last reset.
+///
+/// \return The number of failed jobs.
+size_t AsyncWriter::getFailures() const
+{
+   return failures_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of batches which have been committed (or
+///         abandoned) since the statistics were last reset.
+///
+/// \return The number of transactions.
+size_t AsyncWriter::getCommits() const
+{
+   return commits_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of times a batch has been retried because the
+///         database was busy since the statistics were last reset.
+///
+/// \return The number of retries.
+size_t AsyncWriter::getRetries() const
+{
+   return retries_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the commit latency of the most recent batch.
+///
+/// \return The time from when the oldest job in the batch was submitted until
+///         the batch was committed.
+std::chrono::microseconds AsyncWriter::getLastLatency() const
+{
+   return std::chrono::microseconds(last_latency_.load());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the largest commit latency seen since the statistics
+///         were last reset.
+///
+/// \return The maximum commit latency.
+std::chrono::microseconds AsyncWriter::getMaxLatency() const
+{
+   return std::chrono::microseconds(max_latency_.load());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Resets all statistics (except the current queue depth) to 0.
+void AsyncWriter::resetStats()
+{
+   max_queue_depth_ = queue_depth_.load();
+   jobs_ = 0;
+   failures_ = 0;
+   commits_ = 0;
+   retries_ = 0;
+   last_latency_ = 0;
+   max_latency_ = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Writer thread function.
+///
+/// \details Waits for jobs to be submitted, then commits them in batches.
+///         Returns once the writer is stopping and there are no more pending
+///         jobs.
+void AsyncWriter::run_()
+{
+   std::vector<Node*> pending;   // oldest first
+
+   for (;;)
+   {
+      if (pending.empty())
+      {
+         std::unique_lock<std::mutex> lock(mutex_);
+         while (!head_.load() && !stopping_)
+            wake_.wait(lock);
+
+         if (!head_.load())
+            break;   // stopping, and nothing left to commit
+      }
+
+      take_(pending);
+
+      size_t size = std::min(pending.size(), max_batch_size_.load());
+      commit_(&pending[0], size);
+      pending.erase(pending.begin(), pending.begin() + size);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Removes all submitted jobs from the lock-free list and appends
+///         them to the pending list in submission order.
+///
+/// \param  pending The writer thread's list of pending jobs.
+void AsyncWriter::take_(std::vector<Node*>& pending)
+{
+   Node* node = head_.exchange(nullptr);
+
+   size_t first = pending.size();
+   for (; node; node = node->next)
+      pending.push_back(node);
+
+   std::reverse(pending.begin() + first, pending.end());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Runs a batch of jobs in a single transaction and completes their
+///         futures.
+///
+/// \param  batch The jobs to run, in submission order.
+/// \param  size The number of jobs in the batch.
+void AsyncWriter::commit_(Node** batch, size_t size)
+{
+   std::vector<std::exception_ptr> errors(size);
+   std::chrono::milliseconds backoff(1);
+
+   for (int attempt = 0; ; ++attempt)
+   {
+      try
+      {
+         Transaction transaction(db_, Transaction::Immediate);
+         for (size_t i = 0; i < size; ++i)
+         {
+            errors[i] = std::exception_ptr();
+            db_.exec("SAVEPOINT be_async_writer_job");
+            try
+            {
+               batch[i]->job(db_, stmt_cache_);
+            }
+            catch (const Db::error& err)
+            {
+               if (isBusy(err))
+                  throw;   // retry the whole batch
+
+               errors[i] = std::current_exception();
+            }
+            catch (...)
+            {
+               errors[i] = std::current_exception();
+            }
+
+            if (errors[i])
+               db_.exec("ROLLBACK TO be_async_writer_job");
+            db_.exec("RELEASE be_async_writer_job");
+         }
+         transaction.commit();
+         break;
+      }
+      catch (const Db::error& err)
+      {
+         if (isBusy(err) && attempt < BE_BED_ASYNC_WRITER_MAX_RETRIES)
+         {
+            ++retries_;
+            std::this_thread::sleep_for(backoff);
+            backoff *= 2;
+            continue;
+         }
+
+         // the batch could not be committed, so every job failed
+         for (size_t i = 0; i < size; ++i)
+            errors[i] = std::current_exception();
+         break;
+      }
+   }
+
+   long long latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - batch[0]->submitted).count();
+   last_latency_ = latency;
+   updateMax(max_latency_, latency);
+   ++commits_;
+
+   for (size_t i = 0; i < size; ++i)
+   {
+      Node* node = batch[i];
+      ++jobs_;
+      --queue_depth_;
+
+      if (errors[i])
+      {
+         ++failures_;
+         node->promise.set_exception(std::move(errors[i]));
+      }
+      else
+         node->promise.set_value();
+
+      delete node;
+   }
+}
+
+} // namespace be::bed
+} // namespace be
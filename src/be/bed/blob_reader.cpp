@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/blob_reader.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::BlobReader functions.
+
+#include "be/bed/blob_reader.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Opens a blob for reading.
+///
+/// \details The blob is identified by its table, column, and the rowid of the
+///         row containing it.  For tables with an INTEGER PRIMARY KEY, the
+///         rowid is the same as the primary key.
+///
+/// \param  db The database containing the blob.
+/// \param  table The name of the table containing the blob.
+/// \param  column The name of the column containing the blob.
+/// \param  rowid The rowid of the row containing the blob.
+BlobReader::BlobReader(Db& db, const char* table, const char* column, sqlite3_int64 rowid)
+   : db_(db),
+     blob_(nullptr),
+     size_(0),
+     offset_(0)
+{
+   if (sqlite3_blob_open(db.db_, "main", table, column, rowid, 0, &blob_) != SQLITE_OK)
+   {
+      Db::error e(sqlite3_errmsg(db.db_));
+      sqlite3_blob_close(blob_);
+      throw e;
+   }
+
+   size_ = sqlite3_blob_bytes(blob_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Closes the blob.
+BlobReader::~BlobReader()
+{
+   sqlite3_blob_close(blob_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Moves the reader to the same column of a different row in the same
+///         table.
+///
+/// \details This is faster than opening a new BlobReader.  The read position
+///         is reset to the start of the new blob.
+///
+/// \param  rowid The rowid of the row containing the new blob.
+void BlobReader::reopen(sqlite3_int64 rowid)
+{
+   offset_ = 0;
+   size_ = 0;
+
+   if (sqlite3_blob_reopen(blob_, rowid) != SQLITE_OK)
+      throw Db::error(sqlite3_errmsg(db_.db_));
+
+   size_ = sqlite3_blob_bytes(blob_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the size of the blob.
+///
+/// \return The total number of bytes in the blob.
+int BlobReader::size() const
+{
+   return size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the current read position.
+///
+/// \return The number of bytes between the start of the blob and the next
+///         byte which will be read.
+int BlobReader::tell() const
+{
+   return offset_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if the entire blob has been read.
+///
+/// \return \c true if there are no more bytes to read.
+bool BlobReader::eof() const
+{
+   return offset_ >= size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads the next chunk of the blob.
+///
+/// \details Fewer bytes than requested will be read if the end of the blob is
+///         reached.
+///
+/// \param  dest The buffer to read into.  Must be at least \c bytes long.
+/// \param  bytes The maximum number of bytes to read.
+/// \return The number of bytes actually read.
+int BlobReader::read(void* dest, int bytes)
+{
+   assert(bytes >= 0);
+   bytes = std::min(bytes, size_ - offset_);
+   if (bytes <= 0)
+      return 0;
+
+   if (sqlite3_blob_read(blob_, dest, bytes, offset_) != SQLITE_OK)
+      throw Db::error(sqlite3_errmsg(db_.db_));
+
+   offset_ += bytes;
+   return bytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Advances the read position without reading any data.
+///
+/// \details The read position will not be moved past the end of the blob.
+///         Negative values move the read position backwards, but not before
+///         the start of the blob.
+///
+/// \param  bytes The number of bytes to skip.
+/// \return The number of bytes actually skipped.
+int BlobReader::skip(int bytes)
+{
+   int old_offset = offset_;
+   seek(offset_ + bytes);
+   return offset_ - old_offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Sets the read position.
+///
+/// \param  offset The new read position, in bytes from the start of the
+///         blob.  It will be clamped to the size of the blob.
+void BlobReader::seek(int offset)
+{
+   offset_ = std::max(0, std::min(offset, size_));
+}
+
+} // namespace be::bed
+} // namespace be
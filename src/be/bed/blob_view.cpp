@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/blob_view.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::BlobView functions.
+
+#include "be/bed/blob_view.h"
+
+#include "be/bed/stmt.h"
+
+#include <cassert>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an empty BlobView which does not refer to any
+///         statement.
+BlobView::BlobView()
+   : row_(0),
+     from_stmt_(false),
+     data_(nullptr),
+     size_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a BlobView referring to memory owned by the current row
+///         of a statement.
+///
+/// \param  stmt The statement whose current row contains the blob.
+/// \param  data A pointer to the first byte of the blob.
+/// \param  size The number of bytes in the blob.
+BlobView::BlobView(const Stmt& stmt, const void* data, size_t size)
+   : stmt_row_(stmt.row_),
+     row_(*stmt.row_),
+     from_stmt_(true),
+     data_(data),
+     size_(size)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns a pointer to the blob's data.
+///
+/// \note   The statement the BlobView was created from must still exist and
+///         be on the same row.
+///
+/// \return A pointer to the first byte of the blob, or nullptr if the blob is
+///         empty or NULL.
+const void* BlobView::data() const
+{
+   assert(valid());
+   return data_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the size of the blob.
+///
+/// \return The number of bytes in the blob.
+size_t BlobView::size() const
+{
+   return size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if the blob contains any data.
+///
+/// \return \c true if the blob is empty or NULL.
+bool BlobView::empty() const
+{
+   return size_ == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if the memory referred to by this BlobView can still be
+///         accessed.
+///
+/// \return \c true if the BlobView was default-constructed, or the statement
+///         it was created from still exists and has not been stepped or
+///         reset since.
+bool BlobView::valid() const
+{
+   if (!from_stmt_)
+      return true;
+
+   std::shared_ptr<const unsigned int> row(stmt_row_.lock());
+   return row && *row == row_;
+}
+
+} // namespace be::bed
+} // namespace be
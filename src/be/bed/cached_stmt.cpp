@@ -25,7 +25,9 @@ namespace bed {
 /// \param  other The CachedStmt to move.
 CachedStmt::CachedStmt(CachedStmt&& other)
    : cache_(other.cache_),
-     stmt_(other.stmt_)
+     entry_(other.entry_),
+     stmt_(other.stmt_),
+     held_(other.held_)
 {
    other.cache_ = nullptr;
 }
@@ -37,7 +39,12 @@ CachedStmt::CachedStmt(CachedStmt&& other)
 CachedStmt::~CachedStmt()
 {
    if (cache_)
-      cache_->release_(stmt_);
+   {
+      if (held_ != std::chrono::high_resolution_clock::time_point() && isQueryProfilingEnabled())
+         stmt_.getProfile_().held_ns += detail::getQueryProfileNanoseconds(std::chrono::high_resolution_clock::now() - held_);
+
+      cache_->release_(entry_);
+   }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -279,6 +286,13 @@ int CachedStmt::getBlob(int column, const void*& dest)
    return stmt_.getBlob(column, dest);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \copydoc   Stmt::getBlobView(int)
+BlobView CachedStmt::getBlobView(int column)
+{
+   return stmt_.getBlobView(column);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \copydoc   Stmt::getColor(int)
 glm::vec4 CachedStmt::getColor(int column)
@@ -289,14 +303,22 @@ glm::vec4 CachedStmt::getColor(int column)
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Constructs a CachedStmt.
 ///
-/// \details Called from StmtCache to create cached stmts.
+/// \details Called from StmtCache to create cached stmts.  If the query
+///         profiler is enabled, the hold is counted and timed.
 ///
 /// \param  cache The StmtCache that manages this cached statement.
-/// \param  stmt The Stmt object which should be used for all accesses.
-CachedStmt::CachedStmt(StmtCache* cache, Stmt& stmt)
+/// \param  entry The cache entry owning the Stmt object which should be used
+///         for all accesses.
+CachedStmt::CachedStmt(StmtCache* cache, detail::StmtCacheEntry& entry)
    : cache_(cache),
-     stmt_(stmt)
-{
+     entry_(entry),
+     stmt_(*entry.stmt)
+{
+   if (isQueryProfilingEnabled())
+   {
+      ++stmt_.getProfile_().holds;
+      held_ = std::chrono::high_resolution_clock::now();
+   }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/connection_pool.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::ConnectionPool functions.
+
+#include "be/bed/connection_pool.h"
+
+#include <cassert>
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a pool of read-only connections to a database file.
+///
+/// \details No connections are opened until acquire() is called.
+///
+/// \param  path The path to the database file.
+/// \param  capacity The maximum number of connections which will be opened.
+///         If 0, the pool will have a capacity of 1.
+ConnectionPool::ConnectionPool(const std::string& path, size_t capacity)
+   : path_(path),
+     flags_(SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX),
+     capacity_(capacity > 0 ? capacity : 1),
+     size_(0),
+     held_size_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a pool of connections to a database file, using a
+///         custom sqlite3_open_v2() flag bitfield.
+///
+/// \details No connections are opened until acquire() is called.
+///
+/// \param  path The path to the database file.
+/// \param  capacity The maximum number of connections which will be opened.
+///         If 0, the pool will have a capacity of 1.
+/// \param  flags A set of sqlite3_open_v2() flags used to open each
+///         connection.
+ConnectionPool::ConnectionPool(const std::string& path, size_t capacity, int flags)
+   : path_(path),
+     flags_(flags),
+     capacity_(capacity > 0 ? capacity : 1),
+     size_(0),
+     held_size_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a pool of connections to a database file, using a
+///         custom sqlite3_open_v2() flag bitfield and VFS module.
+///
+/// \details No connections are opened until acquire() is called.
+///
+/// \param  path The path to the database file.
+/// \param  capacity The maximum number of connections which will be opened.
+///         If 0, the pool will have a capacity of 1.
+/// \param  flags A set of sqlite3_open_v2() flags used to open each
+///         connection.
+/// \param  vfs_name The name of the VFS module used by each connection.  If
+///         empty, the default VFS is used.
+ConnectionPool::ConnectionPool(const std::string& path, size_t capacity, int flags, const std::string& vfs_name)
+   : path_(path),
+     flags_(flags),
+     vfs_name_(vfs_name),
+     capacity_(capacity > 0 ? capacity : 1),
+     size_(0),
+     held_size_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destroys the pool, closing all of its connections.
+///
+/// \details All PooledDb objects acquired from the pool must be destroyed
+///         before the pool.
+ConnectionPool::~ConnectionPool()
+{
+   assert(held_size_ == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the path of the database file the pool's connections
+///         refer to.
+///
+/// \return The database path.
+const std::string& ConnectionPool::getPath() const
+{
+   return path_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the name of the VFS module the pool's connections use.
+///
+/// \return The VFS name, or an empty string if the default VFS is used.
+const std::string& ConnectionPool::getVfsName() const
+{
+   return vfs_name_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the maximum number of connections the pool will open.
+///
+/// \return The pool's capacity.
+size_t ConnectionPool::getCapacity() const
+{
+   return capacity_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Sets the options which will be applied to each new connection.
+///
+/// \details Connections which have already been opened are not affected.
+///
+/// \param  options The options to apply to new connections.
+void ConnectionPool::setOptions(const DbOptions& options)
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   options_ = options;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the options which are applied to each new connection.
+///
+/// \return The pool's DbOptions.
+DbOptions ConnectionPool::getOptions()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return options_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of connections which have been opened.
+///
+/// \return The number of open connections.
+size_t ConnectionPool::getSize()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return entries_.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of connections which are currently checked
+///         out.
+///
+/// \return The number of held connections.
+size_t ConnectionPool::getHeldSize()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return held_size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Checks out a connection from the pool.
+///
+/// \details If there is an unheld connection, the most recently released one
+///         is returned.  Otherwise, if the pool is not at capacity, a new
+///         connection is opened.  Otherwise, the calling thread blocks until
+///         another thread releases a connection.
+///
+///         New connections are opened without holding the pool's mutex, so
+///         other threads may continue to acquire and release connections
+///         in the meantime.
+///
+/// \return A PooledDb handle which returns the connection to the pool when
+///         it is destroyed.
+/// \throws Db::error if a new connection must be opened and it cannot be, or
+///         the pool's options cannot be applied to it.
+PooledDb ConnectionPool::acquire()
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+
+   while (free_.empty() && size_ >= capacity_)
+      released_.wait(lock);
+
+   if (!free_.empty())
+   {
+      detail::ConnectionPoolEntry* entry = free_.back();
+      free_.pop_back();
+      entry->held = true;
+      ++held_size_;
+      return PooledDb(this, *entry);
+   }
+
+   ++size_;
+   DbOptions options(options_);
+   lock.unlock();
+
+   std::unique_ptr<detail::ConnectionPoolEntry> entry;
+   try
+   {
+      entry.reset(new detail::ConnectionPoolEntry(path_, flags_, vfs_name_, options));
+   }
+   catch (...)
+   {
+      lock.lock();
+      --size_;
+      lock.unlock();
+      released_.notify_one();
+      throw;
+   }
+
+   lock.lock();
+   detail::ConnectionPoolEntry& ref = *entry;
+   entries_.push_back(std::move(entry));
+   ref.held = true;
+   ++held_size_;
+   return PooledDb(this, ref);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns a connection to the pool.
+///
+/// \details Called when a PooledDb object is destroyed.
+///
+/// \param  entry The entry representing the connection being released.
+void ConnectionPool::release_(detail::ConnectionPoolEntry& entry)
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      assert(entry.held);
+      entry.held = false;
+      --held_size_;
+      free_.push_back(&entry);
+   }
+   released_.notify_one();
+}
+
+} // namespace be::bed
+} // namespace be
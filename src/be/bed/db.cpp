@@ -70,10 +70,11 @@ Db::Db(const std::string& path, int flags)
 ///
 /// \param  path The path to the database file.
 /// \param  flags A set of sqlite3_open_v2() flags.
-/// \param  vfs_name The name of the VFS module to use for low level I/O.
+/// \param  vfs_name The name of the VFS module to use for low level I/O.  If
+///         empty, the default VFS is used.
 Db::Db(const std::string& path, int flags, const std::string& vfs_name)
 {
-   if (sqlite3_open_v2(path.c_str(), &db_, flags, vfs_name.c_str()) != SQLITE_OK)
+   if (sqlite3_open_v2(path.c_str(), &db_, flags, vfs_name.empty() ? nullptr : vfs_name.c_str()) != SQLITE_OK)
    {
       error e(sqlite3_errmsg(db_));
       sqlite3_close(db_);
@@ -90,7 +91,10 @@ Db::Db(const std::string& path, int flags, const std::string& vfs_name)
 ///         than Db objects.
 Db::~Db()
 {
-   assert(sqlite3_next_stmt(db_, NULL) == NULL);
+   // sqlite3_next_stmt() can't be used to check for leaked statements here:
+   // virtual tables (eg. R*Tree indexes) keep statements of their own until
+   // the connection is closed.  sqlite3_close() disconnects them before
+   // failing with SQLITE_BUSY if any of our statements are left.
    int result = sqlite3_close(db_);
    assert(result == SQLITE_OK);
 }
@@ -134,6 +138,52 @@ void Db::vacuum()
    exec("VACUUM");
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Copies the entire contents of this database into another
+///         database, replacing its current contents.
+///
+/// \details Uses SQLite's [Online Backup
+///         API](http://www.sqlite.org/backup.html) to copy every page of the
+///         main database in a single step.  The most common use is to copy a
+///         read-only database file into an in-memory database (constructed
+///         with Db()) so that later queries never touch the file.
+///
+///         No other connection may be using the destination database while
+///         the backup is performed.
+///
+/// \param  destination The database to overwrite.
+void Db::backup(Db& destination)
+{
+   sqlite3_backup* backup = sqlite3_backup_init(destination.db_, "main", db_, "main");
+   if (!backup)
+      throw error(sqlite3_errmsg(destination.db_), sqlite3_errcode(destination.db_));
+
+   int result = sqlite3_backup_step(backup, -1);
+   sqlite3_backup_finish(backup);
+
+   if (result != SQLITE_DONE)
+      throw error(sqlite3_errstr(result), result);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the approximate number of bytes of heap memory used by
+///         this connection's page cache.
+///
+/// \details For an in-memory database, every page lives in the page cache, so
+///         this is the resident size of the whole database.
+///
+/// \return The page cache memory used, in bytes.
+sqlite3_int64 Db::getCacheUsed()
+{
+   int current = 0;
+   int highwater = 0;
+   int result = sqlite3_db_status(db_, SQLITE_DBSTATUS_CACHE_USED, &current, &highwater, 0);
+   if (result != SQLITE_OK)
+      throw error(sqlite3_errstr(result), result);
+
+   return current;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Compiles & executes one or more SQL queries on the database,
 ///         discarding any result sets that may be returned.
@@ -146,13 +196,17 @@ void Db::exec(const std::string& sql)
    if (result != SQLITE_OK)
    {
       if (err)
-         throw error(err);
+      {
+         error e(err, result);
+         sqlite3_free(err);
+         throw e;
+      }
       else
 #if defined(_MSC_VER) && _MSC_VER <= 1600
          // VC10 doesn't include std::to_string(int)
-         throw error("sqlite3_exec() returned " + std::to_string(static_cast<_Longlong>(result)));
+         throw error("sqlite3_exec() returned " + std::to_string(static_cast<_Longlong>(result)), result);
 #else
-         throw error("sqlite3_exec() returned " + std::to_string(result));
+         throw error("sqlite3_exec() returned " + std::to_string(result), result);
 #endif
    }
 }
@@ -178,5 +232,30 @@ int Db::getInt(const std::string& sql, int default_value)
    return default_value;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Asks SQLite how it would execute an SQL query.
+///
+/// \details The query is compiled with EXPLAIN QUERY PLAN but never executed,
+///         so parameters do not need to be bound.  Each line of the plan
+///         describes one step, for instance
+///         "SEARCH t USING COVERING INDEX t_idx (a=?)" or "SCAN t", the
+///         latter indicating that every row of the table will be visited.
+///
+/// \param  sql The statement to explain.
+/// \return The detail text of each step of the query plan, in order.
+std::vector<std::string> Db::getQueryPlan(const std::string& sql)
+{
+   std::vector<std::string> plan;
+
+   Stmt stmt(*this, Id(), "EXPLAIN QUERY PLAN " + sql);
+   while (stmt.step())
+   {
+      const char* detail = stmt.getText(3);
+      plan.push_back(detail ? detail : "");
+   }
+
+   return plan;
+}
+
 } // namespace be::bed
 } // namespace be
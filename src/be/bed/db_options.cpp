@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/db_options.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::DbOptions functions.
+
+#include "be/bed/db_options.h"
+
+#include "be/bed/db.h"
+
+#include <cctype>
+
+namespace be {
+namespace bed {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Determines if a string can safely be used as
+///         the value of a PRAGMA statement.
+bool isValidValue(const std::string& value)
+{
+   if (value.empty())
+      return false;
+
+   for (size_t i = 0; i < value.length(); ++i)
+   {
+      unsigned char c = static_cast<unsigned char>(value[i]);
+      if (!(isalnum(c) || c == '_' || (c == '-' && i == 0)))
+         return false;
+   }
+
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Executes a PRAGMA statement if the value is
+///         not empty.
+void applyPragma(Db& db, const char* pragma, const std::string& value)
+{
+   if (value.empty())
+      return;
+
+   if (!isValidValue(value))
+      throw Db::error(std::string("Invalid value for PRAGMA ") + pragma + ": " + value);
+
+   db.exec(std::string("PRAGMA ") + pragma + " = " + value);
+}
+
+} // namespace be::bed::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the default options for read-only connections.
+///
+/// \details Read-only connections use memory-mapped I/O (up to 256 MiB) and
+///         an 8 MiB page cache.  The journal mode cannot be changed from a
+///         read-only connection, and synchronous has no effect, so they are
+///         left unset.
+///
+/// \return The default read-only DbOptions.
+DbOptions DbOptions::readOnly()
+{
+   DbOptions options;
+   options.locking_mode = "NORMAL";
+   options.cache_size = "-8192";
+   options.mmap_size = "268435456";
+   return options;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the default options for writable connections.
+///
+/// \details Writable connections use write-ahead logging with
+///         synchronous = NORMAL, so that committing a transaction does not
+///         require syncing the database file, and readers are not blocked
+///         while a write is in progress.  They also use memory-mapped I/O and
+///         an 8 MiB page cache.  Note that WAL mode is persistent; once
+///         applied, all future connections to the file will use it.
+///
+/// \return The default writable DbOptions.
+DbOptions DbOptions::writable()
+{
+   DbOptions options;
+   options.locking_mode = "NORMAL";
+   options.journal_mode = "WAL";
+   options.synchronous = "NORMAL";
+   options.cache_size = "-8192";
+   options.mmap_size = "268435456";
+   return options;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Sets the value of an option by name.
+///
+/// \param  pragma The name of the option (and PRAGMA) to set.
+/// \param  value The new value of the option.  An empty value causes the
+///         option not to be applied.
+/// \return \c false if the option name is not recognized or the value is not
+///         valid, in which case the options are not modified.
+bool DbOptions::set(const std::string& pragma, const std::string& value)
+{
+   if (!value.empty() && !isValidValue(value))
+      return false;
+
+   if (pragma == "locking_mode")
+      locking_mode = value;
+   else if (pragma == "journal_mode")
+      journal_mode = value;
+   else if (pragma == "synchronous")
+      synchronous = value;
+   else if (pragma == "cache_size")
+      cache_size = value;
+   else if (pragma == "mmap_size")
+      mmap_size = value;
+   else
+      return false;
+
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Executes a PRAGMA statement on a connection for each non-empty
+///         option.
+///
+/// \details locking_mode is applied before journal_mode, since WAL mode
+///         behaves differently when exclusive locking is used.  Changing the
+///         journal mode requires that no other connection is reading the
+///         database.
+///
+/// \param  db The connection to configure.
+/// \throws Db::error if an option has an invalid value or a PRAGMA fails.
+void DbOptions::apply(Db& db) const
+{
+   applyPragma(db, "locking_mode", locking_mode);
+   applyPragma(db, "journal_mode", journal_mode);
+   applyPragma(db, "synchronous", synchronous);
+   applyPragma(db, "cache_size", cache_size);
+   applyPragma(db, "mmap_size", mmap_size);
+}
+
+} // namespace be::bed
+} // namespace be
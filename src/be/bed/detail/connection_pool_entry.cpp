@@ -0,0 +1,33 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/connection_pool_entry.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::detail::ConnectionPoolEntry functions.
+
+#include "be/bed/detail/connection_pool_entry.h"
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Opens a new connection to the specified database file.
+///
+/// \details The new entry is not held.
+///
+/// \param  path The path to the database file.
+/// \param  flags A set of sqlite3_open_v2() flags.
+/// \param  vfs_name The VFS module to use, or an empty string for the
+///         default VFS.
+/// \param  options The options to apply to the new connection.
+ConnectionPoolEntry::ConnectionPoolEntry(const std::string& path, int flags, const std::string& vfs_name, const DbOptions& options)
+   : held(false),
+     db(path, flags, vfs_name),
+     stmt_cache(db)
+{
+   options.apply(db);
+}
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
@@ -6,6 +6,8 @@
 
 #include "be/bed/detail/db_error.h"
 
+#include "sqlite3.h"
+
 namespace be {
 namespace bed {
 namespace detail {
@@ -15,7 +17,8 @@ namespace detail {
 ///
 /// \param  what_arg A description of the problem that caused the exception.
 db_error::db_error(const std::string& what_arg)
-   : std::runtime_error(what_arg)
+   : std::runtime_error(what_arg),
+     code_(SQLITE_ERROR)
 {
 }
 
@@ -24,7 +27,8 @@ db_error::db_error(const std::string& what_arg)
 ///
 /// \param  what_arg A description of the problem that caused the exception.
 db_error::db_error(const char* what_arg)
-   : std::runtime_error(what_arg)
+   : std::runtime_error(what_arg),
+     code_(SQLITE_ERROR)
 {
 }
 
@@ -35,7 +39,8 @@ db_error::db_error(const char* what_arg)
 /// \param  sql The SQL statement related to the error.
 db_error::db_error(const std::string& what_arg, const std::string& sql)
    : std::runtime_error(what_arg),
-     sql_(sql)
+     sql_(sql),
+     code_(SQLITE_ERROR)
 {
 }
 
@@ -46,7 +51,33 @@ db_error::db_error(const std::string& what_arg, const std::string& sql)
 /// \param  sql The SQL statement related to the error.
 db_error::db_error(const char* what_arg, const char* sql)
    : std::runtime_error(what_arg),
-     sql_(sql)
+     sql_(sql),
+     code_(SQLITE_ERROR)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Construct a DB error with an SQLite result code.
+///
+/// \param  what_arg A description of the problem that caused the exception.
+/// \param  code The SQLite result code which caused the exception.
+db_error::db_error(const std::string& what_arg, int code)
+   : std::runtime_error(what_arg),
+     code_(code)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Construct a DB error with SQL text as context and an SQLite
+///         result code.
+///
+/// \param  what_arg A description of the problem that caused the exception.
+/// \param  sql The SQL statement related to the error.
+/// \param  code The SQLite result code which caused the exception.
+db_error::db_error(const std::string& what_arg, const std::string& sql, int code)
+   : std::runtime_error(what_arg),
+     sql_(sql),
+     code_(code)
 {
 }
 
@@ -60,6 +91,19 @@ const std::string& db_error::sql() const
    return sql_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the SQLite result code which caused the exception.
+///
+/// \details Callers can use this to detect transient errors like
+///         SQLITE_BUSY.  If no result code was provided when the exception
+///         was created, SQLITE_ERROR is returned.
+///
+/// \return The SQLite result code (possibly an extended result code).
+int db_error::code() const
+{
+   return code_;
+}
+
 } // namespace be::bed::detail
 } // namespace be::bed
 } // namespace be
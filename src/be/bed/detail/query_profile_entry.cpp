@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/query_profile_entry.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::detail::QueryProfileEntry functions.
+
+#include "be/bed/detail/query_profile_entry.h"
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a new entry with all counters set to 0.
+///
+/// \param  id The Id of the statements profiled by this entry.
+/// \param  sql The SQL text of the first statement with this Id.
+QueryProfileEntry::QueryProfileEntry(const Id& id, const char* sql)
+   : id(id),
+     sql(sql ? sql : ""),
+     compiles(0),
+     compile_ns(0),
+     steps(0),
+     rows(0),
+     blob_bytes(0),
+     step_ns(0),
+     holds(0),
+     held_ns(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Sets all counters to 0.
+void QueryProfileEntry::reset()
+{
+   compiles = 0;
+   compile_ns = 0;
+   steps = 0;
+   rows = 0;
+   blob_bytes = 0;
+   step_ns = 0;
+   holds = 0;
+   held_ns = 0;
+}
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
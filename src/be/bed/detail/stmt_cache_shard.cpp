@@ -0,0 +1,21 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/detail/stmt_cache_shard.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::detail::StmtCacheShard functions.
+
+#include "be/bed/detail/stmt_cache_shard.h"
+
+namespace be {
+namespace bed {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an empty shard.
+StmtCacheShard::StmtCacheShard()
+{
+}
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
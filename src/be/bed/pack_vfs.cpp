@@ -0,0 +1,662 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/pack_vfs.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::PackVfs functions.
+
+#include "be/bed/pack_vfs.h"
+
+#include "be/bed/db.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Pack file layout (all integers are little-endian):
+//
+//    char[8]     magic ("PBJPACK" followed by a null character)
+//    uint32_t    format version (1)
+//    uint32_t    number of entries
+//    for each entry:
+//       uint64_t offset of the image from the start of the file
+//       uint64_t size of the image in bytes
+//       uint32_t length of the name in bytes
+//       char     name[length] (not null-terminated)
+//    image data, each image starting on a 4 KiB boundary
+
+namespace be {
+namespace bed {
+namespace {
+
+const char pack_magic[8] = { 'P', 'B', 'J', 'P', 'A', 'C', 'K', '\0' };
+const uint32_t pack_version = 1;
+const uint64_t pack_alignment = 4096;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  An open database image.
+///
+/// \details SQLite allocates vfs.szOsFile bytes for each file, which is large
+///         enough for either a PackFile or a file opened by the base VFS.
+struct PackFile
+{
+   sqlite3_file base;
+   const char* data;
+   sqlite3_int64 size;
+};
+
+PackVfs* getPack(sqlite3_vfs* vfs)
+{
+   return static_cast<PackVfs*>(vfs->pAppData);
+}
+
+sqlite3_vfs* getBase(sqlite3_vfs* vfs)
+{
+   return getPack(vfs)->getBaseVfs();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// sqlite3_io_methods for images in the pack
+
+int fileClose(sqlite3_file*)
+{
+   return SQLITE_OK;
+}
+
+int fileRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset)
+{
+   PackFile* f = reinterpret_cast<PackFile*>(file);
+
+   sqlite3_int64 available = std::max(sqlite3_int64(0), std::min(sqlite3_int64(amount), f->size - offset));
+   if (available > 0)
+      memcpy(buffer, f->data + offset, size_t(available));
+
+   if (available < amount)
+   {
+      // SQLite requires that the unread part of the buffer be zeroed
+      memset(static_cast<char*>(buffer) + available, 0, size_t(amount - available));
+      return SQLITE_IOERR_SHORT_READ;
+   }
+
+   return SQLITE_OK;
+}
+
+int fileWrite(sqlite3_file*, const void*, int, sqlite3_int64)
+{
+   return SQLITE_READONLY;
+}
+
+int fileTruncate(sqlite3_file*, sqlite3_int64)
+{
+   return SQLITE_READONLY;
+}
+
+int fileSync(sqlite3_file*, int)
+{
+   return SQLITE_OK;
+}
+
+int fileSize(sqlite3_file* file, sqlite3_int64* size)
+{
+   *size = reinterpret_cast<PackFile*>(file)->size;
+   return SQLITE_OK;
+}
+
+int fileLock(sqlite3_file*, int)
+{
+   return SQLITE_OK;
+}
+
+int fileCheckReservedLock(sqlite3_file*, int* result)
+{
+   *result = 0;
+   return SQLITE_OK;
+}
+
+int fileControl(sqlite3_file*, int, void*)
+{
+   return SQLITE_NOTFOUND;
+}
+
+int fileSectorSize(sqlite3_file*)
+{
+   return int(pack_alignment);
+}
+
+int fileDeviceCharacteristics(sqlite3_file*)
+{
+#ifdef SQLITE_IOCAP_IMMUTABLE
+   return SQLITE_IOCAP_IMMUTABLE;
+#else
+   return 0;
+#endif
+}
+
+int fileFetch(sqlite3_file* file, sqlite3_int64 offset, int amount, void** page)
+{
+   PackFile* f = reinterpret_cast<PackFile*>(file);
+
+   // Pages are served straight out of the pack's mapping, so there is nothing
+   // to do when SQLite is done with them.
+   if (offset >= 0 && offset + amount <= f->size)
+      *page = const_cast<char*>(f->data + offset);
+   else
+      *page = nullptr;
+
+   return SQLITE_OK;
+}
+
+int fileUnfetch(sqlite3_file*, sqlite3_int64, void*)
+{
+   return SQLITE_OK;
+}
+
+const sqlite3_io_methods pack_io_methods =
+{
+   3,                            // iVersion
+   fileClose,
+   fileRead,
+   fileWrite,
+   fileTruncate,
+   fileSync,
+   fileSize,
+   fileLock,
+   fileLock,                     // xUnlock
+   fileCheckReservedLock,
+   fileControl,
+   fileSectorSize,
+   fileDeviceCharacteristics,
+   nullptr,                      // xShmMap (WAL is not supported)
+   nullptr,                      // xShmLock
+   nullptr,                      // xShmBarrier
+   nullptr,                      // xShmUnmap
+   fileFetch,
+   fileUnfetch
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// sqlite3_vfs methods
+
+int vfsOpen(sqlite3_vfs* vfs, const char* name, sqlite3_file* file, int flags, int* out_flags)
+{
+   file->pMethods = nullptr;
+
+   if (name && (flags & SQLITE_OPEN_MAIN_DB))
+   {
+      const detail::PackEntry* entry = getPack(vfs)->find(name);
+      if (!entry)
+         return SQLITE_CANTOPEN;
+
+      PackFile* f = reinterpret_cast<PackFile*>(file);
+      f->data = entry->data;
+      f->size = entry->size;
+      f->base.pMethods = &pack_io_methods;
+
+      // Images are always opened read-only, even if read/write access was
+      // requested.
+      if (out_flags)
+         *out_flags = (flags & ~(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)) | SQLITE_OPEN_READONLY;
+
+      return SQLITE_OK;
+   }
+
+   if (!name || (flags & (SQLITE_OPEN_TEMP_DB | SQLITE_OPEN_TEMP_JOURNAL |
+                          SQLITE_OPEN_SUBJOURNAL | SQLITE_OPEN_TRANSIENT_DB)))
+   {
+      sqlite3_vfs* base = getBase(vfs);
+      return base->xOpen(base, name, file, flags, out_flags);
+   }
+
+   // journals and WAL files for images can't exist
+   return SQLITE_CANTOPEN;
+}
+
+int vfsDelete(sqlite3_vfs* vfs, const char* name, int sync_dir)
+{
+   if (getPack(vfs)->find(name))
+      return SQLITE_IOERR_DELETE;
+
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xDelete(base, name, sync_dir);
+}
+
+int vfsAccess(sqlite3_vfs* vfs, const char* name, int flags, int* result)
+{
+   // Only images exist; in particular there are never hot journals.
+   *result = flags != SQLITE_ACCESS_READWRITE && getPack(vfs)->find(name) ? 1 : 0;
+   return SQLITE_OK;
+}
+
+int vfsFullPathname(sqlite3_vfs*, const char* name, int size, char* full_name)
+{
+   sqlite3_snprintf(size, full_name, "%s", name);
+   return SQLITE_OK;
+}
+
+void* vfsDlOpen(sqlite3_vfs* vfs, const char* filename)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xDlOpen(base, filename);
+}
+
+void vfsDlError(sqlite3_vfs* vfs, int size, char* message)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   base->xDlError(base, size, message);
+}
+
+void (*vfsDlSym(sqlite3_vfs* vfs, void* library, const char* symbol))(void)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xDlSym(base, library, symbol);
+}
+
+void vfsDlClose(sqlite3_vfs* vfs, void* library)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   base->xDlClose(base, library);
+}
+
+int vfsRandomness(sqlite3_vfs* vfs, int size, char* buffer)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xRandomness(base, size, buffer);
+}
+
+int vfsSleep(sqlite3_vfs* vfs, int microseconds)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xSleep(base, microseconds);
+}
+
+int vfsCurrentTime(sqlite3_vfs* vfs, double* time)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xCurrentTime(base, time);
+}
+
+int vfsGetLastError(sqlite3_vfs* vfs, int size, char* message)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   return base->xGetLastError ? base->xGetLastError(base, size, message) : 0;
+}
+
+int vfsCurrentTimeInt64(sqlite3_vfs* vfs, sqlite3_int64* time)
+{
+   sqlite3_vfs* base = getBase(vfs);
+   if (base->iVersion >= 2 && base->xCurrentTimeInt64)
+      return base->xCurrentTimeInt64(base, time);
+
+   double days;
+   int result = base->xCurrentTime(base, &days);
+   *time = sqlite3_int64(days * 86400000.0);
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Reads a little-endian integer from the pack's
+///         directory, checking that it is within the mapped region.
+template <typename T>
+T readInteger(const char* data, size_t size, size_t& offset)
+{
+   if (offset + sizeof(T) > size)
+      throw Db::error("Pack directory is truncated!", SQLITE_CORRUPT);
+
+   T value = 0;
+   for (size_t i = 0; i < sizeof(T); ++i)
+      value |= T(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+
+   offset += sizeof(T);
+   return value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Writes a little-endian integer.
+template <typename T>
+void writeInteger(std::ostream& os, T value)
+{
+   char bytes[sizeof(T)];
+   for (size_t i = 0; i < sizeof(T); ++i)
+      bytes[i] = char((value >> (8 * i)) & 0xFF);
+
+   os.write(bytes, sizeof(T));
+}
+
+} // namespace be::bed::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Maps a pack file into memory and registers a VFS which can be
+///         used to open the images inside it.
+///
+/// \param  path The path to the pack file.
+/// \param  vfs_name The name to register the VFS under.  It must not be the
+///         name of any other VFS.
+///
+/// \throws Db::error if the pack can't be mapped, is not a valid pack file,
+///         or the VFS name is already in use.
+PackVfs::PackVfs(const std::string& path, const std::string& vfs_name)
+   : path_(path),
+     vfs_name_(vfs_name),
+     data_(nullptr),
+     size_(0),
+     base_(sqlite3_vfs_find(nullptr))
+{
+   if (!base_)
+      throw Db::error("No default VFS is available!", SQLITE_ERROR);
+
+   if (sqlite3_vfs_find(vfs_name_.c_str()))
+      throw Db::error("VFS name '" + vfs_name_ + "' is already in use!", SQLITE_ERROR);
+
+   map_();
+
+   try
+   {
+      readDirectory_();
+   }
+   catch (...)
+   {
+      unmap_();
+      throw;
+   }
+
+   memset(&vfs_, 0, sizeof(vfs_));
+   vfs_.iVersion = 2;
+   vfs_.szOsFile = std::max(int(sizeof(PackFile)), base_->szOsFile);
+   vfs_.mxPathname = base_->mxPathname;
+   vfs_.zName = vfs_name_.c_str();
+   vfs_.pAppData = this;
+   vfs_.xOpen = vfsOpen;
+   vfs_.xDelete = vfsDelete;
+   vfs_.xAccess = vfsAccess;
+   vfs_.xFullPathname = vfsFullPathname;
+   vfs_.xDlOpen = vfsDlOpen;
+   vfs_.xDlError = vfsDlError;
+   vfs_.xDlSym = vfsDlSym;
+   vfs_.xDlClose = vfsDlClose;
+   vfs_.xRandomness = vfsRandomness;
+   vfs_.xSleep = vfsSleep;
+   vfs_.xCurrentTime = vfsCurrentTime;
+   vfs_.xGetLastError = vfsGetLastError;
+   vfs_.xCurrentTimeInt64 = vfsCurrentTimeInt64;
+
+   int result = sqlite3_vfs_register(&vfs_, 0);
+   if (result != SQLITE_OK)
+   {
+      unmap_();
+      throw Db::error(sqlite3_errstr(result), result);
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Unregisters the VFS and unmaps the pack file.
+///
+/// \details All Db objects opened using this VFS must be destroyed first.
+PackVfs::~PackVfs()
+{
+   sqlite3_vfs_unregister(&vfs_);
+   unmap_();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the path of the pack file.
+///
+/// \return The pack file's path.
+const std::string& PackVfs::getPath() const
+{
+   return path_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the name of the registered VFS, which should be passed
+///         to Db's constructor when opening an image in this pack.
+///
+/// \return The VFS name.
+const std::string& PackVfs::getVfsName() const
+{
+   return vfs_name_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the size of the pack file.
+///
+/// \return The number of bytes mapped.
+size_t PackVfs::getSize() const
+{
+   return size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the names of all the images in the pack.
+///
+/// \return The image names, in no particular order.
+std::vector<std::string> PackVfs::getFilenames() const
+{
+   std::vector<std::string> filenames;
+   filenames.reserve(entries_.size());
+
+   for (auto i(entries_.begin()), end(entries_.end()); i != end; ++i)
+      filenames.push_back(i->first);
+
+   return filenames;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Looks up an image in the pack.
+///
+/// \param  filename The name of the image.
+/// \return The location of the image within the mapping, or nullptr if the
+///         pack does not contain an image with that name.
+const detail::PackEntry* PackVfs::find(const std::string& filename) const
+{
+   auto i(entries_.find(filename));
+   if (i == entries_.end())
+      return nullptr;
+
+   return &i->second;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the VFS used for temporary files and any other
+///         operations which don't involve the images in the pack.
+///
+/// \return The default VFS at the time the PackVfs was constructed.
+sqlite3_vfs* PackVfs::getBaseVfs() const
+{
+   return base_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Creates a pack file containing copies of one or more database
+///         files.
+///
+/// \details Each image is named after the filename portion of its path.  The
+///         databases should not be open for writing while they are packed.
+///         Databases which use write-ahead logging are marked as using a
+///         rollback journal in the pack, since images are immutable and
+///         SQLite would otherwise look for a WAL file.
+///
+/// \param  path The path of the pack file to create.  Any existing file will
+///         be overwritten.
+/// \param  files The paths of the database files to pack.
+///
+/// \throws Db::error if a file can't be read or the pack can't be written.
+void PackVfs::write(const std::string& path, const std::vector<std::string>& files)
+{
+   std::vector<std::string> names;
+   std::vector<std::string> images;
+   names.reserve(files.size());
+   images.reserve(files.size());
+
+   for (auto i(files.begin()), end(files.end()); i != end; ++i)
+   {
+      std::ifstream ifs(i->c_str(), std::ios::binary);
+      if (!ifs)
+         throw Db::error("Could not read '" + *i + "'!", SQLITE_CANTOPEN);
+
+      std::string image((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+      // file format write/read versions: 2 means WAL, 1 means legacy.
+      if (image.size() >= 20)
+      {
+         if (image[18] == 2) image[18] = 1;
+         if (image[19] == 2) image[19] = 1;
+      }
+
+      size_t separator = i->find_last_of("/\\");
+      names.push_back(separator == std::string::npos ? *i : i->substr(separator + 1));
+      images.push_back(std::move(image));
+   }
+
+   uint64_t directory_size = sizeof(pack_magic) + sizeof(uint32_t) + sizeof(uint32_t);
+   for (auto i(names.begin()), end(names.end()); i != end; ++i)
+      directory_size += sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t) + i->size();
+
+   std::ofstream ofs(path.c_str(), std::ios::binary | std::ios::trunc);
+   if (!ofs)
+      throw Db::error("Could not create '" + path + "'!", SQLITE_CANTOPEN);
+
+   ofs.write(pack_magic, sizeof(pack_magic));
+   writeInteger<uint32_t>(ofs, pack_version);
+   writeInteger<uint32_t>(ofs, uint32_t(names.size()));
+
+   std::vector<uint64_t> offsets;
+   uint64_t offset = directory_size;
+   for (size_t i = 0; i < names.size(); ++i)
+   {
+      offset = (offset + pack_alignment - 1) / pack_alignment * pack_alignment;
+      offsets.push_back(offset);
+
+      writeInteger<uint64_t>(ofs, offset);
+      writeInteger<uint64_t>(ofs, uint64_t(images[i].size()));
+      writeInteger<uint32_t>(ofs, uint32_t(names[i].size()));
+      ofs.write(names[i].data(), names[i].size());
+
+      offset += images[i].size();
+   }
+
+   uint64_t position = directory_size;
+   for (size_t i = 0; i < images.size(); ++i)
+   {
+      std::string padding(size_t(offsets[i] - position), '\0');
+      ofs.write(padding.data(), padding.size());
+      ofs.write(images[i].data(), images[i].size());
+      position = offsets[i] + images[i].size();
+   }
+
+   if (!ofs)
+      throw Db::error("Error writing '" + path + "'!", SQLITE_IOERR);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Maps the entire pack file into memory, read-only.
+void PackVfs::map_()
+{
+#ifdef _WIN32
+   HANDLE file = CreateFileA(path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+   if (file == INVALID_HANDLE_VALUE)
+      throw Db::error("Could not open pack '" + path_ + "'!", SQLITE_CANTOPEN);
+
+   LARGE_INTEGER file_size;
+   if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+   {
+      CloseHandle(file);
+      throw Db::error("Could not determine size of pack '" + path_ + "'!", SQLITE_IOERR);
+   }
+
+   // The view keeps the mapping (and the file) open after the handles are
+   // closed.
+   HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+   CloseHandle(file);
+   if (!mapping)
+      throw Db::error("Could not map pack '" + path_ + "'!", SQLITE_IOERR);
+
+   void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapping);
+   if (!view)
+      throw Db::error("Could not map pack '" + path_ + "'!", SQLITE_IOERR);
+
+   data_ = static_cast<const char*>(view);
+   size_ = size_t(file_size.QuadPart);
+#else
+   int fd = open(path_.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw Db::error("Could not open pack '" + path_ + "'!", SQLITE_CANTOPEN);
+
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size == 0)
+   {
+      close(fd);
+      throw Db::error("Could not determine size of pack '" + path_ + "'!", SQLITE_IOERR);
+   }
+
+   void* view = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (view == MAP_FAILED)
+      throw Db::error("Could not map pack '" + path_ + "'!", SQLITE_IOERR);
+
+   data_ = static_cast<const char*>(view);
+   size_ = size_t(st.st_size);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Unmaps the pack file.
+void PackVfs::unmap_()
+{
+   if (!data_)
+      return;
+
+#ifdef _WIN32
+   UnmapViewOfFile(data_);
+#else
+   munmap(const_cast<char*>(data_), size_);
+#endif
+
+   data_ = nullptr;
+   size_ = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads the pack's directory and validates the location of each
+///         image.
+void PackVfs::readDirectory_()
+{
+   if (size_ < sizeof(pack_magic) || memcmp(data_, pack_magic, sizeof(pack_magic)) != 0)
+      throw Db::error("'" + path_ + "' is not a pack file!", SQLITE_NOTADB);
+
+   size_t offset = sizeof(pack_magic);
+   uint32_t version = readInteger<uint32_t>(data_, size_, offset);
+   if (version != pack_version)
+      throw Db::error("Unsupported pack version!", SQLITE_NOTADB);
+
+   uint32_t count = readInteger<uint32_t>(data_, size_, offset);
+   for (uint32_t i = 0; i < count; ++i)
+   {
+      uint64_t image_offset = readInteger<uint64_t>(data_, size_, offset);
+      uint64_t image_size = readInteger<uint64_t>(data_, size_, offset);
+      uint32_t name_length = readInteger<uint32_t>(data_, size_, offset);
+
+      if (offset + name_length > size_ || image_offset > size_ || image_size > size_ - image_offset)
+         throw Db::error("Pack directory is corrupt!", SQLITE_CORRUPT);
+
+      detail::PackEntry entry;
+      entry.data = data_ + image_offset;
+      entry.size = sqlite3_int64(image_size);
+
+      entries_[std::string(data_ + offset, name_length)] = entry;
+      offset += name_length;
+   }
+}
+
+} // namespace be::bed
+} // namespace be
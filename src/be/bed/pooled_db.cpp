@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/pooled_db.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed::PooledDb functions.
+
+#include "be/bed/pooled_db.h"
+
+#include "be/bed/connection_pool.h"
+
+namespace be {
+namespace bed {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Move-constructs a PooledDb.
+///
+/// \details Moves the hold placed on a connection to a new object.  When the
+///         new object is destroyed, the connection will be returned to the
+///         pool it came from (but not when the first object is destroyed).
+///
+/// \param  other The PooledDb to move.
+PooledDb::PooledDb(PooledDb&& other)
+   : pool_(other.pool_),
+     entry_(other.entry_)
+{
+   other.pool_ = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Destructor.
+///
+/// \details Returns this connection to the pool it came from.
+PooledDb::~PooledDb()
+{
+   if (pool_)
+      pool_->release_(entry_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the connection which has been checked out.
+///
+/// \return The checked out database connection.
+Db& PooledDb::getDb()
+{
+   return entry_.db;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the statement cache associated with the connection
+///         which has been checked out.
+///
+/// \return The connection's StmtCache.
+StmtCache& PooledDb::getStmtCache()
+{
+   return entry_.stmt_cache;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Holds a statement from the connection's StmtCache.
+///
+/// \param  id The Id of the statement to hold.
+/// \param  sql The SQL text to compile if the cache does not contain an unheld
+///         statement with the specified Id.
+/// \return A CachedStmt representing the held statement.
+/// \sa     StmtCache::hold(const Id&, const char*)
+CachedStmt PooledDb::hold(const Id& id, const char* sql)
+{
+   return entry_.stmt_cache.hold(id, sql);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a PooledDb referring to a connection which has already
+///         been marked as held by the pool.
+///
+/// \param  pool The pool which owns the connection.
+/// \param  entry The pool entry representing the connection.
+PooledDb::PooledDb(ConnectionPool* pool, detail::ConnectionPoolEntry& entry)
+   : pool_(pool),
+     entry_(entry)
+{
+}
+
+} // namespace be::bed
+} // namespace be
@@ -0,0 +1,246 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/bed/query_profiler.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::bed query profiler functions.
+
+#include "be/bed/query_profiler.h"
+
+#include "be/id_map.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+namespace be {
+namespace bed {
+namespace detail {
+
+std::atomic<bool> query_profiling_enabled(false);
+
+} // namespace be::bed::detail
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Owns every QueryProfileEntry which has been
+///         created.
+struct QueryProfileRegistry
+{
+   QueryProfileRegistry() : print_at_exit(false) { }
+
+   std::mutex mutex;
+   IdMap<std::unique_ptr<detail::QueryProfileEntry> > entries;
+   bool print_at_exit;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Retrieves the registry, constructing it the
+///         first time it is needed.
+QueryProfileRegistry& getRegistry()
+{
+   static QueryProfileRegistry registry;
+   return registry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Writes the profiling report to the log when
+///         the program exits.
+void printAtExit()
+{
+   if (!getQueryProfiles().empty())
+      printQueryProfiles(BE_LOG_STREAM);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Converts a nanosecond count to microseconds.
+std::chrono::microseconds toMicroseconds(long long ns)
+{
+   return std::chrono::microseconds(ns / 1000);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Formats a duration as fractional milliseconds.
+double toMilliseconds(std::chrono::microseconds duration)
+{
+   return duration.count() / 1000.0;
+}
+
+} // namespace be::bed::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Calculates the total time spent compiling and executing the
+///         statement.
+///
+/// \return compile_time + step_time
+std::chrono::microseconds QueryProfile::getTotalTime() const
+{
+   return compile_time + step_time;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Enables or disables the query profiler.
+///
+/// \details While profiling is enabled, every Stmt and CachedStmt records
+///         its compile time, steps, rows, blob bytes retrieved, step time,
+///         and (for CachedStmts) hold time into a shared per-Id profile.
+///         Disabling the profiler does not discard the statistics collected
+///         so far.
+///
+///         The first time profiling is enabled, a report is scheduled to be
+///         written to #BE_LOG_STREAM when the program exits.
+///
+/// \param  enabled Determines whether statements should be profiled.
+void setQueryProfilingEnabled(bool enabled)
+{
+   if (enabled)
+   {
+      QueryProfileRegistry& registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      if (!registry.print_at_exit)
+      {
+         registry.print_at_exit = true;
+         std::atexit(printAtExit);
+      }
+   }
+
+   detail::query_profiling_enabled = enabled;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the statistics collected by the query profiler.
+///
+/// \details Statements which have not been compiled, stepped, or held since
+///         the profiler was last reset are omitted.
+///
+/// \return The profile of each statement Id, sorted by total time, with the
+///         most expensive statement first.
+std::vector<QueryProfile> getQueryProfiles()
+{
+   std::vector<QueryProfile> profiles;
+
+   QueryProfileRegistry& registry = getRegistry();
+   std::lock_guard<std::mutex> lock(registry.mutex);
+   profiles.reserve(registry.entries.size());
+   for (auto i(registry.entries.begin()), end(registry.entries.end()); i != end; ++i)
+   {
+      const detail::QueryProfileEntry& entry = *i->second;
+
+      QueryProfile profile;
+      profile.id = entry.id;
+      profile.sql = entry.sql;
+      profile.compiles = static_cast<size_t>(entry.compiles.load());
+      profile.compile_time = toMicroseconds(entry.compile_ns);
+      profile.steps = static_cast<size_t>(entry.steps.load());
+      profile.rows = static_cast<size_t>(entry.rows.load());
+      profile.blob_bytes = static_cast<sqlite3_uint64>(entry.blob_bytes.load());
+      profile.step_time = toMicroseconds(entry.step_ns);
+      profile.holds = static_cast<size_t>(entry.holds.load());
+      profile.held_time = toMicroseconds(entry.held_ns);
+
+      if (profile.compiles > 0 || profile.steps > 0 || profile.holds > 0)
+         profiles.push_back(profile);
+   }
+
+   std::sort(profiles.begin(), profiles.end(), [](const QueryProfile& a, const QueryProfile& b)
+   {
+      return a.getTotalTime() > b.getTotalTime();
+   });
+
+   return profiles;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Discards all statistics collected by the query profiler.
+void resetQueryProfiles()
+{
+   QueryProfileRegistry& registry = getRegistry();
+   std::lock_guard<std::mutex> lock(registry.mutex);
+   for (auto i(registry.entries.begin()), end(registry.entries.end()); i != end; ++i)
+      i->second->reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Writes a report of the statistics collected by the query profiler
+///         to a stream.
+///
+/// \details Each statement is written on a separate line, with the most
+///         expensive statement first.  Times are in milliseconds and blob
+///         data is in kilobytes.
+///
+/// \param  os The stream to write to.
+void printQueryProfiles(std::ostream& os)
+{
+   std::vector<QueryProfile> profiles(getQueryProfiles());
+
+   std::ios_base::fmtflags flags(os.flags());
+   std::streamsize precision(os.precision());
+
+   os << "Query profile (" << profiles.size() << " statements):" << std::endl
+      << std::setw(10) << "total ms"
+      << std::setw(12) << "compile ms"
+      << std::setw(10) << "compiles"
+      << std::setw(10) << "steps"
+      << std::setw(10) << "rows"
+      << std::setw(10) << "blob KB"
+      << std::setw(10) << "holds"
+      << std::setw(10) << "held ms"
+      << "  SQL" << std::endl;
+
+   os << std::fixed << std::setprecision(3);
+   for (auto i(profiles.begin()), end(profiles.end()); i != end; ++i)
+   {
+      os << std::setw(10) << toMilliseconds(i->getTotalTime())
+         << std::setw(12) << toMilliseconds(i->compile_time)
+         << std::setw(10) << i->compiles
+         << std::setw(10) << i->steps
+         << std::setw(10) << i->rows
+         << std::setw(10) << std::setprecision(1) << i->blob_bytes / 1024.0 << std::setprecision(3)
+         << std::setw(10) << i->holds
+         << std::setw(10) << toMilliseconds(i->held_time)
+         << "  " << i->sql << std::endl;
+   }
+
+   os.flags(flags);
+   os.precision(precision);
+}
+
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the profile entry for a statement Id, creating it if
+///         necessary.
+///
+/// \param  id The statement Id.
+/// \param  sql The SQL text to associate with the entry if it is created.
+/// \return The entry for the Id.  The reference remains valid until the
+///         program exits.
+QueryProfileEntry& getQueryProfileEntry(const Id& id, const char* sql)
+{
+   QueryProfileRegistry& registry = getRegistry();
+   std::lock_guard<std::mutex> lock(registry.mutex);
+
+   std::unique_ptr<QueryProfileEntry>& entry = registry.entries[id];
+   if (!entry)
+      entry.reset(new QueryProfileEntry(id, sql));
+
+   return *entry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Converts a duration to the nanosecond count stored in
+///         QueryProfileEntry objects.
+///
+/// \param  duration The duration to convert.
+/// \return The duration in nanoseconds.
+long long getQueryProfileNanoseconds(std::chrono::high_resolution_clock::duration duration)
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+} // namespace be::bed::detail
+} // namespace be::bed
+} // namespace be
@@ -6,6 +6,8 @@
 
 #include "be/bed/stmt.h"
 
+#include <chrono>
+
 namespace be {
 namespace bed {
    
@@ -20,10 +22,11 @@ namespace bed {
 /// \param  sql The SQL text of the statement to compile.
 Stmt::Stmt(Db& db, const std::string &sql)
    : db_(db),
-     id_(sql)
+     id_(sql),
+     row_(std::make_shared<unsigned int>(0)),
+     profile_(nullptr)
 {
-   if (sqlite3_prepare_v2(db.db_, sql.c_str(), sql.length() + 1, &stmt_, nullptr) != SQLITE_OK)
-      throw Db::error(sqlite3_errmsg(db.db_), sql.c_str());
+   prepare_(sql);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,10 +38,11 @@ Stmt::Stmt(Db& db, const std::string &sql)
 /// \param  sql The SQL text of the statement to compile.
 Stmt::Stmt(Db& db, const Id& id, const std::string &sql)
    : db_(db),
-     id_(id)
+     id_(id),
+     row_(std::make_shared<unsigned int>(0)),
+     profile_(nullptr)
 {
-   if (sqlite3_prepare_v2(db.db_, sql.c_str(), sql.length() + 1, &stmt_, nullptr) != SQLITE_OK)
-      throw Db::error(sqlite3_errmsg(db.db_), sql.c_str());
+   prepare_(sql);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -296,11 +300,34 @@ void Stmt::bindColor(int parameter, const glm::vec4& color)
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Executes the statement.
 ///
+/// \details If the query profiler is enabled, the step, any row returned, and
+///         the time taken are added to the statement's profile.
+///
 /// \return \c true if a result set was returned and there is a row available.
 bool Stmt::step()
+{
+   if (!isQueryProfilingEnabled())
+      return step_();
+
+   detail::QueryProfileEntry& profile = getProfile_();
+   auto start = std::chrono::high_resolution_clock::now();
+   bool row = step_();
+   profile.step_ns += detail::getQueryProfileNanoseconds(std::chrono::high_resolution_clock::now() - start);
+   ++profile.steps;
+   if (row)
+      ++profile.rows;
+
+   return row;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to execute the statement without profiling it.
+///
+/// \return \c true if a new row is available.
+bool Stmt::step_()
 {
    int result = sqlite3_step(stmt_);
-   col_names_.reset();
+   ++*row_;
 
    if (result == SQLITE_DONE)
       return false;
@@ -309,10 +336,10 @@ bool Stmt::step()
 
    // otherwise an error occurred
    if (result == SQLITE_BUSY)
-      throw Db::error("Database is busy.", sqlite3_sql(stmt_));
+      throw Db::error("Database is busy.", sqlite3_sql(stmt_), result);
    if (result == SQLITE_MISUSE)
-      throw Db::error("Statement shouldn't be executed now!", sqlite3_sql(stmt_));
-   throw Db::error(sqlite3_errmsg(db_.db_), sqlite3_sql(stmt_));
+      throw Db::error("Statement shouldn't be executed now!", sqlite3_sql(stmt_), result);
+   throw Db::error(sqlite3_errmsg(db_.db_), sqlite3_sql(stmt_), result);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -321,6 +348,7 @@ bool Stmt::step()
 void Stmt::reset()
 {
    sqlite3_reset(stmt_);
+   ++*row_;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -334,7 +362,11 @@ int Stmt::columns()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Returns the column index of the column with the specified name.
-/// 
+///
+/// \details The name-to-index mapping is built the first time this is called
+///         and is kept for the lifetime of the statement, since the columns
+///         of a prepared statement's result set do not change between rows.
+///
 /// \note   This is __much__ slower than specifying column indices directly.
 ///
 /// \param  name The name of the column we are interested in.
@@ -464,8 +496,12 @@ const char* Stmt::getText(int column)
 std::string Stmt::getBlob(int column)
 {
    assert(column >= 0 && column < columns());
+   const char* data = reinterpret_cast<const char*>(sqlite3_column_blob(stmt_, column));
    int bytes = sqlite3_column_bytes(stmt_, column);
-   return std::string(reinterpret_cast<const char*>(sqlite3_column_blob(stmt_, column)), bytes);
+   if (isQueryProfilingEnabled())
+      getProfile_().blob_bytes += bytes;
+
+   return std::string(data, bytes);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -477,11 +513,34 @@ std::string Stmt::getBlob(int column)
 int Stmt::getBlob(int column, const void*& dest)
 {
    assert(column >= 0 && column < columns());
-   int bytes = sqlite3_column_bytes(stmt_, column);
    dest = sqlite3_column_blob(stmt_, column);
+   int bytes = sqlite3_column_bytes(stmt_, column);
+   if (isQueryProfilingEnabled())
+      getProfile_().blob_bytes += bytes;
+
    return bytes;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns a view of the specified column's blob data without copying
+///         it.
+///
+/// \details The BlobView is only valid until this statement is stepped,
+///         reset, or destroyed.
+///
+/// \param  column The column to retrieve.
+/// \return A BlobView referring to the column's data.
+BlobView Stmt::getBlobView(int column)
+{
+   assert(column >= 0 && column < columns());
+   const void* data = sqlite3_column_blob(stmt_, column);
+   int bytes = sqlite3_column_bytes(stmt_, column);
+   if (isQueryProfilingEnabled())
+      getProfile_().blob_bytes += bytes;
+
+   return BlobView(*this, data, static_cast<size_t>(bytes));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Returns the specified column as a int-valued 32-bit RGBA8888 value.
 ///
@@ -497,6 +556,49 @@ glm::vec4 Stmt::getColor(int column)
                      ((value >> 24) & 0xFF) / float(0xFF));
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to compile the statement's SQL text.
+///
+/// \details If the query profiler is enabled, the time taken is added to the
+///         statement's profile.
+///
+/// \param  sql The SQL text of the statement to compile.
+void Stmt::prepare_(const std::string& sql)
+{
+   if (!isQueryProfilingEnabled())
+   {
+      if (sqlite3_prepare_v2(db_.db_, sql.c_str(), sql.length() + 1, &stmt_, nullptr) != SQLITE_OK)
+         throw Db::error(sqlite3_errmsg(db_.db_), sql.c_str());
+      return;
+   }
+
+   auto start = std::chrono::high_resolution_clock::now();
+   int result = sqlite3_prepare_v2(db_.db_, sql.c_str(), sql.length() + 1, &stmt_, nullptr);
+   long long ns = detail::getQueryProfileNanoseconds(std::chrono::high_resolution_clock::now() - start);
+
+   if (result != SQLITE_OK)
+      throw Db::error(sqlite3_errmsg(db_.db_), sql.c_str());
+
+   detail::QueryProfileEntry& profile = getProfile_();
+   profile.compile_ns += ns;
+   ++profile.compiles;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to find the query profiler entry for this
+///         statement's Id.
+///
+/// \details The entry is only looked up the first time it is needed.
+///
+/// \return The statement's profile entry.
+detail::QueryProfileEntry& Stmt::getProfile_()
+{
+   if (!profile_)
+      profile_ = &detail::getQueryProfileEntry(id_, sqlite3_sql(stmt_));
+
+   return *profile_;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Prints the uncompiled SQL source a statement object.
 ///
@@ -9,6 +9,7 @@
 #include "be/bed/stmt.h"
 
 #include <iostream>
+#include <thread>
 
 namespace be {
 namespace bed {
@@ -21,9 +22,17 @@ namespace bed {
 StmtCache::StmtCache(Db& db)
    : db_(db),
      capacity_(BE_BED_STMT_CACHE_DEFAULT_MAX_SIZE),
+     size_(0),
      held_size_(0),
-     next_index_(1),
-     oldest_index_(1)
+     hits_(0),
+     misses_(0),
+     compiles_(0),
+     evictions_(0),
+     shard_count_(0),
+     shard_size_(0),
+     entries_(nullptr),
+     lru_head_(nullptr),
+     lru_tail_(nullptr)
 {
 }
 
@@ -36,12 +45,56 @@ StmtCache::StmtCache(Db& db)
 StmtCache::StmtCache(Db& db, size_t capacity)
    : db_(db),
      capacity_(capacity),
+     size_(0),
      held_size_(0),
-     next_index_(1),
-     oldest_index_(1)
+     hits_(0),
+     misses_(0),
+     compiles_(0),
+     evictions_(0),
+     shard_count_(0),
+     shard_size_(0),
+     entries_(nullptr),
+     lru_head_(nullptr),
+     lru_tail_(nullptr)
 {
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a sharded Stmt cache for the provided database using
+///         the specified maximum cache size.
+///
+/// \details Each thread which uses the cache uses the shard its thread id
+///         hashes to, which keeps up to shard_size statements most recently
+///         released by the threads which use it.  If shards or shard_size is
+///         0, the cache is not sharded.
+///
+/// \param  db The database on which the cache's statements will operate.
+/// \param  capacity The maximum number of statements to cache.
+/// \param  shards The number of front caches.  This should usually be at
+///         least the number of threads which use the cache at once, so that
+///         few threads share a shard.
+/// \param  shard_size The maximum number of unheld statements kept in each
+///         shard.
+StmtCache::StmtCache(Db& db, size_t capacity, size_t shards, size_t shard_size)
+   : db_(db),
+     capacity_(capacity),
+     size_(0),
+     held_size_(0),
+     hits_(0),
+     misses_(0),
+     compiles_(0),
+     evictions_(0),
+     shard_count_(shard_size > 0 ? shards : 0),
+     shard_size_(shard_size),
+     shards_(shard_count_ > 0 ? new detail::StmtCacheShard[shard_count_] : nullptr),
+     entries_(nullptr),
+     lru_head_(nullptr),
+     lru_tail_(nullptr)
+{
+   for (size_t i = 0; i < shard_count_; ++i)
+      shards_[i].entries.reserve(shard_size_ + 1);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Destroys this asset cache, along with all Stmt objects owned by it.
 ///
@@ -58,17 +111,22 @@ StmtCache::~StmtCache()
 
 #ifdef DEBUG
       int index = 1;
-      for (auto i(cache_.begin()), end(cache_.end()); i != end; ++i)
+      for (detail::StmtCacheEntry* entry = entries_; entry; entry = entry->next_entry)
       {
-         detail::StmtCacheEntry& entry = i->second;
-
-         if (entry.held)
-            BE_LOG_STREAM << BE_LOG_NL << "Held Stmt " << index++ << " ID: " << entry.stmt->getId();
+         if (entry->held)
+            BE_LOG_STREAM << BE_LOG_NL << "Held Stmt " << index++ << " ID: " << entry->stmt->getId();
       }
 #endif
 
       BE_LOG_STREAM << BE_LOG_END;
    }
+
+   while (entries_)
+   {
+      detail::StmtCacheEntry* entry = entries_;
+      entries_ = entry->next_entry;
+      delete entry;
+   }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -96,6 +154,26 @@ size_t StmtCache::getCapacity()
    return capacity_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of per-thread front caches used by this
+///         cache.
+///
+/// \return The number of shards, or 0 if the cache is not sharded.
+size_t StmtCache::getShards() const
+{
+   return shard_count_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the maximum number of unheld statements kept in each
+///         shard.
+///
+/// \return The maximum size of each shard's front cache.
+size_t StmtCache::getShardSize() const
+{
+   return shard_size_;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Retrieves the number of statements currently in the cache.
 ///
@@ -109,7 +187,7 @@ size_t StmtCache::getSize()
    // lock mutex
    std::lock_guard<std::mutex> lock(mutex_);
 
-   return cache_.size();
+   return size_;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -118,12 +196,66 @@ size_t StmtCache::getSize()
 /// \return The number of statements that are currently in use.
 size_t StmtCache::getHeldSize()
 {
-   // lock mutex
-   std::lock_guard<std::mutex> lock(mutex_);
-
    return held_size_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of hold() calls which were satisfied by an
+///         unheld statement already in the cache.
+///
+/// \return The number of cache hits since construction or the last call to
+///         resetStats().
+size_t StmtCache::getHits()
+{
+   return hits_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of hold() calls which could not be satisfied
+///         by an unheld statement already in the cache.
+///
+/// \return The number of cache misses since construction or the last call to
+///         resetStats().
+size_t StmtCache::getMisses()
+{
+   return misses_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of statements which have been successfully
+///         compiled by this cache.
+///
+/// \details This may be less than getMisses() if some statements failed to
+///         compile.
+///
+/// \return The number of compiled statements since construction or the last
+///         call to resetStats().
+size_t StmtCache::getCompiles()
+{
+   return compiles_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of unheld statements which have been
+///         destroyed to keep the cache within its capacity.
+///
+/// \return The number of evictions since construction or the last call to
+///         resetStats().
+size_t StmtCache::getEvictions()
+{
+   return evictions_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Resets the hit, miss, compile, and eviction counters to zero.
+void StmtCache::resetStats()
+{
+   hits_ = 0;
+   misses_ = 0;
+   compiles_ = 0;
+   evictions_ = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Holds a statement using the provided SQL and an Id generated by
 ///         hashing the SQL text.
@@ -188,45 +320,156 @@ CachedStmt StmtCache::hold(const Id& id, const std::string& sql)
 ///         provided.  The new statement is then added to the cache as a held
 ///         statement.
 ///
+///         If the cache is sharded, the calling thread's front cache is
+///         checked before the shared cache.
+///
 /// \param  id The Id of the statement.
 /// \param  sql The SQL text of the statement to compile.
 /// \return A CachedStmt representing the held statement.
 CachedStmt StmtCache::hold(const Id& id, const char* sql)
 {
-   // First check to see if there's an existing unheld statement we can use
+   std::unique_lock<std::mutex> shard_lock;
+   detail::StmtCacheShard* shard = getShard_(shard_lock);
+   if (shard)
+   {
+      std::vector<detail::StmtCacheEntry*>& entries = shard->entries;
+
+      // search from most recently released to least recently released
+      for (size_t i = entries.size(); i > 0; --i)
+      {
+         detail::StmtCacheEntry* entry = entries[i - 1];
+         if (entry->stmt->getId() == id)
+         {
+            entries.erase(entries.begin() + (i - 1));
+            entry->held = true;
+            ++held_size_;
+            ++hits_;
+            return CachedStmt(this, *entry);
+         }
+      }
+
+      shard_lock.unlock();
+   }
+
+   // Next check to see if there's an existing unheld statement we can use
    std::unique_lock<std::mutex> lock(mutex_);
-   if (held_size_ < cache_.size())
+   if (lru_head_)
    {
       // it only makes sense to check for a specific unheld statement
       // if there is at least one unheld statement in the cache.
 
-      auto range(cache_.equal_range(id));
-
-      for (auto i(range.first); i != range.second; ++i)
+      auto i(free_.find(id));
+      if (i != free_.end() && i->second)
       {
-         detail::StmtCacheEntry& entry = i->second;
+         detail::StmtCacheEntry& entry = *i->second;
 
-         if (!entry.held)
-         {
-            hold_(entry);
-            return CachedStmt(this, *entry.stmt);
-         }
+         unlinkFree_(entry);
+         entry.held = true;
+         ++held_size_;
+         ++hits_;
+         return CachedStmt(this, entry);
       }
    }
+   ++misses_;
    lock.unlock(); // unlock mutex while SQL compiles
 
    // If not, release the mutex lock and construct a new statement
    // SQL statement compilation can be an expensive operation, so
    // we don't want to prevent other threads from accessing the cache
    // while SQLite is doing its thing.
-   Stmt* stmt = new Stmt(db_, id, sql);
+   std::unique_ptr<detail::StmtCacheEntry> entry(new detail::StmtCacheEntry(new Stmt(db_, id, sql)));
+   entry->held = true;
 
    // re-lock mutex and insert the new statement object
    lock.lock();
-   hold_(cache_.insert(std::make_pair(id, detail::StmtCacheEntry(stmt)))->second);
+   ++compiles_;
+   ++held_size_;
+   linkEntry_(*entry);
+   checkSize_();
+
+   if (compiled_.find(id) == compiled_.end())
+      compiled_[id] = sql;
+
+   return CachedStmt(this, *entry.release());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compiles a statement and adds it to the cache without holding it.
+///
+/// \details If there is already an unheld statement with the same Id in the
+///         shared cache, or the cache is full, nothing happens.  Otherwise
+///         the statement is compiled and added to the cache as the most
+///         recently released unheld statement, so that a later call to
+///         hold() with the same Id is a hit.
+///
+///         This is intended to be called from a background thread to
+///         "pre-warm" the cache with statements which will be needed soon.
+///         The calling thread's front cache is not used.
+///
+/// \param  id The Id of the statement.
+/// \param  sql The SQL text of the statement to compile.
+/// \return \c true if a new statement was compiled.
+bool StmtCache::prepare(const Id& id, const std::string& sql)
+{
+   return prepare(id, sql.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compiles a statement and adds it to the cache without holding it.
+///
+/// \details If there is already an unheld statement with the same Id in the
+///         shared cache, or the cache is full, nothing happens.  Otherwise
+///         the statement is compiled and added to the cache as the most
+///         recently released unheld statement, so that a later call to
+///         hold() with the same Id is a hit.
+///
+///         This is intended to be called from a background thread to
+///         "pre-warm" the cache with statements which will be needed soon.
+///         The calling thread's front cache is not used.
+///
+/// \param  id The Id of the statement.
+/// \param  sql The SQL text of the statement to compile.
+/// \return \c true if a new statement was compiled.
+bool StmtCache::prepare(const Id& id, const char* sql)
+{
+   std::unique_lock<std::mutex> lock(mutex_);
+   if (size_ >= capacity_)
+      return false;
+
+   auto i(free_.find(id));
+   if (i != free_.end() && i->second)
+      return false;
+
+   lock.unlock(); // unlock mutex while SQL compiles
+
+   std::unique_ptr<detail::StmtCacheEntry> entry(new detail::StmtCacheEntry(new Stmt(db_, id, sql)));
+
+   lock.lock();
+   ++compiles_;
+   if (compiled_.find(id) == compiled_.end())
+      compiled_[id] = sql;
+
+   detail::StmtCacheEntry& unheld = *entry.release();
+   linkEntry_(unheld);
+   linkFree_(unheld);
    checkSize_();
 
-   return CachedStmt(this, *stmt);
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the Id and SQL text of every distinct statement this
+///         cache has compiled, including statements which have since been
+///         evicted.
+///
+/// \details The result is suitable for passing to prepare() the next time
+///         the same database is used.
+///
+/// \return A list of (Id, SQL) pairs, in no particular order.
+std::vector<std::pair<Id, std::string> > StmtCache::getCompiledStatements()
+{
+   std::lock_guard<std::mutex> lock(mutex_);
+   return std::vector<std::pair<Id, std::string> >(compiled_.begin(), compiled_.end());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -236,106 +479,229 @@ CachedStmt StmtCache::hold(const Id& id, const char* sql)
 ///         restore its original state.  After being released, the statement
 ///         may be returned by future calls to hold().
 ///
-/// \param  stmt The statement to release.
-void StmtCache::release_(Stmt& stmt)
+///         If the cache is sharded, the statement is placed in the calling
+///         thread's front cache, and the shared cache is only locked if the
+///         front cache overflows or the cache is over capacity.
+///
+/// \param  entry The cache entry which owns the statement to release.
+void StmtCache::release_(detail::StmtCacheEntry& entry)
 {
-   const Id& id = stmt.getId();
-   stmt.reset(); // ensure statement is in a clean state
-   stmt.bind();  // release any bound parameters
+   entry.stmt->reset(); // ensure statement is in a clean state
+   entry.stmt->bind();  // release any bound parameters
 
+   std::unique_lock<std::mutex> shard_lock;
+   detail::StmtCacheShard* shard = getShard_(shard_lock);
+   if (shard)
    {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto range(cache_.equal_range(id));
+      if (!entry.held)
+         return;
+
+      entry.held = false;
+      --held_size_;
 
-      for (auto i(range.first); i != range.second; ++i)
+      detail::StmtCacheEntry* overflow = nullptr;
+      std::vector<detail::StmtCacheEntry*>& entries = shard->entries;
+      entries.push_back(&entry);
+      if (entries.size() > shard_size_)
       {
-         detail::StmtCacheEntry& entry = i->second;
+         overflow = entries.front();
+         entries.erase(entries.begin());
+      }
 
-         if (entry.stmt.get() == &stmt && entry.held)
-         {
-            entry.held = false;
-            --held_size_;
-            checkSize_();
-            return;
-         }
+      shard_lock.unlock();
+
+      // size_ and capacity_ may be stale here, but if another thread changes
+      // them, that thread will call checkSize_() itself.
+      if (overflow || size_ > capacity_)
+      {
+         std::lock_guard<std::mutex> lock(mutex_);
+         if (overflow)
+            linkFree_(*overflow);
+         checkSize_();
       }
+      return;
+   }
+
+   std::lock_guard<std::mutex> lock(mutex_);
+   if (entry.held)
+   {
+      entry.held = false;
+      --held_size_;
+      linkFree_(entry);
+      checkSize_();
    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// \brief  Helper function to hold an existing entry in the cache.
+/// \brief  Helper function to reduce the size of the cache if it is too big.
 ///
-/// \note   StmtCache::mutex_ must be locked before calling this function!
+/// \details The least recently released unheld statements in the shared LRU
+///         list are destroyed until the cache is within its capacity.  If
+///         that isn't enough, the least recently released statements in each
+///         front cache are destroyed, shard by shard, until the cache is
+///         within its capacity or there are no unheld statements left.
 ///
-/// \param  entry A reference to an entry owned by StmtCache::cache_.
-void StmtCache::hold_(detail::StmtCacheEntry& entry)
+/// \note   StmtCache::mutex_ must be locked before calling this function,
+///         and the calling thread must not have any shard's mutex locked!
+///         (mutex_ is always locked before a shard's mutex, never after.)
+void StmtCache::checkSize_()
 {
-   entry.held = true;
-   entry.access_index = next_index_++;
-   ++held_size_;
+   while (size_ > capacity_ && lru_tail_)
+   {
+      detail::StmtCacheEntry* oldest = lru_tail_;
+      unlinkFree_(*oldest);
+      unlinkEntry_(*oldest);
+      ++evictions_;
+      delete oldest;
+   }
 
-   if (next_index_ == 0)
+   for (size_t i = 0; i < shard_count_ && size_ > capacity_; ++i)
    {
-      // when next_index_ overflows, set all held access indices to 0
+      detail::StmtCacheShard& shard = shards_[i];
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      std::vector<detail::StmtCacheEntry*>& entries = shard.entries;
 
-      next_index_ = 1;
-      oldest_index_ = 1;
-      for (auto i(cache_.begin()), end(cache_.end()); i != end; ++i)
-         i->second.access_index = 0;
+      size_t count = 0;
+      while (count < entries.size() && size_ > capacity_)
+      {
+         detail::StmtCacheEntry* oldest = entries[count++];
+         unlinkEntry_(*oldest);
+         ++evictions_;
+         delete oldest;
+      }
+      entries.erase(entries.begin(), entries.begin() + count);
    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-/// \brief  Helper function to reduce the size of the cache if it is too big.
+/// \brief  Helper function to find the front cache used by the calling
+///         thread.
+///
+/// \details The shard is chosen by hashing the thread's id, so a thread
+///         always uses the same shard, and threads never need to claim or
+///         give up a shard.
+///
+/// \note   StmtCache::mutex_ must not be locked when calling this function!
+///
+/// \param  shard_lock Receives a lock on the returned shard's mutex.
+/// \return The calling thread's shard, or nullptr if the cache is not
+///         sharded.
+detail::StmtCacheShard* StmtCache::getShard_(std::unique_lock<std::mutex>& shard_lock)
+{
+   if (shard_count_ == 0)
+      return nullptr;
+
+   // Thread ids are often addresses, whose low bits are mostly the same, so
+   // mix the high bits down before choosing a shard.
+   uint64_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+
+   detail::StmtCacheShard& shard = shards_[size_t(hash % shard_count_)];
+   std::unique_lock<std::mutex> lock(shard.mutex);
+   shard_lock.swap(lock);
+   return &shard;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to take ownership of a new entry.
 ///
 /// \note   StmtCache::mutex_ must be locked before calling this function!
-void StmtCache::checkSize_()
+///
+/// \param  entry An entry which is not yet owned by the cache.
+void StmtCache::linkEntry_(detail::StmtCacheEntry& entry)
 {
-   while (cache_.size() > capacity_ && held_size_ < cache_.size())
-   {
-      // remove the oldest entry
-      size_t oldest_index = 0;
-      auto oldest = cache_.end();
+   entry.prev_entry = nullptr;
+   entry.next_entry = entries_;
+   if (entries_)
+      entries_->prev_entry = &entry;
+   entries_ = &entry;
+   ++size_;
+}
 
-      for (auto i(cache_.begin()), end(cache_.end()); i != end; ++i)
-      {
-         detail::StmtCacheEntry& entry = i->second;
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to release ownership of an entry so that it can be
+///         deleted.
+///
+/// \note   StmtCache::mutex_ must be locked before calling this function!
+///
+/// \param  entry An entry owned by the cache.
+void StmtCache::unlinkEntry_(detail::StmtCacheEntry& entry)
+{
+   if (entry.prev_entry)
+      entry.prev_entry->next_entry = entry.next_entry;
+   else
+      entries_ = entry.next_entry;
 
-         if (!entry.held)
-         {
-            if (entry.access_index == 0)
-            {
-               // if this entry is older than the last overflow of next_index_
-               // then we can remove it.
-               cache_.erase(i);
-               oldest_index = 0; // don't call erase(oldest) at end of while()
-               break;
-            }
-
-            if (entry.access_index == oldest_index_)
-            {
-               // if we know this entry is the oldest, theres no point in looking
-               // at any further entries.
-               oldest_index = oldest_index_;
-               oldest = i; // we will remove this at end of while()
-               break;
-            }
-
-            // if we get here, check to see if this entry is older than 'oldest'
-            if (entry.access_index < oldest_index || oldest_index == 0)
-            {
-               oldest_index = entry.access_index;
-               oldest = i; // we will remove this at end of while()
-            }
-         }
-      }
+   if (entry.next_entry)
+      entry.next_entry->prev_entry = entry.prev_entry;
 
-      if (oldest_index > 0)
-      {
-         oldest_index_ = oldest_index + 1;
-         cache_.erase(oldest);
-      }
-   } // remove oldest unheld entry until size < max size or there are no unheld entries.
+   entry.prev_entry = nullptr;
+   entry.next_entry = nullptr;
+   --size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to add an unheld entry to the front of the LRU list
+///         and the free list for its Id.
+///
+/// \note   StmtCache::mutex_ must be locked before calling this function!
+///
+/// \param  entry An unheld entry which is not currently in the LRU list.
+void StmtCache::linkFree_(detail::StmtCacheEntry& entry)
+{
+   entry.prev = nullptr;
+   entry.next = lru_head_;
+   if (lru_head_)
+      lru_head_->prev = &entry;
+   else
+      lru_tail_ = &entry;
+   lru_head_ = &entry;
+
+   detail::StmtCacheEntry*& free_head = free_[entry.stmt->getId()];
+   entry.prev_free = nullptr;
+   entry.next_free = free_head;
+   if (free_head)
+      free_head->prev_free = &entry;
+   free_head = &entry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Helper function to remove an unheld entry from the LRU list and the
+///         free list for its Id.
+///
+/// \details The free list head for the Id is left in place (possibly empty) so
+///         that repeatedly holding and releasing the same statement does not
+///         allocate.
+///
+/// \note   StmtCache::mutex_ must be locked before calling this function!
+///
+/// \param  entry An entry which is currently in the LRU list.
+void StmtCache::unlinkFree_(detail::StmtCacheEntry& entry)
+{
+   if (entry.prev)
+      entry.prev->next = entry.next;
+   else
+      lru_head_ = entry.next;
+
+   if (entry.next)
+      entry.next->prev = entry.prev;
+   else
+      lru_tail_ = entry.prev;
+
+   if (entry.prev_free)
+      entry.prev_free->next_free = entry.next_free;
+   else
+      free_[entry.stmt->getId()] = entry.next_free;
+
+   if (entry.next_free)
+      entry.next_free->prev_free = entry.prev_free;
+
+   entry.prev = nullptr;
+   entry.next = nullptr;
+   entry.prev_free = nullptr;
+   entry.next_free = nullptr;
 }
 
 } // namespace be::bed
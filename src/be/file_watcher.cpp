@@ -0,0 +1,282 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   be/file_watcher.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of be::FileWatcher functions.
+
+#include "be/file_watcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace be {
+namespace {
+
+// Makes sure a directory path ends in a separator, so that filenames can be
+// appended directly.
+std::string normalizeDirectory(const std::string& directory)
+{
+   if (directory.empty())
+      return "./";
+
+   char last = directory[directory.length() - 1];
+   if (last == '/' || last == '\\')
+      return directory;
+
+   return directory + '/';
+}
+
+#ifndef _WIN32
+
+// Retrieves the last modification time of a file, or 0 if it can't be
+// determined.
+uint64_t getWriteTime(const std::string& path)
+{
+   struct stat info;
+   if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+      return 0;
+
+   return static_cast<uint64_t>(info.st_mtim.tv_sec) * 1000000000u + info.st_mtim.tv_nsec;
+}
+
+#endif
+
+} // namespace be::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a FileWatcher which isn't watching any directories.
+FileWatcher::FileWatcher()
+   : fd_(-1)
+{
+#ifndef _WIN32
+   fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+   if (fd_ < 0)
+   {
+      BE_LOG(VWarning) << "Failed to initialize inotify!" << BE_LOG_NL
+                       << "Error: " << std::strerror(errno) << BE_LOG_END;
+   }
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops watching all directories.
+FileWatcher::~FileWatcher()
+{
+#ifdef _WIN32
+   for (auto& dir : directories_)
+      FindCloseChangeNotification(static_cast<HANDLE>(dir.handle));
+#else
+   if (fd_ >= 0)
+      close(fd_);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Starts watching a directory for modified files.
+///
+/// \details Subdirectories are not watched.  Watching a directory which is
+///         already being watched has no effect.
+///
+/// \param  directory The path of the directory to watch.
+/// \return \c true if the directory is now being watched.
+bool FileWatcher::watch(const std::string& directory)
+{
+   std::string path = normalizeDirectory(directory);
+   if (isWatching(path))
+      return true;
+
+   Directory dir;
+   dir.path = path;
+   dir.watch = -1;
+   dir.handle = nullptr;
+
+#ifdef _WIN32
+   HANDLE handle = FindFirstChangeNotificationA(path.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+   if (handle == INVALID_HANDLE_VALUE)
+   {
+      BE_LOG(VWarning) << "Failed to watch directory!" << BE_LOG_NL
+                       << " Path: " << path << BE_LOG_NL
+                       << "Error: " << GetLastError() << BE_LOG_END;
+      return false;
+   }
+   dir.handle = handle;
+#else
+   if (fd_ < 0)
+      return false;
+
+   dir.watch = inotify_add_watch(fd_, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR);
+   if (dir.watch < 0)
+   {
+      BE_LOG(VWarning) << "Failed to watch directory!" << BE_LOG_NL
+                       << " Path: " << path << BE_LOG_NL
+                       << "Error: " << std::strerror(errno) << BE_LOG_END;
+      return false;
+   }
+#endif
+
+   // Record the current write times, so that only later changes are reported.
+   std::vector<std::string> ignored;
+   scan_(dir, ignored);
+
+   directories_.push_back(std::move(dir));
+   return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if a directory is being watched.
+///
+/// \param  directory The path of the directory.
+/// \return \c true if watch() has succeeded for the directory.
+bool FileWatcher::isWatching(const std::string& directory) const
+{
+   std::string path = normalizeDirectory(directory);
+   for (auto& dir : directories_)
+      if (dir.path == path)
+         return true;
+
+   return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the files which have been modified since the last call
+///         to poll() (or since their directory started being watched).
+///
+/// \details Does not block.  Each path is the watched directory's path
+///         (with a trailing separator) followed by the file's name, and each
+///         modified file is only reported once, no matter how many times it
+///         was written.
+///
+/// \return The paths of modified files, sorted.
+std::vector<std::string> FileWatcher::poll()
+{
+   std::vector<std::string> modified;
+
+#ifdef _WIN32
+   for (auto& dir : directories_)
+   {
+      HANDLE handle = static_cast<HANDLE>(dir.handle);
+      if (WaitForSingleObject(handle, 0) == WAIT_OBJECT_0)
+      {
+         scan_(dir, modified);
+         FindNextChangeNotification(handle);
+      }
+   }
+#else
+   if (fd_ < 0)
+      return modified;
+
+   // inotify_event contains an int, so the buffer must be suitably aligned.
+   uint64_t buffer[512];
+   bool overflowed = false;
+   for (;;)
+   {
+      ssize_t length = read(fd_, buffer, sizeof(buffer));
+      if (length <= 0)
+         break;
+
+      const char* ptr = reinterpret_cast<const char*>(buffer);
+      const char* end = ptr + length;
+      while (ptr < end)
+      {
+         const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+         ptr += sizeof(inotify_event) + event->len;
+
+         if (event->mask & IN_Q_OVERFLOW)
+         {
+            overflowed = true;
+            continue;
+         }
+
+         if (event->len == 0 || (event->mask & IN_ISDIR))
+            continue;
+
+         for (auto& dir : directories_)
+         {
+            if (dir.watch == event->wd)
+            {
+               std::string name(event->name);
+               dir.write_times[name] = getWriteTime(dir.path + name);
+               modified.push_back(dir.path + name);
+               break;
+            }
+         }
+      }
+   }
+
+   // If the kernel dropped events, fall back to comparing write times.
+   if (overflowed)
+   {
+      BE_LOG(VNotice) << "inotify queue overflowed; rescanning watched directories." << BE_LOG_END;
+      for (auto& dir : directories_)
+         scan_(dir, modified);
+   }
+#endif
+
+   std::sort(modified.begin(), modified.end());
+   modified.erase(std::unique(modified.begin(), modified.end()), modified.end());
+   return modified;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Lists the files in a directory and adds any whose write times
+///         differ from the last scan to \c modified.
+///
+/// \param  dir The directory to scan.
+/// \param  modified The vector to add the paths of modified files to.
+void FileWatcher::scan_(Directory& dir, std::vector<std::string>& modified)
+{
+   std::unordered_map<std::string, uint64_t> write_times;
+
+#ifdef _WIN32
+   WIN32_FIND_DATAA data;
+   HANDLE find = FindFirstFileA((dir.path + '*').c_str(), &data);
+   if (find != INVALID_HANDLE_VALUE)
+   {
+      do
+      {
+         if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+         write_times[data.cFileName] = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+      } while (FindNextFileA(find, &data));
+
+      FindClose(find);
+   }
+#else
+   DIR* d = opendir(dir.path.c_str());
+   if (d)
+   {
+      while (dirent* ent = readdir(d))
+      {
+         std::string name(ent->d_name);
+         uint64_t time = getWriteTime(dir.path + name);
+         if (time != 0)
+            write_times[name] = time;
+      }
+
+      closedir(d);
+   }
+#endif
+
+   for (auto& file : write_times)
+   {
+      auto i = dir.write_times.find(file.first);
+      if (i == dir.write_times.end() || i->second != file.second)
+         modified.push_back(dir.path + file.first);
+   }
+
+   dir.write_times.swap(write_times);
+}
+
+} // namespace be
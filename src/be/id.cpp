@@ -6,13 +6,18 @@
 
 #include "be/id.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
 #ifdef BE_ID_NAMES_ENABLED
-#include <unordered_map>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <vector>
 #endif
 
 namespace be {
@@ -20,54 +25,240 @@ namespace {
 
 #ifdef BE_ID_NAMES_ENABLED
 
-// Retrieves a map of Id values to strings used to generate them.
-std::unordered_map<uint64_t, std::string>& getNames()
+// The number of shards the name registry is split into.  Shards are selected
+// using the high bits of the Id, so this must be a power of two.
+const size_t name_shard_bits = 6;
+const size_t name_shard_count = 1 << name_shard_bits;
+
+// A string which has been hashed to create an Id.  Names are allocated from
+// their shard's arena and are never freed.
+struct Name
+{
+   uint64_t hash;
+   size_t length;
+   char text[1];  // length + 1 characters, including a null terminator.
+};
+
+// An append-only open addressing table of names.  Once a table is published,
+// the only modification allowed is filling an empty slot, and it is not freed
+// when it is replaced by a larger table, so readers never need to lock.
+struct NameTable
 {
-   static std::unordered_map<uint64_t, std::string> names;
-   return names;
+   explicit NameTable(size_t capacity)
+      : capacity(capacity),
+        size(0),
+        slots(new std::atomic<const Name*>[capacity])
+   {
+      for (size_t i = 0; i < capacity; ++i)
+         slots[i].store(nullptr, std::memory_order_relaxed);
+   }
+
+   // Finds the name with the specified hash, or returns nullptr.
+   const Name* find(uint64_t hash) const
+   {
+      size_t mask = capacity - 1;
+      for (size_t i = static_cast<size_t>(hash) & mask; ; i = (i + 1) & mask)
+      {
+         const Name* name = slots[i].load(std::memory_order_acquire);
+         if (!name || name->hash == hash)
+            return name;
+      }
+   }
+
+   // Places a name in an empty slot.  Only called while holding the shard's
+   // mutex.
+   void add(const Name* name)
+   {
+      size_t mask = capacity - 1;
+      size_t i = static_cast<size_t>(name->hash) & mask;
+      while (slots[i].load(std::memory_order_relaxed))
+         i = (i + 1) & mask;
+
+      slots[i].store(name, std::memory_order_release);
+      ++size;
+   }
+
+   size_t capacity;
+   size_t size;
+   std::unique_ptr<std::atomic<const Name*>[]> slots;
+   std::unique_ptr<NameTable> previous;   // Retired tables may still have readers.
+
+private:
+   NameTable(const NameTable&);
+   void operator=(const NameTable&);
+};
+
+// One shard of the name registry.  Lookups only read the current table, so
+// the mutex is only taken when a new name is added.
+struct NameShard
+{
+   NameShard()
+      : current(new NameTable(64)),
+        table(current.get()),
+        next(nullptr),
+        remaining(0)
+   {
+   }
+
+   // Copies a name into the shard's arena and adds it to the table, growing
+   // the table first if it would be more than 3/4 full.  Only called while
+   // holding mutex.
+   void add(uint64_t hash, const std::string& str)
+   {
+      if (current->size + 1 > current->capacity / 4 * 3)
+      {
+         std::unique_ptr<NameTable> bigger(new NameTable(current->capacity * 2));
+         for (size_t i = 0; i < current->capacity; ++i)
+         {
+            const Name* name = current->slots[i].load(std::memory_order_relaxed);
+            if (name)
+               bigger->add(name);
+         }
+
+         bigger->previous = std::move(current);
+         current = std::move(bigger);
+         table.store(current.get(), std::memory_order_release);
+      }
+
+      size_t size = offsetof(Name, text) + str.length() + 1;
+      size = (size + 7) & ~size_t(7);
+      if (size > remaining)
+      {
+         remaining = std::max(size, size_t(4096));
+         blocks.push_back(std::unique_ptr<char[]>(new char[remaining]));
+         next = blocks.back().get();
+      }
+
+      Name* name = reinterpret_cast<Name*>(next);
+      next += size;
+      remaining -= size;
+
+      name->hash = hash;
+      name->length = str.length();
+      memcpy(name->text, str.c_str(), str.length() + 1);
+
+      current->add(name);
+   }
+
+   std::mutex mutex;
+   std::unique_ptr<NameTable> current;
+   std::atomic<NameTable*> table;
+   std::vector<std::unique_ptr<char[]> > blocks;
+   char* next;
+   size_t remaining;
+
+private:
+   NameShard(const NameShard&);
+   void operator=(const NameShard&);
+};
+
+// Retrieves the shard of the name registry responsible for an Id value.
+NameShard& getNameShard(uint64_t hash)
+{
+   static NameShard shards[name_shard_count];
+   return shards[hash >> (64 - name_shard_bits)];
+}
+
+// Retrieves the name which was hashed to create an Id value, or nullptr.
+const Name* findName(uint64_t hash)
+{
+   return getNameShard(hash).table.load(std::memory_order_acquire)->find(hash);
 }
 
-// Retrieves a mutex that protects the map above.
-std::mutex& getNamesMutex()
+// Records the name used to create an Id, or checks it against the name
+// recorded previously.
+void recordName(uint64_t hash, const std::string& str)
 {
-   static std::mutex mutex;
-   return mutex;
+   const Name* name = findName(hash);
+   if (!name)
+   {
+      NameShard& shard = getNameShard(hash);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      // another thread may have added it since we checked.
+      name = shard.current->find(hash);
+      if (!name)
+      {
+         shard.add(hash, str);
+         return;
+      }
+   }
+
+   // Check for collision with any previously hashed name
+   if (name->length != str.length() || memcmp(name->text, str.c_str(), str.length()) != 0)
+   {
+      // Hash collision: Print a warning
+      std::ostringstream oss;
+      oss << "ID hash collision detected!" << BE_LOG_NL
+          << "    Hash: " << std::hex << std::setfill('0') << std::setw(16) << hash << BE_LOG_NL
+          << "Existing: " << name->text << BE_LOG_NL
+          << " Current: " << str << BE_LOG_END;
+      BE_LOG(VNotice) << oss.str();
+   }
 }
 
 #endif // BE_ID_NAMES_ENABLED
 
 
-// Calculates 64-bit FNV-1a hash of provided name.
-uint64_t hash(const std::string& name)
+// Continues a 64-bit FNV-1a hash over the characters in [begin, end).
+uint64_t fnv1a(uint64_t hash, const uint8_t* begin, const uint8_t* end)
 {
-   uint64_t hash(BE_ID_FNV_OFFSET_BASIS);
-   for (auto i(name.begin()), end(name.end()); i != end; ++i)
-      hash = (hash ^ static_cast<uint8_t>(*i)) * BE_ID_FNV_PRIME;
+   for (; begin != end; ++begin)
+      hash = (hash ^ *begin) * BE_ID_FNV_PRIME;
 
-#ifdef BE_ID_NAMES_ENABLED
-   std::unordered_map<uint64_t, std::string>& names = getNames();
-   std::mutex& mutex = getNamesMutex();
-   std::lock_guard<std::mutex> lock(mutex);
-   auto i(names.find(hash));
-   if (i != names.end())
+   return hash;
+}
+
+// Calculates 64-bit FNV-1a hashes of four names at once.  The common prefix
+// length of all four is hashed in lockstep, then each pair finishes its
+// common length together, then any remaining characters are hashed one name
+// at a time.  Every lane is an independent dependency chain, so the CPU can
+// overlap the multiplies instead of waiting for each one to finish before
+// starting the next.
+void fnv1a4(const std::string* names, uint64_t* hashes)
+{
+   const uint8_t* data[4];
+   size_t length[4];
+   uint64_t hash[4];
+   for (size_t k = 0; k < 4; ++k)
    {
-      // Check for collision with any previously hashed name
-      if (i->second != name)
-      {
-         // Hash collision: Print a warning
-         std::ostringstream oss;
-         oss << "ID hash collision detected!" << BE_LOG_NL
-             << "    Hash: " << std::hex << std::setfill('0') << std::setw(16) << hash << BE_LOG_NL
-             << "Existing: " << i->second << BE_LOG_NL
-             << " Current: " << name << BE_LOG_END;
-         BE_LOG(VNotice) << oss;
-      }
+      data[k] = reinterpret_cast<const uint8_t*>(names[k].data());
+      length[k] = names[k].length();
+      hash[k] = BE_ID_FNV_OFFSET_BASIS;
    }
-   else
+
+   size_t quad_length = std::min(std::min(length[0], length[1]), std::min(length[2], length[3]));
+   for (size_t i = 0; i < quad_length; ++i)
    {
-      // Save this name/hash for future checks
-      names[hash] = name;          
+      hash[0] = (hash[0] ^ data[0][i]) * BE_ID_FNV_PRIME;
+      hash[1] = (hash[1] ^ data[1][i]) * BE_ID_FNV_PRIME;
+      hash[2] = (hash[2] ^ data[2][i]) * BE_ID_FNV_PRIME;
+      hash[3] = (hash[3] ^ data[3][i]) * BE_ID_FNV_PRIME;
    }
+
+   for (size_t k = 0; k < 4; k += 2)
+   {
+      size_t pair_length = std::min(length[k], length[k + 1]);
+      size_t i = quad_length;
+      for (; i < pair_length; ++i)
+      {
+         hash[k] = (hash[k] ^ data[k][i]) * BE_ID_FNV_PRIME;
+         hash[k + 1] = (hash[k + 1] ^ data[k + 1][i]) * BE_ID_FNV_PRIME;
+      }
+
+      hashes[k] = fnv1a(hash[k], data[k] + i, data[k] + length[k]);
+      hashes[k + 1] = fnv1a(hash[k + 1], data[k + 1] + i, data[k + 1] + length[k + 1]);
+   }
+}
+
+// Calculates 64-bit FNV-1a hash of provided name.
+uint64_t hash(const std::string& name)
+{
+   const uint8_t* data = reinterpret_cast<const uint8_t*>(name.data());
+   uint64_t hash = fnv1a(BE_ID_FNV_OFFSET_BASIS, data, data + name.length());
+
+#ifdef BE_ID_NAMES_ENABLED
+   recordName(hash, name);
 #endif // BE_ID_NAMES_ENABLED
 
    return hash;
@@ -100,6 +291,14 @@ Id::Id(uint64_t id)
 /// \details The hash function used is a Fowler-Noll-Vo variant.
 ///         (64-bit FNV-1a)
 ///
+///         If #BE_ID_NAMES_ENABLED is defined, the name is recorded so that
+///         it can be included by to_string(), and a warning is logged if a
+///         different name has already been recorded for the same value.  The
+///         registry of names is split into shards, each of which only needs
+///         to lock when a name is recorded for the first time; looking up
+///         names which have already been recorded never blocks, so many
+///         threads can construct Ids at once.
+///
 /// \param  name The string to hash to generate the numeric value for the Id.
 Id::Id(const std::string& name)
    : id_(hash(name))
@@ -160,12 +359,9 @@ std::string Id::to_string() const
    oss << '#' << std::hex << std::setfill('0') << std::setw(16) << id_;
 
 #ifdef BE_ID_NAMES_ENABLED
-   std::unordered_map<uint64_t, std::string>& names = getNames();
-   std::mutex& mutex = getNamesMutex();
-   std::lock_guard<std::mutex> lock(mutex);
-   auto i(names.find(id_));
-   if (i != names.end())
-      oss << ':' << i->second;
+   const Name* name = findName(id_);
+   if (name)
+      oss.put(':').write(name->text, name->length);
 #endif
 
    return oss.str();
@@ -258,4 +454,81 @@ std::ostream& operator<<(std::ostream& os, const Id& id)
    return os << id.to_string();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs Ids for many strings at once.
+///
+/// \details The resulting Ids are identical to those which would be created
+///         by constructing each one individually with Id(const std::string&),
+///         (including recording names if #BE_ID_NAMES_ENABLED is defined) but
+///         the strings are hashed four at a time, interleaving the FNV-1a
+///         multiplies for each one.  Hashing a byte depends on the result of
+///         hashing the previous byte, so a single string can't be hashed any
+///         faster than one multiply latency per byte, but four unrelated
+///         strings can proceed in parallel.  This makes building large
+///         numbers of Ids (for instance, when indexing every resource in a
+///         directory of sandwiches) significantly faster.
+///
+/// \param  names Points to the first of \c count strings to hash.
+/// \param  count The number of strings to hash.
+/// \param  ids Points to the first of \c count Ids to overwrite with the
+///         resulting Ids.  May not overlap with \c names.
+void hashIds(const std::string* names, size_t count, Id* ids)
+{
+   uint64_t hashes[4];
+   size_t i = 0;
+   for (; i + 4 <= count; i += 4)
+   {
+      fnv1a4(names + i, hashes);
+      for (size_t k = 0; k < 4; ++k)
+         ids[i + k] = Id(hashes[k]);
+   }
+
+   for (; i < count; ++i)
+   {
+      const uint8_t* data = reinterpret_cast<const uint8_t*>(names[i].data());
+      ids[i] = Id(fnv1a(BE_ID_FNV_OFFSET_BASIS, data, data + names[i].length()));
+   }
+
+#ifdef BE_ID_NAMES_ENABLED
+   for (i = 0; i < count; ++i)
+      recordName(ids[i].value(), names[i]);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs Ids for many strings at once.
+///
+/// \details See hashIds(const std::string*, size_t, Id*).
+///
+/// \param  names The strings to hash.
+/// \return A vector containing the Id for each string in \c names, in the
+///         same order.
+std::vector<Id> hashIds(const std::vector<std::string>& names)
+{
+   std::vector<Id> ids(names.size());
+   if (!names.empty())
+      hashIds(&names[0], names.size(), &ids[0]);
+
+   return ids;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Calculates the 64-bit FNV-1a hash of a block of memory.
+///
+/// \details Unlike Id(const std::string&), no name is recorded, so this is
+///         suitable for hashing large or binary data, like the contents of
+///         resource blobs.  Passing the result of a previous call as
+///         \c hash continues that hash, so several discontiguous blocks can
+///         be hashed as if they were one.
+///
+/// \param  data Points to the first byte to hash.
+/// \param  size The number of bytes to hash.
+/// \param  hash The hash state to continue from.
+/// \return The hash of the provided bytes.
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash)
+{
+   const uint8_t* begin = static_cast<const uint8_t*>(data);
+   return fnv1a(hash, begin, begin + size);
+}
+
 } // namespace be
@@ -6,7 +6,9 @@
 
 #include "pbj/audio/buffer.h"
 
+#include <cstdlib>
 #include <iostream>
+#include <utility>
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  SQL statement to load a audio buffer from a sandwich.
@@ -17,8 +19,21 @@
 #ifdef BE_ID_NAMES_ENABLED
 #define PBJSQLID_LOAD PBJSQL_LOAD
 #else
-// TODO: precalculate ids.
-#define PBJSQLID_LOAD PBJSQL_LOAD
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJSQLID_LOAD 0xf4381ca8c2252d48
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the content hash of a sound's blob.
+/// \param  1 The id of the sound.
+#define PBJSQL_CONTENT_HASH "SELECT content_hash " \
+            "FROM sw_sounds WHERE id = ?"
+
+#ifdef BE_ID_NAMES_ENABLED
+#define PBJSQLID_CONTENT_HASH PBJSQL_CONTENT_HASH
+#else
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJSQLID_CONTENT_HASH 0x30a3587cd698806e
 #endif
 
 namespace pbj {
@@ -39,6 +54,53 @@ Buffer::Buffer(const ALubyte* data, size_t size)
     buffer_id_ = alutCreateBufferFromFileImage(data, size);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a buffer from raw PCM samples.
+///
+/// \param  format The OpenAL sample format (eg. AL_FORMAT_MONO16).
+/// \param  data The sample data.
+/// \param  size The number of bytes of sample data.
+/// \param  frequency The sample rate, in Hz.
+Buffer::Buffer(ALenum format, const ALvoid* data, ALsizei size, ALsizei frequency)
+    : buffer_id_(AL_NONE)
+{
+    upload_(format, data, size, frequency);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a buffer from a sound which has already been decoded.
+///
+/// \param  data The decoded sound.
+Buffer::Buffer(const SoundData& data)
+    : buffer_id_(AL_NONE)
+{
+    upload_(data.getFormat(), data.getData(), data.getSize(), data.getFrequency());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Creates the OpenAL buffer and copies PCM samples into it.
+///
+/// \param  format The OpenAL sample format (eg. AL_FORMAT_MONO16).
+/// \param  data The sample data.
+/// \param  size The number of bytes of sample data.
+/// \param  frequency The sample rate, in Hz.
+void Buffer::upload_(ALenum format, const ALvoid* data, ALsizei size, ALsizei frequency)
+{
+    alGenBuffers(1, &buffer_id_);
+    alBufferData(buffer_id_, format, data, size, frequency);
+
+    ALenum error = alGetError();
+    if (error != AL_NO_ERROR)
+    {
+        PBJ_LOG(VWarning) << "OpenAL error while uploading sound data!" << PBJ_LOG_NL
+                          << "Error Code: " << error << PBJ_LOG_END;
+
+        alDeleteBuffers(1, &buffer_id_);
+        buffer_id_ = AL_NONE;
+        throw std::runtime_error("Failed to upload sound data!");
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \fn AudioBuffer::~AudioBuffer()
 ///
@@ -48,10 +110,15 @@ Buffer::Buffer(const ALubyte* data, size_t size)
 /// \date   2013-08-22
 Buffer::~Buffer()
 {
+    if (buffer_id_ != AL_NONE)
+    {
+        alDeleteBuffers(1, &buffer_id_);
+        buffer_id_ = AL_NONE;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \fn ALuint AudioBuffer::getBufferID()
+/// \fn ALuint AudioBuffer::getBufferID() const
 ///
 /// \brief  Gets buffer identifier.
 ///
@@ -59,11 +126,41 @@ Buffer::~Buffer()
 /// \date   2013-08-22
 ///
 /// \return The buffer identifier.
-ALuint Buffer::getBufferID()
+ALuint Buffer::getBufferID() const
 {
 	return buffer_id_;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Exchanges the OpenAL buffers owned by this buffer and another.
+///
+/// \details Used to replace a sound's samples (for instance, when its
+///         sandwich is modified) without invalidating pointers to it.
+///         Sources which are already playing the old samples keep playing
+///         them, and OpenAL will refuse to delete the old buffer while they
+///         are attached to it.
+///
+/// \param  other The buffer to swap with.
+void Buffer::swap(Buffer& other)
+{
+    std::swap(buffer_id_, other.buffer_id_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Gets the amount of memory used by the buffer's PCM samples.
+///
+/// \return The size of the buffer, in bytes, or 0 if it could not be
+///         created.
+size_t Buffer::getSize() const
+{
+    if (buffer_id_ == AL_NONE)
+        return 0;
+
+    ALint size = 0;
+    alGetBufferi(buffer_id_, AL_SIZE, &size);
+    return size_t(size);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \fn std::unique_ptr<AudioBuffer> loadSound(sw::Sandwich& sandwich,
 ///     const Id& id)
@@ -92,10 +189,10 @@ std::unique_ptr<Buffer> loadSound(sw::Sandwich& sandwich, const Id& id)
         stmt.bind(1, id.value());
         if (stmt.step())
         {
-            const void* data;
-            size_t data_length = stmt.getBlob(0, data);
-
-            result.reset(new Buffer(static_cast<const ALubyte*>(data), data_length));
+            // ALUT needs the whole file image, so the blob can't be streamed,
+            // but it can be decoded without copying it out of SQLite.
+            db::BlobView data = stmt.getBlobView(0);
+            result.reset(new Buffer(static_cast<const ALubyte*>(data.data()), data.size()));
         }
         else
             throw std::runtime_error("Sound not found!");
@@ -119,5 +216,134 @@ std::unique_ptr<Buffer> loadSound(sw::Sandwich& sandwich, const Id& id)
    return result;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Decodes a sound file image into PCM samples.
+///
+/// \param  data A memory-image of a sound file in any format supported by
+///         ALUT.
+/// \param  size The number of bytes of data.
+/// \throws std::runtime_error If the data can't be decoded.
+SoundData::SoundData(const ALubyte* data, size_t size)
+{
+    data_ = alutLoadMemoryFromFileImage(data, static_cast<ALsizei>(size), &format_, &size_, &frequency_);
+
+    if (!data_)
+    {
+        PBJ_LOG(VWarning) << "ALUT error while decoding sound data!" << PBJ_LOG_NL
+                          << "Error: " << alutGetErrorString(alutGetError()) << PBJ_LOG_END;
+
+        throw std::runtime_error("Failed to decode sound data!");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Frees the decoded samples.
+SoundData::~SoundData()
+{
+    std::free(data_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the OpenAL format of the decoded samples.
+ALenum SoundData::getFormat() const
+{
+    return format_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the decoded samples.
+const ALvoid* SoundData::getData() const
+{
+    return data_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the number of bytes of decoded samples.
+ALsizei SoundData::getSize() const
+{
+    return size_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the sample rate of the decoded samples, in Hz.
+ALsizei SoundData::getFrequency() const
+{
+    return static_cast<ALsizei>(frequency_);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Decodes a sound from a sandwich without creating an OpenAL buffer.
+///
+/// \details The sound is read using a connection from the sandwich's
+///         connection pool, so this may be called from any thread.
+///
+/// \param  sandwich The sandwich to load from.
+/// \param  id The identifier of the sound.
+/// \return The decoded sound, or an empty unique_ptr if it can't be loaded.
+std::unique_ptr<SoundData> decodeSound(sw::Sandwich& sandwich, const Id& id)
+{
+    std::unique_ptr<SoundData> result;
+
+    try
+    {
+        db::PooledDb conn = sandwich.getConnectionPool().acquire();
+        db::CachedStmt stmt = conn.hold(Id(PBJSQLID_LOAD), PBJSQL_LOAD);
+
+        stmt.bind(1, id.value());
+        if (stmt.step())
+        {
+            db::BlobView data = stmt.getBlobView(0);
+            result.reset(new SoundData(static_cast<const ALubyte*>(data.data()), data.size()));
+        }
+        else
+            throw std::runtime_error("Sound not found!");
+    }
+    catch (const db::Db::error& err)
+    {
+        PBJ_LOG(VWarning) << "Database error while decoding sound!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "   Sound ID: " << id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_NL
+                          << "        SQL: " << err.sql() << PBJ_LOG_END;
+    }
+    catch (const std::exception& err)
+    {
+        PBJ_LOG(VWarning) << "Exception while decoding sound!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "   Sound ID: " << id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_END;
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the content hash stored with a sound's blob (see
+///         sw::hashContent()), so that identical sounds in different
+///         sandwiches can be recognized without reading their blobs.
+///
+/// \details Sandwiches whose schema predates content hashes, and sounds
+///         which don't have one, are not reported as errors.
+///
+/// \param  sandwich The sandwich containing the sound.
+/// \param  id The identifier of the sound.
+/// \return The sound's content hash, or 0 if it is unknown.
+U64 getSoundContentHash(sw::Sandwich& sandwich, const Id& id)
+{
+    try
+    {
+        db::CachedStmt stmt = sandwich.getStmtCache().hold(Id(PBJSQLID_CONTENT_HASH), PBJSQL_CONTENT_HASH);
+        stmt.bind(1, id.value());
+        if (!stmt.step() || stmt.getType(0) == SQLITE_NULL)
+            return 0;
+
+        return stmt.getUInt64(0);
+    }
+    catch (const db::Db::error&)
+    {
+        return 0;   // no content_hash column
+    }
+}
+
 } // namespace pbj::audio
 } // namespace pbj
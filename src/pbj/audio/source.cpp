@@ -267,7 +267,7 @@ void Source::updateVelocity()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \fn void Source::addAudioBuffer(string name, Buffer* buffer)
+/// \fn void Source::addAudioBuffer(string name, const Buffer* buffer)
 ///
 /// \brief  Adds an audio buffer to the source.
 ///
@@ -276,13 +276,13 @@ void Source::updateVelocity()
 ///
 /// \param  name            The name.
 /// \param [in] buffer      The buffer to add.
-void Source::addBuffer(const std::string& name, Buffer* buffer)
+void Source::addBuffer(const std::string& name, const Buffer* buffer)
 {
     _buffers.insert(std::make_pair(name,buffer));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \fn Buffer* Source::getAudioBuffer(string name) const
+/// \fn const Buffer* Source::getAudioBuffer(string name) const
 ///
 /// \brief  Gets audio buffer.
 ///
@@ -292,7 +292,7 @@ void Source::addBuffer(const std::string& name, Buffer* buffer)
 /// \param  name    The name.
 ///
 /// \return null if it fails, else the audio buffer
-Buffer* Source::getBuffer(const std::string& name)
+const Buffer* Source::getBuffer(const std::string& name)
 {
     auto it = _buffers.find(name);
     if(it != _buffers.end())
@@ -311,7 +311,7 @@ Buffer* Source::getBuffer(const std::string& name)
 /// \param  name    The name.
 void Source::play(const std::string& name)
 {
-    Buffer* buf = getBuffer(name);
+    const Buffer* buf = getBuffer(name);
     if (buf)
     {
         alSourcei(_srcId, AL_BUFFER, buf->getBufferID());
@@ -331,7 +331,7 @@ void Source::play(const std::string& name)
 /// \param  pos     The position in seconds.
 void Source::playAt(const std::string& name, F32 pos)
 {
-    Buffer* buf = getBuffer(name);
+    const Buffer* buf = getBuffer(name);
     if (buf)
     {
         alSourcei(_srcId, AL_BUFFER, buf->getBufferID());
@@ -22,7 +22,9 @@
 #include "pbj/decorate_editor_mode.h"
 #include "pbj/dupe_editor_mode.h"
 #include "pbj/mimic_editor_mode.h"
+#include "pbj/ids/editor_modes.h"
 
+#include <chrono>
 #include <iostream>
 #include <thread>
 
@@ -485,6 +487,11 @@ void Editor::run(const std::string& sw_id, const std::string& map_id)
         if (window_.isClosePending())
             break;
 
+        checkSaves_(false);
+
+        engine_.getResourceManager().reloadModified();
+        engine_.getResourceManager().processUploads();
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         glMatrixMode(GL_PROJECTION);
@@ -555,6 +562,9 @@ void Editor::run(const std::string& sw_id, const std::string& map_id)
         }
         fps = 1.0 / frame_time;
     }
+
+    // don't exit before the last save has been written
+    checkSaves_(true);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -631,7 +641,8 @@ EditorMode* Editor::getCurrentMode()
 ///         one having the Id specified.
 ///
 /// \details If the EditorMode Id is not recognized, the current mode will
-///         not be changed.
+///         not be changed.  The known modes are listed in
+///         tools/editor_modes.txt (see pbj/ids/editor_modes.h).
 ///
 /// \param  id Indicates the EditorMode we should enter.
 void Editor::setMode(const Id& id)
@@ -639,45 +650,24 @@ void Editor::setMode(const Id& id)
     if (current_mode_ && current_mode_->getId() == id)
         return;
 
-    if (id == Id("EditorMode.look"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new LookEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.add_clobber"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new AddClobberEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.move"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new MoveEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.rotate"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new RotateEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.scale"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new ScaleEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.decorate"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new DecorateEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.dupe"))
-    {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new DupeEditorMode(*this));
-    }
-    else if (id == Id("EditorMode.mimic"))
+    ids::editor_modes::Index mode = ids::editor_modes::find(id);
+    if (mode == ids::editor_modes::none)
+        return;
+
+    current_mode_.reset();
+
+    switch (mode)
     {
-        current_mode_.reset();
-        current_mode_ = std::unique_ptr<EditorMode>(new MimicEditorMode(*this));
+        case ids::editor_modes::id_EditorMode_look:        current_mode_.reset(new LookEditorMode(*this));       break;
+        case ids::editor_modes::id_EditorMode_add_clobber: current_mode_.reset(new AddClobberEditorMode(*this)); break;
+        case ids::editor_modes::id_EditorMode_move:        current_mode_.reset(new MoveEditorMode(*this));       break;
+        case ids::editor_modes::id_EditorMode_rotate:      current_mode_.reset(new RotateEditorMode(*this));     break;
+        case ids::editor_modes::id_EditorMode_scale:       current_mode_.reset(new ScaleEditorMode(*this));      break;
+        case ids::editor_modes::id_EditorMode_decorate:    current_mode_.reset(new DecorateEditorMode(*this));   break;
+        case ids::editor_modes::id_EditorMode_dupe:        current_mode_.reset(new DupeEditorMode(*this));       break;
+        case ids::editor_modes::id_EditorMode_mimic:       current_mode_.reset(new MimicEditorMode(*this));      break;
+        default:
+            break;
     }
 }
 
@@ -828,9 +818,67 @@ void Editor::setActiveMaterial(const std::string& name, const vec2& scale)
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Overwrites the current scene's data in it's sandwich with the
 ///         current scene's terrain and spawnpoint data.
+///
+/// \details The statements used to load the map are also recorded in the
+///         sandwich's query manifest so that they can be pre-warmed the next
+///         time the sandwich is opened.
+///
+///         Both are written by the sandwich's background writer.  If the
+///         previous save hasn't finished yet, this waits for it first so
+///         that its result isn't lost.
 void Editor::saveMap()
 {
-    scene_->saveScene(map_id_.sandwich, map_id_.resource);
+    checkSaves_(true);
+
+    scene_saved_ = scene_->saveScene(map_id_.sandwich, map_id_.resource);
+    manifest_saved_ = sw::saveQueryManifest(map_id_.sandwich);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Logs any errors from the last call to saveMap().
+///
+/// \details This is called once per frame without waiting, so that errors
+///         are reported soon after the save finishes, and with \c wait set
+///         before the next save and when the editor exits.
+///
+/// \param  wait If true, blocks until the last save has finished.
+void Editor::checkSaves_(bool wait)
+{
+    checkSave_(scene_saved_, "map", wait);
+    checkSave_(manifest_saved_, "query manifest", wait);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Logs the error held by a save's future, if it has one.
+///
+/// \details Once the future is ready it is consumed, so each error is only
+///         logged once.  If the future isn't ready and \c wait is false,
+///         nothing happens.
+///
+/// \param  result The future returned when the save was submitted.
+/// \param  what A description of what was being saved, for the log.
+/// \param  wait If true, blocks until the future is ready.
+void Editor::checkSave_(std::future<void>& result, const char* what, bool wait)
+{
+    if (!result.valid())
+        return;
+
+    if (!wait && result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    try
+    {
+        result.get();
+    }
+    catch (const std::exception& err)
+    {
+        // the details were logged when the save failed; this makes sure a
+        // failed save can't go unnoticed.
+        PBJ_LOG(VWarning) << "Failed to save " << what << "!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << map_id_.sandwich << PBJ_LOG_NL
+                          << "     Map ID: " << map_id_.resource << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_END;
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -9,8 +9,10 @@
 #include "pbj/_al.h"
 #include "pbj/sw/sandwich_open.h"
 #include "pbj/input_controller.h"
+#include "be/bed/query_profiler.h"
 
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
 
 namespace pbj {
@@ -49,6 +51,11 @@ Engine::Engine(int* argc, char** argv)
 
     process_engine_ = this;
 
+    // Setting the PBJ_PROFILE_QUERIES environment variable enables the query
+    // profiler; a report is written to the log when the program exits.
+    if (std::getenv("PBJ_PROFILE_QUERIES"))
+        db::setQueryProfilingEnabled(true);
+
     //init audio
     alutInit(argc, argv);
 
@@ -58,6 +65,15 @@ Engine::Engine(int* argc, char** argv)
 
     sw::readDirectory("./");
 
+    // The editor always reloads sandwiches when they are modified; the game
+    // only does so if the PBJ_HOT_RELOAD environment variable is set.
+#ifdef PBJ_EDITOR
+    resource_mgr_.setHotReload(true);
+#else
+    if (std::getenv("PBJ_HOT_RELOAD"))
+        resource_mgr_.setHotReload(true);
+#endif
+
     std::shared_ptr<sw::Sandwich> config_sandwich;
     config_sandwich = sw::open(Id("__pbjconfig__"));
 
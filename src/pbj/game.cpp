@@ -12,6 +12,17 @@
 #include "pbj/scene/player_component.h"
 #include "pbj/sw/sandwich_open.h"
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the ids of all maps in a sandwich.
+#define PBJ_GAME_SQL_GET_MAPS "SELECT id FROM sw_maps"
+
+#ifdef BE_ID_NAMES_ENABLED
+#define PBJ_GAME_SQLID_GET_MAPS PBJ_GAME_SQL_GET_MAPS
+#else
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_GAME_SQLID_GET_MAPS 0x7a277d0e848034de
+#endif
+
 namespace pbj {
 
 #pragma region statics
@@ -56,7 +67,10 @@ Game::Game()
      _paused(false),
      _engine(getEngine()),
      _window(*getEngine().getWindow()),
-	 _loadRandomSceneNextFrame(false)
+	 _loadRandomSceneNextFrame(false),
+     _streaming(false),
+     _streamingFrames(0),
+     _worstStreamingFrame(0)
 {
     const U32 fps = 30;
 
@@ -109,7 +123,7 @@ void Game::getSceneIds(const Id& sw_id)
 
     if (ptr)
     {
-        db::CachedStmt& stmt = ptr->getStmtCache().hold(Id("SELECT id FROM sw_maps"), "SELECT id FROM sw_maps");
+        db::CachedStmt& stmt = ptr->getStmtCache().hold(Id(PBJ_GAME_SQLID_GET_MAPS), PBJ_GAME_SQL_GET_MAPS);
 
         while (stmt.step())
         {
@@ -125,8 +139,21 @@ sw::ResourceId Game::getRandomSceneId()
     return _scene_ids[dist(_prng)];
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \fn void Game::loadScene(const sw::ResourceId& scene_id)
+///
+/// \brief  Loads a map and adds players and a camera to it.
+///
+/// \details Textures and other large resources stream in over the following
+///         frames.  The time spent in this function (which is the hitch seen
+///         when changing maps) is logged, and run() logs how many frames it
+///         took for streaming to finish and the longest of those frames.
+///
+/// \param  scene_id Identifies the map to load.
 void Game::loadScene(const sw::ResourceId& scene_id)
 {
+    F64 load_start = glfwGetTime();
+
     auto ptr = sw::open(scene_id.sandwich);
     if (!ptr)
         return;
@@ -139,7 +166,7 @@ void Game::loadScene(const sw::ResourceId& scene_id)
     //add the local player to the scene
     vec2 spawnLoc = _scene->getRandomSpawnPoint()->getTransform().getPosition();
     U32 player_id = _scene->makePlayer("Player", spawnLoc, true);
-    _scene->getLocalPlayer()->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("player1_outline"))));
+    _scene->getLocalPlayer()->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_PLAYER1_OUTLINE))));
 
     //since the player will be the focus of the camera, reduce the volume of its output
     _scene->getLocalPlayer()->getAudioSource()->setGain(0.65f);
@@ -153,10 +180,10 @@ void Game::loadScene(const sw::ResourceId& scene_id)
         name.append(std::to_string(i));
         ids[i] = _scene->makePlayer(std::string(name), spawnLoc, false);
     }
-    _scene->getPlayer(ids[0])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("player2_outline"))));
-    _scene->getPlayer(ids[1])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("player3_outline"))));
-    _scene->getPlayer(ids[2])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("player4_outline"))));
-    _scene->getPlayer(ids[3])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("player5_outline"))));
+    _scene->getPlayer(ids[0])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_PLAYER2_OUTLINE))));
+    _scene->getPlayer(ids[1])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_PLAYER3_OUTLINE))));
+    _scene->getPlayer(ids[2])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_PLAYER4_OUTLINE))));
+    _scene->getPlayer(ids[3])->setMaterial(&_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_PLAYER5_OUTLINE))));
 
     //add the camera
     U32 camera_id = _scene->makeCamera();
@@ -175,6 +202,14 @@ void Game::loadScene(const sw::ResourceId& scene_id)
     
     //add the UI to the scene.
     _scene->makeHud();
+
+    _streaming = true;
+    _streamingFrames = 0;
+    _worstStreamingFrame = 0;
+
+    PBJ_LOG(VInfo) << "Loaded scene: " << scene_id << PBJ_LOG_NL
+                   << "  Load Time: " << 1000.0 * (glfwGetTime() - load_start) << " ms" << PBJ_LOG_NL
+                   << "  Streaming: " << _engine.getResourceManager().getStreamingCount() << " resources" << PBJ_LOG_END;
 }
 
 #pragma region run_game
@@ -243,6 +278,27 @@ I32 Game::run()
 
         last_frame_start = frame_start;
         F64 frame_time = last_frame_time = glfwGetTime() - frame_start;
+
+        if (_scene && _streaming)
+        {
+            ++_streamingFrames;
+            _worstStreamingFrame = std::max(_worstStreamingFrame, frame_time);
+
+            if (_engine.getResourceManager().getStreamingCount() == 0)
+            {
+                _streaming = false;
+                sw::ResidencyStats stats = _engine.getResourceManager().getResidencyStats();
+                PBJ_LOG(VInfo) << "Finished streaming scene resources." << PBJ_LOG_NL
+                               << "       Frames: " << _streamingFrames << PBJ_LOG_NL
+                               << "  Worst Frame: " << 1000.0 * _worstStreamingFrame << " ms" << PBJ_LOG_NL
+                               << "     Textures: " << stats.textures << " (" << stats.texture_bytes << " bytes)" << PBJ_LOG_NL
+                               << "       Sounds: " << stats.sounds << " (" << stats.sound_bytes << " bytes)" << PBJ_LOG_NL
+                               << "    Materials: " << stats.materials << PBJ_LOG_NL
+                               << " Unreferenced: " << stats.unreferenced << PBJ_LOG_NL
+                               << " Deduplicated: " << stats.deduplicated << PBJ_LOG_NL
+                               << "       Budget: " << stats.budget << " bytes" << PBJ_LOG_END;
+            }
+        }
         if (last_frame_time < (1.0 / PBJ_GAME_MAX_FPS))
         {
             std::this_thread::sleep_for(std::chrono::microseconds(
@@ -263,6 +319,9 @@ I32 Game::run()
 ////////////////////////////////////////////////////////////////////////////////
 void Game::draw()
 {
+    _engine.getResourceManager().reloadModified();
+    _engine.getResourceManager().processUploads();
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (_scene)
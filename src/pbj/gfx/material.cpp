@@ -7,6 +7,7 @@
 #include "pbj/sw/resource_manager.h"
 
 #include <iostream>
+#include <utility>
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  SQL statement to load a texture from a sandwich.
@@ -17,19 +18,52 @@
 #ifdef BE_ID_NAMES_ENABLED
 #define PBJ_GFX_MATERIAL_SQLID_LOAD PBJ_GFX_MATERIAL_SQL_LOAD
 #else
-// TODO: precalculate ids.
-#define PBJ_GFX_MATERIAL_SQLID_LOAD PBJ_GFX_MATERIAL_SQL_LOAD
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_GFX_MATERIAL_SQLID_LOAD 0x61a58d13663acf5b
 #endif
 
 namespace pbj {
 namespace gfx {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a material's properties.
+///
+/// \param  stmt The PBJ_GFX_MATERIAL_SQL_LOAD statement.
+/// \param  id The Id of the material in the sandwich to load.
+/// \return The material's properties.
+/// \throws std::runtime_error If the material does not exist.
+MaterialData readMaterialData(db::CachedStmt& stmt, const Id& id)
+{
+    stmt.bind(1, id.value());
+    if (!stmt.step())
+        throw std::runtime_error("Material not found!");
+
+    MaterialData data;
+    data.color = stmt.getColor(0);
+    data.has_texture = stmt.getType(1) != SQLITE_NULL;
+    if (data.has_texture)
+        data.texture_id = Id(stmt.getUInt64(1));
+
+    switch (stmt.getUInt(2))
+    {
+        case 0:     data.texture_mode = GL_MODULATE; break;
+        case 1:     data.texture_mode = GL_DECAL; break;
+        case 2:     data.texture_mode = GL_ADD; break;
+        default:    data.texture_mode = GL_REPLACE; break;
+    }
+
+    return data;
+}
+
+} // namespace pbj::gfx::(anon)
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief  Default Material constructor
 ///
 /// \author Josh Douglas
 /// \date   2013-08-13
-Material::Material(const sw::ResourceId& id, const color4& color, const Texture* texture, GLenum texture_mode)
+Material::Material(const sw::ResourceId& id, const color4& color, const sw::ResourceHandle<Texture>& texture, GLenum texture_mode)
     : id_(id),
       color_(color),
       tex_(texture),
@@ -59,9 +93,23 @@ const color4& Material::getColor() const
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief  Get function to return a pointer to this material's texture
 ///
+/// \details If the texture is still streaming in, nullptr is returned, and
+///         the material is drawn untextured until it is ready.
+///
 /// \author Josh Douglas
 /// \date   2013-08-13
 const Texture* Material::getTexture() const
+{
+    return tex_.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the handle to this material's texture.
+///
+/// \details The handle is null if the material is untextured.  Unlike
+///         getTexture(), it identifies the texture even while it is still
+///         streaming in.
+const sw::ResourceHandle<Texture>& Material::getTextureHandle() const
 {
     return tex_;
 }
@@ -84,14 +132,30 @@ GLenum Material::getTextureMode() const
 /// \author Ben Crist
 void Material::use() const
 {
-    if (tex_)
-        tex_->enable(tex_mode_);
+    const Texture* tex = tex_.get();
+    if (tex)
+        tex->enable(tex_mode_);
     else
         Texture::disable();
 
     glColor4fv(glm::value_ptr(color_));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Exchanges the appearance of this material with another's.
+///
+/// \details The materials' ResourceIds are not swapped.  Used to replace a
+///         material's contents (for instance, when its sandwich is modified)
+///         without invalidating references to it.
+///
+/// \param  other The material to swap with.
+void Material::swap(Material& other)
+{
+    std::swap(color_, other.color_);
+    std::swap(tex_, other.tex_);
+    std::swap(tex_mode_, other.tex_mode_);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief  Retrieves the ResourceId which describes where this material can
 ///         be loaded from in a sandwich.
@@ -104,8 +168,8 @@ const sw::ResourceId& Material::getId() const
 /// \brief  Loads the material having the requested Id from the sandwich
 ///         provided.
 ///
-/// \details If the material has a texture, it will be retrieved using the
-///         ResourceManager provided.
+/// \details If the material has a texture, it will be requested from the
+///         ResourceManager provided, and will stream in asynchronously.
 ///
 /// \param  sandwich the Sandwich to load from.
 /// \param  id The Id of the material in the sandwich to load.
@@ -119,34 +183,14 @@ std::unique_ptr<Material> loadMaterial(sw::Sandwich& sandwich, const Id& id, sw:
 
     try
     {
-        db::StmtCache& cache = sandwich.getStmtCache();
-        db::CachedStmt stmt = cache.hold(Id(PBJ_GFX_MATERIAL_SQLID_LOAD), PBJ_GFX_MATERIAL_SQL_LOAD);
-
-        stmt.bind(1, id.value());
-        if (stmt.step())
-        {
-            color4 color(stmt.getColor(0));
-
-            const Texture* tex(nullptr);
-            if (stmt.getType(1) != SQLITE_NULL)
-            {
-                Id texture_id(stmt.getUInt64(1));
-                tex = &rm.getTexture(sw::ResourceId(sandwich.getId(), texture_id));
-            }
-
-            GLenum texture_mode;
-            switch (stmt.getUInt(2))
-            {
-                case 0:     texture_mode = GL_MODULATE; break;
-                case 1:     texture_mode = GL_DECAL; break;
-                case 2:     texture_mode = GL_ADD; break;
-                default:    texture_mode = GL_REPLACE; break;
-            }
-
-            result.reset(new Material(sw::ResourceId(sandwich.getId(), id), color, tex, texture_mode));
-        }
-        else
-            throw std::runtime_error("Material not found!");
+        db::CachedStmt stmt = sandwich.getStmtCache().hold(Id(PBJ_GFX_MATERIAL_SQLID_LOAD), PBJ_GFX_MATERIAL_SQL_LOAD);
+        MaterialData data(readMaterialData(stmt, id));
+
+        sw::ResourceHandle<Texture> tex;
+        if (data.has_texture)
+            tex = rm.requestTexture(sw::ResourceId(sandwich.getId(), data.texture_id));
+
+        result.reset(new Material(sw::ResourceId(sandwich.getId(), id), data.color, tex, data.texture_mode));
     }
     catch (const db::Db::error& err)
     {
@@ -167,5 +211,45 @@ std::unique_ptr<Material> loadMaterial(sw::Sandwich& sandwich, const Id& id, sw:
    return result;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads the properties of the material having the requested Id from
+///         the sandwich provided.
+///
+/// \details The material is read using a connection from the sandwich's
+///         connection pool, so this may be called from any thread.
+///
+/// \param  sandwich the Sandwich to load from.
+/// \param  id The Id of the material in the sandwich to load.
+/// \return A unique_ptr to the material's properties, or an empty unique_ptr
+///         if there is a problem loading it.
+std::unique_ptr<MaterialData> readMaterial(sw::Sandwich& sandwich, const Id& id)
+{
+    std::unique_ptr<MaterialData> result;
+
+    try
+    {
+        db::PooledDb conn = sandwich.getConnectionPool().acquire();
+        db::CachedStmt stmt = conn.hold(Id(PBJ_GFX_MATERIAL_SQLID_LOAD), PBJ_GFX_MATERIAL_SQL_LOAD);
+        result.reset(new MaterialData(readMaterialData(stmt, id)));
+    }
+    catch (const db::Db::error& err)
+    {
+        PBJ_LOG(VWarning) << "Database error while reading material!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "Material ID: " << id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_NL
+                          << "        SQL: " << err.sql() << PBJ_LOG_END;
+    }
+    catch (const std::exception& err)
+    {
+        PBJ_LOG(VWarning) << "Exception while reading material!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "Material ID: " << id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_END;
+    }
+
+    return result;
+}
+
 } // namespace gfx
 } // namespace pbj
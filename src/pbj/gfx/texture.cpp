@@ -10,24 +10,106 @@
 
 #include <cassert>
 #include <iostream>
+#include <utility>
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  SQL statement to load a texture from a sandwich.
 /// \param  1 The id of the texture.
-#define PBJ_GFX_TEXTURE_SQL_LOAD "SELECT data, " \
+#define PBJ_GFX_TEXTURE_SQL_LOAD "SELECT " \
             "internal_format, srgb, mag_filter, min_filter " \
             "FROM sw_textures WHERE id = ?"
 
 #ifdef BE_ID_NAMES_ENABLED
 #define PBJ_GFX_TEXTURE_SQLID_LOAD PBJ_GFX_TEXTURE_SQL_LOAD
 #else
-// TODO: precalculate ids.
-#define PBJ_GFX_TEXTURE_SQLID_LOAD PBJ_GFX_TEXTURE_SQL_LOAD
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_GFX_TEXTURE_SQLID_LOAD 0xd014d155c6d613ce
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the content hash of a texture's blob, along
+///         with the other columns which affect the texture created from it.
+/// \param  1 The id of the texture.
+#define PBJ_GFX_TEXTURE_SQL_CONTENT_HASH "SELECT " \
+            "content_hash, internal_format, srgb, mag_filter, min_filter " \
+            "FROM sw_textures WHERE id = ?"
+
+#ifdef BE_ID_NAMES_ENABLED
+#define PBJ_GFX_TEXTURE_SQLID_CONTENT_HASH PBJ_GFX_TEXTURE_SQL_CONTENT_HASH
+#else
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_GFX_TEXTURE_SQLID_CONTENT_HASH 0xa1e3cfc736fe3560
 #endif
 
 
 namespace pbj {
 namespace gfx {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  State used to let STB Image decode directly from a BlobReader.
+/// \details Exceptions can't be thrown through STB Image, so any database
+///         error is remembered and rethrown after decoding stops.
+struct BlobCallbackState
+{
+    db::BlobReader* reader;
+    std::unique_ptr<db::Db::error> error;
+};
+
+int blobRead(void* user, char* data, int size)
+{
+    BlobCallbackState& state = *static_cast<BlobCallbackState*>(user);
+    try
+    {
+        return state.reader->read(data, size);
+    }
+    catch (const db::Db::error& err)
+    {
+        if (!state.error)
+            state.error.reset(new db::Db::error(err));
+        state.reader->seek(state.reader->size());
+        return 0;
+    }
+}
+
+void blobSkip(void* user, unsigned n)
+{
+    BlobCallbackState& state = *static_cast<BlobCallbackState*>(user);
+    state.reader->skip(static_cast<int>(n));
+}
+
+int blobEof(void* user)
+{
+    BlobCallbackState& state = *static_cast<BlobCallbackState*>(user);
+    return state.reader->eof() ? 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Looks up a texture's properties and decodes its image data.
+///
+/// \param  db The connection to read the image data from.
+/// \param  get_texture The PBJ_GFX_TEXTURE_SQL_LOAD statement, prepared on db.
+/// \param  texture_id Identifies the texture to load.
+/// \return The decoded image.
+/// \throws std::runtime_error If the texture does not exist or can't be
+///         decoded.
+std::unique_ptr<TextureImage> readTextureImage(db::Db& db, db::CachedStmt& get_texture, const Id& texture_id)
+{
+    get_texture.bind(1, texture_id.value());
+    if (!get_texture.step())
+        throw std::runtime_error("Texture not found!");
+
+    Texture::InternalFormat internal_format = static_cast<Texture::InternalFormat>(get_texture.getInt(0));
+    bool srgb = get_texture.getBool(1);
+    Texture::FilterMode mag_mode = static_cast<Texture::FilterMode>(get_texture.getInt(2));
+    Texture::FilterMode min_mode = static_cast<Texture::FilterMode>(get_texture.getInt(3));
+
+    // sw_textures.id is an INTEGER PRIMARY KEY, so it is also the rowid.
+    db::BlobReader data(db, "sw_textures", "data", static_cast<sqlite3_int64>(texture_id.value()));
+    return std::unique_ptr<TextureImage>(new TextureImage(data, internal_format, srgb, mag_mode, min_mode));
+}
+
+} // namespace pbj::gfx::(anon)
 
 bool Texture::texture_enabled_(false);
 GLuint Texture::active_texture_(0);
@@ -51,7 +133,55 @@ GLenum Texture::active_blend_mode_(0);
 /// \param  min_mode Determines the type of sampler interpolation used when
 ///         the texture appears smaller on-screen than the texture size.
 Texture::Texture(const GLubyte* data, size_t size, InternalFormat format, bool srgb_color, FilterMode mag_mode, FilterMode min_mode)
-    : gl_id_(0)
+    : gl_id_(0),
+      size_(0)
+{
+    upload_(TextureImage(data, size, format, srgb_color, mag_mode, min_mode));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a texture object by streaming an image file from a
+///         sandwich and uploads it to the GPU.
+///
+/// \details The image is decoded as it is read, so the encoded image file is
+///         never loaded into memory all at once.
+///
+/// \param  data A BlobReader positioned at the start of an image file.  The
+///         data must be in a format readable by STB Image.
+///         eg. PNG, TGA, BMP, JPG, etc.
+/// \param  format Determines the format used by the GPU to store the texture
+///         data on the graphics card.
+/// \param  srgb_color If true, the texture will be interpretted as an sRGB
+///         encoded image, rather than linearly encoded.  The GPU will
+///         automatically linearize the texture data when it is sampled.
+/// \param  mag_mode Determines the type of sampler interpolation used when
+///         the texture appears larger on-screen than the texture size.
+/// \param  min_mode Determines the type of sampler interpolation used when
+///         the texture appears smaller on-screen than the texture size.
+Texture::Texture(db::BlobReader& data, InternalFormat format, bool srgb_color, FilterMode mag_mode, FilterMode min_mode)
+    : gl_id_(0),
+      size_(0)
+{
+    upload_(TextureImage(data, format, srgb_color, mag_mode, min_mode));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a texture object from an image which has already been
+///         decoded and uploads it to the GPU.
+///
+/// \param  image The decoded image.
+Texture::Texture(const TextureImage& image)
+    : gl_id_(0),
+      size_(0)
+{
+    upload_(image);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Uploads a decoded image to the GPU.
+///
+/// \param  image The decoded image.
+void Texture::upload_(const TextureImage& image)
 {
     GLenum error_status;
     while ((error_status = glGetError()) != GL_NO_ERROR)
@@ -61,58 +191,50 @@ Texture::Texture(const GLubyte* data, size_t size, InternalFormat format, bool s
                          << "         Error: " << pbj::getGlErrorString(error_status) << PBJ_LOG_END;
     }
 
-    int required_components = 4;
+    dimensions_ = image.getDimensions();
 
     GLenum internal_format;
     GLenum source_format;
-    switch (format)
+    size_t components;
+    switch (image.getFormat())
     {
         case IF_R:
             internal_format = GL_RED;
             source_format = GL_RED;
-            required_components = 1;
+            components = 1;
             break;
 
         case IF_RG:
             internal_format = GL_RG;
             source_format = GL_RG;
-            required_components = 2;
+            components = 2;
             break;
 
         case IF_RGB:
-            internal_format = srgb_color ? GL_SRGB : GL_RGB;
+            internal_format = image.isSrgb() ? GL_SRGB : GL_RGB;
             source_format = GL_RGB;
-            required_components = 3;
+            components = 3;
             break;
 
         default: //case IF_RGBA:
-            internal_format = srgb_color ? GL_SRGB_ALPHA : GL_RGBA;
+            internal_format = image.isSrgb() ? GL_SRGB_ALPHA : GL_RGBA;
             source_format = GL_RGBA;
-            required_components = 4;
+            components = 4;
             break;
     }
 
-    int components;
-    stbi_uc* stbi_data = stbi_load_from_memory(data, size, &dimensions_.x, &dimensions_.y, &components, required_components);
-
-    if (stbi_data == nullptr)
-    {
-        PBJ_LOG(VWarning) << "OpenGL error while parsing texture data!" << PBJ_LOG_NL
-                          << "STBI Error: " << stbi_failure_reason() << PBJ_LOG_END;
-
-        throw std::runtime_error("Failed to upload texture data to GPU!");
-    }
+    size_ = size_t(dimensions_.x) * size_t(dimensions_.y) * components;
 
     GLenum mag_filter;
     GLenum min_filter;
-    switch (mag_mode)
+    switch (image.getMagMode())
     {
         case FM_Linear:     mag_filter = GL_LINEAR; break;
         case FM_Nearest:    mag_filter = GL_NEAREST; break;
         default:            mag_filter = GL_LINEAR; break;
     }
 
-    switch (min_mode)
+    switch (image.getMinMode())
     {
         case FM_Linear:     min_filter = GL_LINEAR; break;
         case FM_Nearest:    min_filter = GL_NEAREST; break;
@@ -128,15 +250,16 @@ Texture::Texture(const GLubyte* data, size_t size, InternalFormat format, bool s
     glGenTextures(1, &gl_id_);
     glBindTexture(GL_TEXTURE_2D, gl_id_);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, dimensions_.x, dimensions_.y, 0, source_format, GL_UNSIGNED_BYTE, stbi_data);
-
-    stbi_image_free(stbi_data);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, dimensions_.x, dimensions_.y, 0, source_format, GL_UNSIGNED_BYTE, image.getPixels());
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
 
+    // Uploading changed the GL binding behind enable()'s back.
+    active_texture_ = gl_id_;
+
     error_status = glGetError();
 
     if (error_status != GL_NO_ERROR)
@@ -185,6 +308,34 @@ const ivec2& Texture::getDimensions() const
     return dimensions_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the approximate amount of GPU memory used by the texture.
+///
+/// \details Textures are not mipmapped, so this is just the size of the
+///         pixel data which was uploaded.  Drivers may pad some formats, so
+///         the actual amount of memory used could be slightly larger.
+///
+/// \return the size of the texture, in bytes.
+size_t Texture::getSize() const
+{
+    return size_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Exchanges the OpenGL texture objects owned by this texture and
+///         another.
+///
+/// \details Used to replace a texture's contents (for instance, when its
+///         sandwich is modified) without invalidating references to it.
+///
+/// \param  other The texture to swap with.
+void Texture::swap(Texture& other)
+{
+    std::swap(dimensions_, other.dimensions_);
+    std::swap(gl_id_, other.gl_id_);
+    std::swap(size_, other.size_);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Enables this texture object and sets the texture environment mode
 ///         to the specified mode.
@@ -223,6 +374,156 @@ void Texture::disable()
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Decodes an image file from memory.
+///
+/// \param  data A pointer to a memory-image of an image file.  The data must
+///         be in a format readable by STB Image. eg. PNG, TGA, BMP, JPG, etc.
+/// \param  size The number of bytes of data in the data array.
+/// \param  format The format the texture will be stored in on the GPU.  This
+///         determines how many components are decoded per pixel.
+/// \param  srgb_color If true, the texture will be interpretted as sRGB.
+/// \param  mag_mode The sampler interpolation used for magnification.
+/// \param  min_mode The sampler interpolation used for minification.
+TextureImage::TextureImage(const GLubyte* data, size_t size, Texture::InternalFormat format, bool srgb_color, Texture::FilterMode mag_mode, Texture::FilterMode min_mode)
+    : pixels_(nullptr),
+      format_(format),
+      srgb_(srgb_color),
+      mag_mode_(mag_mode),
+      min_mode_(min_mode)
+{
+    decode_(data, size, nullptr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Decodes an image file as it is streamed from a sandwich.
+///
+/// \param  data A BlobReader positioned at the start of an image file.  The
+///         data must be in a format readable by STB Image.
+///         eg. PNG, TGA, BMP, JPG, etc.
+/// \param  format The format the texture will be stored in on the GPU.  This
+///         determines how many components are decoded per pixel.
+/// \param  srgb_color If true, the texture will be interpretted as sRGB.
+/// \param  mag_mode The sampler interpolation used for magnification.
+/// \param  min_mode The sampler interpolation used for minification.
+TextureImage::TextureImage(db::BlobReader& data, Texture::InternalFormat format, bool srgb_color, Texture::FilterMode mag_mode, Texture::FilterMode min_mode)
+    : pixels_(nullptr),
+      format_(format),
+      srgb_(srgb_color),
+      mag_mode_(mag_mode),
+      min_mode_(min_mode)
+{
+    decode_(nullptr, 0, &data);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Frees the decoded pixel data.
+TextureImage::~TextureImage()
+{
+    stbi_image_free(pixels_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Decodes an image from memory or a BlobReader.
+///
+/// \param  data A pointer to a memory-image of an image file, or nullptr if
+///         reader should be used instead.
+/// \param  size The number of bytes of data in the data array.
+/// \param  reader The BlobReader to decode from if data is nullptr.
+void TextureImage::decode_(const GLubyte* data, size_t size, db::BlobReader* reader)
+{
+    int required_components;
+    switch (format_)
+    {
+        case Texture::IF_R:     required_components = 1; break;
+        case Texture::IF_RG:    required_components = 2; break;
+        case Texture::IF_RGB:   required_components = 3; break;
+        default:                required_components = 4; break;
+    }
+
+    int components;
+    if (reader)
+    {
+        stbi_io_callbacks callbacks = { blobRead, blobSkip, blobEof };
+        BlobCallbackState state;
+        state.reader = reader;
+
+        pixels_ = stbi_load_from_callbacks(&callbacks, &state, &dimensions_.x, &dimensions_.y, &components, required_components);
+
+        if (state.error)
+        {
+            stbi_image_free(pixels_);
+            pixels_ = nullptr;
+            throw *state.error;
+        }
+    }
+    else
+        pixels_ = stbi_load_from_memory(data, size, &dimensions_.x, &dimensions_.y, &components, required_components);
+
+    if (pixels_ == nullptr)
+    {
+        PBJ_LOG(VWarning) << "OpenGL error while parsing texture data!" << PBJ_LOG_NL
+                          << "STBI Error: " << stbi_failure_reason() << PBJ_LOG_END;
+
+        throw std::runtime_error("Failed to upload texture data to GPU!");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the decoded pixel data.
+///
+/// \return The pixels of the image, one byte per component, with rows packed
+///         tightly together.
+const GLubyte* TextureImage::getPixels() const
+{
+    return pixels_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the dimensions of the image.
+///
+/// \return the image's dimensions.
+const ivec2& TextureImage::getDimensions() const
+{
+    return dimensions_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the format the texture will be stored in on the GPU.
+///
+/// \return The texture's internal format.
+Texture::InternalFormat TextureImage::getFormat() const
+{
+    return format_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if the texture should be interpretted as sRGB.
+///
+/// \return \c true if the image is sRGB encoded.
+bool TextureImage::isSrgb() const
+{
+    return srgb_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the sampler interpolation used for magnification.
+///
+/// \return The magnification filter mode.
+Texture::FilterMode TextureImage::getMagMode() const
+{
+    return mag_mode_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the sampler interpolation used for minification.
+///
+/// \return The minification filter mode.
+Texture::FilterMode TextureImage::getMinMode() const
+{
+    return min_mode_;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  loads a texture object from a sandwich.
 ///
@@ -236,24 +537,8 @@ std::unique_ptr<Texture> loadTexture(sw::Sandwich& sandwich, const Id& texture_i
 
     try
     {
-        db::StmtCache& cache = sandwich.getStmtCache();
-        db::CachedStmt get_texture = cache.hold(Id(PBJ_GFX_TEXTURE_SQLID_LOAD), PBJ_GFX_TEXTURE_SQL_LOAD);
-
-        get_texture.bind(1, texture_id.value());
-        if (get_texture.step())
-        {
-            const void* data;
-            GLsizei data_length = get_texture.getBlob(0, data);
-
-            Texture::InternalFormat internal_format = static_cast<Texture::InternalFormat>(get_texture.getInt(1));
-            bool srgb = get_texture.getBool(2);
-            Texture::FilterMode mag_mode = static_cast<Texture::FilterMode>(get_texture.getInt(3));
-            Texture::FilterMode min_mode = static_cast<Texture::FilterMode>(get_texture.getInt(4));
-
-            result.reset(new Texture(static_cast<const GLubyte*>(data), data_length, internal_format, srgb, mag_mode, min_mode));
-        }
-        else
-            throw std::runtime_error("Texture not found!");
+        db::CachedStmt get_texture = sandwich.getStmtCache().hold(Id(PBJ_GFX_TEXTURE_SQLID_LOAD), PBJ_GFX_TEXTURE_SQL_LOAD);
+        result.reset(new Texture(*readTextureImage(sandwich.getDb(), get_texture, texture_id)));
     }
     catch (const db::Db::error& err)
     {
@@ -274,5 +559,81 @@ std::unique_ptr<Texture> loadTexture(sw::Sandwich& sandwich, const Id& texture_i
    return result;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Decodes a texture's image from a sandwich without uploading it to
+///         the GPU.
+///
+/// \details The image is read using a connection from the sandwich's
+///         connection pool, so this may be called from any thread, and the
+///         result can be uploaded later on the thread that owns the GL
+///         context using the Texture(const TextureImage&) constructor.
+///
+/// \param  sandwich The database from which to load the texture.
+/// \param  texture_id Identifies the texture to load from the database.
+/// \return A unique_ptr owning the decoded image, or an empty unique_ptr
+///         if there is a problem with the load.
+std::unique_ptr<TextureImage> decodeTexture(sw::Sandwich& sandwich, const Id& texture_id)
+{
+    std::unique_ptr<TextureImage> result;
+
+    try
+    {
+        db::PooledDb conn = sandwich.getConnectionPool().acquire();
+        db::CachedStmt get_texture = conn.hold(Id(PBJ_GFX_TEXTURE_SQLID_LOAD), PBJ_GFX_TEXTURE_SQL_LOAD);
+        result = readTextureImage(conn.getDb(), get_texture, texture_id);
+    }
+    catch (const db::Db::error& err)
+    {
+        PBJ_LOG(VWarning) << "Database error while decoding texture!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << " Texture ID: " << texture_id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_NL
+                          << "        SQL: " << err.sql() << PBJ_LOG_END;
+    }
+    catch (const std::exception& err)
+    {
+        PBJ_LOG(VWarning) << "Exception while decoding texture!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << " Texture ID: " << texture_id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_END;
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Identifies the content of a texture, so that textures with
+///         identical content in different sandwiches can be recognized
+///         without reading their blobs.
+///
+/// \details The content hash stored with the texture's blob (see
+///         sw::hashContent()) is combined with its format and filter modes,
+///         since the same image can produce different textures.
+///
+///         Sandwiches whose schema predates content hashes, and textures
+///         which don't have one, are not reported as errors.
+///
+/// \param  sandwich The database containing the texture.
+/// \param  texture_id Identifies the texture.
+/// \return A hash identifying the texture's content, or 0 if it is unknown.
+U64 getTextureContentHash(sw::Sandwich& sandwich, const Id& texture_id)
+{
+    try
+    {
+        db::CachedStmt get_hash = sandwich.getStmtCache().hold(Id(PBJ_GFX_TEXTURE_SQLID_CONTENT_HASH), PBJ_GFX_TEXTURE_SQL_CONTENT_HASH);
+        get_hash.bind(1, texture_id.value());
+        if (!get_hash.step() || get_hash.getType(0) == SQLITE_NULL)
+            return 0;
+
+        I32 params[4] = { get_hash.getInt(1), get_hash.getInt(2), get_hash.getInt(3), get_hash.getInt(4) };
+        U64 hash = get_hash.getUInt64(0);
+        return be::hashBytes(params, sizeof(params), hash);
+    }
+    catch (const db::Db::error&)
+    {
+        return 0;   // no content_hash column
+    }
+}
+
 } // namespace pbj::gfx
 } // namespace pbj
@@ -28,9 +28,9 @@
 #define PBJ_GFX_TEXTURE_FONT_SQLID_LOAD         PBJ_GFX_TEXTURE_FONT_SQL_LOAD
 #define PBJ_GFX_TEXTURE_FONT_SQLID_LOAD_CHARS   PBJ_GFX_TEXTURE_FONT_SQL_LOAD_CHARS
 #else
-// TODO: precalculate ids.
-#define PBJ_GFX_TEXTURE_FONT_SQLID_LOAD         PBJ_GFX_TEXTURE_FONT_SQL_LOAD
-#define PBJ_GFX_TEXTURE_FONT_SQLID_LOAD_CHARS   PBJ_GFX_TEXTURE_FONT_SQL_LOAD_CHARS
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_GFX_TEXTURE_FONT_SQLID_LOAD         0x737771278dec7b53
+#define PBJ_GFX_TEXTURE_FONT_SQLID_LOAD_CHARS   0x8cbe85f9660eb5e1
 #endif
 
 namespace pbj {
@@ -12,6 +12,11 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <exception>
+#include <future>
+#include <chrono>
+#include <vector>
+#include <algorithm>
 
 #pragma region SQL queries
 ///////////////////////////////////////////////////////////////////////////////
@@ -49,6 +54,75 @@
     "pos_x, pos_y, scale_x, scale_y, material_sw_id, material_id) " \
     "VALUES (?,?,?,?,?,?,?,?,?,?)"
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to check if a sandwich has an R*Tree index of
+///         entity bounds.
+#define PBJSQL_ENTITY_BOUNDS_EXIST \
+    "SELECT count(*) FROM sqlite_master " \
+    "WHERE type='table' AND name='sw_map_entity_bounds'"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to find the entities of a map whose bounds intersect
+///         a rectangle using the sw_map_entity_bounds R*Tree.
+/// \details CROSS JOIN forces SQLite to search the R*Tree first instead of
+///         visiting every entity in the map and looking up its bounds.
+#define PBJSQL_GET_ENTITIES_IN_REGION \
+    "SELECT k.entity_id FROM sw_map_entity_bounds b " \
+    "CROSS JOIN sw_map_entity_bounds_keys k ON k.id = b.id " \
+    "WHERE b.max_x >= ? AND b.min_x <= ? AND b.max_y >= ? AND b.min_y <= ? AND k.map_id = ?"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to find the entities of a map whose bounds intersect
+///         a rectangle in sandwiches without an R*Tree index.
+/// \details Bounds are calculated the same way as the sw_map_entity_bounds
+///         triggers created by sw.exe: a square whose half-width is at least
+///         half the diagonal of the entity, so it contains the entity at any
+///         rotation.
+#define PBJSQL_SCAN_ENTITIES_IN_REGION \
+    "SELECT entity_id FROM sw_map_entities " \
+    "WHERE pos_x + max(abs(scale_x), abs(scale_y)) * 0.7072 >= ? " \
+    "AND pos_x - max(abs(scale_x), abs(scale_y)) * 0.7072 <= ? " \
+    "AND pos_y + max(abs(scale_x), abs(scale_y)) * 0.7072 >= ? " \
+    "AND pos_y - max(abs(scale_x), abs(scale_y)) * 0.7072 <= ? AND map_id = ?"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to check if a sandwich has a table of map resource
+///         manifests.
+#define PBJSQL_MANIFESTS_EXIST \
+    "SELECT count(*) FROM sqlite_master " \
+    "WHERE type='table' AND name='sw_map_manifests'"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to create the map resource manifest table if it
+///         does not exist.
+/// \details Each row is one resource (see sw::ManifestEntry) which was used
+///         the last time the map was loaded.
+#define PBJSQL_CREATE_MANIFESTS \
+    "CREATE TABLE IF NOT EXISTS sw_map_manifests (" \
+    "map_id INTEGER NOT NULL, " \
+    "resource_type INTEGER NOT NULL, " \
+    "sandwich_id INTEGER NOT NULL, " \
+    "resource_id INTEGER NOT NULL, " \
+    "PRIMARY KEY (map_id, resource_type, sandwich_id, resource_id))"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to load a map's resource manifest from a sandwich.
+#define PBJSQL_LOAD_MANIFEST \
+    "SELECT resource_type, sandwich_id, resource_id " \
+    "FROM sw_map_manifests WHERE map_id = ?"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to clear a map's resource manifest in a sandwich.
+#define PBJSQL_CLEAR_MANIFEST \
+    "DELETE FROM sw_map_manifests WHERE map_id = ?"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to add a resource to a map's resource manifest.
+#define PBJSQL_SAVE_MANIFEST \
+    "INSERT INTO sw_map_manifests " \
+    "(map_id, resource_type, sandwich_id, resource_id) " \
+    "VALUES (?,?,?,?)"
+
 #ifdef BE_ID_NAMES_ENABLED
 #define PBJSQLID_LOAD_SCENE      PBJSQL_LOAD_SCENE
 #define PBJSQLID_GET_ENTITIES    PBJSQL_GET_ENTITIES
@@ -56,20 +130,84 @@
 #define PBJSQLID_CLEAR_ENTITIES  PBJSQL_CLEAR_ENTITIES
 #define PBJSQLID_LOAD_ENTITY     PBJSQL_LOAD_ENTITY
 #define PBJSQLID_SAVE_ENTITY     PBJSQL_SAVE_ENTITY
+#define PBJSQLID_GET_ENTITIES_IN_REGION  PBJSQL_GET_ENTITIES_IN_REGION
+#define PBJSQLID_SCAN_ENTITIES_IN_REGION PBJSQL_SCAN_ENTITIES_IN_REGION
+#define PBJSQLID_LOAD_MANIFEST   PBJSQL_LOAD_MANIFEST
+#define PBJSQLID_CLEAR_MANIFEST  PBJSQL_CLEAR_MANIFEST
+#define PBJSQLID_SAVE_MANIFEST   PBJSQL_SAVE_MANIFEST
 #else
-// TODO: precalculate ids.
-#define PBJSQLID_LOAD_SCENE      PBJSQL_LOAD_SCENE
-#define PBJSQLID_GET_ENTITIES    PBJSQL_GET_ENTITIES
-#define PBJSQLID_SAVE_SCENE      PBJSQL_SAVE_SCENE
-#define PBJSQLID_CLEAR_ENTITIES  PBJSQL_CLEAR_ENTITIES
-#define PBJSQLID_LOAD_ENTITY     PBJSQL_LOAD_ENTITY
-#define PBJSQLID_SAVE_ENTITY     PBJSQL_SAVE_ENTITY
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJSQLID_LOAD_SCENE      0x021a026693b698a2
+#define PBJSQLID_GET_ENTITIES    0x6e65c904c6299b14
+#define PBJSQLID_SAVE_SCENE      0x98b895c281d48a57
+#define PBJSQLID_CLEAR_ENTITIES  0x5df3bfb12dfbc012
+#define PBJSQLID_LOAD_ENTITY     0x380e8ca1c6a08d6c
+#define PBJSQLID_SAVE_ENTITY     0xc464aad967eb1991
+#define PBJSQLID_GET_ENTITIES_IN_REGION  0x58f4e3abd2055a12
+#define PBJSQLID_SCAN_ENTITIES_IN_REGION 0x03c104cb78918b68
+#define PBJSQLID_LOAD_MANIFEST   0xb947bf08efb5cefc
+#define PBJSQLID_CLEAR_MANIFEST  0x3547e8ae0f77dce9
+#define PBJSQLID_SAVE_MANIFEST   0xb7f4be268d8de2be
 #endif
 
 #pragma endregion
 
 namespace pbj {
 namespace scene {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  A copy of the data saved for an entity, so
+///         that it can be written to a sandwich after the entity has changed
+///         or been destroyed.
+struct EntityRow
+{
+    explicit EntityRow(Entity& entity)
+        : entity_id(entity.getSceneId()),
+          type(entity.getType()),
+          rotation(entity.getTransform().getRotation()),
+          position(entity.getTransform().getPosition()),
+          scale(entity.getTransform().getScale()),
+          has_material(entity.getMaterial() != nullptr)
+    {
+        if (has_material)
+            material = entity.getMaterial()->getId();
+    }
+
+    U32 entity_id;
+    Entity::EntityType type;
+    F32 rotation;
+    vec2 position;
+    vec2 scale;
+    bool has_material;
+    sw::ResourceId material;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Binds parameters 2 through 10 of
+///         #PBJSQL_SAVE_ENTITY.
+void bindEntityRow(db::Stmt& stmt, const EntityRow& row)
+{
+    stmt.bind(2, row.entity_id);
+    stmt.bind(3, row.type);
+    stmt.bind(4, row.rotation);
+    stmt.bind(5, row.position.x);
+    stmt.bind(6, row.position.y);
+    stmt.bind(7, row.scale.x);
+    stmt.bind(8, row.scale.y);
+    if (row.has_material)
+    {
+        stmt.bind(9, row.material.sandwich.value());
+        stmt.bind(10, row.material.resource.value());
+    }
+    else
+    {
+        stmt.bind(9);
+        stmt.bind(10);
+    }
+}
+
+} // namespace pbj::scene::(anon)
 
 ////////////////////////////////////////////////////////////////////////////////
 /// \fn Scene::Scene()
@@ -88,8 +226,8 @@ Scene::Scene()
       _localPlayerId(U32(-1)),
       _nextBulletId(U32(-1))
 {
-    _bulletMaterial = &_resources.getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("bullet")));
-    _spawnPointMaterial = &_resources.getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("spawnpoint")));
+    _bulletMaterial = &_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_BULLET)));
+    _spawnPointMaterial = &_engine.getResourceManager().getMaterial(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_SPAWNPOINT)));
 
     _physWorld.SetAllowSleeping(true);
     _physWorld.SetContactListener(this);
@@ -104,7 +242,7 @@ Scene::Scene()
 /// \date   2013-08-22
 void Scene::makeHud()
 {
-    sw::ResourceId font_id(Id(PBJ_ID_PBJBASE), Id("std_font"));
+    sw::ResourceId font_id(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_FONT));
     const gfx::TextureFont* font = &_engine.getResourceManager().getTextureFont(font_id);
 
     // Draws the UI to the screen with seperate lines for the kills/deaths and health
@@ -155,6 +293,8 @@ void Scene::makeHud()
 ///          and draw its members.  This will also draw the UI.
 void Scene::draw()
 {
+    checkManifestSaved();
+
     // Set up scene camera
     Entity* current_camera = getCurrentCamera();
     if (current_camera)
@@ -319,6 +459,24 @@ void Scene::physUpdate(F32 dt)
     _toDisable.clear();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \fn sw::ResourceManager& Scene::getResourceManager()
+///
+/// \brief Gets the ResourceManager which the scene's map resources are
+///        loaded from.
+///
+/// \details This is the engine's ResourceManager.  The scene holds handles to
+///          the materials its entities use, so when the scene is destroyed
+///          they stay resident (making it cheap to load a map which uses
+///          them again) until they are evicted to stay within the
+///          ResourceManager's memory budget.
+///
+/// \return The ResourceManager used by the scene.
+sw::ResourceManager& Scene::getResourceManager()
+{
+    return _engine.getResourceManager();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \fn b2World* Scene::getWorld()
 ///
@@ -505,9 +663,9 @@ U32 Scene::makePlayer(const std::string& name, const vec2& position, bool local_
     e->getPlayerComponent()->setAmmoRemaining(30);
 
     e->addAudioSource();
-    e->getAudioSource()->addBuffer("fire", _engine.getResourceManager().getSound(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("wpnfire"))));
-    e->getAudioSource()->addBuffer("dmg", _engine.getResourceManager().getSound(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("dmg"))));
-    e->getAudioSource()->addBuffer("death", _engine.getResourceManager().getSound(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("death"))));
+    e->getAudioSource()->addBuffer("fire", _engine.getResourceManager().getSound(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_WPNFIRE))));
+    e->getAudioSource()->addBuffer("dmg", _engine.getResourceManager().getSound(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_DMG))));
+    e->getAudioSource()->addBuffer("death", _engine.getResourceManager().getSound(sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_DEATH))));
     e->getAudioSource()->updatePosition();
     e->getAudioSource()->updateVelocity();
 
@@ -982,12 +1140,47 @@ void Scene::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
 {
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \fn void Scene::checkManifestSaved()
+///
+/// \brief  Logs an error if refreshing the map's resource manifest failed.
+///
+/// \details Called every frame by draw(); does nothing until the manifest
+///         has been written.
+///
+/// \author Ben Crist
+void Scene::checkManifestSaved()
+{
+    if (!_manifestSaved.valid() ||
+        _manifestSaved.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+
+    try
+    {
+        _manifestSaved.get();
+    }
+    catch (const std::exception& err)
+    {
+        PBJ_LOG(VWarning) << "Failed to refresh map resource manifest!" << PBJ_LOG_NL
+                          << "      Map: " << _name << PBJ_LOG_NL
+                          << "Exception: " << err.what() << PBJ_LOG_END;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \fn std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich,
 ///     const Id& map_id)
 ///
 /// \brief  Loads a scene.
 ///
+/// \details The resources in the map's manifest (see loadMapManifest()) are
+///         prefetched before any entities are loaded.  If the resources the
+///         entities actually use differ from the manifest, the manifest is
+///         refreshed, but only in the editor or if something is already
+///         writing to the sandwich (see sw::findWriter()); the game never
+///         opens a sandwich for writing just to refresh a manifest.  Errors
+///         writing the manifest are logged by Scene::draw().
+///
 /// \author Ben Crist
 /// \date   2013-08-22
 ///
@@ -1019,14 +1212,34 @@ std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich, const Id& map_id)
           s->physUpdate(0.1);
 #endif
 
+          // Stream in everything the map used last time, then record what
+          // it actually uses this time.
+          std::vector<sw::ManifestEntry> manifest = loadMapManifest(sandwich, map_id);
+          sw::ResourceManager& resources = s->getResourceManager();
+          resources.prefetch(manifest);
+          resources.startRecording();
 
           db::CachedStmt s2 = cache.hold(Id(PBJSQLID_GET_ENTITIES), PBJSQL_GET_ENTITIES);
 
           s2.bind(1, map_id.value());
-          while (s2.step())
-          {
-                Id entity_id(s2.getUInt64(0));
+          for (auto& entity_id : s2.rows<Id>())
                 loadEntity(sandwich, map_id, entity_id, *s);
+
+          std::vector<sw::ManifestEntry> used = resources.stopRecording();
+#ifdef PBJ_EDITOR
+          bool refresh = true;
+#else
+          bool refresh = sw::findWriter(sandwich.getId()) != nullptr;
+#endif
+          if (used != manifest && refresh)
+          {
+              PBJ_LOG(VInfo) << "Map resource manifest is missing or out of date; refreshing." << PBJ_LOG_NL
+                             << "    Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                             << "         Map ID: " << map_id << PBJ_LOG_NL
+                             << "Resources (Old): " << manifest.size() << PBJ_LOG_NL
+                             << "Resources (New): " << used.size() << PBJ_LOG_END;
+
+              s->_manifestSaved = saveMapManifest(sandwich.getId(), map_id, used);
           }
      }
      catch (const db::Db::error& err)
@@ -1050,6 +1263,112 @@ std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich, const Id& map_id)
     return s;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \fn std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich,
+///     const Id& map_id, const vec2& min, const vec2& max)
+///
+/// \brief  Loads only the entities of a scene which may intersect a
+///         rectangular region.
+///
+/// \details Entities are found using getEntitiesInRegion(), so some entities
+///         slightly outside the region may also be loaded.
+///
+/// \param [in,out] sandwich    The sandwich.
+/// \param  map_id              Identifier for the map.
+/// \param  min                 The lower-left corner of the region.
+/// \param  max                 The upper-right corner of the region.
+///
+/// \return The scene.
+std::unique_ptr<Scene> loadScene(sw::Sandwich& sandwich, const Id& map_id, const vec2& min, const vec2& max)
+{
+    std::unique_ptr<Scene> s;
+
+    try
+    {
+        std::vector<Id> entities = getEntitiesInRegion(sandwich, map_id, min, max);
+
+        s.reset(new Scene());
+
+#ifndef PBJ_EDITOR
+        s->initBulletRing();
+        s->physUpdate(0.1);
+#endif
+
+        for (auto& entity_id : entities)
+            loadEntity(sandwich, map_id, entity_id, *s);
+    }
+    catch (const db::Db::error& err)
+    {
+        s.reset(new Scene());
+        PBJ_LOG(VWarning) << "Database error while loading scene region!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "     Map ID: " << map_id << PBJ_LOG_NL
+                          << "     Region: (" << min.x << ", " << min.y << ") - ("
+                                            << max.x << ", " << max.y << ")" << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_NL
+                          << "        SQL: " << err.sql() << PBJ_LOG_END;
+    }
+    catch (const std::exception& err)
+    {
+        s.reset(new Scene());
+        PBJ_LOG(VWarning) << "Exception while loading scene region!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "     Map ID: " << map_id << PBJ_LOG_NL
+                          << "     Region: (" << min.x << ", " << min.y << ") - ("
+                                            << max.x << ", " << max.y << ")" << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_END;
+    }
+
+    return s;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn std::vector<Id> getEntitiesInRegion(sw::Sandwich& sandwich,
+///     const Id& map_id, const vec2& min, const vec2& max)
+///
+/// \brief  Finds the entities of a map which may intersect a rectangular
+///         region.
+///
+/// \details If the sandwich has a sw_map_entity_bounds R*Tree (created by
+///         sw::migrateSchema()) it is used to find candidate entities
+///         without scanning the whole map.  Otherwise every entity in the
+///         map is tested.
+///
+///         Entity bounds are conservative (they do not depend on the entity's
+///         rotation) so the result may contain entities which do not quite
+///         touch the region, but never omits an entity which does.
+///
+/// \param [in,out] sandwich    The sandwich.
+/// \param  map_id              Identifier for the map.
+/// \param  min                 The lower-left corner of the region.
+/// \param  max                 The upper-right corner of the region.
+///
+/// \return The IDs of the entities found.
+///
+/// \throws db::Db::error if there is a problem querying the sandwich.
+std::vector<Id> getEntitiesInRegion(sw::Sandwich& sandwich, const Id& map_id, const vec2& min, const vec2& max)
+{
+    std::vector<Id> entities;
+
+    db::StmtCache& cache = sandwich.getStmtCache();
+    bool indexed = sandwich.getDb().getInt(PBJSQL_ENTITY_BOUNDS_EXIST, 0) != 0;
+
+    db::CachedStmt stmt = indexed ?
+        cache.hold(Id(PBJSQLID_GET_ENTITIES_IN_REGION), PBJSQL_GET_ENTITIES_IN_REGION) :
+        cache.hold(Id(PBJSQLID_SCAN_ENTITIES_IN_REGION), PBJSQL_SCAN_ENTITIES_IN_REGION);
+
+    stmt.bind(1, double(min.x));
+    stmt.bind(2, double(max.x));
+    stmt.bind(3, double(min.y));
+    stmt.bind(4, double(max.y));
+    stmt.bind(5, map_id.value());
+
+    for (auto& entity_id : stmt.rows<Id>())
+        entities.push_back(entity_id);
+
+    return entities;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \fn void loadEntity(sw::Sandwich& sandwich, const Id& map_id, const Id& entity_id)
 ///
@@ -1072,10 +1391,10 @@ void loadEntity(sw::Sandwich& sandwich, const Id& map_id, const Id& entity_id, S
         stmt.bind(2, entity_id.value());
         if (stmt.step())
         {
-            Entity::EntityType type = static_cast<Entity::EntityType>(stmt.getUInt(0));
-            F32 rotation = float(stmt.getDouble(1));
-            vec2 position = vec2(float(stmt.getDouble(2)), float(stmt.getDouble(3)));
-            vec2 scale = vec2(float(stmt.getDouble(4)), float(stmt.getDouble(5)));
+            Entity::EntityType type = static_cast<Entity::EntityType>(stmt.get<U32>(0));
+            F32 rotation = stmt.get<F32>(1);
+            vec2 position = stmt.get<vec2>(2);
+            vec2 scale = stmt.get<vec2>(4);
 
             const gfx::Material* material = nullptr;
             if (stmt.getType(7) != SQLITE_NULL)
@@ -1083,9 +1402,14 @@ void loadEntity(sw::Sandwich& sandwich, const Id& map_id, const Id& entity_id, S
                 sw::ResourceId material_id;
                 material_id.sandwich = (stmt.getType(6) == SQLITE_NULL)
                                         ? sandwich.getId()
-                                        : Id(stmt.getUInt64(6));
-                material_id.resource = Id(stmt.getUInt64(7));
-                material = &scene._resources.getMaterial(material_id);
+                                        : stmt.get<Id>(6);
+                material_id.resource = stmt.get<Id>(7);
+
+                sw::ResourceHandle<gfx::Material>& handle = scene._materials[material_id];
+                if (handle.isNull())
+                    handle = scene.getResourceManager().acquireMaterial(material_id);
+
+                material = handle.get();
             }
 
             switch (type)
@@ -1140,130 +1464,239 @@ void loadEntity(sw::Sandwich& sandwich, const Id& map_id, const Id& entity_id, S
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \fn void saveScene(const Id& sandwich_id, const Id& map_id)
+/// \fn std::future<void> saveScene(const Id& sandwich_id, const Id& map_id)
 ///
 /// \brief  Saves a scene.
 ///
+/// \details The scene's name and entities are copied, then written by the
+///         sandwich's background writer, so this function does not wait for
+///         the database.  The scene's name and all of its entities are saved
+///         in a single transaction.  Errors are logged by the writer thread.
+///
 /// \author Ben Crist
 /// \date   2013-08-22
 ///
 /// \param  sandwich_id Identifier for the sandwich.
 /// \param  map_id      Identifier for the map.
-void Scene::saveScene(const Id& sandwich_id, const Id& map_id)
+/// \return A future which becomes ready when the scene has been committed.
+std::future<void> Scene::saveScene(const Id& sandwich_id, const Id& map_id)
 {
-   try
+   std::shared_ptr<db::AsyncWriter> writer = sw::getWriter(sandwich_id);
+   if (!writer)
    {
-      std::shared_ptr<sw::Sandwich> sandwich = sw::openWritable(sandwich_id);
-      if (!sandwich)
-         throw std::runtime_error("Could not open sandwich for writing!");
+      PBJ_LOG(VWarning) << "Exception while saving scene!" << PBJ_LOG_NL
+                       << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
+                       <<      "Map ID: " << map_id << PBJ_LOG_NL
+                       << "  Exception: Could not open sandwich for writing!" << PBJ_LOG_END;
 
-      db::Db& db = sandwich->getDb();
-      db::Transaction transaction(db, db::Transaction::Immediate);
-      db::CachedStmt& stmt = sandwich->getStmtCache().hold(Id(PBJSQLID_SAVE_SCENE), PBJSQL_SAVE_SCENE);
-      stmt.bind(1, map_id.value());
-      stmt.bind(2, getName());
-      stmt.step();
+      std::promise<void> failed;
+      failed.set_exception(std::make_exception_ptr(std::runtime_error("Could not open sandwich for writing!")));
+      return failed.get_future();
+   }
 
-      db::CachedStmt& s2 = sandwich->getStmtCache().hold(Id(PBJSQLID_CLEAR_ENTITIES), PBJSQL_CLEAR_ENTITIES);
-      s2.bind(1, map_id.value());
-      s2.step();
+   std::string name(getName());
+   std::vector<EntityRow> entities;
+   entities.reserve(_spawnPoints.size() + _terrain.size());
+   for (auto i(_spawnPoints.begin()), end(_spawnPoints.end()); i != end; ++i)
+      if (i->second)
+         entities.push_back(EntityRow(*i->second));
 
-      transaction.commit();
+   for (auto i(_terrain.begin()), end(_terrain.end()); i != end; ++i)
+      if (i->second)
+         entities.push_back(EntityRow(*i->second));
 
-      for (auto i(_spawnPoints.begin()), end(_spawnPoints.end()); i != end; ++i)
+   return writer->submit([=](db::Db& db, db::StmtCache& cache)
+   {
+      try
       {
-          saveEntity(sandwich_id, map_id, i->second.get());
+         db::CachedStmt stmt(cache.hold(Id(PBJSQLID_SAVE_SCENE), PBJSQL_SAVE_SCENE));
+         stmt.bind(1, map_id.value());
+         stmt.bind(2, name);
+         stmt.step();
+
+         db::CachedStmt s2(cache.hold(Id(PBJSQLID_CLEAR_ENTITIES), PBJSQL_CLEAR_ENTITIES));
+         s2.bind(1, map_id.value());
+         s2.step();
+
+         // All entities are saved using the same statement in the same
+         // transaction as the scene itself.
+         db::CachedStmt s3(cache.hold(Id(PBJSQLID_SAVE_ENTITY), PBJSQL_SAVE_ENTITY));
+         s3.bind(1, map_id.value());
+         s3.executeMany(entities.begin(), entities.end(), bindEntityRow);
       }
-
-      for (auto i(_terrain.begin()), end(_terrain.end()); i != end; ++i)
+      catch (const db::Db::error& err)
       {
-          saveEntity(sandwich_id, map_id, i->second.get());
+         PBJ_LOG(VWarning) << "Database error while saving scene!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
+                          <<      "Map ID: " << map_id << PBJ_LOG_NL
+                          << "  Exception: " << err.what() << PBJ_LOG_NL
+                          << "        SQL: " << err.sql() << PBJ_LOG_END;
+         throw;
       }
-
-   }
-   catch (const db::Db::error& err)
-   {
-      PBJ_LOG(VWarning) << "Database error while saving scene!" << PBJ_LOG_NL
-                       << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
-                       <<      "Map ID: " << map_id << PBJ_LOG_NL
-                       << "  Exception: " << err.what() << PBJ_LOG_NL
-                       << "        SQL: " << err.sql() << PBJ_LOG_END;
-   }
-   catch (const std::runtime_error& err)
-   {
-      PBJ_LOG(VWarning) << "Exception while saving scene!" << PBJ_LOG_NL
-                       << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
-                       <<      "Map ID: " << map_id << PBJ_LOG_NL
-                       << "  Exception: " << err.what() << PBJ_LOG_END;
-   }
+   });
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \fn void saveEntity(const Id& sandwich_id, const Id& map_id)
+/// \fn std::future<void> saveEntity(const Id& sandwich_id, const Id& map_id, Entity* entity)
 ///
 /// \brief  Saves an entity.
 ///
+/// \details The entity is copied, then written by the sandwich's background
+///         writer, so this function does not wait for the database.
+///
 /// \author Ben Crist
 /// \date   2013-08-22
 ///
 /// \param  sandwich_id Identifier for the sandwich.
 /// \param  map_id      Identifier for the map.
+/// \param  entity      The entity to save.
+/// \return A future which becomes ready when the entity has been committed.
 ////////////////////////////////////////////////////////////////////////////////
-void saveEntity(const Id& sandwich_id, const Id& map_id, Entity* entity)
+std::future<void> saveEntity(const Id& sandwich_id, const Id& map_id, Entity* entity)
 {
-    if (!entity)
-        return;
+    std::shared_ptr<db::AsyncWriter> writer;
+    if (entity)
+        writer = sw::getWriter(sandwich_id);
 
-    try
+    if (!writer)
     {
-      std::shared_ptr<sw::Sandwich> sandwich = sw::openWritable(sandwich_id);
-      if (!sandwich)
-         throw std::runtime_error("Could not open sandwich for writing!");
-
-      db::Db& db = sandwich->getDb();
-      db::Transaction transaction(db, db::Transaction::Immediate);
-
-      db::CachedStmt& stmt = sandwich->getStmtCache().hold(Id(PBJSQLID_SAVE_ENTITY), PBJSQL_SAVE_ENTITY);
-      stmt.bind(1, map_id.value());
-      stmt.bind(2, entity->getSceneId());
-      stmt.bind(3, entity->getType());
-      stmt.bind(4, entity->getTransform().getRotation());
-      stmt.bind(5, entity->getTransform().getPosition().x);
-      stmt.bind(6, entity->getTransform().getPosition().y);
-      stmt.bind(7, entity->getTransform().getScale().x);
-      stmt.bind(8, entity->getTransform().getScale().y);
-      if (entity->getMaterial())
-      {
-          stmt.bind(9, entity->getMaterial()->getId().sandwich.value());
-          stmt.bind(10, entity->getMaterial()->getId().resource.value());
-      }
-      else
-      {
-          stmt.bind(9);
-          stmt.bind(10);
-      }
-      stmt.step();
+        std::promise<void> failed;
+        if (entity)
+        {
+            PBJ_LOG(VWarning) << "Exception while saving scene!" << PBJ_LOG_NL
+                             << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
+                             << "     Map ID: " << map_id << PBJ_LOG_NL
+                             << "  Entity ID: " << entity->getSceneId() << PBJ_LOG_NL
+                             << "  Exception: Could not open sandwich for writing!" << PBJ_LOG_END;
+            failed.set_exception(std::make_exception_ptr(std::runtime_error("Could not open sandwich for writing!")));
+        }
+        else
+            failed.set_value();
 
-      transaction.commit();
-   }
-   catch (const db::Db::error& err)
-   {
-      PBJ_LOG(VWarning) << "Database error while saving scene!" << PBJ_LOG_NL
-                       << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
-                       << "     Map ID: " << map_id << PBJ_LOG_NL
-                       << "  Entity ID: " << entity->getSceneId() << PBJ_LOG_NL
-                       << "  Exception: " << err.what() << PBJ_LOG_NL
-                       << "        SQL: " << err.sql() << PBJ_LOG_END;
-   }
-   catch (const std::runtime_error& err)
-   {
-      PBJ_LOG(VWarning) << "Exception while saving scene!" << PBJ_LOG_NL
-                       << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
-                       << "     Map ID: " << map_id << PBJ_LOG_NL
-                       << "  Entity ID: " << entity->getSceneId() << PBJ_LOG_NL
-                       << "  Exception: " << err.what() << PBJ_LOG_END;
-   }
+        return failed.get_future();
+    }
+
+    EntityRow row(*entity);
+    return writer->submit([=](db::Db& db, db::StmtCache& cache)
+    {
+        try
+        {
+            db::CachedStmt stmt(cache.hold(Id(PBJSQLID_SAVE_ENTITY), PBJSQL_SAVE_ENTITY));
+            stmt.bind(1, map_id.value());
+            stmt.executeMany(&row, &row + 1, bindEntityRow);
+        }
+        catch (const db::Db::error& err)
+        {
+            PBJ_LOG(VWarning) << "Database error while saving scene!" << PBJ_LOG_NL
+                             << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
+                             << "     Map ID: " << map_id << PBJ_LOG_NL
+                             << "  Entity ID: " << row.entity_id << PBJ_LOG_NL
+                             << "  Exception: " << err.what() << PBJ_LOG_NL
+                             << "        SQL: " << err.sql() << PBJ_LOG_END;
+            throw;
+        }
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn std::vector<sw::ManifestEntry> loadMapManifest(sw::Sandwich& sandwich,
+///     const Id& map_id)
+///
+/// \brief  Loads the resources a map used the last time it was loaded.
+///
+/// \details Manifests are recorded by loadScene() and stored in the map's
+///         sandwich, in the sw_map_manifests table.  Sandwiches which have
+///         never had a map loaded from them (or which are packed, and were
+///         packed before their maps were loaded) have no manifests.
+///
+/// \author Ben Crist
+///
+/// \param [in,out] sandwich    The sandwich.
+/// \param  map_id              Identifier for the map.
+///
+/// \return The map's manifest, sorted and without duplicates, or an empty
+///         vector if the map does not have one.
+///
+/// \throws db::Db::error if there is a problem querying the sandwich.
+std::vector<sw::ManifestEntry> loadMapManifest(sw::Sandwich& sandwich, const Id& map_id)
+{
+    std::vector<sw::ManifestEntry> manifest;
+
+    if (sandwich.getDb().getInt(PBJSQL_MANIFESTS_EXIST, 0) == 0)
+        return manifest;
+
+    db::CachedStmt stmt = sandwich.getStmtCache().hold(Id(PBJSQLID_LOAD_MANIFEST), PBJSQL_LOAD_MANIFEST);
+    stmt.bind(1, map_id.value());
+    while (stmt.step())
+    {
+        sw::ManifestEntry::ResourceType type = static_cast<sw::ManifestEntry::ResourceType>(stmt.get<U32>(0));
+        manifest.push_back(sw::ManifestEntry(type, sw::ResourceId(stmt.get<Id>(1), stmt.get<Id>(2))));
+    }
+
+    // SQLite sorts Ids as signed integers, so sort them again here.
+    std::sort(manifest.begin(), manifest.end());
+    return manifest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn std::future<void> saveMapManifest(const Id& sandwich_id,
+///     const Id& map_id, const std::vector<sw::ManifestEntry>& manifest)
+///
+/// \brief  Replaces the resource manifest of a map.
+///
+/// \details The manifest is written by the sandwich's background writer, so
+///         this function does not wait for the database.  The
+///         sw_map_manifests table is created if necessary.
+///
+/// \author Ben Crist
+///
+/// \param  sandwich_id Identifier for the sandwich.
+/// \param  map_id      Identifier for the map.
+/// \param  manifest    The resources used by the map.
+///
+/// \return A future which becomes ready when the manifest has been
+///         committed.
+std::future<void> saveMapManifest(const Id& sandwich_id, const Id& map_id, const std::vector<sw::ManifestEntry>& manifest)
+{
+    std::shared_ptr<db::AsyncWriter> writer(sw::getWriter(sandwich_id));
+    if (!writer)
+    {
+        std::promise<void> failed;
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("Could not open sandwich for writing!")));
+        return failed.get_future();
+    }
+
+    return writer->submit([=](db::Db& db, db::StmtCache& cache)
+    {
+        try
+        {
+            db.exec(PBJSQL_CREATE_MANIFESTS);
+
+            db::CachedStmt clear(cache.hold(Id(PBJSQLID_CLEAR_MANIFEST), PBJSQL_CLEAR_MANIFEST));
+            clear.bind(1, map_id.value());
+            clear.step();
+
+            db::CachedStmt save(cache.hold(Id(PBJSQLID_SAVE_MANIFEST), PBJSQL_SAVE_MANIFEST));
+            save.bind(1, map_id.value());
+            save.executeMany(manifest.begin(), manifest.end(),
+                [](db::Stmt& stmt, const sw::ManifestEntry& entry)
+                {
+                    stmt.bind(2, static_cast<int>(entry.type));
+                    stmt.bind(3, entry.id.sandwich.value());
+                    stmt.bind(4, entry.id.resource.value());
+                });
+        }
+        catch (const db::Db::error& err)
+        {
+            PBJ_LOG(VWarning) << "Database error while saving map manifest!" << PBJ_LOG_NL
+                              << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
+                              << "     Map ID: " << map_id << PBJ_LOG_NL
+                              << "  Exception: " << err.what() << PBJ_LOG_NL
+                              << "        SQL: " << err.sql() << PBJ_LOG_END;
+            throw;
+        }
+    });
 }
 
 } // namespace pbj::scene
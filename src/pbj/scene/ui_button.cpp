@@ -23,13 +23,13 @@ UIButton::UIButton()
       kbd_active_(false),
       hovered_(false)
 {
-    style_ids_[SNormal]         = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.normal"));
-    style_ids_[SHovered]        = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.hovered"));
-    style_ids_[SActive]         = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.active"));
-    style_ids_[SFocused]        = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.focused"));
-    style_ids_[SFocusedHovered] = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.focused_hovered"));
-    style_ids_[SFocusedActive]  = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.focused_active"));
-    style_ids_[SDisabled]       = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id("std_btn.disabled"));
+    style_ids_[SNormal]         = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_NORMAL));
+    style_ids_[SHovered]        = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_HOVERED));
+    style_ids_[SActive]         = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_ACTIVE));
+    style_ids_[SFocused]        = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_FOCUSED));
+    style_ids_[SFocusedHovered] = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_FOCUSED_HOVERED));
+    style_ids_[SFocusedActive]  = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_FOCUSED_ACTIVE));
+    style_ids_[SDisabled]       = sw::ResourceId(Id(PBJ_ID_PBJBASE), Id(PBJ_ID_STD_BTN_DISABLED));
 
     label_.setAlign(UILabel::AlignCenter);
 }
@@ -27,9 +27,9 @@
 #define PBJ_SCENE_UI_STYLES_SQLID_LOAD_PSTYLE PBJ_SCENE_UI_STYLES_SQL_LOAD_PSTYLE
 #define PBJ_SCENE_UI_STYLES_SQLID_LOAD_BSTYLE PBJ_SCENE_UI_STYLES_SQL_LOAD_BSTYLE
 #else
-// TODO: precalculate ids.
-#define PBJ_SCENE_UI_STYLES_SQLID_LOAD_PSTYLE PBJ_SCENE_UI_STYLES_SQL_LOAD_PSTYLE
-#define PBJ_SCENE_UI_STYLES_SQLID_LOAD_BSTYLE PBJ_SCENE_UI_STYLES_SQL_LOAD_BSTYLE
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_SCENE_UI_STYLES_SQLID_LOAD_PSTYLE 0xbc9e849b55d2ab12
+#define PBJ_SCENE_UI_STYLES_SQLID_LOAD_BSTYLE 0x68508be157dbad83
 #endif
 
 namespace pbj {
@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/detail/stream_queue.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of pbj::sw::detail::StreamQueue functions.
+
+#include "pbj/sw/detail/stream_queue.h"
+
+#include <cassert>
+
+namespace pbj {
+namespace sw {
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs an empty queue.
+///
+/// \param  worker_count The number of worker threads to start when the
+///         first load is queued.  If 0, one less than the number of hardware
+///         threads is used (but at least one), leaving a core for the thread
+///         which processes uploads.
+StreamQueue::StreamQueue(size_t worker_count)
+    : worker_count_(worker_count),
+      streaming_(0),
+      stopping_(false)
+{
+    if (worker_count_ == 0)
+    {
+        size_t count = std::thread::hardware_concurrency();
+        worker_count_ = count > 2 ? count - 1 : 1;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops the worker threads, if stop() hasn't been called already.
+StreamQueue::~StreamQueue()
+{
+    stop();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the number of worker threads which run loads.
+size_t StreamQueue::getWorkerCount() const
+{
+    return worker_count_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Queues a task to run on a worker thread, starting the workers if
+///         necessary.
+///
+/// \details The task must call queueUpload() exactly once.  Must not be
+///         called after stop().
+///
+/// \param  task The task to run.
+void StreamQueue::queueLoad(const Task& task)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(!stopping_);
+
+    if (workers_.empty())
+    {
+        for (size_t i = 0; i < worker_count_; ++i)
+            workers_.push_back(std::thread(&StreamQueue::workerMain_, this));
+    }
+
+    loads_.push_back(task);
+    ++streaming_;
+    load_queued_.notify_one();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Queues a task to be run by processUploads().
+///
+/// \details Usually called by a load task, on a worker thread.
+///
+/// \param  task The task to run.
+void StreamQueue::queueUpload(const Task& task)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uploads_.push_back(task);
+    upload_queued_.notify_one();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Runs upload tasks on the calling thread, in the order they were
+///         queued.
+///
+/// \details At least one task is run per call (if any are waiting) even if
+///         it takes longer than the budget.
+///
+/// \param  budget The amount of time to spend uploading before returning.
+/// \return The number of loads which are still streaming in.
+size_t StreamQueue::processUploads(std::chrono::microseconds budget)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!uploads_.empty())
+    {
+        Task task(std::move(uploads_.front()));
+        uploads_.pop_front();
+        lock.unlock();
+
+        task();
+        --streaming_;
+
+        if (std::chrono::high_resolution_clock::now() - start >= budget)
+            return streaming_;
+
+        lock.lock();
+    }
+
+    return streaming_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Blocks until at least one upload task is waiting, then runs it.
+///
+/// \details Must only be called while loads are streaming in, otherwise it
+///         will never return.
+void StreamQueue::waitForUpload()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (uploads_.empty())
+            upload_queued_.wait(lock);
+    }
+
+    processUploads(std::chrono::microseconds(0));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the number of loads which have been queued but whose
+///         upload tasks haven't been run yet.
+size_t StreamQueue::getStreamingCount() const
+{
+    return streaming_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops the worker threads.
+///
+/// \details Loads which haven't started are abandoned, and queued upload
+///         tasks are never run.  Loads which are running on a worker thread
+///         are allowed to finish first.
+void StreamQueue::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        loads_.clear();
+    }
+
+    load_queued_.notify_all();
+    for (auto i(workers_.begin()), end(workers_.end()); i != end; ++i)
+        i->join();
+
+    workers_.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Runs queued load tasks until stop() is called.
+void StreamQueue::workerMain_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        while (!stopping_ && loads_.empty())
+            load_queued_.wait(lock);
+
+        if (stopping_)
+            return;
+
+        Task task(std::move(loads_.front()));
+        loads_.pop_front();
+        lock.unlock();
+
+        task();
+
+        lock.lock();
+    }
+}
+
+} // namespace pbj::sw::detail
+} // namespace pbj::sw
+} // namespace pbj
@@ -0,0 +1,132 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/manifest.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of pbj::sw::ManifestEntry and
+///         pbj::sw::ManifestRecorder functions.
+
+#include "pbj/sw/manifest.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace pbj {
+namespace sw {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a ManifestEntry referring to no texture.
+ManifestEntry::ManifestEntry()
+    : type(Texture)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a ManifestEntry referring to the resource provided.
+///
+/// \param  type The kind of resource.
+/// \param  id The ResourceId of the resource.
+ManifestEntry::ManifestEntry(ResourceType type, const ResourceId& id)
+    : type(type),
+      id(id)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compares this ManifestEntry with another for equality.
+bool ManifestEntry::operator==(const ManifestEntry& other) const
+{
+    return type == other.type && id == other.id;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compares this ManifestEntry with another for inequality.
+bool ManifestEntry::operator!=(const ManifestEntry& other) const
+{
+    return !(*this == other);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Orders ManifestEntries by type, then by ResourceId.
+bool ManifestEntry::operator<(const ManifestEntry& other) const
+{
+    return type < other.type ||
+           type == other.type && id < other.id;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Constructs a recorder which isn't recording.
+ManifestRecorder::ManifestRecorder()
+    : recording_(false),
+      paused_(0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Starts recording resources.
+///
+/// \details Any resources recorded previously are discarded.
+void ManifestRecorder::start()
+{
+    recorded_.clear();
+    recording_ = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops recording and returns the resources recorded since start()
+///         was called.
+///
+/// \return The resources recorded, sorted and without duplicates.
+std::vector<ManifestEntry> ManifestRecorder::stop()
+{
+    recording_ = false;
+
+    std::vector<ManifestEntry> manifest;
+    manifest.swap(recorded_);
+
+    std::sort(manifest.begin(), manifest.end());
+    manifest.erase(std::unique(manifest.begin(), manifest.end()), manifest.end());
+    return manifest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines whether record() currently records anything.
+///
+/// \return \c true if start() has been called, stop() hasn't been called
+///         since, and the recorder isn't paused.
+bool ManifestRecorder::isRecording() const
+{
+    return recording_ && paused_ == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops recording resources until resume() is called.
+///
+/// \details Calls may be nested; recording resumes once every call to
+///         pause() has been matched by a call to resume().  Pausing does
+///         not discard anything which has already been recorded.
+void ManifestRecorder::pause()
+{
+    ++paused_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Undoes one call to pause().
+void ManifestRecorder::resume()
+{
+    assert(paused_ > 0);
+    --paused_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Adds a resource to the current recording, if there is one.
+///
+/// \param  type The kind of resource.
+/// \param  id The ResourceId of the resource.
+void ManifestRecorder::record(ManifestEntry::ResourceType type, const ResourceId& id)
+{
+    if (isRecording())
+        recorded_.push_back(ManifestEntry(type, id));
+}
+
+} // namespace pbj::sw
+} // namespace pbj
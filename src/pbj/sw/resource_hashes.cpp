@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/resource_hashes.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of pbj::sw::ResourceHashes functions.
+
+#include "pbj/sw/resource_hashes.h"
+
+#include "be/bed/stmt.h"
+
+#include <iostream>
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to read every column of every texture which affects
+///         the texture loaded from it.  The first column must be the id.
+#define PBJ_SW_HASH_SQL_TEXTURES "SELECT id, data, internal_format, srgb, mag_filter, min_filter FROM sw_textures"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to read every column of every material.
+#define PBJ_SW_HASH_SQL_MATERIALS "SELECT id, color, texture_id, texture_mode FROM sw_materials"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to read every column of every sound.
+#define PBJ_SW_HASH_SQL_SOUNDS "SELECT id, data FROM sw_sounds"
+
+namespace pbj {
+namespace sw {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Hashes the columns after the first (the id)
+///         of each row returned by a query.
+///
+/// \details Each value's type is hashed along with its contents, so (for
+///         instance) a NULL texture_id hashes differently from 0.
+void hashRows(Sandwich& sandwich, const char* sql, be::IdMap<U64>& hashes)
+{
+    try
+    {
+        db::Stmt stmt(sandwich.getDb(), sql);
+        int columns = stmt.columns();
+        while (stmt.step())
+        {
+            U64 hash = BE_ID_FNV_OFFSET_BASIS;
+            for (int column = 1; column < columns; ++column)
+            {
+                U8 type = U8(stmt.getType(column));
+                hash = be::hashBytes(&type, sizeof(type), hash);
+
+                switch (type)
+                {
+                case SQLITE_INTEGER:
+                    {
+                        sqlite3_int64 value = stmt.getInt64(column);
+                        hash = be::hashBytes(&value, sizeof(value), hash);
+                        break;
+                    }
+
+                case SQLITE_FLOAT:
+                    {
+                        double value = stmt.getDouble(column);
+                        hash = be::hashBytes(&value, sizeof(value), hash);
+                        break;
+                    }
+
+                case SQLITE_TEXT:
+                case SQLITE_BLOB:
+                    {
+                        const void* data;
+                        int size = stmt.getBlob(column, data);
+                        hash = be::hashBytes(data, size_t(size), hash);
+                        break;
+                    }
+
+                default:
+                    break;
+                }
+            }
+
+            hashes[Id(stmt.getUInt64(0))] = hash;
+        }
+    }
+    catch (const db::Db::error& e)
+    {
+        PBJ_LOG(VWarning) << "Database error while hashing resources!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                          << "  Exception: " << e.what() << PBJ_LOG_NL
+                          << "        SQL: " << e.sql() << PBJ_LOG_END;
+    }
+}
+
+} // namespace pbj::sw::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Calculates a content hash for every texture, material, and sound
+///         in a sandwich.
+///
+/// \details Every column which affects the loaded resource is hashed,
+///         including the full contents of texture and sound blobs, so this
+///         reads (but does not decode) every resource in the sandwich.  It
+///         should only be used when resources need to be compared, for
+///         instance when hot-reloading modified sandwiches.
+///
+///         Uses the sandwich's primary connection, so it must be called from
+///         the thread which owns the sandwich.
+///
+/// \param  sandwich The sandwich to hash.
+/// \return The hashes of each resource.
+ResourceHashes hashResources(Sandwich& sandwich)
+{
+    ResourceHashes hashes;
+    hashRows(sandwich, PBJ_SW_HASH_SQL_TEXTURES, hashes.textures);
+    hashRows(sandwich, PBJ_SW_HASH_SQL_MATERIALS, hashes.materials);
+    hashRows(sandwich, PBJ_SW_HASH_SQL_SOUNDS, hashes.sounds);
+    return hashes;
+}
+
+} // namespace pbj::sw
+} // namespace pbj
@@ -13,81 +13,113 @@
 #include "pbj/sw/sandwich_open.h"
 #include "pbj/_gl.h"
 
+#include <algorithm>
 #include <iostream>
 
 namespace pbj {
 namespace sw {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines if a resource's row has changed between two sets of
+///         content hashes.
+///
+/// \details Resources which no longer exist are not considered modified;
+///         the previously loaded copy is kept.
+bool isModified(const Id& resource_id, const be::IdMap<U64>& before, const be::IdMap<U64>& after)
+{
+    auto a = after.find(resource_id);
+    if (a == after.end())
+        return false;
+
+    auto b = before.find(resource_id);
+    return b == before.end() || b->second != a->second;
+}
+
+} // namespace pbj::sw::(anon)
+
+namespace detail {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns 0; materials don't count toward the budget.
+size_t ResourceSize<gfx::Material>::get(const gfx::Material& material)
+{
+    return 0;
+}
+
+} // namespace pbj::sw::detail
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Constructs an empty ResourceManager.
+///
+/// \details No worker threads are started until the first resource is
+///         requested asynchronously.
 ResourceManager::ResourceManager()
+    : use_clock_(0),
+      textures_(ManifestEntry::Texture, use_clock_, recorder_),
+      materials_(ManifestEntry::Material, use_clock_, recorder_),
+      sounds_(ManifestEntry::Sound, use_clock_, recorder_),
+      placeholder_material_(new gfx::Material(ResourceId(), color4(0.5f, 0.5f, 0.5f, 1.0f), ResourceHandle<gfx::Texture>(), GL_MODULATE)),
+      budget_(PBJ_SW_RESOURCE_BUDGET),
+      evicted_(0),
+      hot_reload_(false)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops any worker threads and destroys all resources.
+///
+/// \details Requests which haven't been decoded yet are abandoned.  All
+///         ResourceHandles referring to this manager's resources must
+///         already have been destroyed.
+ResourceManager::~ResourceManager()
 {
+    stream_.stop();
+
+    // Materials hold handles to textures, so they must be destroyed first.
+    materials_.clear();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Retrieves an audio::Buffer from this ResourceManager, loading it
 ///         from a sandwich if necessary.
 ///
+/// \details If the sound has been requested with requestSound() but has not
+///         finished streaming in, it is loaded immediately and the streamed
+///         copy is discarded when it arrives.
+///
+///         The sound is pinned, so it will never be evicted.  Use
+///         acquireSound() for sounds which are only needed temporarily.
+///
 /// \param  id The ResourceId of the asset to retrieve.
 /// \return A reference to the requested resource.
 /// \throws std::invalid_argument If the Texture could not be loaded.
 audio::Buffer* ResourceManager::getSound(const ResourceId& id)
 {
-    auto i = sounds_.find(id);
-    if (i != sounds_.end())
-        return i->second.get();
-
-    // if we get to here, the resource is not loaded yet.
-    Sandwich& sandwich = getSandwich(id.sandwich);
-
-    std::unique_ptr<audio::Buffer> ptr = audio::loadSound(sandwich, id.resource);
-
-    if (ptr)
-    {
-        audio::Buffer* ab = ptr.get();
-        sounds_[id] = std::move(ptr);
-        return sounds_[id].get();
-    }
-
-    // if we get to here, the resource could not be loaded from the sandwich
-    PBJ_LOG(VError) << "Sound not found!" << PBJ_LOG_NL
-                    << "Sandwich ID: " << id.sandwich << PBJ_LOG_NL
-                    << "   Sound ID: " << id.resource << PBJ_LOG_END;
-
-    throw std::invalid_argument("Sound not found!");
+    detail::ResourceSlot<audio::Buffer>& slot = loadSound_(id);
+    slot.pinned = true;
+    return slot.resource.get();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Retrieves a Material from this ResourceManager, loading it from a
 ///         sandwich if necessary.
 ///
+/// \details The material's texture (if any) is requested asynchronously, so
+///         the material may be drawn untextured for a few frames.
+///
+///         The material is pinned, so it will never be evicted.  Use
+///         acquireMaterial() for materials which are only needed
+///         temporarily.
+///
 /// \param  id The ResourceId of the material to retrieve.
 /// \return A reference to the requested resource.
 /// \throws std::invalid_argument If the Texture could not be loaded.
 const gfx::Material& ResourceManager::getMaterial(const ResourceId& id)
 {
-    auto i = materials_.find(id);
-    if (i != materials_.end())
-        return *i->second;
-
-    // if we get to here, the resource is not loaded yet.
-    Sandwich& sandwich = getSandwich(id.sandwich);
-
-    std::unique_ptr<gfx::Material> ptr = gfx::loadMaterial(sandwich, id.resource, *this);
-
-    if (ptr)
-    {
-        gfx::Material* mat = ptr.get();
-        materials_[id] = std::move(ptr);
-        return *mat;
-    }
-
-    // if we get to here, the resource could not be loaded from the sandwich
-    PBJ_LOG(VError) << "Material not found!" << PBJ_LOG_NL
-                    << "   Sandwich ID: " << id.sandwich << PBJ_LOG_NL
-                    << "TextureFont ID: " << id.resource << PBJ_LOG_END;
-
-    throw std::invalid_argument("TextureFont not found!");
+    detail::ResourceSlot<gfx::Material>& slot = loadMaterial_(id);
+    slot.pinned = true;
+    return *slot.resource;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -127,33 +159,21 @@ const gfx::TextureFont& ResourceManager::getTextureFont(const ResourceId& id)
 /// \brief  Retrieves a Texture from this ResourceManager, loading it from a
 ///         sandwich if necessary.
 ///
+/// \details If the texture has been requested with requestTexture() but has
+///         not finished streaming in, it is loaded immediately and the
+///         streamed copy is discarded when it arrives.
+///
+///         The texture is pinned, so it will never be evicted.  Use
+///         acquireTexture() for textures which are only needed temporarily.
+///
 /// \param  id The ResourceId of the texture to retrieve.
 /// \return A reference to the requested resource.
 /// \throws std::invalid_argument If the Texture could not be loaded.
 const gfx::Texture& ResourceManager::getTexture(const ResourceId& id)
 {
-    auto i = textures_.find(id);
-    if (i != textures_.end())
-        return *i->second;
-
-    // if we get to here, the resource is not loaded yet.
-    Sandwich& sandwich = getSandwich(id.sandwich);
-
-    std::unique_ptr<gfx::Texture> ptr = gfx::loadTexture(sandwich, id.resource);
-
-    if (ptr)
-    {
-        gfx::Texture* tex = ptr.get();
-        textures_[id] = std::move(ptr);
-        return *tex;
-    }
-
-    // if we get to here, the resource could not be loaded from the sandwich
-    PBJ_LOG(VError) << "Texture not found!" << PBJ_LOG_NL
-                    << "Sandwich ID: " << id.sandwich << PBJ_LOG_NL
-                    << " Texture ID: " << id.resource << PBJ_LOG_END;
-
-    throw std::invalid_argument("Texture not found!");
+    detail::ResourceSlot<gfx::Texture>& slot = loadTexture_(id);
+    slot.pinned = true;
+    return *slot.resource;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -166,12 +186,15 @@ const scene::UIPanelStyle& ResourceManager::getUIPanelStyle(const ResourceId& id
 {
     auto i = panel_styles_.find(id);
     if (i != panel_styles_.end())
-        return i->second;
+        return *i->second;
 
     // if we get to here, the resource is not loaded yet.
     Sandwich& sandwich = getSandwich(id.sandwich);
 
-    return panel_styles_[id] = scene::loadUIPanelStyle(sandwich, id.resource);
+    std::unique_ptr<scene::UIPanelStyle> ptr(new scene::UIPanelStyle(scene::loadUIPanelStyle(sandwich, id.resource)));
+    scene::UIPanelStyle* style = ptr.get();
+    panel_styles_[id] = std::move(ptr);
+    return *style;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -184,12 +207,829 @@ const scene::UIButtonStyle& ResourceManager::getUIButtonStyle(const ResourceId&
 {
     auto i = button_styles_.find(id);
     if (i != button_styles_.end())
-        return i->second;
+        return *i->second;
+
+    // if we get to here, the resource is not loaded yet.
+    Sandwich& sandwich = getSandwich(id.sandwich);
+
+    std::unique_ptr<scene::UIButtonStyle> ptr(new scene::UIButtonStyle(scene::loadUIButtonStyle(sandwich, id.resource, *this)));
+    scene::UIButtonStyle* style = ptr.get();
+    button_styles_[id] = std::move(ptr);
+    return *style;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves a sound from this ResourceManager, loading it from a
+///         sandwich if necessary.
+///
+/// \details Unlike getSound(), the sound is not pinned; once the returned
+///         handle (and any copies of it) are destroyed, it may be evicted.
+///
+/// \param  id The ResourceId of the sound to retrieve.
+/// \return A handle to the loaded sound.
+/// \throws std::invalid_argument If the sound could not be loaded.
+ResourceHandle<audio::Buffer> ResourceManager::acquireSound(const ResourceId& id)
+{
+    return ResourceHandle<audio::Buffer>(loadSound_(id));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves a material from this ResourceManager, loading it from a
+///         sandwich if necessary.
+///
+/// \details Unlike getMaterial(), the material is not pinned; once the
+///         returned handle (and any copies of it) are destroyed, it may be
+///         evicted.
+///
+/// \param  id The ResourceId of the material to retrieve.
+/// \return A handle to the loaded material.
+/// \throws std::invalid_argument If the material could not be loaded.
+ResourceHandle<gfx::Material> ResourceManager::acquireMaterial(const ResourceId& id)
+{
+    return ResourceHandle<gfx::Material>(loadMaterial_(id));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves a texture from this ResourceManager, loading it from a
+///         sandwich if necessary.
+///
+/// \details Unlike getTexture(), the texture is not pinned; once the
+///         returned handle (and any copies of it) are destroyed, it may be
+///         evicted.
+///
+/// \param  id The ResourceId of the texture to retrieve.
+/// \return A handle to the loaded texture.
+/// \throws std::invalid_argument If the texture could not be loaded.
+ResourceHandle<gfx::Texture> ResourceManager::acquireTexture(const ResourceId& id)
+{
+    return ResourceHandle<gfx::Texture>(loadTexture_(id));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Requests that a sound be streamed in from a sandwich.
+///
+/// \details The sound is read and decoded on a worker thread, and its
+///         OpenAL buffer is created during a later call to processUploads().
+///         Until then, the handle returns a short silent buffer.
+///
+///         If a sound with identical content is already loaded, it is shared
+///         and the handle is ready immediately.  If one is still streaming
+///         in, this sound waits for it instead of decoding another copy.
+///
+/// \param  id The ResourceId of the sound to retrieve.
+/// \return A handle to the sound.
+/// \throws std::invalid_argument If the sandwich can't be opened.
+ResourceHandle<audio::Buffer> ResourceManager::requestSound(const ResourceId& id)
+{
+    detail::ResourceSlot<audio::Buffer>* found = sounds_.find(id);
+    if (found)
+    {
+        sounds_.touch(*found);
+        return ResourceHandle<audio::Buffer>(*found);
+    }
+
+    std::shared_ptr<Sandwich> sandwich = getSandwich(id.sandwich).shared_from_this();
+
+    if (!placeholder_sound_)
+    {
+        const ALshort silence[64] = { 0 };
+        placeholder_sound_.reset(new audio::Buffer(AL_FORMAT_MONO16, silence, sizeof(silence), 22050));
+    }
+
+    detail::ResourceSlot<audio::Buffer>* slot = &sounds_.insert(id, placeholder_sound_.get(), audio::getSoundContentHash(*sandwich, id.resource));
+
+    std::shared_ptr<audio::Buffer> existing(sounds_.findContent(slot->content));
+    if (existing)
+    {
+        sounds_.shareResource(*slot, existing);
+        return ResourceHandle<audio::Buffer>(*slot);
+    }
+
+    if (sounds_.waitForContent(*slot))
+        return ResourceHandle<audio::Buffer>(*slot);    // already streaming in for another sound
+
+    ResourceManager* rm = this;
+    stream_.queueLoad([=]()
+    {
+        std::shared_ptr<audio::SoundData> data(audio::decodeSound(*sandwich, id.resource));
+        rm->stream_.queueUpload([=]()
+        {
+            std::vector<detail::ResourceSlot<audio::Buffer>*> slots(rm->sounds_.takeWaiting(*slot));
+            std::shared_ptr<audio::Buffer> buffer(rm->sounds_.findContent(slot->content));
+            bool failed = !data;
+
+            for (auto i(slots.begin()), end(slots.end()); i != end; ++i)
+            {
+                detail::ResourceSlot<audio::Buffer>& waiting = **i;
+                if (waiting.resource)
+                    continue;   // loaded by getSound() in the meantime
+
+                if (buffer)
+                {
+                    rm->sounds_.shareResource(waiting, buffer);
+                    continue;
+                }
+
+                if (!failed)
+                {
+                    try
+                    {
+                        rm->sounds_.setResource(waiting, std::unique_ptr<audio::Buffer>(new audio::Buffer(*data)));
+                        buffer = waiting.resource;
+                        continue;
+                    }
+                    catch (const std::exception&)
+                    {
+                        // Buffer has already logged the error
+                        failed = true;
+                    }
+                }
+
+                waiting.failed = true;
+            }
+        });
+    });
+
+    return ResourceHandle<audio::Buffer>(*slot);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Requests that a material be streamed in from a sandwich.
+///
+/// \details The material is read on a worker thread and constructed during
+///         a later call to processUploads(), at which point its texture (if
+///         any) is requested in turn.  Until then, the handle returns an
+///         untextured grey placeholder material.
+///
+/// \param  id The ResourceId of the material to retrieve.
+/// \return A handle to the material.
+/// \throws std::invalid_argument If the sandwich can't be opened.
+ResourceHandle<gfx::Material> ResourceManager::requestMaterial(const ResourceId& id)
+{
+    detail::ResourceSlot<gfx::Material>* found = materials_.find(id);
+    if (found)
+    {
+        materials_.touch(*found);
+        return ResourceHandle<gfx::Material>(*found);
+    }
+
+    std::shared_ptr<Sandwich> sandwich = getSandwich(id.sandwich).shared_from_this();
+
+    detail::ResourceSlot<gfx::Material>* slot = &materials_.insert(id, placeholder_material_.get(), 0);
+    materials_.waitForContent(*slot);
+
+    ResourceManager* rm = this;
+    stream_.queueLoad([=]()
+    {
+        std::shared_ptr<gfx::MaterialData> data(gfx::readMaterial(*sandwich, id.resource));
+        rm->stream_.queueUpload([=]()
+        {
+            rm->materials_.takeWaiting(*slot);
+            if (slot->resource)
+                return;     // loaded by getMaterial() in the meantime
+
+            if (data)
+            {
+                try
+                {
+                    ResourceHandle<gfx::Texture> tex;
+                    if (data->has_texture)
+                        tex = rm->requestTexture(ResourceId(id.sandwich, data->texture_id));
+
+                    rm->materials_.setResource(*slot, std::unique_ptr<gfx::Material>(new gfx::Material(id, data->color, tex, data->texture_mode)));
+                    return;
+                }
+                catch (const std::exception& err)
+                {
+                    PBJ_LOG(VWarning) << "Exception while streaming material!" << PBJ_LOG_NL
+                                      << "Material ID: " << id << PBJ_LOG_NL
+                                      << "  Exception: " << err.what() << PBJ_LOG_END;
+                }
+            }
+
+            slot->failed = true;
+        });
+    });
+
+    return ResourceHandle<gfx::Material>(*slot);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Requests that a texture be streamed in from a sandwich.
+///
+/// \details The texture is read and decoded on a worker thread, and uploaded
+///         to the GPU during a later call to processUploads().  Until then,
+///         the handle returns nullptr.
+///
+///         If a texture with identical content is already loaded, it is
+///         shared and the handle is ready immediately.  If one is still
+///         streaming in, this texture waits for it instead of decoding
+///         another copy.
+///
+/// \param  id The ResourceId of the texture to retrieve.
+/// \return A handle to the texture.
+/// \throws std::invalid_argument If the sandwich can't be opened.
+ResourceHandle<gfx::Texture> ResourceManager::requestTexture(const ResourceId& id)
+{
+    detail::ResourceSlot<gfx::Texture>* found = textures_.find(id);
+    if (found)
+    {
+        textures_.touch(*found);
+        return ResourceHandle<gfx::Texture>(*found);
+    }
+
+    std::shared_ptr<Sandwich> sandwich = getSandwich(id.sandwich).shared_from_this();
+
+    detail::ResourceSlot<gfx::Texture>* slot = &textures_.insert(id, nullptr, gfx::getTextureContentHash(*sandwich, id.resource));
+
+    std::shared_ptr<gfx::Texture> existing(textures_.findContent(slot->content));
+    if (existing)
+    {
+        textures_.shareResource(*slot, existing);
+        return ResourceHandle<gfx::Texture>(*slot);
+    }
+
+    if (textures_.waitForContent(*slot))
+        return ResourceHandle<gfx::Texture>(*slot);     // already streaming in for another texture
+
+    ResourceManager* rm = this;
+    stream_.queueLoad([=]()
+    {
+        std::shared_ptr<gfx::TextureImage> image(gfx::decodeTexture(*sandwich, id.resource));
+        rm->stream_.queueUpload([=]()
+        {
+            std::vector<detail::ResourceSlot<gfx::Texture>*> slots(rm->textures_.takeWaiting(*slot));
+            std::shared_ptr<gfx::Texture> texture(rm->textures_.findContent(slot->content));
+            bool failed = !image;
+
+            for (auto i(slots.begin()), end(slots.end()); i != end; ++i)
+            {
+                detail::ResourceSlot<gfx::Texture>& waiting = **i;
+                if (waiting.resource)
+                    continue;   // loaded by getTexture() in the meantime
+
+                if (texture)
+                {
+                    rm->textures_.shareResource(waiting, texture);
+                    continue;
+                }
+
+                if (!failed)
+                {
+                    try
+                    {
+                        rm->textures_.setResource(waiting, std::unique_ptr<gfx::Texture>(new gfx::Texture(*image)));
+                        texture = waiting.resource;
+                        continue;
+                    }
+                    catch (const std::exception&)
+                    {
+                        // Texture has already logged the error
+                        failed = true;
+                    }
+                }
+
+                waiting.failed = true;
+            }
+        });
+    });
+
+    return ResourceHandle<gfx::Texture>(*slot);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Requests every resource in a manifest, then waits for the
+///         materials among them, and their textures, to be ready.
+///
+/// \details All of the resources are queued for streaming at once, so they
+///         are read and decoded in parallel by the worker threads.  Entities
+///         need their materials as soon as they are constructed, and are
+///         drawn with the materials' textures, so this function blocks
+///         (uploading resources as they arrive) until every prefetched
+///         material and its texture is ready or has failed to load.  Other
+///         textures and sounds continue streaming in during later calls to
+///         processUploads().
+///
+///         Resources requested by prefetch() are not recorded, even if
+///         startRecording() has been called.  Resources which can't be
+///         requested (for instance because their sandwich no longer exists)
+///         are logged and skipped.
+///
+/// \param  manifest The resources to request, usually from a previous call
+///         to stopRecording().
+void ResourceManager::prefetch(const std::vector<ManifestEntry>& manifest)
+{
+    recorder_.pause();
+
+    // Hold every handle until this function returns so nothing prefetched
+    // is evicted by the uploads below.
+    std::vector<ResourceHandle<gfx::Texture> > textures;
+    std::vector<ResourceHandle<gfx::Material> > materials;
+    std::vector<ResourceHandle<audio::Buffer> > sounds;
+    for (auto i(manifest.begin()), end(manifest.end()); i != end; ++i)
+    {
+        try
+        {
+            switch (i->type)
+            {
+            case ManifestEntry::Texture:
+                textures.push_back(requestTexture(i->id));
+                break;
+
+            case ManifestEntry::Material:
+                materials.push_back(requestMaterial(i->id));
+                break;
+
+            case ManifestEntry::Sound:
+                sounds.push_back(requestSound(i->id));
+                break;
+
+            default:
+                break;
+            }
+        }
+        catch (const std::exception& err)
+        {
+            PBJ_LOG(VWarning) << "Exception while prefetching resource!" << PBJ_LOG_NL
+                              << "Resource Type: " << i->type << PBJ_LOG_NL
+                              << "  Resource ID: " << i->id << PBJ_LOG_NL
+                              << "    Exception: " << err.what() << PBJ_LOG_END;
+        }
+    }
+
+    for (auto i(materials.begin()), end(materials.end()); i != end; ++i)
+    {
+        while (!i->isReady() && !i->isFailed() && stream_.getStreamingCount() > 0)
+            stream_.waitForUpload();
+    }
+
+    // A material's texture is only requested once the material itself has
+    // been uploaded, so the textures can't be waited for until now.
+    for (auto i(materials.begin()), end(materials.end()); i != end; ++i)
+    {
+        if (!i->isReady())
+            continue;
+
+        const ResourceHandle<gfx::Texture>& texture = i->get()->getTextureHandle();
+        while (!texture.isNull() && !texture.isReady() && !texture.isFailed() && stream_.getStreamingCount() > 0)
+            stream_.waitForUpload();
+    }
+
+    recorder_.resume();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Starts recording the resources which are retrieved or requested
+///         from this ResourceManager.
+///
+/// \details Any resources recorded previously are discarded.
+void ResourceManager::startRecording()
+{
+    recorder_.start();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Stops recording resources and returns the resources which were
+///         used since startRecording() was called.
+///
+/// \details Materials are recorded along with their textures, whether or not
+///         the material was already loaded, so the result does not depend on
+///         what was loaded before recording started.
+///
+/// \return The resources used, sorted and without duplicates.
+std::vector<ManifestEntry> ResourceManager::stopRecording()
+{
+    return recorder_.stop();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Sets the amount of texture and sound memory this manager may use
+///         before it starts evicting unreferenced resources.
+///
+/// \details If the manager is already over the new budget, unreferenced
+///         resources are evicted immediately.  Pinned and referenced
+///         resources are never evicted, so the budget may still be exceeded.
+///
+/// \param  bytes The new budget, in bytes.
+void ResourceManager::setBudget(size_t bytes)
+{
+    budget_ = bytes;
+    evict_();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the amount of texture and sound memory this manager may
+///         use before it starts evicting unreferenced resources.
+///
+/// \return The budget, in bytes.
+size_t ResourceManager::getBudget() const
+{
+    return budget_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Counts the resources currently loaded by this manager.
+///
+/// \return The current residency statistics.
+ResidencyStats ResourceManager::getResidencyStats() const
+{
+    ResidencyStats stats;
+    stats.budget = budget_;
+    stats.textures = textures_.getLoadedCount();
+    stats.texture_bytes = textures_.getBytes();
+    stats.sounds = sounds_.getLoadedCount();
+    stats.sound_bytes = sounds_.getBytes();
+    stats.materials = materials_.getLoadedCount();
+    stats.texture_fonts = texture_fonts_.size();
+    stats.unreferenced = textures_.getEvictableCount() + materials_.getEvictableCount() + sounds_.getEvictableCount();
+    stats.evicted = evicted_;
+    stats.deduplicated = textures_.getDeduplicated() + sounds_.getDeduplicated();
+    return stats;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Enables or disables reloading resources from modified sandwiches.
+///
+/// \details While enabled, every sandwich this manager uses is hashed (see
+///         hashResources()) when it is first opened, so that reloadModified()
+///         can tell which resources have changed.  Hashing reads every
+///         texture and sound blob in the sandwich, so hot reloading should
+///         only be enabled during development.
+///
+/// \param  enabled If true, reloadModified() will reload changed resources.
+void ResourceManager::setHotReload(bool enabled)
+{
+    hot_reload_ = enabled;
+
+    if (!enabled)
+    {
+        resource_hashes_.clear();
+        return;
+    }
+
+    for (auto i(sandwiches_.begin()), end(sandwiches_.end()); i != end; ++i)
+    {
+        if (resource_hashes_.count(i->first) == 0)
+            resource_hashes_[i->first] = hashResources(*i->second);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines whether reloadModified() will reload changed
+///         resources.
+///
+/// \return \c true if hot reloading is enabled.
+bool ResourceManager::isHotReloadEnabled() const
+{
+    return hot_reload_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reloads any loaded textures, materials, and sounds whose rows
+///         have changed in sandwich files modified since the last call.
+///
+/// \details Does nothing unless hot reloading is enabled (see
+///         setHotReload()).  Modified sandwiches are detected with
+///         pollModifiedSandwiches(), which never blocks, so this can be
+///         called once per frame.  Each modified sandwich this manager has
+///         used is reopened and rehashed, and only resources whose content
+///         hashes differ from the previous version are reloaded.
+///
+///         Reloaded resources replace the old ones in place (see
+///         gfx::Texture::swap(), gfx::Material::swap(), and
+///         audio::Buffer::swap()), so references returned by the get
+///         functions, and existing ResourceHandles, stay valid and see the
+///         new version immediately.  The exception is a texture or sound
+///         whose old version is shared with another sandwich's identical
+///         resource: it gets a new object, which its handles see, while
+///         references returned by getTexture() or getSound() keep the shared
+///         one.  Resources which are still streaming in, texture fonts, and
+///         UI styles are not reloaded.
+///
+///         Must be called from the thread which owns the GL context.
+///
+/// \return The number of resources reloaded.
+size_t ResourceManager::reloadModified()
+{
+    if (!hot_reload_)
+        return 0;
+
+    size_t reloaded = 0;
+
+    std::vector<Id> modified = pollModifiedSandwiches();
+    for (auto i(modified.begin()), end(modified.end()); i != end; ++i)
+        reloaded += reloadSandwich_(*i);
+
+    return reloaded;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Uploads resources which have finished decoding on worker threads.
+///
+/// \details Must be called regularly (usually once per frame) from the
+///         thread which owns the GL context, otherwise requested resources
+///         will never become ready.  At least one resource is uploaded per
+///         call (if any are waiting) even if it takes longer than the budget.
+///
+///         Afterwards, if the resident texture and sound memory exceeds the
+///         memory budget (see setBudget()), unreferenced resources are
+///         evicted.
+///
+/// \param  budget The amount of time to spend uploading before returning.
+/// \return The number of requested resources which are still streaming in.
+size_t ResourceManager::processUploads(std::chrono::microseconds budget)
+{
+    size_t streaming = stream_.processUploads(budget);
+
+    if (textures_.getBytes() + sounds_.getBytes() > budget_)
+        evict_();
+
+    return streaming;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Returns the number of requested resources which have not been
+///         uploaded yet.
+///
+/// \return The number of resources still streaming in.
+size_t ResourceManager::getStreamingCount() const
+{
+    return stream_.getStreamingCount();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Adds a material's texture (if any) to the current recording, if
+///         startRecording() has been called.
+///
+/// \details The material itself is recorded when it is used (see
+///         detail::ResourceTable::touch()).  Its texture is recorded too,
+///         since it may have been requested before recording started.
+///
+/// \param  material The material whose texture should be recorded.
+void ResourceManager::recordTexture_(const gfx::Material& material)
+{
+    if (!recorder_.isRecording())
+        return;
+
+    const ResourceHandle<gfx::Texture>& texture = material.getTextureHandle();
+    if (!texture.isNull())
+        recorder_.record(ManifestEntry::Texture, texture.getId());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds a loaded sound, or loads it from a sandwich if necessary.
+///
+/// \details If the sound is still streaming in, it is loaded immediately and
+///         the streamed copy is discarded when it arrives.  If a sound with
+///         identical content is already loaded, it is shared instead.
+///
+/// \param  id The ResourceId of the sound to load.
+/// \return The slot holding the loaded sound.
+/// \throws std::invalid_argument If the sound could not be loaded.
+detail::ResourceSlot<audio::Buffer>& ResourceManager::loadSound_(const ResourceId& id)
+{
+    detail::ResourceSlot<audio::Buffer>* found = sounds_.find(id);
+    if (found && found->resource)
+    {
+        sounds_.touch(*found);
+        return *found;
+    }
 
     // if we get to here, the resource is not loaded yet.
     Sandwich& sandwich = getSandwich(id.sandwich);
 
-    return button_styles_[id] = scene::loadUIButtonStyle(sandwich, id.resource, *this);
+    U64 content = audio::getSoundContentHash(sandwich, id.resource);
+    std::shared_ptr<audio::Buffer> existing(sounds_.findContent(content));
+
+    std::unique_ptr<audio::Buffer> ptr;
+    if (!existing)
+        ptr = audio::loadSound(sandwich, id.resource);
+
+    if (existing || ptr)
+    {
+        detail::ResourceSlot<audio::Buffer>& slot = sounds_.insert(id, nullptr, content);
+        if (existing)
+            sounds_.shareResource(slot, existing);
+        else
+            sounds_.setResource(slot, std::move(ptr));
+
+        return slot;
+    }
+
+    // if we get to here, the resource could not be loaded from the sandwich
+    PBJ_LOG(VError) << "Sound not found!" << PBJ_LOG_NL
+                    << "Sandwich ID: " << id.sandwich << PBJ_LOG_NL
+                    << "   Sound ID: " << id.resource << PBJ_LOG_END;
+
+    throw std::invalid_argument("Sound not found!");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds a loaded material, or loads it from a sandwich if necessary.
+///
+/// \details If the material is still streaming in, it is loaded immediately
+///         and the streamed copy is discarded when it arrives.  The
+///         material's texture is requested asynchronously.
+///
+/// \param  id The ResourceId of the material to load.
+/// \return The slot holding the loaded material.
+/// \throws std::invalid_argument If the material could not be loaded.
+detail::ResourceSlot<gfx::Material>& ResourceManager::loadMaterial_(const ResourceId& id)
+{
+    detail::ResourceSlot<gfx::Material>* found = materials_.find(id);
+    if (found && found->resource)
+    {
+        materials_.touch(*found);
+        recordTexture_(*found->resource);
+        return *found;
+    }
+
+    // if we get to here, the resource is not loaded yet.
+    Sandwich& sandwich = getSandwich(id.sandwich);
+
+    std::unique_ptr<gfx::Material> ptr = gfx::loadMaterial(sandwich, id.resource, *this);
+
+    if (ptr)
+    {
+        detail::ResourceSlot<gfx::Material>& slot = materials_.insert(id, placeholder_material_.get(), 0);
+        materials_.setResource(slot, std::move(ptr));
+        recordTexture_(*slot.resource);
+        return slot;
+    }
+
+    // if we get to here, the resource could not be loaded from the sandwich
+    PBJ_LOG(VError) << "Material not found!" << PBJ_LOG_NL
+                    << "Sandwich ID: " << id.sandwich << PBJ_LOG_NL
+                    << "Material ID: " << id.resource << PBJ_LOG_END;
+
+    throw std::invalid_argument("Material not found!");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Finds a loaded texture, or loads it from a sandwich if necessary.
+///
+/// \details If the texture is still streaming in, it is loaded immediately and
+///         the streamed copy is discarded when it arrives.  If a texture with
+///         identical content is already loaded, it is shared instead.
+///
+/// \param  id The ResourceId of the texture to load.
+/// \return The slot holding the loaded texture.
+/// \throws std::invalid_argument If the texture could not be loaded.
+detail::ResourceSlot<gfx::Texture>& ResourceManager::loadTexture_(const ResourceId& id)
+{
+    detail::ResourceSlot<gfx::Texture>* found = textures_.find(id);
+    if (found && found->resource)
+    {
+        textures_.touch(*found);
+        return *found;
+    }
+
+    // if we get to here, the resource is not loaded yet.
+    Sandwich& sandwich = getSandwich(id.sandwich);
+
+    U64 content = gfx::getTextureContentHash(sandwich, id.resource);
+    std::shared_ptr<gfx::Texture> existing(textures_.findContent(content));
+
+    std::unique_ptr<gfx::Texture> ptr;
+    if (!existing)
+        ptr = gfx::loadTexture(sandwich, id.resource);
+
+    if (existing || ptr)
+    {
+        detail::ResourceSlot<gfx::Texture>& slot = textures_.insert(id, nullptr, content);
+        if (existing)
+            textures_.shareResource(slot, existing);
+        else
+            textures_.setResource(slot, std::move(ptr));
+
+        return slot;
+    }
+
+    // if we get to here, the resource could not be loaded from the sandwich
+    PBJ_LOG(VError) << "Texture not found!" << PBJ_LOG_NL
+                    << "Sandwich ID: " << id.sandwich << PBJ_LOG_NL
+                    << " Texture ID: " << id.resource << PBJ_LOG_END;
+
+    throw std::invalid_argument("Texture not found!");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Evicts unreferenced resources, least recently used first, until
+///         the texture and sound memory in use fits within the budget.
+///
+/// \details See detail::evictLeastRecentlyUsed().
+///
+/// \return The number of resources evicted.
+size_t ResourceManager::evict_()
+{
+    size_t evicted = detail::evictLeastRecentlyUsed(budget_, textures_, materials_, sounds_);
+
+    if (evicted > 0)
+    {
+        evicted_ += evicted;
+
+        PBJ_LOG(VInfo) << "Evicted unreferenced resources." << PBJ_LOG_NL
+                       << "      Evicted: " << evicted << PBJ_LOG_NL
+                       << "Texture Bytes: " << textures_.getBytes() << PBJ_LOG_NL
+                       << "  Sound Bytes: " << sounds_.getBytes() << PBJ_LOG_NL
+                       << "       Budget: " << budget_ << PBJ_LOG_END;
+    }
+
+    return evicted;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reopens a modified sandwich and reloads any loaded resources from
+///         it whose content hashes have changed.
+///
+/// \details If a changed resource fails to load, the error is logged and the
+///         previous version is kept.
+///
+/// \param  sandwich_id The Id of the modified sandwich.
+/// \return The number of resources reloaded.
+size_t ResourceManager::reloadSandwich_(const Id& sandwich_id)
+{
+    auto s = sandwiches_.find(sandwich_id);
+    if (s == sandwiches_.end())
+        return 0;   // nothing has been loaded from this sandwich
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<Sandwich> sandwich = open(sandwich_id);
+    if (!sandwich)
+        return 0;
+
+    s->second = sandwich;
+
+    ResourceHashes hashes = hashResources(*sandwich);
+    ResourceHashes previous(resource_hashes_[sandwich_id]);
+
+    size_t textures = 0;
+    for (auto i(textures_.begin()), end(textures_.end()); i != end; ++i)
+    {
+        detail::ResourceSlot<gfx::Texture>& slot = *i->second;
+        if (slot.id.sandwich != sandwich_id || !slot.resource ||
+            !isModified(slot.id.resource, previous.textures, hashes.textures))
+            continue;
+
+        std::unique_ptr<gfx::Texture> ptr = gfx::loadTexture(*sandwich, slot.id.resource);
+        if (!ptr)
+            continue;   // loadTexture() has already logged the error
+
+        // If the old texture is still shared with unmodified textures in
+        // other sandwiches, it can't be changed in place, so this slot gets
+        // a new one.
+        textures_.replaceResource(slot, std::move(ptr), gfx::getTextureContentHash(*sandwich, slot.id.resource));
+        ++textures;
+    }
+
+    // Loading a material may request a texture, but never another material,
+    // so materials_ can be iterated safely.
+    size_t materials = 0;
+    for (auto i(materials_.begin()), end(materials_.end()); i != end; ++i)
+    {
+        detail::ResourceSlot<gfx::Material>& slot = *i->second;
+        if (slot.id.sandwich != sandwich_id || !slot.resource ||
+            !isModified(slot.id.resource, previous.materials, hashes.materials))
+            continue;
+
+        std::unique_ptr<gfx::Material> ptr = gfx::loadMaterial(*sandwich, slot.id.resource, *this);
+        if (!ptr)
+            continue;   // loadMaterial() has already logged the error
+
+        materials_.replaceResource(slot, std::move(ptr), 0);
+        ++materials;
+    }
+
+    size_t sounds = 0;
+    for (auto i(sounds_.begin()), end(sounds_.end()); i != end; ++i)
+    {
+        detail::ResourceSlot<audio::Buffer>& slot = *i->second;
+        if (slot.id.sandwich != sandwich_id || !slot.resource ||
+            !isModified(slot.id.resource, previous.sounds, hashes.sounds))
+            continue;
+
+        std::unique_ptr<audio::Buffer> ptr = audio::loadSound(*sandwich, slot.id.resource);
+        if (!ptr)
+            continue;   // loadSound() has already logged the error
+
+        // If the old sound is still shared with unmodified sounds in other
+        // sandwiches, it can't be changed in place, so this slot gets a new
+        // one.
+        sounds_.replaceResource(slot, std::move(ptr), audio::getSoundContentHash(*sandwich, slot.id.resource));
+        ++sounds;
+    }
+
+    resource_hashes_[sandwich_id] = hashes;
+
+    PBJ_LOG(VInfo) << "Reloaded modified sandwich." << PBJ_LOG_NL
+                   << "Sandwich ID: " << sandwich_id << PBJ_LOG_NL
+                   << "   Textures: " << textures << PBJ_LOG_NL
+                   << "  Materials: " << materials << PBJ_LOG_NL
+                   << "     Sounds: " << sounds << PBJ_LOG_NL
+                   << "       Time: " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() << " us" << PBJ_LOG_END;
+
+    return textures + materials + sounds;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -213,6 +1053,9 @@ Sandwich& ResourceManager::getSandwich(const Id& sandwich_id)
     if (ptr)
     {
         sandwiches_[sandwich_id] = sw;
+
+        if (hot_reload_)
+            resource_hashes_[sandwich_id] = hashResources(*ptr);
     }
     else
     {
@@ -6,28 +6,202 @@
 
 #include "pbj/sw/sandwich.h"
 
+#include "be/bed/db_options.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  SQL statement to get the Id of a DbFile.
 /// \details The Id is stored in the 'id' property of the
 ///         'pbj_sandwich_properties' table.
 #define PBJ_SW_SANDWICH_SQL_GET_ID "SELECT value FROM sw_sandwich_properties WHERE property = 'id' LIMIT 1"
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the connection option overrides of a
+///         sandwich.
+/// \details Properties named 'db.readonly.<pragma>' override
+///         DbOptions::readOnly() and properties named 'db.writable.<pragma>'
+///         override DbOptions::writable().
+#define PBJ_SW_SANDWICH_SQL_GET_OPTIONS "SELECT property, value FROM sw_sandwich_properties WHERE property LIKE 'db.%'"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to check if the sw_sandwich_queries table exists
+///         in a sandwich.
+#define PBJ_SW_SANDWICH_SQL_QUERIES_EXIST \
+    "SELECT count(*) FROM sqlite_master " \
+    "WHERE type='table' AND name='sw_sandwich_queries'"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the statements which should be compiled
+///         when a sandwich is opened.
+#define PBJ_SW_SANDWICH_SQL_GET_QUERIES "SELECT id, sql FROM sw_sandwich_queries"
+
 #ifdef BE_ID_NAMES_ENABLED
-#define PBJ_SW_SANDWICH_SQLID_GET_ID     PBJ_SW_SANDWICH_SQL_GET_ID
+#define PBJ_SW_SANDWICH_SQLID_GET_ID        PBJ_SW_SANDWICH_SQL_GET_ID
+#define PBJ_SW_SANDWICH_SQLID_GET_OPTIONS   PBJ_SW_SANDWICH_SQL_GET_OPTIONS
+#define PBJ_SW_SANDWICH_SQLID_GET_QUERIES   PBJ_SW_SANDWICH_SQL_GET_QUERIES
 #else
-// TODO: precalculate SQLID using idgen.exe
-#define PBJ_SW_SANDWICH_SQLID_GET_ID     PBJ_SW_SANDWICH_SQL_GET_ID
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_SW_SANDWICH_SQLID_GET_ID        0xf19801a7f8b938ea
+#define PBJ_SW_SANDWICH_SQLID_GET_OPTIONS   0xd8023dc185ee360d
+#define PBJ_SW_SANDWICH_SQLID_GET_QUERIES   0x3a2907e104e10a9f
 #endif
 namespace pbj {
 namespace sw {
+namespace {
 
-Sandwich::Sandwich(const std::string& path, bool read_only)
-   : db_(path, read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE),
-     stmt_cache_(db_)
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Generates the URI of a new shared-cache in-memory database.
+///
+/// \details Every connection opened with the same URI (and SQLITE_OPEN_URI)
+///         sees the same in-memory database, which lasts until the last of
+///         those connections is closed.  Each snapshot gets its own name so
+///         that two snapshots never share a database.
+std::string makeSnapshotUri()
 {
-    db::CachedStmt& get_id(stmt_cache_.hold(Id(PBJ_SW_SANDWICH_SQLID_GET_ID), PBJ_SW_SANDWICH_SQL_GET_ID));
-    if (get_id.step())
-        id_ = Id(get_id.getUInt64(0));
+    static std::atomic<unsigned int> next_snapshot(0);
+
+    std::ostringstream oss;
+    oss << "file:pbj_sw_snapshot_" << next_snapshot++ << "?mode=memory&cache=shared";
+    return oss.str();
+}
+
+} // namespace pbj::sw::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Opens a sandwich file.
+///
+/// \details The primary connection is configured using
+///         DbOptions::readOnly() or DbOptions::writable(), and the sandwich's
+///         connection pool using DbOptions::readOnly().  Either profile can be
+///         overridden per-sandwich by adding 'db.readonly.<pragma>' or
+///         'db.writable.<pragma>' properties to the sw_sandwich_properties
+///         table, e.g. ('db.writable.journal_mode', 'DELETE').  The
+///         'db.snapshot' property is reported by isSnapshotRequested().  Invalid
+///         overrides are ignored, and failing to apply the options does not
+///         prevent the sandwich from being opened.
+///
+///         The sandwich's connection pool can hold up to one connection per
+///         hardware thread, but no pooled connections are opened until they
+///         are first needed.
+///
+///         If a read-only snapshot is requested, the sandwich file is copied
+///         into a shared-cache in-memory database using the SQLite backup
+///         API, and both the primary connection and the connection pool use
+///         the copy, so once the constructor returns, the file is never read
+///         again (it isn't even kept open).
+///
+///         Sandwiches inside a pack file are opened by passing the name of
+///         the pack's db::PackVfs and the name of the sandwich within the
+///         pack.  Such sandwiches are always read-only.
+///
+/// \param  path The path to the sandwich file.
+/// \param  read_only If false, the sandwich's primary connection is opened for
+///         writing, and the file is created if it does not exist.
+/// \param  snapshot If true and read_only is true, the primary connection
+///         and pooled connections use an in-memory copy of the sandwich.
+/// \param  vfs_name The SQLite VFS used to open the sandwich, or an empty
+///         string to use the default VFS.
+Sandwich::Sandwich(const std::string& path, bool read_only, bool snapshot, const std::string& vfs_name)
+   : snapshot_(read_only && snapshot),
+     snapshot_requested_(false),
+     open_time_(0),
+     snapshot_uri_(snapshot_ ? makeSnapshotUri() : std::string()),
+     db_(snapshot_ ? snapshot_uri_ : path,
+         snapshot_ ? SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_SHAREDCACHE :
+                     read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+         snapshot_ ? std::string() : vfs_name),
+     stmt_cache_(db_),
+     pool_(snapshot_ ? snapshot_uri_ : path, std::thread::hardware_concurrency(),
+           snapshot_ ? SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI | SQLITE_OPEN_SHAREDCACHE :
+                       SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+           snapshot_ ? std::string() : vfs_name),
+     read_only_options_(db::DbOptions::readOnly()),
+     writable_options_(db::DbOptions::writable()),
+     stop_prewarm_(false),
+     prewarmed_(0)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (snapshot_)
+    {
+        db::Db file(path, SQLITE_OPEN_READONLY, vfs_name);
+        file.backup(db_);
+    }
+
+    {
+        db::CachedStmt get_id(stmt_cache_.hold(Id(PBJ_SW_SANDWICH_SQLID_GET_ID), PBJ_SW_SANDWICH_SQL_GET_ID));
+        if (get_id.step())
+            id_ = Id(get_id.getUInt64(0));
+    }
+
+    {
+        const std::string readonly_prefix("db.readonly.");
+        const std::string writable_prefix("db.writable.");
+
+        db::CachedStmt get_options(stmt_cache_.hold(Id(PBJ_SW_SANDWICH_SQLID_GET_OPTIONS), PBJ_SW_SANDWICH_SQL_GET_OPTIONS));
+        while (get_options.step())
+        {
+            const char* property_text = get_options.getText(0);
+            const char* value_text = get_options.getText(1);
+            std::string property(property_text ? property_text : "");
+            std::string value(value_text ? value_text : "");
+
+            bool valid = true;
+            if (property == "db.snapshot")
+            {
+                valid = value == "0" || value == "1";
+                snapshot_requested_ = value == "1";
+            }
+            else if (property.compare(0, readonly_prefix.length(), readonly_prefix) == 0)
+            {
+                std::string pragma(property.substr(readonly_prefix.length()));
+                valid = read_only_options_.set(pragma, value);
+            }
+            else if (property.compare(0, writable_prefix.length(), writable_prefix) == 0)
+            {
+                std::string pragma(property.substr(writable_prefix.length()));
+                valid = writable_options_.set(pragma, value);
+            }
+            else
+                valid = false;
+
+            if (!valid)
+                PBJ_LOG(VWarning) << "Ignoring invalid sandwich option!" << PBJ_LOG_NL
+                                  << "    Path: " << path << PBJ_LOG_NL
+                                  << "Property: " << property << PBJ_LOG_NL
+                                  << "   Value: " << value << PBJ_LOG_END;
+        }
+    }
+
+    try
+    {
+        getOptions(read_only).apply(db_);
+    }
+    catch (const db::Db::error& err)
+    {
+        PBJ_LOG(VWarning) << "Database error while applying sandwich options!" << PBJ_LOG_NL
+                          << "     Path: " << path << PBJ_LOG_NL
+                          << "Exception: " << err.what() << PBJ_LOG_NL
+                          << "      SQL: " << err.sql() << PBJ_LOG_END;
+    }
+
+    pool_.setOptions(read_only_options_);
+
+    open_time_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Closes the sandwich.
+///
+/// \details If a background pre-warm pass is running, it is stopped before
+///         the sandwich's statement cache is destroyed.
+Sandwich::~Sandwich()
+{
+   stop_prewarm_ = true;
+   waitForPrewarm();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,6 +213,57 @@ const Id& Sandwich::getId() const
    return id_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines whether this bed's primary connection uses an in-memory
+///         copy of the database file.
+///
+/// \return \c true if the bed was opened as a snapshot.
+bool Sandwich::isSnapshot() const
+{
+   return snapshot_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines whether the sandwich file asks to be opened as a
+///         snapshot when it is opened read-only.
+///
+/// \details Snapshots are requested by setting the 'db.snapshot' property in
+///         the sw_sandwich_properties table to '1'.
+///
+/// \return \c true if the sandwich requests snapshot mode.
+bool Sandwich::isSnapshotRequested() const
+{
+   return snapshot_requested_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the time it took to open this bed, including copying the
+///         database into memory if it is a snapshot.
+///
+/// \return The bed's open time.
+std::chrono::microseconds Sandwich::getOpenTime() const
+{
+   return open_time_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the amount of memory used by the primary connection's
+///         page cache.
+///
+/// \details For snapshots this is the size of the entire in-memory database.
+///         (The page cache of a snapshot is shared with its pooled
+///         connections, so SQLite would only attribute part of it to the
+///         primary connection.)
+///
+/// \return The bed's resident size in bytes.
+sqlite3_int64 Sandwich::getResidentSize()
+{
+   if (snapshot_)
+      return sqlite3_int64(db_.getInt("PRAGMA page_count", 0)) * db_.getInt("PRAGMA page_size", 0);
+
+   return db_.getCacheUsed();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Retrieves the Db object representing the connection to this bed's
 ///         database file.
@@ -59,5 +284,138 @@ db::StmtCache& Sandwich::getStmtCache()
    return stmt_cache_;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the options which should be used for connections to
+///         this bed's database file, including any overrides stored in the
+///         sandwich.
+///
+/// \param  read_only Determines whether the read-only or writable profile is
+///         returned.
+/// \return The bed's DbOptions for the requested type of connection.
+const db::DbOptions& Sandwich::getOptions(bool read_only) const
+{
+   return read_only ? read_only_options_ : writable_options_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves a pool of read-only connections to this bed's database
+///         file.
+///
+/// \details Worker threads should acquire() a connection from the pool rather
+///         than using getDb() or getStmtCache():
+///
+/// \code
+///    db::PooledDb conn = sandwich->getConnectionPool().acquire();
+///    db::CachedStmt stmt = conn.hold(Id(PBJ_GFX_TEXTURE_SQLID_LOAD), PBJ_GFX_TEXTURE_SQL_LOAD);
+///    ...
+/// \endcode
+///
+///         Pooled connections are read-only, and will not see changes made
+///         through getDb() until they are committed.  If the sandwich is a
+///         snapshot, pooled connections read the same in-memory copy as
+///         getDb() rather than the sandwich file.
+///
+/// \return The bed's ConnectionPool.
+db::ConnectionPool& Sandwich::getConnectionPool()
+{
+   return pool_;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Compiles every statement in this bed's query manifest into the
+///         primary connection's StmtCache.
+///
+/// \details The manifest is the sw_sandwich_queries table, which holds the
+///         Id and SQL text of each statement (see sw::saveQueryManifest()).
+///         If the sandwich has no manifest, nothing happens.  Statements
+///         which are already cached are skipped, and compiling stops once
+///         the cache is full.  Statements which fail to compile (for
+///         instance because the schema has changed) are skipped with a
+///         warning.
+///
+/// \return The number of statements compiled.
+size_t Sandwich::prewarm()
+{
+   size_t compiled = 0;
+
+   if (db_.getInt(PBJ_SW_SANDWICH_SQL_QUERIES_EXIST, 0) == 0)
+      return compiled;
+
+   db::CachedStmt get_queries(stmt_cache_.hold(Id(PBJ_SW_SANDWICH_SQLID_GET_QUERIES), PBJ_SW_SANDWICH_SQL_GET_QUERIES));
+   while (!stop_prewarm_ && get_queries.step())
+   {
+      Id id(get_queries.getUInt64(0));
+      const char* sql = get_queries.getText(1);
+      if (!sql)
+         continue;
+
+      try
+      {
+         if (stmt_cache_.prepare(id, sql))
+         {
+            ++compiled;
+            ++prewarmed_;
+         }
+      }
+      catch (const db::Db::error& err)
+      {
+         PBJ_LOG(VWarning) << "Database error while pre-warming sandwich!" << PBJ_LOG_NL
+                           << "Sandwich ID: " << id_ << PBJ_LOG_NL
+                           << "  Exception: " << err.what() << PBJ_LOG_NL
+                           << "        SQL: " << err.sql() << PBJ_LOG_END;
+      }
+   }
+
+   return compiled;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Starts compiling this bed's query manifest on a background thread.
+///
+/// \details Statements held before the background pass compiles them are
+///         simply compiled by hold() as usual, so there is no need to wait
+///         for the pass to complete.  If a pass has already been started,
+///         this function does nothing.
+///
+/// \sa     prewarm()
+void Sandwich::startPrewarm()
+{
+   if (prewarm_thread_.joinable())
+      return;
+
+   prewarm_thread_ = std::thread([=]()
+   {
+      try
+      {
+         prewarm();
+      }
+      catch (const db::Db::error& err)
+      {
+         PBJ_LOG(VWarning) << "Database error while pre-warming sandwich!" << PBJ_LOG_NL
+                           << "Sandwich ID: " << id_ << PBJ_LOG_NL
+                           << "  Exception: " << err.what() << PBJ_LOG_NL
+                           << "        SQL: " << err.sql() << PBJ_LOG_END;
+      }
+   });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Blocks until a background pre-warm pass started by startPrewarm()
+///         completes.
+void Sandwich::waitForPrewarm()
+{
+   if (prewarm_thread_.joinable())
+      prewarm_thread_.join();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the number of statements compiled by prewarm() so far.
+///
+/// \return The number of pre-warmed statements.
+size_t Sandwich::getPrewarmed() const
+{
+   return prewarmed_;
+}
+
 } // namespace pbj::sw
 } // namespace pbj
@@ -7,10 +7,77 @@
 
 #include "pbj/sw/sandwich_open.h"
 
+#include "pbj/sw/schema.h"
+#include "be/bed/pack_vfs.h"
+#include "be/bed/transaction.h"
+#include "be/file_watcher.h"
+#include "be/id_map.h"
+
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <thread>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to create the query manifest table if it does not
+///         exist.
+#define PBJ_SW_SANDWICH_SQL_CREATE_QUERIES \
+    "CREATE TABLE IF NOT EXISTS sw_sandwich_queries (" \
+    "id INTEGER PRIMARY KEY, " \
+    "sql TEXT NOT NULL)"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to add a statement to a sandwich's query manifest.
+#define PBJ_SW_SANDWICH_SQL_SAVE_QUERY "INSERT OR REPLACE INTO sw_sandwich_queries (id, sql) VALUES (?,?)"
+
+#ifdef BE_ID_NAMES_ENABLED
+#define PBJ_SW_SANDWICH_SQLID_SAVE_QUERY    PBJ_SW_SANDWICH_SQL_SAVE_QUERY
+#else
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_SW_SANDWICH_SQLID_SAVE_QUERY    0x5123feb711e1591f
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the sandwich properties which are needed by
+///         readDirectory().
+#define PBJ_SW_SANDWICH_SQL_DISCOVER "SELECT property, value FROM sw_sandwich_properties WHERE property IN ('id', 'db.snapshot')"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to create the sandwich index table if it does not
+///         exist.
+/// \details The sandwich index records the Id of each sandwich found by
+///         readDirectory(), along with the size and modification time of the
+///         file it was found in.  Sandwiches in packs are identified by the
+///         pack file and the sandwich's name within the pack.
+#define PBJ_SW_INDEX_SQL_CREATE \
+    "CREATE TABLE IF NOT EXISTS sw_index (" \
+    "file TEXT NOT NULL, " \
+    "name TEXT NOT NULL, " \
+    "size INTEGER NOT NULL, " \
+    "mtime INTEGER NOT NULL, " \
+    "id INTEGER NOT NULL, " \
+    "snapshot INTEGER NOT NULL, " \
+    "PRIMARY KEY (file, name))"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get every entry in the sandwich index.
+#define PBJ_SW_INDEX_SQL_GET "SELECT file, name, size, mtime, id, snapshot FROM sw_index"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to remove every entry from the sandwich index.
+#define PBJ_SW_INDEX_SQL_CLEAR "DELETE FROM sw_index"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to add an entry to the sandwich index.
+#define PBJ_SW_INDEX_SQL_ADD "INSERT OR REPLACE INTO sw_index (file, name, size, mtime, id, snapshot) VALUES (?,?,?,?,?,?)"
 
 namespace pbj {
 namespace sw {
@@ -21,13 +88,22 @@ namespace {
 struct SandwichInfo
 {
    std::string path;
+   std::string vfs;        ///< The pack's VFS if the sandwich is in a pack.
+   bool snapshot;
    std::weak_ptr<Sandwich> sandwich;
+   std::shared_ptr<db::AsyncWriter> writer;
 };
 
-typedef std::unordered_map<Id, SandwichInfo> sw_map_t;
+typedef be::IdMap<SandwichInfo> sw_map_t;
+
+// Declared before sandwiches so that packs outlive any writers.
+std::vector<std::unique_ptr<db::PackVfs> > packs;
 
 sw_map_t sandwiches;
 
+// Watches each directory passed to readDirectory() for modified sandwiches.
+be::FileWatcher watcher;
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Internal use only. Retrieves the SandwichInfo object associated
 ///         with a particular Id.
@@ -40,6 +116,290 @@ SandwichInfo* getSWI(const Id& sandwich_id)
    return &i->second;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Describes a sandwich found by readDirectory()
+///         and the file it was found in.
+struct DiscoveredSandwich
+{
+   std::string file;       ///< The sandwich file, or the pack containing it.
+   std::string name;       ///< The sandwich's name within a pack, or empty.
+   std::string vfs;        ///< The pack's VFS if the sandwich is in a pack.
+   I64 size;               ///< The size of file when it was examined.
+   I64 mtime;              ///< The modification time of file.
+   Id id;                  ///< The sandwich's Id, or Id() if not yet known.
+   bool snapshot;          ///< The sandwich's 'db.snapshot' property.
+   bool indexed;           ///< True if id and snapshot came from the index.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Checks if a filename ends with an extension,
+///         ignoring case.
+bool hasExtension(const std::string& filename, const std::string& extension)
+{
+   if (filename.length() < extension.length())
+      return false;
+
+   std::string end = filename.substr(filename.length() - extension.length());
+   std::transform(end.begin(), end.end(), end.begin(), tolower);
+   return end == extension;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Creates a DiscoveredSandwich for a file,
+///         recording its current size and modification time.
+DiscoveredSandwich discover(const std::string& file, const std::string& name, const std::string& vfs)
+{
+   DiscoveredSandwich ds;
+   ds.file = file;
+   ds.name = name;
+   ds.vfs = vfs;
+   ds.size = -1;
+   ds.mtime = -1;
+   ds.snapshot = false;
+   ds.indexed = false;
+
+   struct stat st;
+   if (stat(file.c_str(), &st) == 0)
+   {
+      ds.size = st.st_size;
+      ds.mtime = st.st_mtime;
+   }
+
+   return ds;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Reads the Id and snapshot property of a
+///         sandwich.
+///
+/// \details Only the properties needed by readDirectory() are read, using
+///         a bare connection rather than a full Sandwich (which would also
+///         set up a StmtCache and ConnectionPool and apply the sandwich's
+///         connection options).  This is safe to call from any thread.
+void probe(DiscoveredSandwich& ds)
+{
+   const std::string& path = ds.vfs.empty() ? ds.file : ds.name;
+
+   try
+   {
+      db::Db db(path, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, ds.vfs);
+      db::Stmt get_properties(db, PBJ_SW_SANDWICH_SQL_DISCOVER);
+      while (get_properties.step())
+      {
+         const char* property = get_properties.getText(0);
+         if (!property)
+            continue;
+
+         if (strcmp(property, "id") == 0)
+            ds.id = Id(get_properties.getUInt64(1));
+         else
+            ds.snapshot = get_properties.getInt(1) == 1;
+      }
+
+      if (ds.id == Id())
+         throw std::runtime_error("Sandwich has no Id!");
+   }
+   catch (const db::Db::error& e)
+   {
+      ds.id = Id();
+      PBJ_LOG(VWarning) << "Database error while opening sandwich!"  << PBJ_LOG_NL
+                        << "     Path: " << path << PBJ_LOG_NL
+                        << "      VFS: " << ds.vfs << PBJ_LOG_NL
+                        << "Exception: " << e.what() << PBJ_LOG_NL
+                        << "      SQL: " << e.sql() << PBJ_LOG_END;
+   }
+   catch (const std::exception& e)
+   {
+      ds.id = Id();
+      PBJ_LOG(VWarning) << "Exception while opening sandwich!"  << PBJ_LOG_NL
+                        << "     Path: " << path << PBJ_LOG_NL
+                        << "      VFS: " << ds.vfs << PBJ_LOG_NL
+                        << "Exception: " << e.what() << PBJ_LOG_END;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Probes every sandwich which was not found in
+///         the index, spreading the work across one thread per hardware
+///         thread.
+///
+/// \return The number of sandwiches probed.
+size_t probeAll(std::vector<DiscoveredSandwich>& found)
+{
+   std::vector<DiscoveredSandwich*> pending;
+   for (auto& ds : found)
+      if (!ds.indexed)
+         pending.push_back(&ds);
+
+   size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), pending.size());
+   if (thread_count <= 1)
+   {
+      for (auto ds : pending)
+         probe(*ds);
+
+      return pending.size();
+   }
+
+   std::atomic<size_t> next(0);
+   std::vector<std::thread> threads;
+   for (size_t i = 0; i < thread_count; ++i)
+      threads.push_back(std::thread([&]()
+      {
+         for (size_t n = next++; n < pending.size(); n = next++)
+            probe(*pending[n]);
+      }));
+
+   for (auto& thread : threads)
+      thread.join();
+
+   return pending.size();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Fills in the Ids of any sandwiches whose files
+///         have not changed since they were last recorded in the index.
+///
+/// \return The number of entries in the index.
+size_t loadIndex(const std::string& index_path, std::vector<DiscoveredSandwich>& found)
+{
+   struct stat st;
+   if (stat(index_path.c_str(), &st) != 0)
+      return 0;   // no index yet
+
+   size_t entries = 0;
+
+   try
+   {
+      std::unordered_map<std::string, DiscoveredSandwich*> by_key;
+      for (auto& ds : found)
+         by_key[ds.file + '\0' + ds.name] = &ds;
+
+      db::Db db(index_path, SQLITE_OPEN_READONLY);
+      db::Stmt get_index(db, PBJ_SW_INDEX_SQL_GET);
+      while (get_index.step())
+      {
+         ++entries;
+
+         const char* file = get_index.getText(0);
+         const char* name = get_index.getText(1);
+         auto i(by_key.find(std::string(file ? file : "") + '\0' + (name ? name : "")));
+         if (i == by_key.end())
+            continue;
+
+         DiscoveredSandwich& ds = *i->second;
+         if (ds.size < 0 || ds.size != get_index.getInt64(2) || ds.mtime != get_index.getInt64(3))
+            continue;
+
+         ds.id = Id(get_index.getUInt64(4));
+         ds.snapshot = get_index.getBool(5);
+         ds.indexed = true;
+      }
+   }
+   catch (const db::Db::error& e)
+   {
+      PBJ_LOG(VNotice) << "Could not read sandwich index; all sandwiches will be examined." << PBJ_LOG_NL
+                       << "     Path: " << index_path << PBJ_LOG_NL
+                       << "Exception: " << e.what() << PBJ_LOG_NL
+                       << "      SQL: " << e.sql() << PBJ_LOG_END;
+   }
+
+   return entries;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Replaces the contents of the index with the
+///         sandwiches which were just discovered.
+void saveIndex(const std::string& index_path, const std::vector<DiscoveredSandwich>& found)
+{
+   try
+   {
+      db::Db db(index_path);
+      db.exec(PBJ_SW_INDEX_SQL_CREATE);
+
+      db::Transaction transaction(db, db::Transaction::Immediate);
+      db.exec(PBJ_SW_INDEX_SQL_CLEAR);
+
+      db::Stmt add(db, PBJ_SW_INDEX_SQL_ADD);
+      for (auto& ds : found)
+      {
+         if (ds.id == Id() || ds.size < 0)
+            continue;
+
+         add.bind(1, ds.file);
+         add.bind(2, ds.name);
+         add.bind(3, static_cast<sqlite3_int64>(ds.size));
+         add.bind(4, static_cast<sqlite3_int64>(ds.mtime));
+         add.bind(5, ds.id.value());
+         add.bind(6, ds.snapshot);
+         add.step();
+         add.reset();
+      }
+
+      transaction.commit();
+   }
+   catch (const db::Db::error& e)
+   {
+      PBJ_LOG(VNotice) << "Could not save sandwich index." << PBJ_LOG_NL
+                       << "     Path: " << index_path << PBJ_LOG_NL
+                       << "Exception: " << e.what() << PBJ_LOG_NL
+                       << "      SQL: " << e.sql() << PBJ_LOG_END;
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Makes a discovered sandwich available through
+///         open().
+///
+/// \details Loose sandwich files take precedence over sandwiches with the
+///         same Id in a pack, so that individual sandwiches can be
+///         overridden during development without rebuilding the pack.
+void addSandwich(const DiscoveredSandwich& ds)
+{
+   if (ds.id == Id())
+      return;
+
+   SandwichInfo* existing = getSWI(ds.id);
+   if (existing && !ds.vfs.empty() && existing->vfs.empty())
+      return;
+
+   SandwichInfo swi;
+   swi.path = ds.vfs.empty() ? ds.file : ds.name;
+   swi.vfs = ds.vfs;
+   swi.snapshot = ds.snapshot;
+
+   sandwiches[ds.id] = swi;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Maps a pack file and records each of the
+///         sandwiches inside it.
+void addPack(const std::string& path, std::vector<DiscoveredSandwich>& found)
+{
+   db::PackVfs* pack = nullptr;
+   for (auto& p : packs)
+      if (p->getPath() == path)
+         pack = p.get();    // already mapped
+
+   try
+   {
+      if (!pack)
+      {
+         packs.push_back(std::unique_ptr<db::PackVfs>(new db::PackVfs(path, "pbj-pack:" + path)));
+         pack = packs.back().get();
+      }
+
+      for (auto& filename : pack->getFilenames())
+         if (hasExtension(filename, ".sw"))
+            found.push_back(discover(path, filename, pack->getVfsName()));
+   }
+   catch (const db::Db::error& e)
+   {
+      PBJ_LOG(VWarning) << "Error while opening sandwich pack!"  << PBJ_LOG_NL
+                        << "     Path: " << path << PBJ_LOG_NL
+                        << "Exception: " << e.what() << PBJ_LOG_END;
+   }
+}
+
 } // namespace pbj::sw::(anon)
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -49,8 +409,27 @@ SandwichInfo* getSWI(const Id& sandwich_id)
 /// \details Any sandwiches found will have their Ids added to an internal
 ///         structure and will henceforth be accessible through open() or
 ///         openWritable().
+///
+///         Files with the extension ".swpack" are memory-mapped pack files
+///         (see db::PackVfs) which may contain any number of sandwiches.
+///         Packed sandwiches can be opened with open(), but are read-only.
+///         A loose sandwich file overrides a packed sandwich with the same
+///         Id.
+///
+///         The Id of each sandwich is recorded, along with the size and
+///         modification time of its file, in an index ("sandwiches.swindex")
+///         in the same directory.  Files which have not changed since the
+///         index was written are not opened at all; the rest are opened in
+///         parallel.  If the index can't be read or written, every sandwich
+///         is examined.
+///
+///         The directory is also watched for changes; see
+///         pollModifiedSandwiches().
 void readDirectory(const std::string& path)
 {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<DiscoveredSandwich> found;
+
     dirent *ent;
                 
     DIR* dir = opendir(path.c_str());
@@ -63,39 +442,12 @@ void readDirectory(const std::string& path)
                 case DT_REG:
                     {
                         std::string fullpath = path + ent->d_name;
-                        std::string extension = fullpath.substr(fullpath.length() - 3, 3);
-                        std::transform(extension.begin(), extension.end(), extension.begin(), tolower);
-
-                        if (extension == ".sw") // SW for sandwich (i.e. PB & J Sandwich)
-                        {
-                            try
-                            {
-                                Sandwich sw(fullpath, true);
-                                Id swid = sw.getId();
-
-                                if (swid == Id())
-                                    throw std::runtime_error("Sandwich has no Id!");
-
-                                SandwichInfo swi;
-                                swi.path = fullpath;
-
-                                sandwiches[swid] = swi;
-                            }
-                            catch (const db::Db::error& e)
-                            {
-                                PBJ_LOG(VWarning) << "Database error while opening sandwich!"  << PBJ_LOG_NL
-                                                  << "     Path: " << fullpath << PBJ_LOG_NL
-                                                  << "Exception: " << e.what() << PBJ_LOG_NL
-                                                  << "      SQL: " << e.sql() << PBJ_LOG_END;
-                            }
-                            catch (const std::exception& e)
-                            {
-                                PBJ_LOG(VWarning) << "Exception while opening sandwich!"  << PBJ_LOG_NL
-                                                  << "     Path: " << fullpath << PBJ_LOG_NL
-                                                  << "Exception: " << e.what() << PBJ_LOG_END;
-                            }
-
-                        }
+
+                        if (hasExtension(fullpath, ".sw")) // SW for sandwich (i.e. PB & J Sandwich)
+                            found.push_back(discover(fullpath, std::string(), std::string()));
+                        else if (hasExtension(fullpath, ".swpack"))
+                            addPack(fullpath, found);
+
                         break;
                     }
 
@@ -111,7 +463,84 @@ void readDirectory(const std::string& path)
         /* Could not open directory */
         PBJ_LOG(VWarning) << "Could not open directory!" << PBJ_LOG_NL
                           << "Path: " << path << PBJ_LOG_END;
+        return;
     }
+
+    watcher.watch(path);
+
+    std::string index_path = path + "sandwiches.swindex";
+    size_t indexed = loadIndex(index_path, found);
+    size_t probed = probeAll(found);
+
+    // packed sandwiches first, so that loose files can override them
+    std::stable_partition(found.begin(), found.end(), [](const DiscoveredSandwich& ds) { return !ds.vfs.empty(); });
+    for (auto& ds : found)
+        addSandwich(ds);
+
+    if (probed > 0 || indexed != found.size())
+        saveIndex(index_path, found);
+
+    PBJ_LOG(VInfo) << "Read sandwich directory." << PBJ_LOG_NL
+                   << "      Path: " << path << PBJ_LOG_NL
+                   << "     Found: " << found.size() << PBJ_LOG_NL
+                   << "    Probed: " << probed << PBJ_LOG_NL
+                   << "Sandwiches: " << sandwiches.size() << PBJ_LOG_NL
+                   << "      Time: " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() << " us" << PBJ_LOG_END;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Checks the directories passed to readDirectory() for sandwich
+///         files which have been modified since the last call.
+///
+/// \details Does not block, so it can be called every frame.  Each modified
+///         sandwich is forgotten by open(), so the next call to open() will
+///         open the new version of the file.  Anyone still holding a
+///         shared_ptr to the previous instance can continue to use it until
+///         they release it.
+///
+///         New sandwich files which appear in a watched directory are
+///         examined and added, just as if they had been present when
+///         readDirectory() was called.  Sandwiches in packs are never
+///         reported; packs are immutable.
+///
+/// \return The Ids of sandwiches which have been modified or added.
+std::vector<Id> pollModifiedSandwiches()
+{
+    std::vector<Id> modified;
+
+    for (auto& path : watcher.poll())
+    {
+        if (!hasExtension(path, ".sw"))
+            continue;
+
+        bool known = false;
+        for (auto& swi : sandwiches)
+        {
+            if (swi.second.vfs.empty() && swi.second.path == path)
+            {
+                known = true;
+                swi.second.sandwich.reset();
+                modified.push_back(swi.first);
+            }
+        }
+
+        if (!known)
+        {
+            DiscoveredSandwich ds(discover(path, std::string(), std::string()));
+            probe(ds);
+            if (ds.id == Id())
+                continue;
+
+            addSandwich(ds);
+            modified.push_back(ds.id);
+        }
+
+        PBJ_LOG(VInfo) << "Sandwich file modified." << PBJ_LOG_NL
+                       << "       Path: " << path << PBJ_LOG_NL
+                       << "Sandwich ID: " << modified.back() << PBJ_LOG_END;
+    }
+
+    return modified;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -131,6 +560,10 @@ std::vector<Id> getSandwichIds()
 /// \brief  Retrieves a shared_ptr to a read-only sandwich which is already
 ///         open, or opens the sanwich if it is not (saving it for future calls
 ///         to  open()).
+///
+/// \details When a sandwich is opened, the statements in its query manifest
+///         are compiled on a background thread (see Sandwich::startPrewarm())
+///         so that they are ready before the first loader needs them.
 std::shared_ptr<Sandwich> open(const Id& id)
 {
     SandwichInfo* swi = getSWI(id);
@@ -146,17 +579,66 @@ std::shared_ptr<Sandwich> open(const Id& id)
 
     if (!ptr)   // previous instance has already been destroyed
     {
-        ptr.reset(new Sandwich(swi->path, true));
+        ptr.reset(new Sandwich(swi->path, true, swi->snapshot, swi->vfs));
         swi->sandwich = std::weak_ptr<Sandwich>(ptr);
+
+        int version = getSchemaVersion(ptr->getDb());
+        if (version < getLatestSchemaVersion())
+        {
+            PBJ_LOG(VNotice) << "Sandwich schema is out of date; it will be upgraded when opened for writing." << PBJ_LOG_NL
+                             << "   Sandwich ID: " << id << PBJ_LOG_NL
+                             << "Schema Version: " << version << PBJ_LOG_NL
+                             << "Latest Version: " << getLatestSchemaVersion() << PBJ_LOG_END;
+        }
+
+        ptr->startPrewarm();
+
+        PBJ_LOG(VInfo) << "Opened sandwich." << PBJ_LOG_NL
+                       << "  Sandwich ID: " << id << PBJ_LOG_NL
+                       << "         Path: " << swi->path << PBJ_LOG_NL
+                       << "          VFS: " << (swi->vfs.empty() ? "default" : swi->vfs) << PBJ_LOG_NL
+                       << "     Snapshot: " << (ptr->isSnapshot() ? "yes" : "no") << PBJ_LOG_NL
+                       << "    Open Time: " << ptr->getOpenTime().count() << " us" << PBJ_LOG_NL
+                       << "Resident Size: " << ptr->getResidentSize() << " bytes" << PBJ_LOG_END;
     }
 
     return std::move(ptr);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines whether future calls to open() will copy a sandwich
+///         into memory.
+///
+/// \details By default, sandwiches are snapshotted if their 'db.snapshot'
+///         property is set to '1'.  Snapshots trade memory (see
+///         Sandwich::getResidentSize()) for queries which never touch the
+///         file.  If the sandwich is already open, the setting takes effect
+///         the next time it is opened.  Snapshots do not see changes made
+///         through openWritable() or getWriter().
+///
+/// \param  id The Id of the sandwich.
+/// \param  snapshot If true, the sandwich will be opened as a snapshot.
+void setSnapshot(const Id& id, bool snapshot)
+{
+    SandwichInfo* swi = getSWI(id);
+
+    if (!swi)
+    {
+        PBJ_LOG(VWarning) << "Attempted to configure unknown sandwich!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << id << PBJ_LOG_END;
+        return;
+    }
+
+    swi->snapshot = snapshot;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Retrieves a modifiable sandwich by opening a new db::Db object.
 ///         The Sandwich object returned will always be unique from previously
 ///         returned sandwiches, or those returned from open().
+///
+/// \details If the sandwich's schema is out of date, it is upgraded in place
+///         (see migrateSchema()) before it is returned.
 std::shared_ptr<Sandwich> openWritable(const Id& id)
 {
     SandwichInfo* swi = getSWI(id);
@@ -167,8 +649,149 @@ std::shared_ptr<Sandwich> openWritable(const Id& id)
                           << "Sandwich ID: " << id << PBJ_LOG_END;
         return std::shared_ptr<Sandwich>();
     }
-   
-    return std::shared_ptr<Sandwich>(new Sandwich(swi->path, false));
+
+    if (!swi->vfs.empty())
+    {
+        PBJ_LOG(VWarning) << "Attempted to open packed sandwich for writing!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << id << PBJ_LOG_NL
+                          << "        VFS: " << swi->vfs << PBJ_LOG_END;
+        return std::shared_ptr<Sandwich>();
+    }
+
+    std::shared_ptr<Sandwich> ptr(new Sandwich(swi->path, false));
+
+    try
+    {
+        migrateSchema(*ptr);
+    }
+    catch (const db::Db::error& e)
+    {
+        PBJ_LOG(VWarning) << "Database error while upgrading sandwich schema!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << id << PBJ_LOG_NL
+                          << "       Path: " << swi->path << PBJ_LOG_NL
+                          << "  Exception: " << e.what() << PBJ_LOG_NL
+                          << "        SQL: " << e.sql() << PBJ_LOG_END;
+    }
+
+    return ptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the background writer for a sandwich, starting it if
+///         it has not been started yet.
+///
+/// \details Each sandwich has at most one writer, which lives until the
+///         program exits (at which point any pending writes are committed).
+///         Saving through the writer rather than openWritable() means the
+///         calling thread never waits for the database.
+///
+/// \param  id The Id of the sandwich to write to.
+/// \return The sandwich's AsyncWriter, or a null pointer if the sandwich is
+///         unknown or could not be opened for writing.
+std::shared_ptr<db::AsyncWriter> getWriter(const Id& id)
+{
+    SandwichInfo* swi = getSWI(id);
+
+    if (!swi)
+    {
+        PBJ_LOG(VWarning) << "Attempted to open unknown sandwich!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << id << PBJ_LOG_END;
+        return std::shared_ptr<db::AsyncWriter>();
+    }
+
+    if (!swi->vfs.empty())
+    {
+        PBJ_LOG(VWarning) << "Attempted to open packed sandwich for writing!" << PBJ_LOG_NL
+                          << "Sandwich ID: " << id << PBJ_LOG_NL
+                          << "        VFS: " << swi->vfs << PBJ_LOG_END;
+        return std::shared_ptr<db::AsyncWriter>();
+    }
+
+    if (!swi->writer)
+    {
+        try
+        {
+            std::shared_ptr<Sandwich> sandwich(open(id));
+            db::DbOptions options(sandwich ? sandwich->getOptions(false) : db::DbOptions::writable());
+            swi->writer = std::make_shared<db::AsyncWriter>(swi->path, options);
+        }
+        catch (const db::Db::error& e)
+        {
+            PBJ_LOG(VWarning) << "Database error while opening sandwich for writing!"  << PBJ_LOG_NL
+                              << "Sandwich ID: " << id << PBJ_LOG_NL
+                              << "       Path: " << swi->path << PBJ_LOG_NL
+                              << "  Exception: " << e.what() << PBJ_LOG_NL
+                              << "        SQL: " << e.sql() << PBJ_LOG_END;
+        }
+    }
+
+    return swi->writer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the background writer for a sandwich, if it has
+///         already been started.
+///
+/// \details Unlike getWriter(), this never opens the sandwich for writing,
+///         so it can be used to write something only if a tool is already
+///         writing to the sandwich.
+///
+/// \param  id The Id of the sandwich.
+/// \return The sandwich's AsyncWriter, or a null pointer if getWriter()
+///         hasn't successfully started one.
+std::shared_ptr<db::AsyncWriter> findWriter(const Id& id)
+{
+    SandwichInfo* swi = getSWI(id);
+    if (!swi)
+        return std::shared_ptr<db::AsyncWriter>();
+
+    return swi->writer;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Records the statements a sandwich has been queried with in its
+///         query manifest.
+///
+/// \details Every statement compiled by the read-only sandwich's StmtCache
+///         since it was opened is added to the sw_sandwich_queries table
+///         using the sandwich's background writer.  The next time the
+///         sandwich is opened, those statements will be compiled ahead of
+///         time.  This is usually done by tools (like the editor) after a
+///         representative workload, such as loading a map.
+///
+/// \param  id The Id of the sandwich.
+/// \return A future which becomes ready when the manifest has been
+///         committed.
+std::future<void> saveQueryManifest(const Id& id)
+{
+    std::shared_ptr<Sandwich> sandwich(open(id));
+    std::shared_ptr<db::AsyncWriter> writer(getWriter(id));
+    if (!sandwich || !writer)
+    {
+        std::promise<void> failed;
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("Could not open sandwich for writing!")));
+        return failed.get_future();
+    }
+
+    std::vector<std::pair<Id, std::string> > statements(sandwich->getStmtCache().getCompiledStatements());
+    return writer->submit([=](db::Db& db, db::StmtCache& cache)
+    {
+        try
+        {
+            db.exec(PBJ_SW_SANDWICH_SQL_CREATE_QUERIES);
+
+            db::CachedStmt save(cache.hold(Id(PBJ_SW_SANDWICH_SQLID_SAVE_QUERY), PBJ_SW_SANDWICH_SQL_SAVE_QUERY));
+            save.executeMany(statements.begin(), statements.end());
+        }
+        catch (const db::Db::error& err)
+        {
+            PBJ_LOG(VWarning) << "Database error while saving query manifest!" << PBJ_LOG_NL
+                              << "Sandwich ID: " << id << PBJ_LOG_NL
+                              << "  Exception: " << err.what() << PBJ_LOG_NL
+                              << "        SQL: " << err.sql() << PBJ_LOG_END;
+            throw;
+        }
+    });
 }
 
 } // namespace be::bed
@@ -0,0 +1,596 @@
+///////////////////////////////////////////////////////////////////////////////
+/// \file   pbj/sw/schema.cpp
+/// \author Benjamin Crist
+///
+/// \brief  Implementations of functions for creating and upgrading the
+///         tables in a sandwich.
+
+#include "pbj/sw/schema.h"
+
+#include "be/bed/transaction.h"
+
+#include <iostream>
+#include <map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the schema version of a sandwich.
+#define PBJ_SW_SCHEMA_SQL_GET_VERSION "SELECT value FROM sw_sandwich_properties WHERE property = 'schema_version' LIMIT 1"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to set the schema version of a sandwich.
+#define PBJ_SW_SCHEMA_SQL_SET_VERSION "INSERT OR REPLACE INTO sw_sandwich_properties (property, value) VALUES ('schema_version', ?)"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to check if the sw_sandwich_queries table exists
+///         in a sandwich.
+#define PBJ_SW_SCHEMA_SQL_QUERIES_EXIST \
+    "SELECT count(*) FROM sqlite_master " \
+    "WHERE type='table' AND name='sw_sandwich_queries'"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statement to get the statements in a sandwich's query
+///         manifest.
+#define PBJ_SW_SCHEMA_SQL_GET_QUERIES "SELECT id, sql FROM sw_sandwich_queries"
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  SQL statements to read and set the content hashes of the blobs
+///         in sw_textures and sw_sounds.
+#define PBJ_SW_SCHEMA_SQL_GET_TEXTURE_BLOBS "SELECT id, data FROM sw_textures"
+#define PBJ_SW_SCHEMA_SQL_SET_TEXTURE_HASH "UPDATE sw_textures SET content_hash = ? WHERE id = ?"
+#define PBJ_SW_SCHEMA_SQL_GET_SOUND_BLOBS "SELECT id, data FROM sw_sounds"
+#define PBJ_SW_SCHEMA_SQL_SET_SOUND_HASH "UPDATE sw_sounds SET content_hash = ? WHERE id = ?"
+
+namespace pbj {
+namespace sw {
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  One step in upgrading a sandwich's schema.
+struct Migration
+{
+    int version;            ///< The schema version after this migration.
+    const char* description;
+    const char* sql;        ///< One or more statements to execute.
+    void (*update)(db::Db& db);   ///< Optional; run after sql, in the same transaction.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Sets the content_hash column of every row in
+///         a table from its data column.
+void hashBlobs(db::Db& db, const char* get_sql, const char* set_sql)
+{
+    // Collect the hashes first; updating a table while it is being read
+    // could visit some rows twice.
+    std::vector<std::pair<sqlite3_int64, U64> > hashes;
+
+    db::Stmt get(db, get_sql);
+    while (get.step())
+    {
+        const void* data;
+        int size = get.getBlob(1, data);
+        hashes.push_back(std::make_pair(get.getInt64(0), hashContent(data, size_t(size))));
+    }
+
+    db::Stmt set(db, set_sql);
+    for (auto i(hashes.begin()), end(hashes.end()); i != end; ++i)
+    {
+        set.bind(1, static_cast<sqlite3_uint64>(i->second));
+        set.bind(2, i->first);
+        set.step();
+        set.reset();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Fills in the content hashes of the textures
+///         and sounds which existed before schema version 4.
+void hashAllBlobs(db::Db& db)
+{
+    hashBlobs(db, PBJ_SW_SCHEMA_SQL_GET_TEXTURE_BLOBS, PBJ_SW_SCHEMA_SQL_SET_TEXTURE_HASH);
+    hashBlobs(db, PBJ_SW_SCHEMA_SQL_GET_SOUND_BLOBS, PBJ_SW_SCHEMA_SQL_SET_SOUND_HASH);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Every schema migration, in order.
+///
+/// \details Migrations must never be changed once they have been released,
+///         since sandwiches which have already applied them will not apply
+///         them again.  Instead, add a new migration to the end of the list.
+///
+///         Sandwiches created before schema versions existed may already
+///         contain some of these tables, so migrations use IF NOT EXISTS
+///         where possible.
+const Migration migrations[] =
+{
+    { 1, "Create resource and map tables",
+        "CREATE TABLE IF NOT EXISTS sw_sounds\n"
+        "(\n"
+        "   id INTEGER PRIMARY KEY,\n"
+        "   data NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_textures\n"
+        "(\n"
+        "   id              INTEGER PRIMARY KEY,\n"
+        "   data            NOT NULL,\n"
+        "   internal_format INTEGER NOT NULL,\n"
+        "   srgb            INTEGER NOT NULL,\n"
+        "   mag_filter      INTEGER NOT NULL,\n"
+        "   min_filter      INTEGER NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_texture_fonts\n"
+        "(\n"
+        "   id         INTEGER PRIMARY KEY,\n"
+        "   texture_id NOT NULL,\n"
+        "   cap_height INTEGER NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_texture_font_chars\n"
+        "(\n"
+        "   font_id   INTEGER NOT NULL,\n"
+        "   codepoint INTEGER NOT NULL,\n"
+        "   tc_x      INTEGER NOT NULL,\n"
+        "   tc_y      INTEGER NOT NULL,\n"
+        "   tc_width  INTEGER NOT NULL,\n"
+        "   tc_height INTEGER NOT NULL,\n"
+        "   offset_x  INTEGER NOT NULL,\n"
+        "   offset_y  INTEGER NOT NULL,\n"
+        "   advance   INTEGER NOT NULL,\n"
+        "   PRIMARY KEY (font_id, codepoint)\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_ui_panel_styles\n"
+        "(\n"
+        "   id              INTEGER PRIMARY KEY,\n"
+        "   bg_color_top    INTEGER NOT NULL,\n"
+        "   bg_color_bottom INTEGER NOT NULL,\n"
+        "   border_color    INTEGER NOT NULL,\n"
+        "   margin_color    INTEGER NOT NULL,\n"
+        "   margin_left     REAL NOT NULL,\n"
+        "   margin_right    REAL NOT NULL,\n"
+        "   margin_top      REAL NOT NULL,\n"
+        "   margin_bottom   REAL NOT NULL,\n"
+        "   border_left     REAL NOT NULL,\n"
+        "   border_right    REAL NOT NULL,\n"
+        "   border_top      REAL NOT NULL,\n"
+        "   border_bottom   REAL NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_ui_button_styles\n"
+        "(\n"
+        "   id             INTEGER PRIMARY KEY,\n"
+        "   font_id        INTEGER NOT NULL,\n"
+        "   text_color     INTEGER NOT NULL,\n"
+        "   text_scale_x   INTEGER NOT NULL,\n"
+        "   text_scale_y   INTEGER NOT NULL,\n"
+        "   panel_style_id INTEGER NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_window_settings\n"
+        "(\n"
+        "   id                INTEGER NOT NULL,\n"
+        "   history_index     INTEGER NOT NULL,\n"
+        "   window_mode       INTEGER NOT NULL,\n"
+        "   system_positioned INTEGER NOT NULL,\n"
+        "   maximized         INTEGER NOT NULL,\n"
+        "   save_pos_on_close INTEGER NOT NULL,\n"
+        "   position_x        INTEGER NOT NULL,\n"
+        "   position_y        INTEGER NOT NULL,\n"
+        "   size_x            INTEGER NOT NULL,\n"
+        "   size_y            INTEGER NOT NULL,\n"
+        "   monitor_index     INTEGER NOT NULL,\n"
+        "   refresh_rate      INTEGER NOT NULL,\n"
+        "   v_sync            INTEGER NOT NULL,\n"
+        "   msaa_level        INTEGER NOT NULL,\n"
+        "   red_bits          INTEGER NOT NULL,\n"
+        "   green_bits        INTEGER NOT NULL,\n"
+        "   blue_bits         INTEGER NOT NULL,\n"
+        "   alpha_bits        INTEGER NOT NULL,\n"
+        "   depth_bits        INTEGER NOT NULL,\n"
+        "   stencil_bits      INTEGER NOT NULL,\n"
+        "   srgb_capable      INTEGER NOT NULL,\n"
+        "   use_custom_gamma  INTEGER NOT NULL,\n"
+        "   custom_gamma      REAL NOT NULL,\n"
+        "   PRIMARY KEY (id, history_index)\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_materials\n"
+        "(\n"
+        "   id           INTEGER PRIMARY KEY,\n"
+        "   color        INTEGER NOT NULL,\n"
+        "   texture_id   INTEGER,\n"
+        "   texture_mode INTEGER NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_maps\n"
+        "(\n"
+        "   id   INTEGER PRIMARY KEY,\n"
+        "   name TEXT NOT NULL\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_map_entities\n"
+        "(\n"
+        "   map_id      INTEGER NOT NULL,\n"
+        "   entity_id   INTEGER NOT NULL,\n"
+        "   entity_type INTEGER NOT NULL,\n"
+        "   rotation    REAL NOT NULL,\n"
+        "   pos_x       REAL NOT NULL,\n"
+        "   pos_y       REAL NOT NULL,\n"
+        "   scale_x     REAL NOT NULL,\n"
+        "   scale_y     REAL NOT NULL,\n"
+        "   material_sw_id INTEGER,\n"
+        "   material_id INTEGER,\n"
+        "   PRIMARY KEY (map_id, entity_id)\n"
+        ");",
+        nullptr },
+
+    // R*Tree of conservative entity bounds, used to find the entities in
+    // a region of a map without scanning every entity.  The half-width of
+    // each box is at least half the diagonal of the entity, so the box
+    // contains the entity regardless of its rotation.  sw_map_entities has
+    // a composite primary key, so its rowids are renumbered by VACUUM; the
+    // R*Tree is instead keyed by sw_map_entity_bounds_keys, whose INTEGER
+    // PRIMARY KEY is stable.  Triggers keep the index up to date whenever
+    // sw_map_entities is modified.
+    { 2, "Index map entity bounds",
+        "CREATE VIRTUAL TABLE IF NOT EXISTS sw_map_entity_bounds USING rtree\n"
+        "(\n"
+        "   id,\n"
+        "   min_x, max_x,\n"
+        "   min_y, max_y\n"
+        ");\n"
+        "CREATE TABLE IF NOT EXISTS sw_map_entity_bounds_keys\n"
+        "(\n"
+        "   id        INTEGER PRIMARY KEY,\n"
+        "   map_id    INTEGER NOT NULL,\n"
+        "   entity_id INTEGER NOT NULL,\n"
+        "   UNIQUE (map_id, entity_id)\n"
+        ");\n"
+        "CREATE TRIGGER IF NOT EXISTS sw_map_entities_insert_bounds\n"
+        "AFTER INSERT ON sw_map_entities\n"
+        "BEGIN\n"
+        "   DELETE FROM sw_map_entity_bounds WHERE id =\n"
+        "      (SELECT id FROM sw_map_entity_bounds_keys WHERE map_id = new.map_id AND entity_id = new.entity_id);\n"
+        "   INSERT OR REPLACE INTO sw_map_entity_bounds_keys (map_id, entity_id) VALUES (new.map_id, new.entity_id);\n"
+        "   INSERT OR REPLACE INTO sw_map_entity_bounds VALUES (\n"
+        "      (SELECT id FROM sw_map_entity_bounds_keys WHERE map_id = new.map_id AND entity_id = new.entity_id),\n"
+        "      new.pos_x - max(abs(new.scale_x), abs(new.scale_y)) * 0.7072,\n"
+        "      new.pos_x + max(abs(new.scale_x), abs(new.scale_y)) * 0.7072,\n"
+        "      new.pos_y - max(abs(new.scale_x), abs(new.scale_y)) * 0.7072,\n"
+        "      new.pos_y + max(abs(new.scale_x), abs(new.scale_y)) * 0.7072);\n"
+        "END;\n"
+        "CREATE TRIGGER IF NOT EXISTS sw_map_entities_update_bounds\n"
+        "AFTER UPDATE ON sw_map_entities\n"
+        "BEGIN\n"
+        "   DELETE FROM sw_map_entity_bounds WHERE id =\n"
+        "      (SELECT id FROM sw_map_entity_bounds_keys WHERE map_id = old.map_id AND entity_id = old.entity_id);\n"
+        "   DELETE FROM sw_map_entity_bounds_keys WHERE map_id = old.map_id AND entity_id = old.entity_id;\n"
+        "   INSERT OR REPLACE INTO sw_map_entity_bounds_keys (map_id, entity_id) VALUES (new.map_id, new.entity_id);\n"
+        "   INSERT OR REPLACE INTO sw_map_entity_bounds VALUES (\n"
+        "      (SELECT id FROM sw_map_entity_bounds_keys WHERE map_id = new.map_id AND entity_id = new.entity_id),\n"
+        "      new.pos_x - max(abs(new.scale_x), abs(new.scale_y)) * 0.7072,\n"
+        "      new.pos_x + max(abs(new.scale_x), abs(new.scale_y)) * 0.7072,\n"
+        "      new.pos_y - max(abs(new.scale_x), abs(new.scale_y)) * 0.7072,\n"
+        "      new.pos_y + max(abs(new.scale_x), abs(new.scale_y)) * 0.7072);\n"
+        "END;\n"
+        "CREATE TRIGGER IF NOT EXISTS sw_map_entities_delete_bounds\n"
+        "AFTER DELETE ON sw_map_entities\n"
+        "BEGIN\n"
+        "   DELETE FROM sw_map_entity_bounds WHERE id =\n"
+        "      (SELECT id FROM sw_map_entity_bounds_keys WHERE map_id = old.map_id AND entity_id = old.entity_id);\n"
+        "   DELETE FROM sw_map_entity_bounds_keys WHERE map_id = old.map_id AND entity_id = old.entity_id;\n"
+        "END;\n"
+        "INSERT OR IGNORE INTO sw_map_entity_bounds_keys (map_id, entity_id)\n"
+        "SELECT map_id, entity_id FROM sw_map_entities;\n"
+        "INSERT OR REPLACE INTO sw_map_entity_bounds\n"
+        "SELECT k.id,\n"
+        "   e.pos_x - max(abs(e.scale_x), abs(e.scale_y)) * 0.7072,\n"
+        "   e.pos_x + max(abs(e.scale_x), abs(e.scale_y)) * 0.7072,\n"
+        "   e.pos_y - max(abs(e.scale_x), abs(e.scale_y)) * 0.7072,\n"
+        "   e.pos_y + max(abs(e.scale_x), abs(e.scale_y)) * 0.7072\n"
+        "FROM sw_map_entities e\n"
+        "JOIN sw_map_entity_bounds_keys k ON k.map_id = e.map_id AND k.entity_id = e.entity_id;",
+        nullptr },
+
+    // Loading a font reads every character with a given font_id, and loading
+    // a map reads every entity with a given map_id.  The primary keys find
+    // the rows, but every row found then requires a second b-tree search to
+    // read the table itself.  Covering indexes contain every column the
+    // loaders need, so the table is never touched.
+    { 3, "Add covering indexes for font and map loaders",
+        "CREATE INDEX IF NOT EXISTS sw_texture_font_chars_load ON sw_texture_font_chars\n"
+        "(\n"
+        "   font_id, codepoint,\n"
+        "   tc_x, tc_y, tc_width, tc_height,\n"
+        "   offset_x, offset_y, advance\n"
+        ");\n"
+        "CREATE INDEX IF NOT EXISTS sw_map_entities_load ON sw_map_entities\n"
+        "(\n"
+        "   map_id, entity_id,\n"
+        "   entity_type, rotation,\n"
+        "   pos_x, pos_y, scale_x, scale_y,\n"
+        "   material_sw_id, material_id\n"
+        ");",
+        nullptr },
+
+    // The same texture or sound is often imported into several sandwiches.
+    // Storing a hash of each blob (see hashContent()) lets the
+    // ResourceManager recognize identical resources without reading their
+    // blobs, and share one decoded copy between them.
+    { 4, "Add content hashes to texture and sound blobs",
+        "ALTER TABLE sw_textures ADD COLUMN content_hash INTEGER;\n"
+        "ALTER TABLE sw_sounds ADD COLUMN content_hash INTEGER;",
+        hashAllBlobs }
+};
+
+const size_t migration_count = sizeof(migrations) / sizeof(migrations[0]);
+
+typedef std::vector<std::pair<std::string, std::vector<std::string> > > plans_t;
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Retrieves the query plan for each statement
+///         in a sandwich's query manifest and each statement its StmtCache
+///         has compiled.
+plans_t getQueryPlans(Sandwich& sandwich)
+{
+    db::Db& db = sandwich.getDb();
+
+    std::vector<std::string> queries;
+    std::unordered_set<Id> ids;
+
+    if (db.getInt(PBJ_SW_SCHEMA_SQL_QUERIES_EXIST, 0) != 0)
+    {
+        db::Stmt get_queries(db, PBJ_SW_SCHEMA_SQL_GET_QUERIES);
+        while (get_queries.step())
+        {
+            const char* sql = get_queries.getText(1);
+            if (sql && ids.insert(Id(get_queries.getUInt64(0))).second)
+                queries.push_back(sql);
+        }
+    }
+
+    std::vector<std::pair<Id, std::string> > compiled(sandwich.getStmtCache().getCompiledStatements());
+    for (auto i(compiled.begin()), end(compiled.end()); i != end; ++i)
+        if (ids.insert(i->first).second)
+            queries.push_back(i->second);
+
+    plans_t plans;
+    for (auto i(queries.begin()), end(queries.end()); i != end; ++i)
+    {
+        std::vector<std::string> plan;
+        try
+        {
+            plan = db.getQueryPlan(*i);
+        }
+        catch (const db::Db::error& err)
+        {
+            // eg. the query uses a table added by a later migration.
+            plan.push_back(std::string("ERROR: ") + err.what());
+        }
+        plans.push_back(std::make_pair(*i, std::move(plan)));
+    }
+
+    return plans;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Determines if a query plan visits every row
+///         of a table or index.
+///
+/// \details R*Tree searches are reported as scans of a virtual table, but
+///         they only visit the nodes which overlap the query, so they are not
+///         counted.
+bool isFullScan(const std::vector<std::string>& plan)
+{
+    for (auto i(plan.begin()), end(plan.end()); i != end; ++i)
+        if (i->compare(0, 5, "SCAN ") == 0 && i->find("VIRTUAL TABLE") == std::string::npos)
+            return true;
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Joins the steps of a query plan into a single
+///         line for logging.
+std::string formatPlan(const std::vector<std::string>& plan)
+{
+    std::string line;
+    for (auto i(plan.begin()), end(plan.end()); i != end; ++i)
+    {
+        if (!line.empty())
+            line.append("; ");
+        line.append(*i);
+    }
+    return line;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Internal use only.  Counts the query plans which contain full
+///         scans.
+size_t countFullScans(const plans_t& plans)
+{
+    size_t scans = 0;
+    for (auto i(plans.begin()), end(plans.end()); i != end; ++i)
+        if (isFullScan(i->second))
+            ++scans;
+
+    return scans;
+}
+
+} // namespace pbj::sw::(anon)
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the schema version of a sandwich.
+///
+/// \details The version is stored in the 'schema_version' property.
+///         Sandwiches created before schema versions existed are version 0.
+///
+/// \param  db The sandwich's database connection.
+/// \return The version of the last migration applied to the sandwich.
+int getSchemaVersion(db::Db& db)
+{
+    return db.getInt(PBJ_SW_SCHEMA_SQL_GET_VERSION, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Retrieves the schema version which migrateSchema() upgrades
+///         sandwiches to.
+///
+/// \return The version of the last migration known to this program.
+int getLatestSchemaVersion()
+{
+    return migrations[migration_count - 1].version;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Upgrades a sandwich to the latest schema version.
+///
+/// \details See migrateSchema(Sandwich&, int).
+///
+/// \param  sandwich The sandwich to upgrade.
+/// \return The number of migrations applied.
+///
+/// \throws db::Db::error if a migration fails.
+int migrateSchema(Sandwich& sandwich)
+{
+    return migrateSchema(sandwich, getLatestSchemaVersion());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Upgrades a sandwich to a specific schema version.
+///
+/// \details Each migration which has not been applied yet is executed in its
+///         own transaction, along with updating the 'schema_version'
+///         property, so if one fails, the sandwich is left at the last version
+///         which succeeded.  After any migrations are applied, ANALYZE is run
+///         so that SQLite's query planner knows how selective the new indexes
+///         are.
+///
+///         The plan of every statement in the sandwich's query manifest (and
+///         every statement compiled by its StmtCache) is checked before and
+///         after migrating.  Plans which change are logged, along with the
+///         number of statements which require a full table scan.
+///
+///         The sandwich must have been opened for writing.
+///
+/// \param  sandwich The sandwich to upgrade.
+/// \param  target_version The version to stop at.  Migrations after this
+///         version are not applied.  Sandwiches which are already at or
+///         past this version are not changed.
+/// \return The number of migrations applied.
+///
+/// \throws db::Db::error if a migration fails.
+int migrateSchema(Sandwich& sandwich, int target_version)
+{
+    db::Db& db = sandwich.getDb();
+
+    int version = getSchemaVersion(db);
+    if (version >= target_version)
+        return 0;
+
+    plans_t before(getQueryPlans(sandwich));
+
+    int applied = 0;
+    for (size_t i = 0; i < migration_count; ++i)
+    {
+        const Migration& migration = migrations[i];
+        if (migration.version <= version)
+            continue;
+
+        if (migration.version > target_version)
+            break;
+
+        db::Transaction transaction(db);
+        db.exec(migration.sql);
+        if (migration.update)
+            migration.update(db);
+
+        db::Stmt set_version(db, PBJ_SW_SCHEMA_SQL_SET_VERSION);
+        set_version.bind(1, migration.version);
+        set_version.step();
+
+        transaction.commit();
+        ++applied;
+
+        PBJ_LOG(VInfo) << "Applied sandwich schema migration." << PBJ_LOG_NL
+                       << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                       << "    Version: " << migration.version << PBJ_LOG_NL
+                       << "Description: " << migration.description << PBJ_LOG_END;
+    }
+
+    db.exec("ANALYZE");
+
+    plans_t after(getQueryPlans(sandwich));
+
+    std::map<std::string, std::vector<std::string> > old_plans(before.begin(), before.end());
+    for (auto i(after.begin()), end(after.end()); i != end; ++i)
+    {
+        auto old(old_plans.find(i->first));
+        if (old == old_plans.end() || old->second == i->second)
+            continue;
+
+        PBJ_LOG(VInfo) << "Query plan changed." << PBJ_LOG_NL
+                       << "   SQL: " << i->first << PBJ_LOG_NL
+                       << "Before: " << formatPlan(old->second) << PBJ_LOG_NL
+                       << " After: " << formatPlan(i->second) << PBJ_LOG_END;
+    }
+
+    PBJ_LOG(VInfo) << "Sandwich schema upgraded." << PBJ_LOG_NL
+                   << "        Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                   << "            Version: " << version << " -> " << getSchemaVersion(db) << PBJ_LOG_NL
+                   << "    Queries Checked: " << after.size() << PBJ_LOG_NL
+                   << "Full Scans (Before): " << countFullScans(before) << PBJ_LOG_NL
+                   << " Full Scans (After): " << countFullScans(after) << PBJ_LOG_END;
+
+    return applied;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Logs the query plan of every statement in a sandwich's query
+///         manifest and every statement compiled by its StmtCache.
+///
+/// \details Statements whose plans visit every row of a table or index are
+///         logged as notices.  Some of these are expected (for instance,
+///         listing every map) but loaders which look up a single resource
+///         should never need a full scan.
+///
+/// \param  sandwich The sandwich to check.
+/// \return The number of statements whose plans contain a full scan.
+size_t checkQueryPlans(Sandwich& sandwich)
+{
+    plans_t plans(getQueryPlans(sandwich));
+
+    for (auto i(plans.begin()), end(plans.end()); i != end; ++i)
+    {
+        if (isFullScan(i->second))
+        {
+            PBJ_LOG(VNotice) << "Query plan contains full scan." << PBJ_LOG_NL
+                             << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                             << "        SQL: " << i->first << PBJ_LOG_NL
+                             << "       Plan: " << formatPlan(i->second) << PBJ_LOG_END;
+        }
+        else
+        {
+            PBJ_LOG(VInfo) << "Query plan." << PBJ_LOG_NL
+                           << "Sandwich ID: " << sandwich.getId() << PBJ_LOG_NL
+                           << "        SQL: " << i->first << PBJ_LOG_NL
+                           << "       Plan: " << formatPlan(i->second) << PBJ_LOG_END;
+        }
+    }
+
+    return countFullScans(plans);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Calculates the hash stored in the content_hash column of a
+///         texture or sound.
+///
+/// \details Anything which writes texture or sound blobs to a sandwich must
+///         also store this hash, otherwise identical resources won't be
+///         shared at runtime.
+///
+/// \param  data The blob's data.
+/// \param  size The size of the blob, in bytes.
+/// \return The 64-bit FNV-1a hash of the blob.
+U64 hashContent(const void* data, size_t size)
+{
+    return be::hashBytes(data, size);
+}
+
+} // namespace pbj::sw
+} // namespace pbj
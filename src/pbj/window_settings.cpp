@@ -8,6 +8,7 @@
 
 #include "be/bed/transaction.h"
 #include "pbj/sw/sandwich_open.h"
+#include <exception>
 #include <iostream>
 
 #pragma region SQL statements
@@ -180,27 +181,16 @@
 #define PBJ_WINDOW_SETTINGS_SQLID_REVERT       PBJ_WINDOW_SETTINGS_SQL_REVERT
 #define PBJ_WINDOW_SETTINGS_SQLID_COMPRESS     PBJ_WINDOW_SETTINGS_SQL_COMPRESS
 #else
-// TODO: precalculate ids using idgen.exe
-#define PBJ_WINDOW_SETTINGS_SQLID_LOAD         PBJ_WINDOW_SETTINGS_SQL_LOAD
-#define PBJ_WINDOW_SETTINGS_SQLID_TABLE_EXISTS PBJ_WINDOW_SETTINGS_SQL_TABLE_EXISTS
-#define PBJ_WINDOW_SETTINGS_SQLID_CREATE_TABLE PBJ_WINDOW_SETTINGS_SQL_CREATE_TABLE
-#define PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX PBJ_WINDOW_SETTINGS_SQL_LATEST_INDEX
-#define PBJ_WINDOW_SETTINGS_SQLID_SAVE         PBJ_WINDOW_SETTINGS_SQL_SAVE
-#define PBJ_WINDOW_SETTINGS_SQLID_SAVE_POS     PBJ_WINDOW_SETTINGS_SQL_SAVE_POS
-#define PBJ_WINDOW_SETTINGS_SQLID_TRUNCATE     PBJ_WINDOW_SETTINGS_SQL_TRUNCATE
-#define PBJ_WINDOW_SETTINGS_SQLID_REVERT       PBJ_WINDOW_SETTINGS_SQL_REVERT
-#define PBJ_WINDOW_SETTINGS_SQLID_COMPRESS     PBJ_WINDOW_SETTINGS_SQL_COMPRESS
-/* These are outdated:
-#define PBJ_WINDOW_SETTINGS_SQLID_LOAD         0xf87b0cbda9871ec2
-#define PBJ_WINDOW_SETTINGS_SQLID_TABLE_EXISTS 0x1f291c4330f2e631
-#define PBJ_WINDOW_SETTINGS_SQLID_CREATE_TABLE 0x5be45399e0383389
-#define PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX 0xd76d8693b84a643c
-#define PBJ_WINDOW_SETTINGS_SQLID_SAVE         0x4a8f712d4305761c
-#define PBJ_WINDOW_SETTINGS_SQLID_SAVE_POS     0xf9e73cb74a980b0c
-#define PBJ_WINDOW_SETTINGS_SQLID_TRUNCATE     0xdacc0b7fdef69265
-#define PBJ_WINDOW_SETTINGS_SQLID_REVERT       0xe29c347fe32614fa
-#define PBJ_WINDOW_SETTINGS_SQLID_COMPRESS     0x7c719307914c91fb
-*/
+// precalculated using idgen.exe (see tools/sql.txt)
+#define PBJ_WINDOW_SETTINGS_SQLID_LOAD         0x5dcf9b3d53a51eee
+#define PBJ_WINDOW_SETTINGS_SQLID_TABLE_EXISTS 0xb2046ac48d334198
+#define PBJ_WINDOW_SETTINGS_SQLID_CREATE_TABLE 0x212f87f41c0802ec
+#define PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX 0x24806e6497997eb8
+#define PBJ_WINDOW_SETTINGS_SQLID_SAVE         0x8c6de6a1ebace5ca
+#define PBJ_WINDOW_SETTINGS_SQLID_SAVE_POS     0xbfaf6898ecd7f1d3
+#define PBJ_WINDOW_SETTINGS_SQLID_TRUNCATE     0x49556c73a9da59b0
+#define PBJ_WINDOW_SETTINGS_SQLID_REVERT       0x4185c373a5abb09b
+#define PBJ_WINDOW_SETTINGS_SQLID_COMPRESS     0x34629d4aad2994fe
 #endif
 
 #pragma endregion
@@ -256,26 +246,24 @@ WindowSettings loadWindowSettings(sw::Sandwich& sandwich, const Id& id)
             ws.id.sandwich = sandwich.getId();
             ws.id.resource = id;
 
-            ws.mode = static_cast<WindowSettings::Mode>(stmt.getInt(0));
-            ws.system_positioned = stmt.getBool(1);
-            ws.save_position_on_close = stmt.getBool(2);
-            ws.position.x = stmt.getInt(3);
-            ws.position.y = stmt.getInt(4);
-            ws.size.x = stmt.getInt(5);
-            ws.size.y = stmt.getInt(6);
-            ws.monitor_index = stmt.getInt(7);
-            ws.refresh_rate = stmt.getUInt(8);
-            ws.v_sync = static_cast<WindowSettings::VSyncMode>(stmt.getInt(9));
-            ws.msaa_level = stmt.getUInt(10);
-            ws.red_bits = stmt.getUInt(11);
-            ws.green_bits = stmt.getUInt(12);
-            ws.blue_bits = stmt.getUInt(13);
-            ws.alpha_bits = stmt.getUInt(14);
-            ws.depth_bits = stmt.getUInt(15);
-            ws.stencil_bits = stmt.getUInt(16);
-            ws.srgb_capable = stmt.getBool(17);
-            ws.use_custom_gamma = stmt.getBool(18);
-            ws.custom_gamma = float(stmt.getDouble(19));
+            ws.mode = static_cast<WindowSettings::Mode>(stmt.get<int>(0));
+            ws.system_positioned = stmt.get<bool>(1);
+            ws.save_position_on_close = stmt.get<bool>(2);
+            ws.position = stmt.get<ivec2>(3);
+            ws.size = stmt.get<ivec2>(5);
+            ws.monitor_index = stmt.get<int>(7);
+            ws.refresh_rate = stmt.get<unsigned int>(8);
+            ws.v_sync = static_cast<WindowSettings::VSyncMode>(stmt.get<int>(9));
+            ws.msaa_level = stmt.get<unsigned int>(10);
+            ws.red_bits = stmt.get<unsigned int>(11);
+            ws.green_bits = stmt.get<unsigned int>(12);
+            ws.blue_bits = stmt.get<unsigned int>(13);
+            ws.alpha_bits = stmt.get<unsigned int>(14);
+            ws.depth_bits = stmt.get<unsigned int>(15);
+            ws.stencil_bits = stmt.get<unsigned int>(16);
+            ws.srgb_capable = stmt.get<bool>(17);
+            ws.use_custom_gamma = stmt.get<bool>(18);
+            ws.custom_gamma = stmt.get<float>(19);
 
             return ws;
         }
@@ -308,84 +296,86 @@ WindowSettings loadWindowSettings(sw::Sandwich& sandwich, const Id& id)
 ///         of the WindowSettings object passed in.  If the WindowSettings
 ///         already exist in the sandwich, a new history index will be created.
 ///
-///         If there is a problem saving the WindowSettings, a warning will
-///         be emitted, and false will be returned.
+///         The settings are written by the sandwich's background writer, so
+///         this function does not wait for the database.  If there is a
+///         problem saving the WindowSettings, a warning will be emitted, and
+///         the returned future will hold the exception.
 ///
 /// \param  window_settings The WindowSettings to save.
-/// \return \c true if the WindowSettings were saved successfully.
+/// \return A future which becomes ready when the WindowSettings have been
+///         committed.
 ///
 /// \ingroup loading
-bool saveWindowSettings(const WindowSettings& window_settings)
+std::future<void> saveWindowSettings(const WindowSettings& window_settings)
 {
-    try
+    std::shared_ptr<db::AsyncWriter> writer = sw::getWriter(window_settings.id.sandwich);
+    if (!writer)
     {
-        std::shared_ptr<sw::Sandwich> sandwich = sw::openWritable(window_settings.id.sandwich);
-        if (!sandwich)
-            throw std::runtime_error("Could not open sandwich for writing!");
-
-        db::Db& db = sandwich->getDb();
-
-        db::Transaction transaction(db, db::Transaction::Immediate);
+        PBJ_LOG(VWarning) << "Exception while saving window settings!" << PBJ_LOG_NL
+                          << "      Sandwich ID: " << window_settings.id.sandwich << PBJ_LOG_NL
+                          << "WindowSettings ID: " << window_settings.id.resource << PBJ_LOG_NL
+                          << "        Exception: Could not open sandwich for writing!" << PBJ_LOG_END;
 
-        int history_index = 0;
+        std::promise<void> failed;
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("Could not open sandwich for writing!")));
+        return failed.get_future();
+    }
 
-        if (db.getInt(PBJ_WINDOW_SETTINGS_SQL_TABLE_EXISTS, 0) == 0)
+    WindowSettings ws(window_settings);
+    return writer->submit([=](db::Db& db, db::StmtCache& cache)
+    {
+        try
         {
-            db.exec(PBJ_WINDOW_SETTINGS_SQL_CREATE_TABLE);
+            int history_index = 0;
+
+            if (db.getInt(PBJ_WINDOW_SETTINGS_SQL_TABLE_EXISTS, 0) == 0)
+            {
+                db.exec(PBJ_WINDOW_SETTINGS_SQL_CREATE_TABLE);
+            }
+            else
+            {
+                db::CachedStmt latest(cache.hold(Id(PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX), PBJ_WINDOW_SETTINGS_SQL_LATEST_INDEX));
+                latest.bind(1, ws.id.resource.value());
+                if (latest.step())
+                    history_index = latest.getInt(0);
+            }
+
+            db::CachedStmt save(cache.hold(Id(PBJ_WINDOW_SETTINGS_SQLID_SAVE), PBJ_WINDOW_SETTINGS_SQL_SAVE));
+            save.bind(1, ws.id.resource.value());
+            save.bind(2, history_index + 1);
+            save.bind(3, static_cast<int>(ws.mode));
+            save.bind(4, ws.system_positioned);
+            save.bind(5, ws.save_position_on_close);
+            save.bind(6, ws.position.x);
+            save.bind(7, ws.position.y);
+            save.bind(8, ws.size.x);
+            save.bind(9, ws.size.y);
+            save.bind(10, ws.monitor_index);
+            save.bind(11, ws.refresh_rate);
+            save.bind(12, static_cast<int>(ws.v_sync));
+            save.bind(13, ws.msaa_level);
+            save.bind(14, ws.red_bits);
+            save.bind(15, ws.green_bits);
+            save.bind(16, ws.blue_bits);
+            save.bind(17, ws.alpha_bits);
+            save.bind(18, ws.depth_bits);
+            save.bind(19, ws.stencil_bits);
+            save.bind(20, ws.srgb_capable);
+            save.bind(21, ws.use_custom_gamma);
+            save.bind(22, ws.custom_gamma);
+
+            save.step();
         }
-        else
+        catch (const db::Db::error& err)
         {
-            db::Stmt latest(db, Id(PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX), PBJ_WINDOW_SETTINGS_SQL_LATEST_INDEX);
-            latest.bind(1, window_settings.id.resource.value());
-            if (latest.step())
-                history_index = latest.getInt(0);
+            PBJ_LOG(VWarning) << "Database error while saving window settings!" << PBJ_LOG_NL
+                              << "      Sandwich ID: " << ws.id.sandwich << PBJ_LOG_NL
+                              << "WindowSettings ID: " << ws.id.resource << PBJ_LOG_NL
+                              << "        Exception: " << err.what() << PBJ_LOG_NL
+                              << "              SQL: " << err.sql() << PBJ_LOG_END;
+            throw;
         }
-
-        db::Stmt save(db, Id(PBJ_WINDOW_SETTINGS_SQLID_SAVE), PBJ_WINDOW_SETTINGS_SQL_SAVE);
-        save.bind(1, window_settings.id.resource.value());
-        save.bind(2, history_index + 1);
-        save.bind(3, static_cast<int>(window_settings.mode));
-        save.bind(4, window_settings.system_positioned);
-        save.bind(5, window_settings.save_position_on_close);
-        save.bind(6, window_settings.position.x);
-        save.bind(7, window_settings.position.y);
-        save.bind(8, window_settings.size.x);
-        save.bind(9, window_settings.size.y);
-        save.bind(10, window_settings.monitor_index);
-        save.bind(11, window_settings.refresh_rate);
-        save.bind(12, static_cast<int>(window_settings.v_sync));
-        save.bind(13, window_settings.msaa_level);
-        save.bind(14, window_settings.red_bits);
-        save.bind(15, window_settings.green_bits);
-        save.bind(16, window_settings.blue_bits);
-        save.bind(17, window_settings.alpha_bits);
-        save.bind(18, window_settings.depth_bits);
-        save.bind(19, window_settings.stencil_bits);
-        save.bind(20, window_settings.srgb_capable);
-        save.bind(21, window_settings.use_custom_gamma);
-        save.bind(22, window_settings.custom_gamma);
-
-        save.step();
-        transaction.commit();
-        return true;
-    }
-    catch (const db::Db::error& err)
-    {
-        PBJ_LOG(VWarning) << "Database error while saving window settings!" << PBJ_LOG_NL
-                          << "      Sandwich ID: " << window_settings.id.sandwich << PBJ_LOG_NL
-                          << "WindowSettings ID: " << window_settings.id.resource << PBJ_LOG_NL
-                          << "        Exception: " << err.what() << PBJ_LOG_NL
-                          << "              SQL: " << err.sql() << PBJ_LOG_END;
-    }
-    catch (const std::runtime_error& err)
-    {
-        PBJ_LOG(VWarning) << "Exception while saving window settings!" << PBJ_LOG_NL
-                          << "      Sandwich ID: " << window_settings.id.sandwich << PBJ_LOG_NL
-                          << "WindowSettings ID: " << window_settings.id.resource << PBJ_LOG_NL
-                          << "        Exception: " << err.what() << PBJ_LOG_END;
-    }
-
-    return false;
+    });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -398,64 +388,81 @@ bool saveWindowSettings(const WindowSettings& window_settings)
 ///         be updated, and only if window_settings.save_position_on_close
 ///         is true.
 ///
+///         The update is performed by the sandwich's background writer, so
+///         this function does not wait for the database.
+///
 /// \param  window_settings Determines where the WindowSettings are saved and
 ///         the new position/size values to update.
-/// \return \c true if the size and position were updated successfully.
+/// \return A future which becomes ready when the size and position have
+///         been committed (immediately if save_position_on_close is false).
 ///
 /// \ingroup loading
-bool updateSavedPosition(const WindowSettings& window_settings)
+std::future<void> updateSavedPosition(const WindowSettings& window_settings)
 {
     if (!window_settings.save_position_on_close)
-        return false;
-
-    try
     {
-        std::shared_ptr<sw::Sandwich> sandwich = sw::openWritable(window_settings.id.sandwich);
-        if (!sandwich)
-            throw std::runtime_error("Could not open sandwich for writing!");
-
-        db::Db& db = sandwich->getDb();
-
-        if (db.getInt(PBJ_WINDOW_SETTINGS_SQL_TABLE_EXISTS, 0) == 0)
-            throw std::runtime_error("WindowSettings table does not exist!");
-
-        db::Transaction transaction(db, db::Transaction::Immediate);
-
-        int history_index = 0;
-        db::Stmt latest(db, Id(PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX), PBJ_WINDOW_SETTINGS_SQL_LATEST_INDEX);
-        latest.bind(1, window_settings.id.resource.value());
-        if (latest.step())
-            history_index = latest.getInt(0);
-
-        db::Stmt save(db, Id(PBJ_WINDOW_SETTINGS_SQLID_SAVE_POS), PBJ_WINDOW_SETTINGS_SQL_SAVE_POS);
-        save.bind(1, window_settings.position.x);
-        save.bind(2, window_settings.position.y);
-        save.bind(3, window_settings.size.x);
-        save.bind(4, window_settings.size.y);
-        save.bind(5, window_settings.id.resource.value());
-        save.bind(6, history_index);
-
-        save.step();
-        transaction.commit();
-        return true;
+        std::promise<void> skipped;
+        skipped.set_value();
+        return skipped.get_future();
     }
-    catch (const db::Db::error& err)
-    {
-        PBJ_LOG(VWarning) << "Database error while saving window position!" << PBJ_LOG_NL
-                          << "      Sandwich ID: " << window_settings.id.sandwich << PBJ_LOG_NL
-                          << "WindowSettings ID: " << window_settings.id.resource << PBJ_LOG_NL
-                          << "        Exception: " << err.what() << PBJ_LOG_NL
-                          << "              SQL: " << err.sql() << PBJ_LOG_END;
-    }
-    catch (const std::runtime_error& err)
+
+    std::shared_ptr<db::AsyncWriter> writer = sw::getWriter(window_settings.id.sandwich);
+    if (!writer)
     {
         PBJ_LOG(VWarning) << "Exception while saving window position!" << PBJ_LOG_NL
                           << "      Sandwich ID: " << window_settings.id.sandwich << PBJ_LOG_NL
                           << "WindowSettings ID: " << window_settings.id.resource << PBJ_LOG_NL
-                          << "        Exception: " << err.what() << PBJ_LOG_END;
+                          << "        Exception: Could not open sandwich for writing!" << PBJ_LOG_END;
+
+        std::promise<void> failed;
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("Could not open sandwich for writing!")));
+        return failed.get_future();
     }
 
-    return false;
+    sw::ResourceId id(window_settings.id);
+    ivec2 position(window_settings.position);
+    ivec2 size(window_settings.size);
+    return writer->submit([=](db::Db& db, db::StmtCache& cache)
+    {
+        try
+        {
+            if (db.getInt(PBJ_WINDOW_SETTINGS_SQL_TABLE_EXISTS, 0) == 0)
+                throw std::runtime_error("WindowSettings table does not exist!");
+
+            int history_index = 0;
+            db::CachedStmt latest(cache.hold(Id(PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX), PBJ_WINDOW_SETTINGS_SQL_LATEST_INDEX));
+            latest.bind(1, id.resource.value());
+            if (latest.step())
+                history_index = latest.getInt(0);
+
+            db::CachedStmt save(cache.hold(Id(PBJ_WINDOW_SETTINGS_SQLID_SAVE_POS), PBJ_WINDOW_SETTINGS_SQL_SAVE_POS));
+            save.bind(1, position.x);
+            save.bind(2, position.y);
+            save.bind(3, size.x);
+            save.bind(4, size.y);
+            save.bind(5, id.resource.value());
+            save.bind(6, history_index);
+
+            save.step();
+        }
+        catch (const db::Db::error& err)
+        {
+            PBJ_LOG(VWarning) << "Database error while saving window position!" << PBJ_LOG_NL
+                              << "      Sandwich ID: " << id.sandwich << PBJ_LOG_NL
+                              << "WindowSettings ID: " << id.resource << PBJ_LOG_NL
+                              << "        Exception: " << err.what() << PBJ_LOG_NL
+                              << "              SQL: " << err.sql() << PBJ_LOG_END;
+            throw;
+        }
+        catch (const std::runtime_error& err)
+        {
+            PBJ_LOG(VWarning) << "Exception while saving window position!" << PBJ_LOG_NL
+                              << "      Sandwich ID: " << id.sandwich << PBJ_LOG_NL
+                              << "WindowSettings ID: " << id.resource << PBJ_LOG_NL
+                              << "        Exception: " << err.what() << PBJ_LOG_END;
+            throw;
+        }
+    });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -485,12 +492,12 @@ WindowSettings revertWindowSettings(const sw::ResourceId& id)
         db::Transaction transaction(db, db::Transaction::Immediate);
 
         int history_index = 0;
-        db::Stmt latest(db, PBJ_WINDOW_SETTINGS_SQLID_LATEST_INDEX);
+        db::Stmt latest(db, PBJ_WINDOW_SETTINGS_SQL_LATEST_INDEX);
         latest.bind(1, id.resource.value());
         if (latest.step())
             history_index = latest.getInt(0);
 
-        db::Stmt remove(db, PBJ_WINDOW_SETTINGS_SQLID_REVERT);
+        db::Stmt remove(db, PBJ_WINDOW_SETTINGS_SQL_REVERT);
         remove.bind(1, id.resource.value());
         remove.bind(2, history_index);
         remove.step();
@@ -0,0 +1,226 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/async_writer.h"
+#include "be/bed/db.h"
+#include "be/bed/transaction.h"
+#include "pbj/_pbj.h"
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+const char* test_path = "test_async_writer.db";
+
+} // namespace (anon)
+
+TEST_CASE("bengine/bed/AsyncWriter", "Jobs are committed in batches on a background thread")
+{
+   std::remove(test_path);
+   {
+      be::bed::Db setup(test_path);
+      setup.exec("CREATE TABLE t (x INTEGER)");
+   }
+
+   {
+      be::bed::AsyncWriter writer(test_path);
+
+      std::vector<std::future<void> > futures;
+      for (int i = 0; i < 100; ++i)
+      {
+         futures.push_back(writer.submit([=](be::bed::Db& db, be::bed::StmtCache& cache)
+         {
+            be::bed::CachedStmt stmt = cache.hold("INSERT INTO t (x) VALUES (?)");
+            stmt.bind(1, i);
+            stmt.step();
+         }));
+      }
+
+      for (auto i(futures.begin()), end(futures.end()); i != end; ++i)
+         i->get();
+
+      REQUIRE(writer.getJobs() == 100);
+      REQUIRE(writer.getFailures() == 0);
+      REQUIRE(writer.getCommits() >= 1);
+      REQUIRE(writer.getCommits() <= 100);
+      REQUIRE(writer.getQueueDepth() == 0);
+      REQUIRE(writer.getMaxQueueDepth() >= 1);
+      REQUIRE(writer.getMaxLatency() >= writer.getLastLatency());
+
+      // a failing job only rolls back its own changes
+      std::future<void> good_before = writer.submit([](be::bed::Db& db, be::bed::StmtCache&) { db.exec("INSERT INTO t (x) VALUES (1000)"); });
+      std::future<void> bad = writer.submit([](be::bed::Db& db, be::bed::StmtCache&)
+      {
+         db.exec("INSERT INTO t (x) VALUES (2000)");
+         db.exec("INSERT INTO nonexistent (x) VALUES (1)");
+      });
+      std::future<void> thrown = writer.submit([](be::bed::Db&, be::bed::StmtCache&) { throw std::runtime_error("job failed"); });
+      std::future<void> good_after = writer.submit([](be::bed::Db& db, be::bed::StmtCache&) { db.exec("INSERT INTO t (x) VALUES (3000)"); });
+
+      good_before.get();
+      good_after.get();
+      REQUIRE_THROWS_AS(bad.get(), const be::bed::Db::error&);
+      REQUIRE_THROWS_AS(thrown.get(), const std::runtime_error&);
+      REQUIRE(writer.getFailures() == 2);
+
+      writer.resetStats();
+      REQUIRE(writer.getJobs() == 0);
+      REQUIRE(writer.getCommits() == 0);
+      REQUIRE(writer.getMaxQueueDepth() == 0);
+   }
+
+   be::bed::Db check(test_path);
+   REQUIRE(check.getInt("SELECT count(*) FROM t", 0) == 102);
+   REQUIRE(check.getInt("SELECT count(*) FROM t WHERE x = 2000", -1) == 0);
+   REQUIRE(check.getInt("SELECT count(*) FROM t WHERE x = 3000", -1) == 1);
+}
+
+TEST_CASE("bengine/bed/AsyncWriter/setMaxBatchSize", "A maximum batch size of 0 is treated as 1")
+{
+   std::remove(test_path);
+   {
+      be::bed::Db setup(test_path);
+      setup.exec("CREATE TABLE t (x INTEGER)");
+   }
+
+   be::bed::AsyncWriter writer(test_path);
+   REQUIRE(writer.getMaxBatchSize() == BE_BED_ASYNC_WRITER_DEFAULT_MAX_BATCH_SIZE);
+
+   writer.setMaxBatchSize(0);
+   REQUIRE(writer.getMaxBatchSize() == 1);
+
+   std::vector<std::future<void> > futures;
+   for (int i = 0; i < 10; ++i)
+      futures.push_back(writer.submit([](be::bed::Db& db, be::bed::StmtCache&) { db.exec("INSERT INTO t (x) VALUES (1)"); }));
+
+   for (auto i(futures.begin()), end(futures.end()); i != end; ++i)
+      i->get();
+
+   REQUIRE(writer.getJobs() == 10);
+   REQUIRE(writer.getCommits() == 10);
+}
+
+TEST_CASE("bengine/bed/AsyncWriter/busy", "Batches are retried while another connection holds the write lock")
+{
+   std::remove(test_path);
+   be::bed::Db other(test_path);
+   other.exec("CREATE TABLE t (x INTEGER)");
+
+   be::bed::AsyncWriter writer(test_path);
+   writer.flush();   // make sure the writer's connection is open
+
+   {
+      be::bed::Transaction lock(other, be::bed::Transaction::Immediate);
+
+      std::future<void> f = writer.submit([](be::bed::Db& db, be::bed::StmtCache&) { db.exec("INSERT INTO t (x) VALUES (1)"); });
+      REQUIRE(f.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+
+      lock.commit();
+      f.get();
+   }
+
+   REQUIRE(writer.getRetries() >= 1);
+   REQUIRE(writer.getFailures() == 0);
+   REQUIRE(other.getInt("SELECT count(*) FROM t", 0) == 1);
+
+   try
+   {
+      other.exec("INSERT INTO nonexistent (x) VALUES (1)");
+      FAIL("expected Db::error");
+   }
+   catch (const be::bed::Db::error& err)
+   {
+      REQUIRE(err.code() == SQLITE_ERROR);
+   }
+}
+
+TEST_CASE("./bench/bed/AsyncWriter", "Compares synchronous per-row transactions to AsyncWriter submits [hide]")
+{
+   const int rows = 2000;
+
+   std::remove(test_path);
+   {
+      be::bed::Db setup(test_path);
+      setup.exec("CREATE TABLE t (x INTEGER)");
+   }
+
+   be::bed::DbOptions options(be::bed::DbOptions::writable());
+
+   {
+      be::bed::Db db(test_path);
+      options.apply(db);
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < rows; ++i)
+      {
+         be::bed::Transaction transaction(db, be::bed::Transaction::Immediate);
+         be::bed::Stmt stmt(db, "INSERT INTO t (x) VALUES (?)");
+         stmt.bind(1, i);
+         stmt.step();
+         transaction.commit();
+      }
+      double seconds = std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::high_resolution_clock::now() - start).count();
+      std::cout << "synchronous:  " << rows << " rows in " << seconds << " s" << std::endl;
+   }
+
+   {
+      be::bed::AsyncWriter writer(test_path, options);
+
+      auto start = std::chrono::high_resolution_clock::now();
+      std::chrono::high_resolution_clock::duration max_submit(0);
+      for (int i = 0; i < rows; ++i)
+      {
+         auto submit_start = std::chrono::high_resolution_clock::now();
+         writer.submit([=](be::bed::Db& db, be::bed::StmtCache& cache)
+         {
+            be::bed::CachedStmt stmt = cache.hold("INSERT INTO t (x) VALUES (?)");
+            stmt.bind(1, i);
+            stmt.step();
+         });
+         max_submit = std::max(max_submit, std::chrono::high_resolution_clock::now() - submit_start);
+      }
+      double submit_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::high_resolution_clock::now() - start).count();
+      writer.flush();
+      double seconds = std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::high_resolution_clock::now() - start).count();
+
+      std::cout << "AsyncWriter:  " << rows << " rows in " << seconds << " s (submits: " << submit_seconds
+                << " s, max submit: " << std::chrono::duration_cast<std::chrono::microseconds>(max_submit).count()
+                << " us)  commits: " << writer.getCommits()
+                << "  max queue depth: " << writer.getMaxQueueDepth()
+                << "  max latency: " << writer.getMaxLatency().count() << " us" << std::endl;
+
+      REQUIRE(writer.getFailures() == 0);
+   }
+
+   be::bed::Db check(test_path);
+   REQUIRE(check.getInt("SELECT count(*) FROM t", 0) == rows * 2);
+}
+
+#endif
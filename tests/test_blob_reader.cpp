@@ -0,0 +1,111 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/blob_reader.h"
+#include "be/bed/stmt.h"
+#include "be/bed/db.h"
+#include "pbj/_pbj.h"
+
+#include <iostream>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+TEST_CASE("bengine/bed/BlobReader", "Reads blobs incrementally")
+{
+   be::bed::Db db;
+   db.exec("CREATE TABLE t (id INTEGER PRIMARY KEY, data BLOB)");
+   db.exec("INSERT INTO t VALUES (7, x'00010203040506070809')");
+   db.exec("INSERT INTO t VALUES (8, x'FF')");
+
+   be::bed::BlobReader reader(db, "t", "data", 7);
+   REQUIRE(reader.size() == 10);
+   REQUIRE(reader.tell() == 0);
+
+   unsigned char buffer[4];
+   REQUIRE(reader.read(buffer, 4) == 4);
+   REQUIRE(buffer[0] == 0);
+   REQUIRE(buffer[3] == 3);
+
+   REQUIRE(reader.skip(3) == 3);
+   REQUIRE(reader.read(buffer, 4) == 3);   // only 3 bytes remain
+   REQUIRE(buffer[0] == 7);
+   REQUIRE(buffer[2] == 9);
+   REQUIRE(reader.eof());
+   REQUIRE(reader.read(buffer, 4) == 0);
+
+   reader.seek(1);
+   REQUIRE(reader.read(buffer, 1) == 1);
+   REQUIRE(buffer[0] == 1);
+
+   reader.reopen(8);
+   REQUIRE(reader.size() == 1);
+   REQUIRE(reader.tell() == 0);
+   REQUIRE(reader.read(buffer, 4) == 1);
+   REQUIRE(buffer[0] == 0xFF);
+
+   REQUIRE_THROWS_AS(reader.reopen(9), const be::bed::Db::error&);
+   REQUIRE_THROWS_AS(be::bed::BlobReader(db, "t", "missing", 7), const be::bed::Db::error&);
+}
+
+TEST_CASE("./bench/bed/BlobReader", "Compares SQLite memory high-water mark when loading a 50 MB blob [hide]")
+{
+   const int blob_size = 50 * 1024 * 1024;
+   const int chunk_size = 64 * 1024;
+
+   be::bed::Db db;
+   db.exec("CREATE TABLE t (id INTEGER PRIMARY KEY, data BLOB)");
+   {
+      be::bed::Stmt insert(db, "INSERT INTO t VALUES (1, zeroblob(?))");
+      insert.bind(1, blob_size);
+      insert.step();
+   }
+
+   sqlite3_int64 baseline = sqlite3_memory_used();
+   sqlite3_memory_highwater(1);
+   {
+      be::bed::Stmt select(db, "SELECT data FROM t WHERE id = 1");
+      REQUIRE(select.step());
+      REQUIRE(select.getBlobView(0).size() == blob_size);
+   }
+   sqlite3_int64 whole = sqlite3_memory_highwater(1) - baseline;
+
+   baseline = sqlite3_memory_used();
+   sqlite3_memory_highwater(1);
+   {
+      std::vector<char> chunk(chunk_size);
+      be::bed::BlobReader reader(db, "t", "data", 1);
+      int total = 0;
+      while (!reader.eof())
+         total += reader.read(&chunk[0], chunk_size);
+      REQUIRE(total == blob_size);
+   }
+   sqlite3_int64 streamed = sqlite3_memory_highwater(1) - baseline;
+
+   std::cout << "SQLite peak memory for a " << blob_size / (1024 * 1024) << " MB blob:" << std::endl
+             << "   getBlobView(): " << whole / 1024 << " KB" << std::endl
+             << "   BlobReader:    " << streamed / 1024 << " KB (+ " << chunk_size / 1024 << " KB chunk)" << std::endl;
+
+   REQUIRE(streamed < whole);
+}
+
+#endif
@@ -0,0 +1,249 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/connection_pool.h"
+#include "be/bed/stmt.h"
+#include "pbj/_pbj.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+const char* test_path = "test_connection_pool.sqlite";
+
+} // namespace (anon)
+
+TEST_CASE("bengine/bed/ConnectionPool", "Opens connections lazily and reuses released connections")
+{
+   std::remove(test_path);
+   {
+      be::bed::Db db(test_path);
+      db.exec("CREATE TABLE t (x INTEGER)");
+      db.exec("INSERT INTO t VALUES (42)");
+   }
+
+   {
+      be::bed::ConnectionPool pool(test_path, 2);
+      REQUIRE(pool.getCapacity() == 2);
+      REQUIRE(pool.getSize() == 0);
+
+      be::bed::Db* first;
+      {
+         be::bed::PooledDb a = pool.acquire();
+         first = &a.getDb();
+         be::bed::CachedStmt stmt = a.hold(be::Id("SELECT x FROM t"), "SELECT x FROM t");
+         REQUIRE(stmt.step());
+         REQUIRE(stmt.getInt(0) == 42);
+
+         be::bed::PooledDb b = pool.acquire();
+         REQUIRE(&b.getDb() != first);
+         REQUIRE(pool.getSize() == 2);
+         REQUIRE(pool.getHeldSize() == 2);
+
+         REQUIRE_THROWS_AS(b.getDb().exec("INSERT INTO t VALUES (1)"), const be::bed::Db::error&);   // read-only
+      }
+      REQUIRE(pool.getHeldSize() == 0);
+
+      be::bed::PooledDb c = pool.acquire();
+      REQUIRE(pool.getSize() == 2);
+      REQUIRE(c.getStmtCache().getSize() <= 1);
+
+      // a third thread must wait until a connection is released
+      be::bed::PooledDb d = pool.acquire();
+      std::atomic<bool> acquired(false);
+      std::thread waiter([&]()
+      {
+         be::bed::PooledDb e = pool.acquire();
+         acquired = true;
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      REQUIRE_FALSE(acquired);
+      {
+         be::bed::PooledDb moved(std::move(d));
+      }
+      waiter.join();
+      REQUIRE(acquired);
+      REQUIRE(pool.getSize() == 2);
+   }
+
+   be::bed::ConnectionPool missing("this_file_does_not_exist.sqlite", 1);
+   REQUIRE_THROWS_AS(missing.acquire(), const be::bed::Db::error&);
+   REQUIRE(missing.getSize() == 0);
+
+   std::remove(test_path);
+}
+
+TEST_CASE("./bench/bed/ConnectionPool", "Loads every resource in pbjbase.sw with 1, 2, 4, and 8 workers [hide]")
+{
+   const char* path = "pbjbase.sw";
+   bool synthetic = false;
+   try
+   {
+      be::bed::Db db(path, SQLITE_OPEN_READONLY);
+      db.exec("SELECT id FROM sw_textures LIMIT 1");
+   }
+   catch (const be::bed::Db::error&)
+   {
+      // No sandwich available; generate one with roughly the same contents.
+      std::cout << "pbjbase.sw not found; using a generated sandwich" << std::endl;
+      path = "bench_connection_pool.sw";
+      synthetic = true;
+      std::remove(path);
+
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_textures (id INTEGER PRIMARY KEY, data NOT NULL, internal_format INTEGER NOT NULL, "
+              "srgb INTEGER NOT NULL, mag_filter INTEGER NOT NULL, min_filter INTEGER NOT NULL)");
+      db.exec("CREATE TABLE sw_sounds (id INTEGER PRIMARY KEY, data NOT NULL)");
+      db.exec("CREATE TABLE sw_texture_fonts (id INTEGER PRIMARY KEY, texture_id NOT NULL, cap_height INTEGER NOT NULL)");
+      db.exec("CREATE TABLE sw_texture_font_chars (font_id INTEGER NOT NULL, codepoint INTEGER NOT NULL, "
+              "tc_x INTEGER NOT NULL, tc_y INTEGER NOT NULL, tc_width INTEGER NOT NULL, tc_height INTEGER NOT NULL, "
+              "offset_x INTEGER NOT NULL, offset_y INTEGER NOT NULL, advance INTEGER NOT NULL)");
+
+      std::vector<char> data(256 * 1024);
+      for (size_t i = 0; i < data.size(); ++i)
+         data[i] = char(i * 31);
+
+      db.begin();
+      be::bed::Stmt texture(db, "INSERT INTO sw_textures VALUES (?, ?, 0, 0, 0, 0)");
+      be::bed::Stmt sound(db, "INSERT INTO sw_sounds VALUES (?, ?)");
+      be::bed::Stmt font(db, "INSERT INTO sw_texture_fonts VALUES (?, ?, 10)");
+      be::bed::Stmt font_char(db, "INSERT INTO sw_texture_font_chars VALUES (?, ?, 0, 0, 8, 8, 0, 0, 8)");
+      for (int i = 1; i <= 64; ++i)
+      {
+         texture.bind(1, i);
+         texture.bindBlob_s(2, &data[0], int(data.size()));
+         texture.step();
+         texture.reset();
+
+         sound.bind(1, i);
+         sound.bindBlob_s(2, &data[0], int(data.size() / 2));
+         sound.step();
+         sound.reset();
+      }
+      for (int i = 1; i <= 8; ++i)
+      {
+         font.bind(1, i);
+         font.bind(2, i);
+         font.step();
+         font.reset();
+
+         font_char.bind(1, i);
+         std::vector<int> codepoints;
+         for (int c = 32; c < 127; ++c)
+            codepoints.push_back(c);
+         font_char.executeMany(codepoints.begin(), codepoints.end(), [](be::bed::Stmt& s, int c) { s.bind(2, c); });
+      }
+      db.commit();
+   }
+
+   // Each task loads one resource: 0 = texture, 1 = sound, 2 = font.
+   typedef std::pair<int, sqlite3_int64> Task;
+   std::vector<Task> tasks;
+   {
+      be::bed::Db db(path, SQLITE_OPEN_READONLY);
+      be::bed::Stmt textures(db, "SELECT id FROM sw_textures");
+      for (auto& id : textures.rows<sqlite3_int64>())
+         tasks.push_back(Task(0, id));
+
+      be::bed::Stmt sounds(db, "SELECT id FROM sw_sounds");
+      for (auto& id : sounds.rows<sqlite3_int64>())
+         tasks.push_back(Task(1, id));
+
+      be::bed::Stmt fonts(db, "SELECT id FROM sw_texture_fonts");
+      for (auto& id : fonts.rows<sqlite3_int64>())
+         tasks.push_back(Task(2, id));
+   }
+
+   const char* sql[] = {
+      "SELECT data FROM sw_textures WHERE id = ?",
+      "SELECT data FROM sw_sounds WHERE id = ?",
+      "SELECT codepoint, tc_x, tc_y, tc_width, tc_height FROM sw_texture_font_chars WHERE font_id = ?"
+   };
+
+   sqlite3_uint64 expected = 0;
+   for (size_t workers = 1; workers <= 8; workers *= 2)
+   {
+      be::bed::ConnectionPool pool(path, workers);
+      std::atomic<size_t> next(0);
+      std::atomic<sqlite3_uint64> checksum(0);
+
+      auto start = std::chrono::high_resolution_clock::now();
+
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < workers; ++t)
+      {
+         threads.push_back(std::thread([&]()
+         {
+            size_t i;
+            while ((i = next++) < tasks.size())
+            {
+               const Task& task = tasks[i];
+               be::bed::PooledDb conn = pool.acquire();
+               be::bed::CachedStmt stmt = conn.hold(be::Id(sql[task.first]), sql[task.first]);
+               stmt.bind(1, task.second);
+
+               // "decode" the resource by hashing all of its data
+               sqlite3_uint64 hash = 0xcbf29ce484222325ULL;
+               if (task.first == 2)
+               {
+                  for (auto& ch : stmt.rows<std::tuple<int, int, int, int, int> >())
+                     hash = (hash ^ std::get<0>(ch)) * 0x100000001b3ULL;
+               }
+               else if (stmt.step())
+               {
+                  be::bed::BlobView blob = stmt.getBlobView(0);
+                  const unsigned char* data = static_cast<const unsigned char*>(blob.data());
+                  for (size_t b = 0; b < blob.size(); ++b)
+                     hash = (hash ^ data[b]) * 0x100000001b3ULL;
+               }
+               checksum += hash;
+            }
+         }));
+      }
+
+      for (auto i(threads.begin()), end(threads.end()); i != end; ++i)
+         i->join();
+
+      double ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(std::chrono::high_resolution_clock::now() - start).count();
+
+      std::cout << "workers: " << workers << "  resources: " << tasks.size()
+                << "  connections: " << pool.getSize()
+                << "  time: " << ms << " ms" << std::endl;
+
+      if (workers == 1)
+         expected = checksum.load();
+      REQUIRE(checksum.load() == expected);
+   }
+
+   if (synthetic)
+      std::remove(path);
+}
+
+#endif
@@ -0,0 +1,200 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/db.h"
+#include "be/bed/stmt.h"
+#include "pbj/_pbj.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+TEST_CASE("bengine/bed/Db/backup", "Copies a database file into memory")
+{
+   const char* path = "test_db_backup.db";
+   std::remove(path);
+   {
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE t (id INTEGER PRIMARY KEY, data BLOB)");
+      db.begin();
+      be::bed::Stmt insert(db, "INSERT INTO t VALUES (?, zeroblob(4096))");
+      for (int i = 0; i < 100; ++i)
+      {
+         insert.bind(1, i);
+         insert.step();
+         insert.reset();
+      }
+      db.commit();
+   }
+
+   be::bed::Db memory;
+   sqlite3_int64 empty_size = memory.getCacheUsed();
+   {
+      be::bed::Db file(path, SQLITE_OPEN_READONLY);
+      file.backup(memory);
+   }
+   std::remove(path);   // the copy no longer depends on the file
+
+   REQUIRE(memory.getInt("SELECT count(*) FROM t", 0) == 100);
+   REQUIRE(memory.getInt("SELECT sum(length(data)) FROM t", 0) == 409600);
+   REQUIRE(memory.getCacheUsed() > empty_size + 409600);
+
+   // in-memory copies are writable
+   memory.exec("DELETE FROM t WHERE id >= 50");
+   REQUIRE(memory.getInt("SELECT count(*) FROM t", 0) == 50);
+
+   // backing up into a database that is in use fails
+   be::bed::Db busy;
+   busy.exec("CREATE TABLE u (x)");
+   be::bed::Stmt reading(busy, "SELECT * FROM u");
+   busy.exec("INSERT INTO u VALUES (1)");
+   REQUIRE(reading.step());
+   REQUIRE_THROWS_AS(memory.backup(busy), const be::bed::Db::error&);
+}
+
+TEST_CASE("bengine/bed/Db/getQueryPlan", "Reports whether a query scans a table or searches an index")
+{
+   be::bed::Db db(":memory:");
+   db.exec("CREATE TABLE chars (font_id INTEGER NOT NULL, codepoint INTEGER NOT NULL, advance INTEGER NOT NULL, PRIMARY KEY (font_id, codepoint))");
+
+   std::string sql("SELECT codepoint, advance FROM chars WHERE font_id = ?");
+
+   SECTION("before", "The primary key index is used, but not all columns are in it")
+   {
+      std::vector<std::string> plan(db.getQueryPlan(sql));
+      REQUIRE(plan.size() == 1);
+      REQUIRE(plan[0].find("SEARCH") == 0);
+      REQUIRE(plan[0].find("COVERING") == std::string::npos);
+   }
+
+   SECTION("after", "A covering index means the table is never read")
+   {
+      db.exec("CREATE INDEX chars_covering ON chars (font_id, codepoint, advance)");
+
+      std::vector<std::string> plan(db.getQueryPlan(sql));
+      REQUIRE(plan.size() == 1);
+      REQUIRE(plan[0].find("COVERING INDEX chars_covering") != std::string::npos);
+   }
+
+   SECTION("scan", "Filtering on an unindexed column visits every row")
+   {
+      std::vector<std::string> plan(db.getQueryPlan("SELECT font_id FROM chars WHERE advance = ?"));
+      REQUIRE(plan.size() == 1);
+      REQUIRE(plan[0].find("SCAN") == 0);
+   }
+
+   SECTION("invalid", "Statements which can't be compiled throw")
+   {
+      REQUIRE_THROWS_AS(db.getQueryPlan("SELECT * FROM nonexistent"), const be::bed::Db::error&);
+   }
+}
+
+TEST_CASE("bengine/bed/Db/rtree", "Connections which have used an R*Tree can be closed")
+{
+   // The R*Tree module prepares statements of its own on the connection,
+   // which are only finalized when the connection is closed.
+   be::bed::Db db;
+   db.exec("CREATE VIRTUAL TABLE bounds USING rtree (id, min_x, max_x)");
+   db.exec("INSERT INTO bounds VALUES (1, 0, 10)");
+   REQUIRE(db.getInt("SELECT id FROM bounds WHERE max_x >= 5 AND min_x <= 5", 0) == 1);
+}
+
+TEST_CASE("./bench/bed/Db/backup", "Compares point queries against pbjbase.sw on disk and snapshotted into memory [hide]")
+{
+   std::string path("pbjbase.sw");
+   bool synthetic = false;
+   try
+   {
+      be::bed::Db db(path, SQLITE_OPEN_READONLY);
+      db.exec("SELECT * FROM sw_textures LIMIT 1");
+   }
+   catch (const be::bed::Db::error&)
+   {
+      std::cout << "pbjbase.sw not found; using a generated sandwich" << std::endl;
+      path = "bench_db_backup.sw";
+      synthetic = true;
+      std::remove(path.c_str());
+
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_textures (id INTEGER PRIMARY KEY, data NOT NULL)");
+      std::vector<char> data(64 * 1024, 'x');
+      db.begin();
+      be::bed::Stmt texture(db, "INSERT INTO sw_textures VALUES (?, ?)");
+      for (int i = 0; i < 256; ++i)
+      {
+         texture.bind(1, i);
+         texture.bindBlob_s(2, &data[0], int(data.size()));
+         texture.step();
+         texture.reset();
+      }
+      db.commit();
+   }
+
+   std::vector<sqlite3_int64> ids;
+   {
+      be::bed::Db db(path, SQLITE_OPEN_READONLY);
+      be::bed::Stmt stmt(db, "SELECT id FROM sw_textures");
+      for (auto& id : stmt.rows<sqlite3_int64>())
+         ids.push_back(id);
+   }
+
+   const int passes = 20;
+   for (int snapshot = 0; snapshot < 2; ++snapshot)
+   {
+      auto start = std::chrono::high_resolution_clock::now();
+      be::bed::Db file(path, SQLITE_OPEN_READONLY);
+      be::bed::Db memory;
+      if (snapshot)
+         file.backup(memory);
+      be::bed::Db& db = snapshot ? memory : file;
+      double open_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(std::chrono::high_resolution_clock::now() - start).count();
+
+      sqlite3_uint64 bytes = 0;
+      start = std::chrono::high_resolution_clock::now();
+      be::bed::Stmt stmt(db, "SELECT data FROM sw_textures WHERE id = ?");
+      for (int p = 0; p < passes; ++p)
+      {
+         for (auto i(ids.begin()), end(ids.end()); i != end; ++i)
+         {
+            stmt.bind(1, *i);
+            if (stmt.step())
+               bytes += stmt.getBlobView(0).size();
+            stmt.reset();
+         }
+      }
+      double query_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(std::chrono::high_resolution_clock::now() - start).count();
+
+      std::cout << (snapshot ? "snapshot:  " : "file:      ")
+                << "open: " << open_ms << " ms  queries: " << query_ms / passes << " ms/pass"
+                << "  resident: " << db.getCacheUsed() << " bytes" << std::endl;
+      REQUIRE(bytes > 0);
+   }
+
+   if (synthetic)
+      std::remove(path.c_str());
+}
+
+#endif
@@ -0,0 +1,183 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/db_options.h"
+#include "be/bed/db.h"
+#include "be/bed/stmt.h"
+#include "pbj/_pbj.h"
+#include "test_util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+std::string getPragma(be::bed::Db& db, const std::string& pragma)
+{
+   be::bed::Stmt stmt(db, "PRAGMA " + pragma);
+   REQUIRE(stmt.step());
+   return stmt.getText(0);
+}
+
+} // namespace (anon)
+
+TEST_CASE("bengine/bed/DbOptions", "Validates and applies PRAGMA profiles")
+{
+   be::bed::DbOptions options;
+   REQUIRE(options.set("cache_size", "-4096"));
+   REQUIRE(options.set("synchronous", "OFF"));
+   REQUIRE(options.set("mmap_size", ""));
+   REQUIRE_FALSE(options.set("cache_size", "1; DROP TABLE t"));
+   REQUIRE_FALSE(options.set("cache_size", "4-4"));
+   REQUIRE_FALSE(options.set("page_size", "4096"));
+   REQUIRE(options.cache_size == "-4096");
+
+   const char* path = "test_db_options.sqlite";
+   test::removeDb(path);
+   {
+      be::bed::Db db(path);
+      options.apply(db);
+      REQUIRE(getPragma(db, "cache_size") == "-4096");
+      REQUIRE(getPragma(db, "synchronous") == "0");
+
+      be::bed::DbOptions::writable().apply(db);
+      REQUIRE(getPragma(db, "journal_mode") == "wal");
+      REQUIRE(getPragma(db, "synchronous") == "1");
+      db.exec("CREATE TABLE t (x INTEGER); INSERT INTO t VALUES (1)");
+
+      be::bed::DbOptions invalid;
+      invalid.mmap_size = "0 OR 1";
+      REQUIRE_THROWS_AS(invalid.apply(db), const be::bed::Db::error&);
+   }
+   {
+      // read-only connections can open WAL databases left by writable ones
+      be::bed::Db db(path, SQLITE_OPEN_READONLY);
+      be::bed::DbOptions::readOnly().apply(db);
+      REQUIRE(getPragma(db, "cache_size") == "-8192");
+      REQUIRE(db.getInt("SELECT x FROM t", 0) == 1);
+   }
+   test::removeDb(path);
+}
+
+TEST_CASE("./bench/bed/DbOptions", "Loads levels.sw and pbjbase.sw with default and tuned profiles [hide]")
+{
+   const char* files[] = { "levels.sw", "pbjbase.sw" };
+   const int iterations = 5;
+
+   for (int f = 0; f < 2; ++f)
+   {
+      std::string path(files[f]);
+      bool synthetic = false;
+      try
+      {
+         be::bed::Db db(path, SQLITE_OPEN_READONLY);
+         db.exec("SELECT * FROM sw_sandwich_properties LIMIT 1");
+      }
+      catch (const be::bed::Db::error&)
+      {
+         // Generate a sandwich with a similar shape: levels.sw is mostly
+         // map entities, pbjbase.sw is mostly texture and sound blobs.
+         path = std::string("bench_db_options_") + files[f];
+         synthetic = true;
+         test::removeDb(path);
+
+         be::bed::Db db(path);
+         db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+         db.exec("CREATE TABLE sw_map_entities (map_id INTEGER, entity_id INTEGER, entity_type INTEGER, rotation REAL, "
+                 "pos_x REAL, pos_y REAL, scale_x REAL, scale_y REAL, material_sw_id INTEGER, material_id INTEGER)");
+         db.exec("CREATE TABLE sw_textures (id INTEGER PRIMARY KEY, data NOT NULL)");
+
+         std::vector<char> data(256 * 1024, 'x');
+         db.begin();
+         be::bed::Stmt entity(db, "INSERT INTO sw_map_entities VALUES (?, ?, 1, 0, ?, ?, 1, 1, NULL, 42)");
+         be::bed::Stmt texture(db, "INSERT INTO sw_textures VALUES (?, ?)");
+         if (f == 0)
+         {
+            for (int i = 0; i < 100000; ++i)
+            {
+               entity.bindRow(std::make_tuple(i / 1000, i, i * 0.5, i * 0.25));
+               entity.step();
+               entity.reset();
+            }
+         }
+         else
+         {
+            for (int i = 0; i < 128; ++i)
+            {
+               texture.bind(1, i);
+               texture.bindBlob_s(2, &data[0], int(data.size()));
+               texture.step();
+               texture.reset();
+            }
+         }
+         db.commit();
+      }
+
+      // Collect every table in the sandwich, then load all of their rows.
+      std::vector<std::string> tables;
+      {
+         be::bed::Db db(path, SQLITE_OPEN_READONLY);
+         be::bed::Stmt stmt(db, "SELECT name FROM sqlite_master WHERE type = 'table'");
+         for (auto& name : stmt.rows<const char*>())
+            tables.push_back(name);
+      }
+
+      for (int tuned = 0; tuned < 2; ++tuned)
+      {
+         double total = 0;
+         sqlite3_uint64 bytes = 0;
+         for (int i = 0; i < iterations; ++i)
+         {
+            auto start = std::chrono::high_resolution_clock::now();
+            be::bed::Db db(path, SQLITE_OPEN_READONLY);
+            if (tuned)
+               be::bed::DbOptions::readOnly().apply(db);
+
+            for (auto t(tables.begin()), end(tables.end()); t != end; ++t)
+            {
+               be::bed::Stmt stmt(db, "SELECT * FROM \"" + *t + "\"");
+               int columns = stmt.columns();
+               while (stmt.step())
+                  for (int c = 0; c < columns; ++c)
+                     bytes += stmt.getBlobView(c).size();
+            }
+            total += std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(std::chrono::high_resolution_clock::now() - start).count();
+         }
+
+         std::cout << files[f] << (synthetic ? " (generated)" : "")
+                   << (tuned ? "  tuned:   " : "  default: ")
+                   << total / iterations << " ms/load  (" << bytes / iterations << " bytes)" << std::endl;
+         REQUIRE(bytes > 0);
+      }
+
+      if (synthetic)
+         test::removeDb(path);
+   }
+}
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+const char* watched_name = "test_file_watcher.txt";
+
+///////////////////////////////////////////////////////////////////////////////
+void writeFile(const char* path, const char* contents)
+{
+   std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+   ofs << contents;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+bool contains(const std::vector<std::string>& paths, const std::string& path)
+{
+   return std::find(paths.begin(), paths.end(), path) != paths.end();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Change notifications may take a moment to arrive (especially when falling
+// back to comparing write times), so poll a few times before giving up.
+std::vector<std::string> pollUntil(be::FileWatcher& watcher, const std::string& path)
+{
+   std::vector<std::string> modified;
+   for (int attempt = 0; attempt < 50; ++attempt)
+   {
+      modified = watcher.poll();
+      if (contains(modified, path))
+         break;
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   }
+   return modified;
+}
+
+} // namespace (anon)
+
+TEST_CASE("bengine/FileWatcher", "Reports files modified in watched directories")
+{
+   writeFile(watched_name, "before");
+
+   be::FileWatcher watcher;
+   REQUIRE(watcher.watch("."));
+   REQUIRE(watcher.isWatching("./"));
+   REQUIRE_FALSE(watcher.isWatching("./nonexistent/"));
+   REQUIRE_FALSE(watcher.watch("./nonexistent"));
+
+   // Existing files are not reported until they change.
+   std::string path = std::string("./") + watched_name;
+   REQUIRE_FALSE(contains(watcher.poll(), path));
+
+   // Sleep so that the write time is guaranteed to differ on file systems
+   // with coarse timestamps.
+   std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+   writeFile(watched_name, "after");
+   writeFile(watched_name, "after again");
+
+   std::vector<std::string> modified = pollUntil(watcher, path);
+   REQUIRE(std::count(modified.begin(), modified.end(), path) == 1);
+
+   // Each modification is only reported once.
+   REQUIRE_FALSE(contains(watcher.poll(), path));
+
+   std::remove(watched_name);
+}
+
+#endif
@@ -20,6 +20,15 @@
 
 #include "be/id.h"
 #include "pbj/_pbj.h"
+#include "pbj/ids/editor_modes.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #ifdef BE_TEST
 #include "catch.hpp"
@@ -106,4 +115,254 @@ TEST_CASE("bengine/Id/Comparisons", "Comparison based on numerical value of hash
    REQUIRE(!(be::Id(0x100000000) >= be::Id(0x100000001)));
 }
 
+TEST_CASE("pbj/Id/Precalculated", "Precalculated builtin ids match their names and do not collide")
+{
+   struct Builtin
+   {
+      uint64_t value;
+      const char* name;
+   };
+
+   const Builtin builtins[] =
+   {
+      { PBJ_ID_PBJBASE,                 "__pbjbase__" },
+      { PBJ_ID_PBJCONFIG,               "__pbjconfig__" },
+      { PBJ_ID_BULLET,                  "bullet" },
+      { PBJ_ID_SPAWNPOINT,              "spawnpoint" },
+      { PBJ_ID_STD_FONT,                "std_font" },
+      { PBJ_ID_WPNFIRE,                 "wpnfire" },
+      { PBJ_ID_DMG,                     "dmg" },
+      { PBJ_ID_DEATH,                   "death" },
+      { PBJ_ID_STD_BTN_NORMAL,          "std_btn.normal" },
+      { PBJ_ID_STD_BTN_HOVERED,         "std_btn.hovered" },
+      { PBJ_ID_STD_BTN_ACTIVE,          "std_btn.active" },
+      { PBJ_ID_STD_BTN_FOCUSED,         "std_btn.focused" },
+      { PBJ_ID_STD_BTN_FOCUSED_HOVERED, "std_btn.focused_hovered" },
+      { PBJ_ID_STD_BTN_FOCUSED_ACTIVE,  "std_btn.focused_active" },
+      { PBJ_ID_STD_BTN_DISABLED,        "std_btn.disabled" },
+      { PBJ_ID_PLAYER1_OUTLINE,         "player1_outline" },
+      { PBJ_ID_PLAYER2_OUTLINE,         "player2_outline" },
+      { PBJ_ID_PLAYER3_OUTLINE,         "player3_outline" },
+      { PBJ_ID_PLAYER4_OUTLINE,         "player4_outline" },
+      { PBJ_ID_PLAYER5_OUTLINE,         "player5_outline" },
+   };
+
+   std::set<uint64_t> values;
+   for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); ++i)
+   {
+      INFO(builtins[i].name);
+      REQUIRE(be::Id(builtins[i].name).value() == builtins[i].value);
+      REQUIRE(values.insert(builtins[i].value).second);
+   }
+}
+
+TEST_CASE("pbj/Id/PerfectHash", "Generated perfect hash tables find exactly the Ids they were generated from")
+{
+   namespace table = pbj::ids::editor_modes;
+   REQUIRE(table::size >= table::count);
+
+   size_t names = 0;
+   for (size_t slot = 0; slot < table::size; ++slot)
+   {
+      if (!table::names[slot])
+         continue;
+
+      INFO(table::names[slot]);
+      ++names;
+      REQUIRE(be::Id(table::names[slot]).value() == table::values[slot]);
+      REQUIRE(table::find(table::values[slot]) == static_cast<table::Index>(slot));
+   }
+   REQUIRE(names == table::count);
+
+   REQUIRE(table::find(be::Id("not a precalculated id")) == table::none);
+   REQUIRE(table::find(uint64_t(0)) == table::none);
+   for (uint64_t i = 1; i < 1000; ++i)
+      REQUIRE(table::find(i * 0x9E3779B97F4A7C15ULL) == table::none);
+
+   REQUIRE(table::find(be::Id("EditorMode.look")) == table::id_EditorMode_look);
+   REQUIRE(table::find(be::Id("EditorMode.Look")) == table::none);
+}
+
+TEST_CASE("bengine/Id/Threads", "Ids can be hashed from many threads at once")
+{
+   const int thread_count = 8;
+   const int names = 1000;
+
+   std::vector<std::thread> threads;
+   std::vector<uint64_t> sums(thread_count, 0);
+   for (int t = 0; t < thread_count; ++t)
+      threads.push_back(std::thread([=, &sums]()
+      {
+         for (int i = 0; i < names; ++i)
+         {
+            std::ostringstream oss;
+            oss << "threads." << (i + t * 100) % names;
+            sums[t] += be::Id(oss.str()).value();
+         }
+      }));
+
+   for (auto& thread : threads)
+      thread.join();
+
+   for (int t = 1; t < thread_count; ++t)
+      REQUIRE(sums[t] == sums[0]);
+
+#ifdef BE_ID_NAMES_ENABLED
+   for (int i = 0; i < names; ++i)
+   {
+      std::ostringstream oss;
+      oss << "threads." << i;
+      std::string name(oss.str());
+      std::string str(be::Id(be::Id(name).value()).to_string());
+      REQUIRE(str.substr(18) == name);
+   }
+#endif
+}
+
+TEST_CASE("bengine/Id/hashIds", "Batch hashing produces the same Ids as hashing one string at a time")
+{
+   std::mt19937 rng(20);
+   std::uniform_int_distribution<int> length_dist(0, 40);
+   std::uniform_int_distribution<int> char_dist(0, 255);
+
+   // Every count from 0 to 13 exercises partial batches of four.
+   for (size_t count = 0; count < 14; ++count)
+   {
+      std::vector<std::string> names(count);
+      for (auto& name : names)
+      {
+         name.resize(length_dist(rng));
+         for (auto& c : name)
+            c = static_cast<char>(char_dist(rng));
+      }
+
+      std::vector<be::Id> ids(be::hashIds(names));
+      REQUIRE(ids.size() == count);
+      for (size_t i = 0; i < count; ++i)
+         REQUIRE(ids[i] == be::Id(names[i]));
+   }
+
+   std::vector<std::string> names;
+   names.push_back("");
+   names.push_back("asdf");
+   names.push_back("hashIds.a");
+   names.push_back("hashIds.ab");
+   names.push_back("hashIds.abc");
+   std::vector<be::Id> ids(names.size());
+   be::hashIds(&names[0], names.size(), &ids[0]);
+
+   REQUIRE(ids[0] == be::Id());
+   REQUIRE(ids[1].value() == 0x90285684421F9857);
+
+#ifdef BE_ID_NAMES_ENABLED
+   REQUIRE(ids[2].to_string().substr(18) == "hashIds.a");
+   REQUIRE(ids[3].to_string().substr(18) == "hashIds.ab");
+   REQUIRE(ids[4].to_string().substr(18) == "hashIds.abc");
+#endif
+}
+
+TEST_CASE("bengine/Id/hashBytes", "Hashes arbitrary bytes without recording names")
+{
+   std::string data("asdf");
+   REQUIRE(be::hashBytes(data.data(), data.size()) == 0x90285684421F9857);
+   REQUIRE(be::hashBytes(nullptr, 0) == BE_ID_FNV_OFFSET_BASIS);
+
+   // Hashing in pieces is the same as hashing all at once.
+   uint64_t hash = be::hashBytes(data.data(), 1);
+   hash = be::hashBytes(data.data() + 1, data.size() - 1, hash);
+   REQUIRE(hash == be::hashBytes(data.data(), data.size()));
+
+   std::string binary("a\0b", 3);
+   REQUIRE(be::hashBytes(binary.data(), binary.size()) != be::hashBytes(binary.data(), 1));
+}
+
+TEST_CASE("./bench/Id/hash", "Hashes strings into Ids from several threads at once [hide]")
+{
+   const int names = 2000;
+   const int passes = 100;
+
+   std::vector<std::string> strings;
+   for (int i = 0; i < names; ++i)
+   {
+      std::ostringstream oss;
+      oss << "bench.id.hash." << i;
+      strings.push_back(oss.str());
+   }
+
+#ifdef BE_ID_NAMES_ENABLED
+   std::cout << "Id names enabled" << std::endl;
+#else
+   std::cout << "Id names disabled" << std::endl;
+#endif
+
+   unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+   for (unsigned thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+   {
+      std::vector<std::thread> threads;
+      std::vector<uint64_t> sums(thread_count, 0);
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (unsigned t = 0; t < thread_count; ++t)
+         threads.push_back(std::thread([&, t]()
+         {
+            for (int pass = 0; pass < passes; ++pass)
+               for (auto& str : strings)
+                  sums[t] += be::Id(str).value();
+         }));
+
+      for (auto& thread : threads)
+         thread.join();
+
+      auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+      for (unsigned t = 1; t < thread_count; ++t)
+         REQUIRE(sums[t] == sums[0]);
+
+      std::cout << "   " << thread_count << " thread(s) x " << names * passes << " Ids: "
+                << elapsed.count() << " us" << std::endl;
+   }
+}
+
+TEST_CASE("./bench/Id/hashIds", "Compares batch hashing with hashing one string at a time [hide]")
+{
+   const int names = 2000;
+   const int passes = 1000;
+
+   std::vector<std::string> strings;
+   for (int i = 0; i < names; ++i)
+   {
+      std::ostringstream oss;
+      oss << "bench.id.hashIds." << (i * 7919) % 1000003;
+      strings.push_back(oss.str());
+   }
+
+   std::vector<be::Id> ids(names);
+   uint64_t scalar_sum = 0;
+   auto start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < passes; ++pass)
+      for (int i = 0; i < names; ++i)
+      {
+         ids[i] = be::Id(strings[i]);
+         scalar_sum += ids[i].value();
+      }
+
+   auto scalar_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   uint64_t batch_sum = 0;
+   start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < passes; ++pass)
+   {
+      be::hashIds(&strings[0], names, &ids[0]);
+      for (int i = 0; i < names; ++i)
+         batch_sum += ids[i].value();
+   }
+
+   auto batch_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   REQUIRE(batch_sum == scalar_sum);
+
+   std::cout << "   be::Id(str) x " << names * passes << ": " << scalar_elapsed.count() << " us" << std::endl;
+   std::cout << "   be::hashIds x " << names * passes << ": " << batch_elapsed.count() << " us" << std::endl;
+}
+
 #endif
@@ -0,0 +1,318 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/id_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+// Sends every key to the same slot, to exercise collision handling.
+struct CollidingHash
+{
+   size_t operator()(const be::Id&) const { return 42; }
+};
+
+std::vector<be::Id> makeIds(size_t count)
+{
+   std::vector<be::Id> ids;
+   ids.reserve(count);
+   for (size_t i = 0; i < count; ++i)
+      ids.push_back(be::Id("id_map." + std::to_string(static_cast<unsigned long long>(i))));
+   return ids;
+}
+
+} // namespace (anon)
+
+TEST_CASE("bengine/IdMap", "Open addressing hash map keyed by Ids")
+{
+   be::IdMap<int> map;
+   REQUIRE(map.empty());
+   REQUIRE(map.size() == 0);
+   REQUIRE(map.capacity() == 0);
+   REQUIRE(map.find(be::Id(1)) == map.end());
+   REQUIRE(map.begin() == map.end());
+   REQUIRE(map.count(be::Id(1)) == 0);
+   REQUIRE(map.erase(be::Id(1)) == 0);
+
+   SECTION("insert", "Elements can be inserted with operator[] or insert()")
+   {
+      map[be::Id(1)] = 10;
+      REQUIRE(map.size() == 1);
+      REQUIRE(map[be::Id(1)] == 10);
+      REQUIRE(map.size() == 1);
+
+      auto result = map.insert(std::make_pair(be::Id(2), 20));
+      REQUIRE(result.second);
+      REQUIRE(result.first->first == be::Id(2));
+      REQUIRE(result.first->second == 20);
+
+      result = map.insert(std::make_pair(be::Id(2), 30));
+      REQUIRE(!result.second);
+      REQUIRE(result.first->second == 20);
+
+      REQUIRE(map[be::Id(3)] == 0);
+      REQUIRE(map.size() == 3);
+      REQUIRE(map.count(be::Id(3)) == 1);
+   }
+
+   SECTION("grow", "The map grows as elements are inserted")
+   {
+      std::vector<be::Id> ids(makeIds(1000));
+      for (size_t i = 0; i < ids.size(); ++i)
+         map[ids[i]] = static_cast<int>(i);
+
+      REQUIRE(map.size() == ids.size());
+      REQUIRE(map.capacity() >= ids.size() * 4 / 3);
+
+      for (size_t i = 0; i < ids.size(); ++i)
+      {
+         auto it = map.find(ids[i]);
+         REQUIRE(it != map.end());
+         REQUIRE(it->second == static_cast<int>(i));
+      }
+
+      size_t count = 0;
+      int sum = 0;
+      for (auto& pair : map)
+      {
+         ++count;
+         sum += pair.second;
+      }
+      REQUIRE(count == ids.size());
+      REQUIRE(sum == 999 * 1000 / 2);
+   }
+
+   SECTION("reserve", "Reserving space prevents the map from growing")
+   {
+      map.reserve(100);
+      size_t capacity = map.capacity();
+      REQUIRE(capacity >= 134);
+
+      for (uint64_t i = 0; i < 100; ++i)
+         map[be::Id(i)] = 1;
+
+      REQUIRE(map.capacity() == capacity);
+
+      map.clear();
+      REQUIRE(map.empty());
+      REQUIRE(map.capacity() == capacity);
+      REQUIRE(map.find(be::Id(5)) == map.end());
+   }
+
+   SECTION("erase", "Erasing elements doesn't hide the rest")
+   {
+      std::vector<be::Id> ids(makeIds(500));
+      for (size_t i = 0; i < ids.size(); ++i)
+         map[ids[i]] = static_cast<int>(i);
+
+      for (size_t i = 0; i < ids.size(); i += 2)
+         REQUIRE(map.erase(ids[i]) == 1);
+
+      REQUIRE(map.size() == 250);
+      for (size_t i = 0; i < ids.size(); ++i)
+         REQUIRE(map.count(ids[i]) == i % 2);
+
+      map.erase(map.find(ids[1]));
+      REQUIRE(map.size() == 249);
+      REQUIRE(map.count(ids[1]) == 0);
+      REQUIRE(map[ids[3]] == 3);
+   }
+
+   SECTION("copy", "Maps can be copied, moved and swapped")
+   {
+      map[be::Id(1)] = 1;
+      map[be::Id(2)] = 2;
+
+      be::IdMap<int> copy(map);
+      copy[be::Id(1)] = 3;
+      REQUIRE(copy.size() == 2);
+      REQUIRE(map[be::Id(1)] == 1);
+      REQUIRE(copy[be::Id(1)] == 3);
+
+      be::IdMap<int> moved(std::move(copy));
+      REQUIRE(copy.empty());
+      REQUIRE(moved.size() == 2);
+      REQUIRE(moved[be::Id(2)] == 2);
+
+      copy = moved;
+      REQUIRE(copy.size() == 2);
+
+      be::IdMap<int> other;
+      other[be::Id(7)] = 7;
+      other.swap(map);
+      REQUIRE(map.size() == 1);
+      REQUIRE(other.size() == 2);
+      REQUIRE(map[be::Id(7)] == 7);
+   }
+
+   SECTION("const", "Const maps can be searched and iterated")
+   {
+      map[be::Id(1)] = 1;
+      const be::IdMap<int>& cmap = map;
+
+      be::IdMap<int>::const_iterator it = cmap.find(be::Id(1));
+      REQUIRE(it != cmap.end());
+      REQUIRE(it == map.find(be::Id(1)));
+      REQUIRE(it->second == 1);
+      REQUIRE(cmap.find(be::Id(2)) == cmap.end());
+   }
+}
+
+TEST_CASE("bengine/IdMap/unique_ptr", "IdMap supports move-only values")
+{
+   be::IdMap<std::unique_ptr<int> > map;
+   for (uint64_t i = 0; i < 100; ++i)
+      map[be::Id(i)].reset(new int(static_cast<int>(i)));
+
+   int* ptr = map[be::Id(50)].get();
+   for (uint64_t i = 100; i < 1000; ++i)
+      map.insert(std::make_pair(be::Id(i), std::unique_ptr<int>(new int(static_cast<int>(i)))));
+
+   REQUIRE(map[be::Id(50)].get() == ptr);
+   REQUIRE(*map[be::Id(999)] == 999);
+
+   for (uint64_t i = 0; i < 1000; i += 3)
+      map.erase(be::Id(i));
+
+   REQUIRE(map.size() == 666);
+   REQUIRE(*map[be::Id(998)] == 998);
+}
+
+TEST_CASE("bengine/IdMap/random", "IdMap behaves like std::unordered_map")
+{
+   std::mt19937_64 rng(1234);
+   std::uniform_int_distribution<uint64_t> key_dist(0, 300);
+   std::uniform_int_distribution<int> op_dist(0, 2);
+
+   be::IdMap<uint64_t> map;
+   be::IdMap<uint64_t, be::Id, CollidingHash> colliding;
+   std::unordered_map<be::Id, uint64_t> expected;
+
+   for (int n = 0; n < 20000; ++n)
+   {
+      be::Id key(key_dist(rng));
+      int op = op_dist(rng);
+
+      if (op == 0)
+      {
+         map[key] = n;
+         colliding[key] = n;
+         expected[key] = n;
+      }
+      else if (op == 1)
+      {
+         size_t erased = expected.erase(key);
+         REQUIRE(map.erase(key) == erased);
+         REQUIRE(colliding.erase(key) == erased);
+      }
+      else
+      {
+         auto i = expected.find(key);
+         auto j = map.find(key);
+         auto k = colliding.find(key);
+         REQUIRE((i == expected.end()) == (j == map.end()));
+         REQUIRE((i == expected.end()) == (k == colliding.end()));
+         if (i != expected.end())
+         {
+            REQUIRE(j->second == i->second);
+            REQUIRE(k->second == i->second);
+         }
+      }
+
+      REQUIRE(map.size() == expected.size());
+      REQUIRE(colliding.size() == expected.size());
+   }
+
+   for (auto& pair : map)
+      REQUIRE(expected[pair.first] == pair.second);
+}
+
+TEST_CASE("./bench/IdMap", "Compares IdMap lookups and inserts with std::unordered_map [hide]")
+{
+   const size_t count = 10000;
+   const int lookup_passes = 200;
+   const int insert_passes = 50;
+
+   std::vector<be::Id> ids(makeIds(count));
+   std::vector<be::Id> lookups(ids);
+   std::shuffle(lookups.begin(), lookups.end(), std::mt19937(5678));
+
+   uint64_t total_std = 0;
+   uint64_t total_idmap = 0;
+
+   auto start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < insert_passes; ++pass)
+   {
+      std::unordered_map<be::Id, uint64_t> map;
+      for (size_t i = 0; i < count; ++i)
+         map[ids[i]] = i;
+      total_std += map.size();
+   }
+   auto std_insert = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < insert_passes; ++pass)
+   {
+      be::IdMap<uint64_t> map;
+      for (size_t i = 0; i < count; ++i)
+         map[ids[i]] = i;
+      total_idmap += map.size();
+   }
+   auto idmap_insert = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   std::unordered_map<be::Id, uint64_t> std_map;
+   be::IdMap<uint64_t> id_map;
+   for (size_t i = 0; i < count; ++i)
+   {
+      std_map[ids[i]] = i;
+      id_map[ids[i]] = i;
+   }
+
+   start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < lookup_passes; ++pass)
+      for (auto& id : lookups)
+         total_std += std_map.find(id)->second;
+   auto std_lookup = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < lookup_passes; ++pass)
+      for (auto& id : lookups)
+         total_idmap += id_map.find(id)->second;
+   auto idmap_lookup = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   REQUIRE(total_std == total_idmap);
+
+   std::cout << count << " Ids:" << std::endl
+             << "   std::unordered_map insert (x" << insert_passes << "): " << std_insert.count() << " us" << std::endl
+             << "   be::IdMap insert          (x" << insert_passes << "): " << idmap_insert.count() << " us" << std::endl
+             << "   std::unordered_map lookup (x" << lookup_passes << "): " << std_lookup.count() << " us" << std::endl
+             << "   be::IdMap lookup          (x" << lookup_passes << "): " << idmap_lookup.count() << " us" << std::endl;
+}
+
+#endif
@@ -0,0 +1,111 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "pbj/_pbj.h"
+#include "pbj/sw/manifest.h"
+
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+namespace {
+
+pbj::sw::ResourceId makeId(int sandwich, int resource)
+{
+   return pbj::sw::ResourceId(be::Id(pbj::U64(sandwich)), be::Id(pbj::U64(resource)));
+}
+
+} // namespace (anon)
+
+TEST_CASE("pbj/sw/ManifestRecorder", "Records resources only between start() and stop(), returning them sorted and without duplicates")
+{
+   using pbj::sw::ManifestEntry;
+   pbj::sw::ManifestRecorder recorder;
+
+   REQUIRE_FALSE(recorder.isRecording());
+   recorder.record(ManifestEntry::Texture, makeId(1, 1));
+
+   recorder.start();
+   REQUIRE(recorder.isRecording());
+   recorder.record(ManifestEntry::Sound, makeId(1, 3));
+   recorder.record(ManifestEntry::Texture, makeId(1, 2));
+   recorder.record(ManifestEntry::Material, makeId(2, 1));
+   recorder.record(ManifestEntry::Texture, makeId(1, 2));
+   recorder.record(ManifestEntry::Texture, makeId(1, 1));
+
+   std::vector<ManifestEntry> manifest(recorder.stop());
+   REQUIRE_FALSE(recorder.isRecording());
+   REQUIRE(manifest.size() == 4);
+   REQUIRE(manifest[0] == ManifestEntry(ManifestEntry::Texture, makeId(1, 1)));
+   REQUIRE(manifest[1] == ManifestEntry(ManifestEntry::Texture, makeId(1, 2)));
+   REQUIRE(manifest[2] == ManifestEntry(ManifestEntry::Material, makeId(2, 1)));
+   REQUIRE(manifest[3] == ManifestEntry(ManifestEntry::Sound, makeId(1, 3)));
+
+   // nothing is recorded after stop()
+   recorder.record(ManifestEntry::Sound, makeId(1, 4));
+   recorder.start();
+   REQUIRE(recorder.stop().empty());
+}
+
+TEST_CASE("pbj/sw/ManifestRecorder/pause", "Nothing is recorded while paused, and pauses nest")
+{
+   using pbj::sw::ManifestEntry;
+   pbj::sw::ManifestRecorder recorder;
+
+   recorder.start();
+   recorder.record(ManifestEntry::Texture, makeId(1, 1));
+
+   recorder.pause();
+   recorder.pause();
+   REQUIRE_FALSE(recorder.isRecording());
+   recorder.record(ManifestEntry::Texture, makeId(1, 2));
+
+   recorder.resume();
+   REQUIRE_FALSE(recorder.isRecording());
+   recorder.record(ManifestEntry::Texture, makeId(1, 3));
+
+   recorder.resume();
+   REQUIRE(recorder.isRecording());
+   recorder.record(ManifestEntry::Texture, makeId(1, 4));
+
+   std::vector<ManifestEntry> manifest(recorder.stop());
+   REQUIRE(manifest.size() == 2);
+   REQUIRE(manifest[0].id == makeId(1, 1));
+   REQUIRE(manifest[1].id == makeId(1, 4));
+}
+
+TEST_CASE("pbj/sw/ManifestRecorder/restart", "start() discards anything recorded by an earlier recording which was never stopped")
+{
+   using pbj::sw::ManifestEntry;
+   pbj::sw::ManifestRecorder recorder;
+
+   recorder.start();
+   recorder.record(ManifestEntry::Texture, makeId(1, 1));
+   recorder.start();
+   recorder.record(ManifestEntry::Material, makeId(1, 2));
+
+   std::vector<ManifestEntry> manifest(recorder.stop());
+   REQUIRE(manifest.size() == 1);
+   REQUIRE(manifest[0] == ManifestEntry(ManifestEntry::Material, makeId(1, 2)));
+}
+
+#endif
@@ -0,0 +1,202 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/pack_vfs.h"
+#include "be/bed/connection_pool.h"
+#include "be/bed/stmt.h"
+#include "pbj/_pbj.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+const char* pack_path = "test_pack_vfs.swpack";
+const char* first_path = "test_pack_vfs_first.sw";
+const char* second_path = "test_pack_vfs_second.sw";
+
+///////////////////////////////////////////////////////////////////////////////
+void createDb(const char* path, int value, bool wal)
+{
+   std::remove(path);
+   be::bed::Db db(path);
+   if (wal)
+      db.exec("PRAGMA journal_mode = WAL");
+
+   db.exec("CREATE TABLE t (x INTEGER, y TEXT)");
+   std::ostringstream oss;
+   oss << "INSERT INTO t VALUES (" << value << ", 'abc')";
+   db.exec(oss.str());
+
+   if (wal)
+      db.exec("PRAGMA wal_checkpoint(TRUNCATE)");
+}
+
+} // namespace (anon)
+
+TEST_CASE("bengine/bed/PackVfs", "Serves read-only databases out of a memory-mapped pack file")
+{
+   createDb(first_path, 1, false);
+   createDb(second_path, 2, true);
+
+   std::vector<std::string> files;
+   files.push_back(first_path);
+   files.push_back(second_path);
+   be::bed::PackVfs::write(pack_path, files);
+
+   {
+      be::bed::PackVfs pack(pack_path, "test-pack");
+      REQUIRE(pack.getVfsName() == "test-pack");
+      REQUIRE(pack.getSize() > 0);
+      REQUIRE((pack.getSize() % 4096) == 0);
+
+      std::vector<std::string> filenames(pack.getFilenames());
+      std::sort(filenames.begin(), filenames.end());
+      REQUIRE(filenames.size() == 2);
+      REQUIRE(filenames[0] == first_path);
+      REQUIRE(filenames[1] == second_path);
+      REQUIRE(pack.find(first_path));
+      REQUIRE(!pack.find("nonexistent.sw"));
+
+      SECTION("read", "Images can be queried, including those which used WAL")
+      {
+         be::bed::Db first(first_path, SQLITE_OPEN_READONLY, "test-pack");
+         be::bed::Db second(second_path, SQLITE_OPEN_READONLY, "test-pack");
+         REQUIRE(first.getInt("SELECT x FROM t", 0) == 1);
+         REQUIRE(second.getInt("SELECT x FROM t", 0) == 2);
+      }
+
+      SECTION("mmap", "Pages are fetched directly from the mapping")
+      {
+         be::bed::Db db(second_path, SQLITE_OPEN_READONLY, "test-pack");
+         db.exec("PRAGMA mmap_size = 268435456");
+         REQUIRE(db.getInt("SELECT count(*) FROM t WHERE y = 'abc'", 0) == 1);
+      }
+
+      SECTION("readonly", "Images can't be modified")
+      {
+         be::bed::Db db(first_path, SQLITE_OPEN_READWRITE, "test-pack");
+         REQUIRE_THROWS_AS(db.exec("INSERT INTO t VALUES (3, 'def')"), const be::bed::Db::error&);
+         REQUIRE(db.getInt("SELECT count(*) FROM t", 0) == 1);
+      }
+
+      SECTION("temp", "Temporary tables use the default VFS")
+      {
+         be::bed::Db db(first_path, SQLITE_OPEN_READONLY, "test-pack");
+         db.exec("CREATE TEMP TABLE u (z INTEGER)");
+         db.exec("INSERT INTO u SELECT x FROM t");
+         REQUIRE(db.getInt("SELECT z FROM u", 0) == 1);
+      }
+
+      SECTION("pool", "Connection pools can use a pack")
+      {
+         be::bed::ConnectionPool pool(second_path, 2, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, "test-pack");
+         REQUIRE(pool.getVfsName() == "test-pack");
+         be::bed::PooledDb db = pool.acquire();
+         REQUIRE(db.getDb().getInt("SELECT x FROM t", 0) == 2);
+      }
+
+      SECTION("missing", "Images not in the pack can't be opened")
+      {
+         REQUIRE_THROWS_AS(be::bed::Db("nonexistent.sw", SQLITE_OPEN_READONLY, "test-pack"), const be::bed::Db::error&);
+      }
+
+      SECTION("duplicate", "VFS names must be unique")
+      {
+         REQUIRE_THROWS_AS(be::bed::PackVfs(pack_path, "test-pack"), const be::bed::Db::error&);
+      }
+   }
+
+   // the VFS is unregistered when the PackVfs is destroyed
+   REQUIRE_THROWS_AS(be::bed::Db(first_path, SQLITE_OPEN_READONLY, "test-pack"), const be::bed::Db::error&);
+
+   // loose files are not packs
+   REQUIRE_THROWS_AS(be::bed::PackVfs(first_path, "test-pack"), const be::bed::Db::error&);
+   REQUIRE_THROWS_AS(be::bed::PackVfs("nonexistent.swpack", "test-pack"), const be::bed::Db::error&);
+
+   std::remove(pack_path);
+   std::remove(first_path);
+   std::remove(second_path);
+}
+
+TEST_CASE("./bench/bed/PackVfs/open", "Compares opening and querying loose database files against images in a pack [hide]")
+{
+   const int files = 32;
+   const int passes = 50;
+
+   std::vector<std::string> paths;
+   for (int i = 0; i < files; ++i)
+   {
+      std::ostringstream oss;
+      oss << "bench_pack_vfs_" << i << ".sw";
+      paths.push_back(oss.str());
+      createDb(paths.back().c_str(), i, true);
+   }
+   be::bed::PackVfs::write(pack_path, paths);
+
+   int total = 0;
+
+   auto start = std::chrono::high_resolution_clock::now();
+   for (int pass = 0; pass < passes; ++pass)
+      for (auto& path : paths)
+      {
+         be::bed::Db db(path, SQLITE_OPEN_READONLY);
+         total += db.getInt("SELECT x FROM t", 0);
+      }
+   auto loose = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   {
+      be::bed::PackVfs pack(pack_path, "bench-pack");
+
+      start = std::chrono::high_resolution_clock::now();
+      for (int pass = 0; pass < passes; ++pass)
+         for (auto& path : paths)
+         {
+            be::bed::Db db(path, SQLITE_OPEN_READONLY, "bench-pack");
+            total += db.getInt("SELECT x FROM t", 0);
+         }
+   }
+   auto packed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+   REQUIRE(total == 2 * passes * (files * (files - 1) / 2));
+
+   std::cout << "Open + query " << files << " databases x " << passes << " passes:" << std::endl
+             << "   Loose files: " << loose.count() << " us" << std::endl
+             << "   Pack:        " << packed.count() << " us" << std::endl;
+
+   std::remove(pack_path);
+   for (auto& path : paths)
+   {
+      test::removeDb(path);
+   }
+}
+
+#endif
@@ -0,0 +1,141 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/query_profiler.h"
+#include "be/bed/stmt_cache.h"
+#include "be/bed/db.h"
+#include "pbj/_pbj.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+const be::bed::QueryProfile* findProfile(const std::vector<be::bed::QueryProfile>& profiles, const be::Id& id)
+{
+   for (auto i(profiles.begin()), end(profiles.end()); i != end; ++i)
+      if (i->id == id)
+         return &*i;
+
+   return nullptr;
+}
+
+} // namespace (anon)
+
+TEST_CASE("bengine/bed/QueryProfiler", "Collects per-statement statistics only while enabled")
+{
+   be::bed::Db db;
+   db.exec("CREATE TABLE t (id INTEGER PRIMARY KEY, data BLOB)");
+   db.exec("INSERT INTO t VALUES (1, x'00010203'), (2, x'0405'), (3, NULL)");
+
+   be::bed::resetQueryProfiles();
+   {
+      be::bed::Stmt stmt(db, be::Id("unprofiled"), "SELECT data FROM t");
+      while (stmt.step())
+         stmt.getBlobView(0);
+   }
+   REQUIRE(!findProfile(be::bed::getQueryProfiles(), be::Id("unprofiled")));
+
+   be::bed::setQueryProfilingEnabled(true);
+   REQUIRE(be::bed::isQueryProfilingEnabled());
+   {
+      be::bed::StmtCache cache(db);
+      for (int i = 0; i < 2; ++i)
+      {
+         be::bed::CachedStmt stmt = cache.hold(be::Id("select_data"), "SELECT data FROM t ORDER BY id");
+         while (stmt.step())
+            stmt.getBlob(0);
+      }
+
+      be::bed::Stmt count(db, be::Id("count"), "SELECT count(*) FROM t");
+      count.step();
+   }
+   be::bed::setQueryProfilingEnabled(false);
+
+   {
+      be::bed::Stmt stmt(db, be::Id("count"), "SELECT count(*) FROM t");
+      stmt.step();   // not profiled
+   }
+
+   std::vector<be::bed::QueryProfile> profiles(be::bed::getQueryProfiles());
+   const be::bed::QueryProfile* select = findProfile(profiles, be::Id("select_data"));
+   REQUIRE(select);
+   REQUIRE(select->sql == "SELECT data FROM t ORDER BY id");
+   REQUIRE(select->compiles == 1);
+   REQUIRE(select->holds == 2);
+   REQUIRE(select->steps == 8);
+   REQUIRE(select->rows == 6);
+   REQUIRE(select->blob_bytes == 12);
+   REQUIRE(select->held_time >= select->step_time);
+
+   const be::bed::QueryProfile* count = findProfile(profiles, be::Id("count"));
+   REQUIRE(count);
+   REQUIRE(count->compiles == 1);
+   REQUIRE(count->steps == 1);
+   REQUIRE(count->holds == 0);
+
+   for (size_t i = 1; i < profiles.size(); ++i)
+      REQUIRE(profiles[i - 1].getTotalTime() >= profiles[i].getTotalTime());
+
+   std::ostringstream report;
+   be::bed::printQueryProfiles(report);
+   REQUIRE(report.str().find("SELECT data FROM t ORDER BY id") != std::string::npos);
+
+   be::bed::resetQueryProfiles();
+   REQUIRE(!findProfile(be::bed::getQueryProfiles(), be::Id("select_data")));
+}
+
+TEST_CASE("./bench/bed/QueryProfiler", "Measures the overhead of the query profiler [hide]")
+{
+   const int iterations = 200000;
+
+   be::bed::Db db;
+   be::bed::StmtCache cache(db);
+
+   for (int enabled = 0; enabled < 2; ++enabled)
+   {
+      be::bed::setQueryProfilingEnabled(enabled != 0);
+
+      auto start = std::chrono::high_resolution_clock::now();
+      int sum = 0;
+      for (int i = 0; i < iterations; ++i)
+      {
+         be::bed::CachedStmt stmt = cache.hold("SELECT 1");
+         if (stmt.step())
+            sum += stmt.getInt(0);
+      }
+      double ns = std::chrono::duration_cast<std::chrono::duration<double, std::nano> >(std::chrono::high_resolution_clock::now() - start).count();
+
+      std::cout << (enabled ? "enabled:   " : "disabled:  ") << ns / iterations << " ns per hold/step/release" << std::endl;
+      REQUIRE(sum == iterations);
+   }
+
+   be::bed::setQueryProfilingEnabled(false);
+   be::bed::printQueryProfiles(std::cout);
+   be::bed::resetQueryProfiles();
+}
+
+#endif
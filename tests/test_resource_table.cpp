@@ -0,0 +1,337 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "pbj/_pbj.h"
+#include "pbj/sw/detail/resource_table.h"
+#include "pbj/sw/manifest.h"
+#include "pbj/sw/resource_handle.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+namespace {
+
+using pbj::sw::ManifestEntry;
+using pbj::sw::ResourceHandle;
+using pbj::sw::ResourceId;
+using pbj::sw::detail::ResourceSlot;
+using pbj::sw::detail::ResourceTable;
+
+// Stand-ins for gfx::Texture and audio::Buffer: they only need a size, and
+// swap() for replaceResource().
+struct FakeTexture
+{
+   explicit FakeTexture(size_t size) : size(size) { }
+   size_t getSize() const { return size; }
+   void swap(FakeTexture& other) { std::swap(size, other.size); }
+
+   size_t size;
+};
+
+struct FakeSound
+{
+   explicit FakeSound(size_t size) : size(size) { }
+   size_t getSize() const { return size; }
+   void swap(FakeSound& other) { std::swap(size, other.size); }
+
+   size_t size;
+};
+
+// Like gfx::Material, a FakeMaterial uses no memory itself, but keeps its
+// texture loaded.
+struct FakeMaterial
+{
+   explicit FakeMaterial(const ResourceHandle<FakeTexture>& texture) : texture(texture) { }
+   size_t getSize() const { return 0; }
+   void swap(FakeMaterial& other) { std::swap(texture, other.texture); }
+
+   ResourceHandle<FakeTexture> texture;
+};
+
+// The tables a ResourceManager would have.
+struct Tables
+{
+   Tables()
+      : use_clock(0),
+        textures(ManifestEntry::Texture, use_clock, recorder),
+        materials(ManifestEntry::Material, use_clock, recorder),
+        sounds(ManifestEntry::Sound, use_clock, recorder)
+   {
+   }
+
+   ~Tables()
+   {
+      materials.clear();
+   }
+
+   size_t getBytes() const
+   {
+      return textures.getBytes() + materials.getBytes() + sounds.getBytes();
+   }
+
+   size_t evict(size_t budget)
+   {
+      return pbj::sw::detail::evictLeastRecentlyUsed(budget, textures, materials, sounds);
+   }
+
+   pbj::sw::ManifestRecorder recorder;
+   pbj::U64 use_clock;
+   ResourceTable<FakeTexture> textures;
+   ResourceTable<FakeMaterial> materials;
+   ResourceTable<FakeSound> sounds;
+};
+
+ResourceId makeId(int resource)
+{
+   return ResourceId(be::Id(pbj::U64(1)), be::Id(pbj::U64(resource)));
+}
+
+// Loads a texture the way ResourceManager::loadTexture_() does.
+ResourceSlot<FakeTexture>& loadTexture(Tables& tables, int id, size_t size, pbj::U64 content = 0)
+{
+   ResourceSlot<FakeTexture>& slot = tables.textures.insert(makeId(id), nullptr, content);
+   std::shared_ptr<FakeTexture> existing(tables.textures.findContent(content));
+   if (existing)
+      tables.textures.shareResource(slot, existing);
+   else
+      tables.textures.setResource(slot, std::unique_ptr<FakeTexture>(new FakeTexture(size)));
+
+   return slot;
+}
+
+} // namespace (anon)
+
+TEST_CASE("pbj/sw/detail/ResourceTable/evict", "Unreferenced resources are evicted least recently used first, until the tables fit in the budget")
+{
+   Tables tables;
+   loadTexture(tables, 1, 100);
+   loadTexture(tables, 2, 100);
+   loadTexture(tables, 3, 100);
+   tables.sounds.setResource(tables.sounds.insert(makeId(4), nullptr, 0), std::unique_ptr<FakeSound>(new FakeSound(100)));
+   REQUIRE(tables.getBytes() == 400);
+
+   // using texture 1 again makes texture 2 the least recently used resource
+   tables.textures.touch(*tables.textures.find(makeId(1)));
+
+   REQUIRE(tables.evict(400) == 0);
+   REQUIRE(tables.evict(300) == 1);
+   REQUIRE_FALSE(tables.textures.find(makeId(2)));
+
+   REQUIRE(tables.evict(150) == 2);
+   REQUIRE_FALSE(tables.textures.find(makeId(3)));
+   REQUIRE_FALSE(tables.sounds.find(makeId(4)));
+   REQUIRE(tables.textures.find(makeId(1)));
+   REQUIRE(tables.getBytes() == 100);
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/evict/survivors", "Pinned, referenced, and pending resources are never evicted")
+{
+   Tables tables;
+   loadTexture(tables, 1, 100).pinned = true;
+   ResourceHandle<FakeTexture> held(loadTexture(tables, 2, 100));
+   loadTexture(tables, 3, 100);
+
+   // requested, but still streaming in
+   ResourceSlot<FakeTexture>& pending = tables.textures.insert(makeId(4), nullptr, 44);
+   REQUIRE_FALSE(tables.textures.waitForContent(pending));
+   REQUIRE(pending.pending);
+
+   REQUIRE(tables.textures.getEvictableCount() == 1);
+   REQUIRE(tables.evict(0) == 1);
+   REQUIRE(tables.textures.find(makeId(1)));
+   REQUIRE(tables.textures.find(makeId(2)));
+   REQUIRE_FALSE(tables.textures.find(makeId(3)));
+   REQUIRE(tables.textures.find(makeId(4)) == &pending);
+   REQUIRE(tables.getBytes() == 200);
+
+   // Once the load finishes, the slot is no longer pending, and can be
+   // evicted as soon as nothing refers to it.
+   std::vector<ResourceSlot<FakeTexture>*> waiting(tables.textures.takeWaiting(pending));
+   REQUIRE(waiting.size() == 1);
+   REQUIRE(waiting[0] == &pending);
+   REQUIRE_FALSE(pending.pending);
+   tables.textures.setResource(pending, std::unique_ptr<FakeTexture>(new FakeTexture(100)));
+
+   held = ResourceHandle<FakeTexture>();
+   REQUIRE(tables.evict(0) == 2);
+   REQUIRE(tables.textures.find(makeId(1)));
+   REQUIRE(tables.getBytes() == 100);
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/evict/materials", "Evicting a material releases its texture, which is then evicted in turn")
+{
+   Tables tables;
+   ResourceHandle<FakeTexture> texture(loadTexture(tables, 1, 100));
+   ResourceSlot<FakeMaterial>& material = tables.materials.insert(makeId(2), nullptr, 0);
+   tables.materials.setResource(material, std::unique_ptr<FakeMaterial>(new FakeMaterial(texture)));
+   texture = ResourceHandle<FakeTexture>();
+
+   REQUIRE(tables.materials.getBytes() == 0);
+   REQUIRE(tables.getBytes() == 100);
+   REQUIRE(tables.textures.getEvictableCount() == 0);
+
+   REQUIRE(tables.evict(0) == 2);
+   REQUIRE_FALSE(tables.materials.find(makeId(2)));
+   REQUIRE_FALSE(tables.textures.find(makeId(1)));
+   REQUIRE(tables.getBytes() == 0);
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/content", "Resources with the same content share one object, which is only counted once")
+{
+   Tables tables;
+   ResourceSlot<FakeTexture>& a = loadTexture(tables, 1, 100, 7);
+   ResourceSlot<FakeTexture>& b = loadTexture(tables, 2, 100, 7);
+   ResourceSlot<FakeTexture>& c = loadTexture(tables, 3, 50, 8);
+
+   REQUIRE(a.resource == b.resource);
+   REQUIRE(a.resource != c.resource);
+   REQUIRE(tables.textures.getBytes() == 150);
+   REQUIRE(tables.textures.getDeduplicated() == 1);
+   REQUIRE(tables.textures.getLoadedCount() == 3);
+
+   // Content without a hash is never shared.
+   loadTexture(tables, 4, 25);
+   loadTexture(tables, 5, 25);
+   REQUIRE(tables.textures.getBytes() == 200);
+   REQUIRE(tables.textures.getDeduplicated() == 1);
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/content/release", "Shared objects stay loaded and counted until the last slot sharing them is evicted")
+{
+   Tables tables;
+   ResourceHandle<FakeTexture> a(loadTexture(tables, 1, 100, 7));
+   ResourceHandle<FakeTexture> b(loadTexture(tables, 2, 100, 7));
+   const FakeTexture* shared = b.get();
+   REQUIRE(a.get() == shared);
+
+   REQUIRE(tables.textures.find(makeId(1))->refs == 1);
+   REQUIRE(tables.textures.find(makeId(2))->refs == 1);
+
+   {
+      ResourceHandle<FakeTexture> copy(b);
+      REQUIRE(tables.textures.find(makeId(2))->refs == 2);
+   }
+   REQUIRE(tables.textures.find(makeId(2))->refs == 1);
+
+   // Releasing one handle only makes its own slot evictable.
+   a = ResourceHandle<FakeTexture>();
+   REQUIRE(tables.textures.find(makeId(1))->refs == 0);
+   REQUIRE(tables.textures.getEvictableCount() == 1);
+
+   REQUIRE(tables.evict(0) == 1);
+   REQUIRE_FALSE(tables.textures.find(makeId(1)));
+   REQUIRE(tables.textures.getBytes() == 100);
+   REQUIRE(b.isReady());
+   REQUIRE(b.get() == shared);
+   REQUIRE(tables.textures.findContent(7).get() == shared);
+
+   // A new slot with the same content still shares the object.
+   ResourceHandle<FakeTexture> c(loadTexture(tables, 3, 100, 7));
+   REQUIRE(c.get() == shared);
+   REQUIRE(tables.textures.getBytes() == 100);
+
+   b = ResourceHandle<FakeTexture>();
+   c = ResourceHandle<FakeTexture>();
+   REQUIRE(tables.evict(0) == 2);
+   REQUIRE(tables.textures.getBytes() == 0);
+   REQUIRE_FALSE(tables.textures.findContent(7).get());
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/content/streaming", "Slots requested while their content is streaming in wait for the same load")
+{
+   Tables tables;
+   ResourceSlot<FakeSound>& a = tables.sounds.insert(makeId(1), nullptr, 9);
+   ResourceSlot<FakeSound>& b = tables.sounds.insert(makeId(2), nullptr, 9);
+   ResourceSlot<FakeSound>& c = tables.sounds.insert(makeId(3), nullptr, 10);
+
+   REQUIRE_FALSE(tables.sounds.waitForContent(a));
+   REQUIRE(tables.sounds.waitForContent(b));       // a's load will be shared
+   REQUIRE_FALSE(tables.sounds.waitForContent(c));
+
+   std::vector<ResourceSlot<FakeSound>*> waiting(tables.sounds.takeWaiting(a));
+   REQUIRE(waiting.size() == 2);
+   REQUIRE(waiting[0] == &a);
+   REQUIRE(waiting[1] == &b);
+   REQUIRE_FALSE(a.pending);
+   REQUIRE_FALSE(b.pending);
+   REQUIRE(c.pending);
+
+   tables.sounds.setResource(a, std::unique_ptr<FakeSound>(new FakeSound(64)));
+   tables.sounds.shareResource(b, tables.sounds.findContent(9));
+   REQUIRE(a.resource == b.resource);
+   REQUIRE(tables.sounds.getBytes() == 64);
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/replace", "Replacing a resource swaps it in place unless it is shared")
+{
+   Tables tables;
+   ResourceSlot<FakeTexture>& a = loadTexture(tables, 1, 100, 7);
+   ResourceSlot<FakeTexture>& b = loadTexture(tables, 2, 100, 7);
+   ResourceSlot<FakeTexture>& c = loadTexture(tables, 3, 50, 8);
+   const FakeTexture* original = c.resource.get();
+
+   tables.textures.replaceResource(c, std::unique_ptr<FakeTexture>(new FakeTexture(60)), 9);
+   REQUIRE(c.resource.get() == original);
+   REQUIRE(c.resource->size == 60);
+   REQUIRE(tables.textures.getBytes() == 160);
+   REQUIRE_FALSE(tables.textures.findContent(8).get());
+   REQUIRE(tables.textures.findContent(9) == c.resource);
+
+   tables.textures.replaceResource(b, std::unique_ptr<FakeTexture>(new FakeTexture(80)), 11);
+   REQUIRE(a.resource != b.resource);
+   REQUIRE(a.resource->size == 100);
+   REQUIRE(b.resource->size == 80);
+   REQUIRE(tables.textures.getBytes() == 240);
+}
+
+TEST_CASE("pbj/sw/detail/ResourceTable/record", "Resources are recorded when they are used, but not when they are only looked up")
+{
+   Tables tables;
+   loadTexture(tables, 1, 100);
+
+   tables.recorder.start();
+   REQUIRE(tables.textures.find(makeId(1)));
+   loadTexture(tables, 2, 100);
+   tables.sounds.insert(makeId(3), nullptr, 0);
+   tables.materials.touch(tables.materials.insert(makeId(4), nullptr, 0));
+
+   tables.recorder.pause();
+   tables.textures.touch(*tables.textures.find(makeId(1)));
+   tables.recorder.resume();
+
+   std::vector<ManifestEntry> manifest(tables.recorder.stop());
+   REQUIRE(manifest.size() == 3);
+   REQUIRE(manifest[0] == ManifestEntry(ManifestEntry::Texture, makeId(2)));
+   REQUIRE(manifest[1] == ManifestEntry(ManifestEntry::Material, makeId(4)));
+   REQUIRE(manifest[2] == ManifestEntry(ManifestEntry::Sound, makeId(3)));
+
+   // Touching a resource while paused still makes it the most recently
+   // used, so texture 2 is evicted before texture 1.
+   REQUIRE(tables.evict(100) == 1);
+   REQUIRE(tables.textures.find(makeId(1)));
+   REQUIRE_FALSE(tables.textures.find(makeId(2)));
+}
+
+#endif
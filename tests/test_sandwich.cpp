@@ -0,0 +1,129 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "pbj/_pbj.h"
+#include "pbj/sw/sandwich.h"
+#include "be/bed/db.h"
+#include "be/bed/stmt.h"
+#include "test_util.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+namespace {
+
+bool fileExists(const std::string& path)
+{
+   FILE* file = std::fopen(path.c_str(), "rb");
+   if (!file)
+      return false;
+
+   std::fclose(file);
+   return true;
+}
+
+int countSounds(be::bed::Db& db)
+{
+   return db.getInt("SELECT count(*) FROM sw_sounds", -1);
+}
+
+} // namespace (anon)
+
+TEST_CASE("pbj/sw/Sandwich/snapshot", "Once a snapshot is open, neither the primary connection nor pooled connections read the sandwich file")
+{
+   const std::string path("test_sandwich_snapshot.sw");
+   test::removeDb(path);
+   {
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+      db.exec("INSERT INTO sw_sandwich_properties VALUES ('id', 4323)");
+      db.exec("CREATE TABLE sw_sounds (id INTEGER PRIMARY KEY, data BLOB, content_hash INTEGER)");
+      db.exec("INSERT INTO sw_sounds VALUES (1, x'0102030405', 11)");
+      db.exec("INSERT INTO sw_sounds VALUES (2, x'0607', 12)");
+   }
+
+   pbj::sw::Sandwich snapshot(path, true, true);
+   REQUIRE(snapshot.isSnapshot());
+   REQUIRE(snapshot.getId() == pbj::Id(4323));
+
+   // The snapshot doesn't keep the file open, so it can be deleted; any
+   // later attempt to read it would fail.
+   test::removeDb(path);
+   REQUIRE_FALSE(fileExists(path));
+
+   REQUIRE(countSounds(snapshot.getDb()) == 2);
+
+   {
+      be::bed::PooledDb conn = snapshot.getConnectionPool().acquire();
+      REQUIRE(countSounds(conn.getDb()) == 2);
+
+      be::bed::Stmt load(conn.getDb(), "SELECT data FROM sw_sounds WHERE id = ?");
+      load.bind(1, 1);
+      REQUIRE(load.step());
+      REQUIRE(load.getBlob(0).size() == 5);
+   }
+
+   // Worker threads read the snapshot through the pool, as the
+   // ResourceManager's loaders do.
+   int count = 0;
+   std::thread worker([&]()
+   {
+      be::bed::PooledDb conn = snapshot.getConnectionPool().acquire();
+      count = countSounds(conn.getDb());
+   });
+   worker.join();
+   REQUIRE(count == 2);
+
+   REQUIRE(snapshot.getResidentSize() > 0);
+   REQUIRE_FALSE(fileExists(path));
+}
+
+TEST_CASE("pbj/sw/Sandwich/snapshot/separate", "Two snapshots of the same file don't share an in-memory database")
+{
+   const std::string path("test_sandwich_snapshot_separate.sw");
+   test::removeDb(path);
+   {
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+      db.exec("INSERT INTO sw_sandwich_properties VALUES ('id', 4324)");
+      db.exec("CREATE TABLE sw_sounds (id INTEGER PRIMARY KEY, data BLOB, content_hash INTEGER)");
+   }
+
+   pbj::sw::Sandwich first(path, true, true);
+   first.getDb().exec("INSERT INTO sw_sounds VALUES (1, x'01', 1)");
+
+   pbj::sw::Sandwich second(path, true, true);
+   REQUIRE(countSounds(first.getDb()) == 1);
+   REQUIRE(countSounds(second.getDb()) == 0);
+
+   {
+      be::bed::PooledDb conn = second.getConnectionPool().acquire();
+      REQUIRE(countSounds(conn.getDb()) == 0);
+   }
+
+   test::removeDb(path);
+}
+
+#endif
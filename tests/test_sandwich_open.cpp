@@ -0,0 +1,124 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "pbj/_pbj.h"
+#include "pbj/sw/sandwich_open.h"
+#include "be/bed/db.h"
+#include "be/bed/stmt.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+namespace {
+
+void makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+   _mkdir(path.c_str());
+#else
+   mkdir(path.c_str(), 0777);
+#endif
+}
+
+void removeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+   _rmdir(path.c_str());
+#else
+   rmdir(path.c_str());
+#endif
+}
+
+// Times one call to readDirectory(), in milliseconds.
+double timeReadDirectory(const std::string& path)
+{
+   auto start = std::chrono::high_resolution_clock::now();
+   pbj::sw::readDirectory(path);
+   auto finish = std::chrono::high_resolution_clock::now();
+   return std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(finish - start).count();
+}
+
+} // namespace (anon)
+
+TEST_CASE("./bench/pbj/sw/readDirectory", "Measures a cold directory scan and an indexed rescan of 500 sandwiches [hide]")
+{
+   const std::string path("bench_sandwiches/");
+   const std::string index_path(path + "sandwiches.swindex");
+   const int sandwich_count = 500;
+   const int iterations = 5;
+
+   // Each sandwich only needs an Id for readDirectory() to accept it.  The
+   // Ids are chosen so they won't collide with any real sandwiches.
+   makeDirectory(path);
+   std::vector<std::string> files;
+   for (int i = 0; i < sandwich_count; ++i)
+   {
+      std::ostringstream oss;
+      oss << path << "bench_" << i << ".sw";
+      files.push_back(oss.str());
+      std::remove(files.back().c_str());
+
+      be::bed::Db db(files.back());
+      db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+      be::bed::Stmt set_id(db, "INSERT INTO sw_sandwich_properties VALUES ('id', ?)");
+      set_id.bind(1, 0x62656e6300000000LL + i);
+      set_id.step();
+   }
+
+   double cold_ms = 0;
+   double indexed_ms = 0;
+   for (int n = 0; n < iterations; ++n)
+   {
+      // Without an index every sandwich must be opened and probed.
+      std::remove(index_path.c_str());
+      cold_ms += timeReadDirectory(path);
+
+      // The first scan wrote the index, so nothing needs to be opened.
+      indexed_ms += timeReadDirectory(path);
+   }
+
+   std::vector<pbj::Id> ids(pbj::sw::getSandwichIds());
+   REQUIRE(ids.size() >= size_t(sandwich_count));
+
+   std::cout << "readDirectory (" << sandwich_count << " sandwiches):" << std::endl
+             << "  cold scan:      " << cold_ms / iterations << " ms" << std::endl
+             << "  indexed rescan: " << indexed_ms / iterations << " ms" << std::endl;
+
+   std::remove(index_path.c_str());
+   for (auto i(files.begin()), end(files.end()); i != end; ++i)
+      std::remove(i->c_str());
+   removeDirectory(path);
+}
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "pbj/_pbj.h"
+#include "pbj/scene/scene.h"
+#include "pbj/sw/sandwich.h"
+#include "pbj/sw/schema.h"
+#include "be/bed/db.h"
+#include "be/bed/stmt.h"
+#include "test_util.h"
+
+#include <string>
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+TEST_CASE("pbj/scene/getEntitiesInRegion/vacuum", "Region queries find the right entities after the sandwich is vacuumed")
+{
+   const std::string path("test_scene_region.sw");
+   test::removeDb(path);
+   {
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+      db.exec("INSERT INTO sw_sandwich_properties VALUES ('id', 1234)");
+   }
+
+   {
+      pbj::sw::Sandwich sandwich(path, false);
+      pbj::sw::migrateSchema(sandwich);
+      be::bed::Db& db = sandwich.getDb();
+
+      // Entity i is a unit square at (i * 10, 0).  Deleting the first half
+      // leaves gaps in the rowids of sw_map_entities, which VACUUM closes.
+      be::bed::Stmt insert(db, "INSERT INTO sw_map_entities VALUES (1, ?, 1, 0, ?, 0, 1, 1, NULL, NULL)");
+      for (int i = 1; i <= 10; ++i)
+      {
+         insert.bind(1, i);
+         insert.bind(2, i * 10.0);
+         insert.step();
+         insert.reset();
+      }
+      db.exec("DELETE FROM sw_map_entities WHERE entity_id <= 5");
+      db.exec("UPDATE sw_map_entities SET pos_x = 200 WHERE entity_id = 9");
+
+      pbj::Id map_id(1);
+      std::vector<pbj::Id> found(pbj::scene::getEntitiesInRegion(sandwich, map_id, pbj::vec2(78, -1), pbj::vec2(82, 1)));
+      REQUIRE(found.size() == 1);
+      REQUIRE(found[0] == pbj::Id(8));
+
+      db.vacuum();
+
+      found = pbj::scene::getEntitiesInRegion(sandwich, map_id, pbj::vec2(78, -1), pbj::vec2(82, 1));
+      REQUIRE(found.size() == 1);
+      REQUIRE(found[0] == pbj::Id(8));
+
+      found = pbj::scene::getEntitiesInRegion(sandwich, map_id, pbj::vec2(199, -1), pbj::vec2(201, 1));
+      REQUIRE(found.size() == 1);
+      REQUIRE(found[0] == pbj::Id(9));
+
+      found = pbj::scene::getEntitiesInRegion(sandwich, map_id, pbj::vec2(0, -1), pbj::vec2(55, 1));
+      REQUIRE(found.empty());
+
+      REQUIRE(db.getInt("SELECT count(*) FROM sw_map_entity_bounds", 0) == 5);
+   }
+
+   test::removeDb(path);
+}
+
+#endif
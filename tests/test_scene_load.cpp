@@ -0,0 +1,286 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "pbj/_pbj.h"
+#include "pbj/_gl.h"
+#include "pbj/engine.h"
+#include "pbj/window.h"
+#include "pbj/scene/scene.h"
+#include "pbj/sw/resource_manager.h"
+#include "pbj/sw/sandwich.h"
+#include "pbj/sw/sandwich_open.h"
+#include "be/bed/stmt.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+namespace {
+
+// Scenes need a window, a GL context, and the engine's ResourceManager, and
+// only one Engine may exist per process, so it is created on first use and
+// shared by every benchmark in this file.  Like the game, these benchmarks
+// must be run from the stage directory so that the engine finds its
+// sandwiches.
+pbj::Engine& getBenchEngine()
+{
+   static int argc = 0;
+   static pbj::Engine engine(&argc, nullptr);
+   return engine;
+}
+
+// Finds the map with the most entities in any sandwich the engine found.
+pbj::sw::ResourceId findLargestMap()
+{
+   pbj::sw::ResourceId largest;
+   int most = 0;
+
+   std::vector<be::Id> ids(pbj::sw::getSandwichIds());
+   for (auto i(ids.begin()), end(ids.end()); i != end; ++i)
+   {
+      std::shared_ptr<pbj::sw::Sandwich> sandwich(pbj::sw::open(*i));
+      if (!sandwich)
+         continue;
+
+      try
+      {
+         be::bed::Stmt stmt(sandwich->getDb(), "SELECT map_id, count(*) FROM sw_map_entities GROUP BY map_id ORDER BY 2 DESC LIMIT 1");
+         if (stmt.step() && stmt.getInt(1) > most)
+         {
+            most = stmt.getInt(1);
+            largest = pbj::sw::ResourceId(*i, be::Id(stmt.getUInt64(0)));
+         }
+      }
+      catch (const be::bed::Db::error&)
+      {
+         // this sandwich has no maps
+      }
+   }
+
+   return largest;
+}
+
+// Renders one frame the way Game::draw() does and returns how long it took,
+// in milliseconds.
+double drawFrame(pbj::scene::Scene& scene)
+{
+   auto start = std::chrono::high_resolution_clock::now();
+
+   getBenchEngine().getResourceManager().processUploads();
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+   scene.draw();
+   glfwSwapBuffers(getBenchEngine().getWindow()->getGlfwHandle());
+
+   auto finish = std::chrono::high_resolution_clock::now();
+   return std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(finish - start).count();
+}
+
+} // namespace (anon)
+
+TEST_CASE("./bench/pbj/scene/loadScene/prewarm", "Measures loadScene with and without its statements being pre-warmed on another thread [hide]")
+{
+   const int iterations = 5;
+
+   getBenchEngine();
+   pbj::sw::ResourceId map_id = findLargestMap();
+   std::shared_ptr<pbj::sw::Sandwich> sandwich(pbj::sw::open(map_id.sandwich));
+   REQUIRE(sandwich.get());
+   sandwich->waitForPrewarm();
+
+   be::bed::StmtCache& cache = sandwich->getStmtCache();
+   size_t capacity = cache.getCapacity();
+
+   // Load the map once so that every texture, material, and sound it uses is
+   // already resident in the ResourceManager; the timed loads below then
+   // only differ in how many statements they have to compile.  This is also
+   // where the manifest comes from: getCompiledStatements() is exactly what
+   // sw::saveQueryManifest() would store in the sandwich.
+   pbj::scene::loadScene(*sandwich, map_id.resource);
+   std::vector<std::pair<be::Id, std::string> > manifest(cache.getCompiledStatements());
+   REQUIRE(!manifest.empty());
+
+   for (int prewarm = 0; prewarm < 2; ++prewarm)
+   {
+      double total_ms = 0;
+      size_t total_compiles = 0;
+
+      for (int n = 0; n < iterations; ++n)
+      {
+         // empty the cache
+         cache.setCapacity(0);
+         cache.setCapacity(capacity);
+         cache.resetStats();
+
+         auto start = std::chrono::high_resolution_clock::now();
+
+         std::thread worker;
+         if (prewarm)
+         {
+            worker = std::thread([&]()
+            {
+               for (auto i(manifest.begin()), end(manifest.end()); i != end; ++i)
+                  cache.prepare(i->first, i->second);
+            });
+         }
+
+         std::unique_ptr<pbj::scene::Scene> scene(pbj::scene::loadScene(*sandwich, map_id.resource));
+
+         auto finish = std::chrono::high_resolution_clock::now();
+
+         if (worker.joinable())
+            worker.join();
+
+         REQUIRE(scene.get());
+         total_ms += std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(finish - start).count();
+         total_compiles += cache.getMisses();
+      }
+
+      std::cout << (prewarm ? "pre-warmed:  " : "cold:        ")
+                << "loadScene: " << total_ms / iterations << " ms"
+                << "  compiles during load: " << total_compiles / iterations
+                << "  (map " << map_id << ", " << manifest.size() << " statements in manifest)" << std::endl;
+   }
+}
+
+TEST_CASE("./bench/pbj/scene/loadScene/hitch", "Measures the worst frame after loadScene when resources are loaded synchronously or streamed [hide]")
+{
+   const int iterations = 3;
+   const int frames = 120;
+
+   getBenchEngine();
+   pbj::sw::ResourceManager& rm = getBenchEngine().getResourceManager();
+   pbj::sw::ResourceId map_id = findLargestMap();
+   std::shared_ptr<pbj::sw::Sandwich> sandwich(pbj::sw::open(map_id.sandwich));
+   REQUIRE(sandwich.get());
+   sandwich->waitForPrewarm();
+
+   size_t budget = rm.getBudget();
+
+   for (int streamed = 0; streamed < 2; ++streamed)
+   {
+      double total_load_ms = 0;
+      double total_worst_ms = 0;
+      int total_streaming_frames = 0;
+
+      for (int n = 0; n < iterations; ++n)
+      {
+         // Evict everything the previous load left behind, so each load
+         // starts with none of the map's textures or sounds resident.
+         rm.setBudget(0);
+         rm.setBudget(budget);
+
+         // The frame in which the map is loaded includes loadScene itself.
+         // The synchronous path also finishes every texture and sound
+         // before that frame is drawn, as loadScene did before resources
+         // were streamed; the streamed path leaves them to processUploads().
+         auto start = std::chrono::high_resolution_clock::now();
+         std::unique_ptr<pbj::scene::Scene> scene(pbj::scene::loadScene(*sandwich, map_id.resource));
+         REQUIRE(scene.get());
+
+         if (!streamed)
+         {
+            while (rm.getStreamingCount() > 0)
+            {
+               rm.processUploads(std::chrono::hours(1));
+               std::this_thread::yield();
+            }
+         }
+
+         auto loaded = std::chrono::high_resolution_clock::now();
+         double load_ms = std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(loaded - start).count();
+         double worst_ms = load_ms + drawFrame(*scene);
+         int streaming_frames = 1;
+
+         for (int f = 1; f < frames; ++f)
+         {
+            if (rm.getStreamingCount() > 0)
+               ++streaming_frames;
+
+            worst_ms = std::max(worst_ms, drawFrame(*scene));
+         }
+
+         total_load_ms += load_ms;
+         total_worst_ms += worst_ms;
+         total_streaming_frames += streaming_frames;
+      }
+
+      std::cout << (streamed ? "streamed:    " : "synchronous: ")
+                << "loadScene: " << total_load_ms / iterations << " ms"
+                << "  worst of first " << frames << " frames: " << total_worst_ms / iterations << " ms"
+                << "  frames until resident: " << total_streaming_frames / iterations
+                << "  (map " << map_id << ")" << std::endl;
+   }
+}
+
+TEST_CASE("./bench/pbj/sw/ResourceManager/prefetch", "Measures prefetching the largest map's manifest, and checks that its materials' textures are finished too [hide]")
+{
+   const int iterations = 3;
+
+   getBenchEngine();
+   pbj::sw::ResourceId map_id = findLargestMap();
+   std::shared_ptr<pbj::sw::Sandwich> sandwich(pbj::sw::open(map_id.sandwich));
+   REQUIRE(sandwich.get());
+
+   std::vector<pbj::sw::ManifestEntry> manifest(pbj::scene::loadMapManifest(*sandwich, map_id.resource));
+   REQUIRE(!manifest.empty());
+
+   double total_ms = 0;
+   for (int n = 0; n < iterations; ++n)
+   {
+      // A fresh manager has nothing resident, so every resource in the
+      // manifest has to be read, decoded, and uploaded.
+      pbj::sw::ResourceManager rm;
+
+      auto start = std::chrono::high_resolution_clock::now();
+      rm.prefetch(manifest);
+      auto finish = std::chrono::high_resolution_clock::now();
+      total_ms += std::chrono::duration_cast<std::chrono::duration<double, std::milli> >(finish - start).count();
+
+      // Nothing should still be waiting for an upload: the textures of the
+      // manifest's materials are ready (or failed) as soon as prefetch()
+      // returns.
+      for (auto i(manifest.begin()), end(manifest.end()); i != end; ++i)
+      {
+         if (i->type != pbj::sw::ManifestEntry::Material)
+            continue;
+
+         INFO("material " << i->id);
+         pbj::sw::ResourceHandle<pbj::gfx::Material> material(rm.acquireMaterial(i->id));
+         REQUIRE(material.isReady());
+
+         const pbj::sw::ResourceHandle<pbj::gfx::Texture>& texture = material.get()->getTextureHandle();
+         bool texture_done = texture.isNull() || texture.isReady() || texture.isFailed();
+         REQUIRE(texture_done);
+      }
+   }
+
+   std::cout << "prefetch: " << total_ms / iterations << " ms"
+             << "  (map " << map_id << ", " << manifest.size() << " resources in manifest)" << std::endl;
+}
+
+#endif
@@ -0,0 +1,218 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "pbj/_pbj.h"
+#include "pbj/sw/sandwich.h"
+#include "pbj/sw/schema.h"
+#include "be/bed/db.h"
+#include "be/bed/stmt.h"
+#include "test_util.h"
+
+#include <string>
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+namespace {
+
+// The statements the resource, map, and window settings loaders use to look
+// up a single resource (see tools/sql.txt).  None of them should ever need
+// to visit every row of a table.
+const char* const loader_queries[] =
+{
+   "SELECT name FROM sw_maps WHERE id = ?",
+   "SELECT entity_id FROM sw_map_entities WHERE map_id = ?",
+   "SELECT entity_type, rotation, pos_x, pos_y, scale_x, scale_y, material_sw_id, material_id FROM sw_map_entities WHERE map_id = ? AND entity_id = ?",
+   "SELECT k.entity_id FROM sw_map_entity_bounds b CROSS JOIN sw_map_entity_bounds_keys k ON k.id = b.id WHERE b.max_x >= ? AND b.min_x <= ? AND b.max_y >= ? AND b.min_y <= ? AND k.map_id = ?",
+   "SELECT bg_color_top, bg_color_bottom, border_color, margin_color, margin_left, margin_right, margin_top, margin_bottom, border_left, border_right, border_top, border_bottom FROM sw_ui_panel_styles WHERE id = ?",
+   "SELECT font_id, text_color, text_scale_x, text_scale_y, panel_style_id FROM sw_ui_button_styles WHERE id = ?",
+   "SELECT data FROM sw_sounds WHERE id = ?",
+   "SELECT content_hash FROM sw_sounds WHERE id = ?",
+   "SELECT content_hash, internal_format, srgb, mag_filter, min_filter FROM sw_textures WHERE id = ?",
+   "SELECT texture_id, cap_height FROM sw_texture_fonts WHERE id = ?",
+   "SELECT codepoint, tc_x, tc_y, tc_width, tc_height, offset_x, offset_y, advance FROM sw_texture_font_chars WHERE font_id = ?",
+   "SELECT color, texture_id, texture_mode FROM sw_materials WHERE id = ?",
+   "SELECT window_mode, system_positioned, save_pos_on_close, position_x, position_y, size_x, size_y, monitor_index, refresh_rate, v_sync, msaa_level, red_bits, green_bits, blue_bits, alpha_bits, depth_bits, stencil_bits, srgb_capable, use_custom_gamma, custom_gamma FROM sw_window_settings WHERE id = ? ORDER BY history_index DESC LIMIT 1"
+};
+
+const size_t loader_query_count = sizeof(loader_queries) / sizeof(loader_queries[0]);
+
+// Matches the rule checkQueryPlans() uses: R*Tree searches are reported as
+// scans of a virtual table, but only visit the nodes they need.
+bool isFullScan(const std::vector<std::string>& plan)
+{
+   for (auto i(plan.begin()), end(plan.end()); i != end; ++i)
+      if (i->compare(0, 5, "SCAN ") == 0 && i->find("VIRTUAL TABLE") == std::string::npos)
+         return true;
+
+   return false;
+}
+
+bool usesIndex(const std::vector<std::string>& plan, const std::string& index)
+{
+   for (auto i(plan.begin()), end(plan.end()); i != end; ++i)
+      if (i->find(index) != std::string::npos)
+         return true;
+
+   return false;
+}
+
+// Creates a sandwich as it might have been written before schema versions
+// existed: it has an Id, and map entities and font characters, but those
+// tables were created without primary keys, so every loader which reads
+// them has to scan the whole table.
+void createVersion0Sandwich(const std::string& path)
+{
+   be::bed::Db db(path);
+   db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+   db.exec("INSERT INTO sw_sandwich_properties VALUES ('id', 4321)");
+   db.exec("CREATE TABLE sw_map_entities (map_id INTEGER NOT NULL, entity_id INTEGER NOT NULL, entity_type INTEGER NOT NULL, "
+           "rotation REAL NOT NULL, pos_x REAL NOT NULL, pos_y REAL NOT NULL, scale_x REAL NOT NULL, scale_y REAL NOT NULL, "
+           "material_sw_id INTEGER, material_id INTEGER)");
+   db.exec("CREATE TABLE sw_texture_font_chars (font_id INTEGER NOT NULL, codepoint INTEGER NOT NULL, "
+           "tc_x INTEGER NOT NULL, tc_y INTEGER NOT NULL, tc_width INTEGER NOT NULL, tc_height INTEGER NOT NULL, "
+           "offset_x INTEGER NOT NULL, offset_y INTEGER NOT NULL, advance INTEGER NOT NULL)");
+
+   db.begin();
+   be::bed::Stmt entity(db, "INSERT INTO sw_map_entities VALUES (?, ?, 1, 0, ?, 0, 1, 1, NULL, NULL)");
+   for (int i = 0; i < 200; ++i)
+   {
+      entity.bind(1, i / 20);
+      entity.bind(2, i);
+      entity.bind(3, i * 2.0);
+      entity.step();
+      entity.reset();
+   }
+   db.commit();
+}
+
+} // namespace (anon)
+
+TEST_CASE("pbj/sw/migrateSchema", "Upgrades a version 0 sandwich one migration at a time, and never applies a migration twice")
+{
+   const std::string path("test_schema_migrate.sw");
+   test::removeDb(path);
+   createVersion0Sandwich(path);
+
+   {
+      pbj::sw::Sandwich sandwich(path, false);
+      be::bed::Db& db = sandwich.getDb();
+      REQUIRE(pbj::sw::getSchemaVersion(db) == 0);
+
+      REQUIRE(isFullScan(db.getQueryPlan(loader_queries[1])));
+      REQUIRE(isFullScan(db.getQueryPlan(loader_queries[2])));
+      REQUIRE(isFullScan(db.getQueryPlan(loader_queries[10])));
+
+      for (int version = 1; version <= pbj::sw::getLatestSchemaVersion(); ++version)
+      {
+         INFO("version " << version);
+         REQUIRE(pbj::sw::migrateSchema(sandwich, version) == 1);
+         REQUIRE(pbj::sw::getSchemaVersion(db) == version);
+
+         // re-running (or asking for an older version) changes nothing
+         REQUIRE(pbj::sw::migrateSchema(sandwich, version) == 0);
+         REQUIRE(pbj::sw::migrateSchema(sandwich, version - 1) == 0);
+         REQUIRE(pbj::sw::getSchemaVersion(db) == version);
+      }
+
+      REQUIRE(pbj::sw::migrateSchema(sandwich) == 0);
+
+      // existing rows survive, and are indexed by migration 2
+      REQUIRE(db.getInt("SELECT count(*) FROM sw_map_entities", 0) == 200);
+      REQUIRE(db.getInt("SELECT count(*) FROM sw_map_entity_bounds", 0) == 200);
+   }
+
+   // Opening the sandwich again finds it up to date.
+   {
+      pbj::sw::Sandwich sandwich(path, false);
+      REQUIRE(pbj::sw::getSchemaVersion(sandwich.getDb()) == pbj::sw::getLatestSchemaVersion());
+      REQUIRE(pbj::sw::migrateSchema(sandwich) == 0);
+   }
+
+   test::removeDb(path);
+}
+
+TEST_CASE("pbj/sw/migrateSchema/plans", "Loader queries do not scan whole tables once a sandwich is migrated")
+{
+   const std::string path("test_schema_plans.sw");
+   test::removeDb(path);
+   createVersion0Sandwich(path);
+
+   {
+      pbj::sw::Sandwich sandwich(path, false);
+      be::bed::Db& db = sandwich.getDb();
+      REQUIRE(pbj::sw::migrateSchema(sandwich) == pbj::sw::getLatestSchemaVersion());
+
+      for (size_t i = 0; i < loader_query_count; ++i)
+      {
+         INFO(loader_queries[i]);
+         REQUIRE_FALSE(isFullScan(db.getQueryPlan(loader_queries[i])));
+      }
+
+      REQUIRE(usesIndex(db.getQueryPlan(loader_queries[1]), "sw_map_entities_load"));
+      REQUIRE(usesIndex(db.getQueryPlan(loader_queries[2]), "sw_map_entities_load"));
+      REQUIRE(usesIndex(db.getQueryPlan(loader_queries[3]), "VIRTUAL TABLE"));
+      REQUIRE(usesIndex(db.getQueryPlan(loader_queries[10]), "sw_texture_font_chars_load"));
+
+      // checkQueryPlans() checks every statement the StmtCache has compiled,
+      // including the sandwich's own property queries.
+      be::bed::StmtCache& cache = sandwich.getStmtCache();
+      size_t scans = pbj::sw::checkQueryPlans(sandwich);
+      for (size_t i = 0; i < loader_query_count; ++i)
+         cache.prepare(be::Id(loader_queries[i]), loader_queries[i]);
+
+      REQUIRE(pbj::sw::checkQueryPlans(sandwich) == scans);
+
+      cache.prepare(be::Id("SELECT id FROM sw_maps"), "SELECT id FROM sw_maps");
+      REQUIRE(pbj::sw::checkQueryPlans(sandwich) == scans + 1);
+   }
+
+   test::removeDb(path);
+}
+
+TEST_CASE("pbj/sw/migrateSchema/new", "Creates every table in an empty sandwich")
+{
+   const std::string path("test_schema_new.sw");
+   test::removeDb(path);
+   {
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_sandwich_properties (property TEXT PRIMARY KEY, value NUMERIC)");
+      db.exec("INSERT INTO sw_sandwich_properties VALUES ('id', 4322)");
+   }
+
+   {
+      pbj::sw::Sandwich sandwich(path, false);
+      be::bed::Db& db = sandwich.getDb();
+      REQUIRE(pbj::sw::migrateSchema(sandwich) == pbj::sw::getLatestSchemaVersion());
+      REQUIRE(pbj::sw::getSchemaVersion(db) == pbj::sw::getLatestSchemaVersion());
+      REQUIRE(pbj::sw::migrateSchema(sandwich) == 0);
+
+      for (size_t i = 0; i < loader_query_count; ++i)
+      {
+         INFO(loader_queries[i]);
+         REQUIRE_FALSE(isFullScan(db.getQueryPlan(loader_queries[i])));
+      }
+   }
+
+   test::removeDb(path);
+}
+
+#endif
@@ -0,0 +1,505 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "be/bed/stmt.h"
+#include "be/bed/stmt_cache.h"
+#include "be/bed/db.h"
+#include "pbj/_pbj.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <tuple>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+namespace {
+
+// Counts every allocation made through the global operator new (including
+// those made by array new and the nothrow versions, which call it) so that
+// tests can check that decoding rows doesn't allocate.
+std::atomic<size_t> allocations;
+
+size_t getAllocations()
+{
+   return allocations.load();
+}
+
+} // namespace (anon)
+
+void* operator new(size_t size)
+{
+   ++allocations;
+   void* ptr = std::malloc(size ? size : 1);
+   if (!ptr)
+      throw std::bad_alloc();
+
+   return ptr;
+}
+
+void operator delete(void* ptr)
+{
+   std::free(ptr);
+}
+
+TEST_CASE("bengine/bed/Stmt/get", "Reads typed values from one or more columns")
+{
+   be::bed::Db db;
+   be::bed::Stmt stmt(db, "SELECT 1, 2.5, 3, 4, 'five'");
+   REQUIRE(stmt.step());
+
+   REQUIRE(stmt.get<bool>(0));
+   REQUIRE(stmt.get<int>(0) == 1);
+   REQUIRE(stmt.get<float>(1) == 2.5f);
+   REQUIRE(stmt.get<be::Id>(2) == be::Id(3));
+   REQUIRE(stmt.get<glm::vec2>(2) == glm::vec2(3, 4));
+   REQUIRE(stmt.get<glm::ivec2>(2) == glm::ivec2(3, 4));
+   REQUIRE(std::string(stmt.get<const char*>(4)) == "five");
+
+   std::pair<int, glm::vec2> p = stmt.get<std::pair<int, glm::vec2> >(0);
+   REQUIRE(p.first == 1);
+   REQUIRE(p.second == glm::vec2(2.5f, 3));
+
+   std::tuple<int, double, glm::ivec2, const char*> t = stmt.get<std::tuple<int, double, glm::ivec2, const char*> >(0);
+   REQUIRE(std::get<0>(t) == 1);
+   REQUIRE(std::get<1>(t) == 2.5);
+   REQUIRE(std::get<2>(t) == glm::ivec2(3, 4));
+   REQUIRE(std::string(std::get<3>(t)) == "five");
+
+   REQUIRE(stmt.column("'five'") == 4);
+   REQUIRE_FALSE(stmt.step());
+}
+
+TEST_CASE("bengine/bed/Stmt/rows", "Iterates over decoded result rows")
+{
+   be::bed::Db db;
+   db.exec("CREATE TABLE t (id INTEGER, x REAL, y REAL)");
+   db.exec("INSERT INTO t VALUES (1, 1.5, 2.5)");
+   db.exec("INSERT INTO t VALUES (2, 3.5, 4.5)");
+   db.exec("INSERT INTO t VALUES (3, 5.5, 6.5)");
+
+   be::bed::StmtCache cache(db);
+   be::bed::CachedStmt stmt = cache.hold("SELECT id, x, y FROM t WHERE id >= ? ORDER BY id");
+   stmt.bind(1, 2);
+
+   int count = 0;
+   for (auto& row : stmt.rows<std::tuple<be::Id, glm::vec2> >())
+   {
+      ++count;
+      REQUIRE(std::get<0>(row) == be::Id(count + 1));
+      REQUIRE(std::get<1>(row).x == count * 2 + 1.5f);
+   }
+   REQUIRE(count == 2);
+
+   // decoding rows doesn't allocate
+   stmt.reset();
+   float sum = 0;
+   size_t before = getAllocations();
+   for (auto& row : stmt.rows<std::tuple<be::Id, glm::vec2> >())
+      sum += std::get<1>(row).x;
+   size_t after = getAllocations();
+   REQUIRE(after == before);
+   REQUIRE(sum == 3.5f + 5.5f);
+
+   stmt.reset();
+   stmt.bind(1, 4);
+   be::bed::Rows<int> empty(stmt.rows<int>());
+   REQUIRE(empty.begin() == empty.end());
+}
+
+TEST_CASE("bengine/bed/Stmt/getBlobView", "Views blob data without copying it")
+{
+   be::bed::Db db;
+   be::bed::Stmt stmt(db, "SELECT x'0102030405' UNION ALL SELECT NULL");
+   REQUIRE(stmt.step());
+
+   be::bed::BlobView view = stmt.getBlobView(0);
+   REQUIRE(view.valid());
+   REQUIRE(view.size() == 5);
+   REQUIRE(static_cast<const unsigned char*>(view.data())[4] == 5);
+
+   REQUIRE(stmt.step());
+   REQUIRE_FALSE(view.valid());   // the view refers to the previous row
+
+   be::bed::BlobView null_view = stmt.getBlobView(0);
+   REQUIRE(null_view.valid());
+   REQUIRE(null_view.empty());
+
+   stmt.reset();
+   REQUIRE_FALSE(null_view.valid());
+   REQUIRE(be::bed::BlobView().valid());
+
+   be::bed::BlobView orphan;
+   {
+      be::bed::Stmt temp(db, "SELECT x'01'");
+      REQUIRE(temp.step());
+      orphan = temp.getBlobView(0);
+      REQUIRE(orphan.valid());
+   }
+   REQUIRE_FALSE(orphan.valid());   // the statement has been destroyed
+}
+
+TEST_CASE("bengine/bed/Stmt/executeMany", "Binds and executes a statement once per row")
+{
+   be::bed::Db db;
+   db.exec("CREATE TABLE t (id INTEGER, x REAL, y REAL, name TEXT)");
+
+   typedef std::tuple<be::Id, glm::vec2, std::string> Row;
+   std::vector<Row> rows;
+   rows.push_back(Row(be::Id(1), glm::vec2(1, 2), "one"));
+   rows.push_back(Row(be::Id(2), glm::vec2(3, 4), "two"));
+   rows.push_back(Row(be::Id(3), glm::vec2(5, 6), "three"));
+
+   REQUIRE(db.executeMany("INSERT INTO t VALUES (?, ?, ?, ?)", rows.begin(), rows.end()) == 3);
+   REQUIRE(db.getInt("SELECT count(*) FROM t", 0) == 3);
+
+   std::vector<int> ids;
+   ids.push_back(4);
+   ids.push_back(5);
+
+   be::bed::Stmt insert(db, "INSERT INTO t VALUES (?, ?, 0, ?)");
+   insert.bind(3, "default");   // parameters not bound by the binder keep their values
+   REQUIRE(insert.executeMany(ids.begin(), ids.end(), [](be::bed::Stmt& stmt, int id)
+   {
+      stmt.bind(1, id);
+      stmt.bind(2, id * 10);
+   }) == 2);
+
+   be::bed::Stmt stmt(db, "SELECT id, x, y, name FROM t ORDER BY id");
+   int n = 0;
+   for (auto& row : stmt.rows<std::tuple<int, glm::vec2, const char*> >())
+   {
+      ++n;
+      REQUIRE(std::get<0>(row) == n);
+      if (n <= 3)
+      {
+         REQUIRE(std::get<1>(row) == std::get<1>(rows[n - 1]));
+         REQUIRE(std::string(std::get<2>(row)) == std::get<2>(rows[n - 1]));
+      }
+      else
+      {
+         REQUIRE(std::get<1>(row) == glm::vec2(n * 10.0f, 0));
+         REQUIRE(std::string(std::get<2>(row)) == "default");
+      }
+   }
+   REQUIRE(n == 5);
+
+   be::bed::Stmt select(db, "SELECT ?, ?, ?");
+   select.bindRow(std::make_pair(7, glm::ivec2(8, 9)));
+   REQUIRE(select.step());
+   REQUIRE(select.get<int>(0) == 7);
+   REQUIRE(select.get<glm::ivec2>(1) == glm::ivec2(8, 9));
+}
+
+TEST_CASE("bengine/bed/Db/executeMany/rollback", "Writes no rows if any row fails")
+{
+   be::bed::Db db;
+   db.exec("CREATE TABLE t (id INTEGER PRIMARY KEY)");
+
+   std::vector<int> ids;
+   ids.push_back(1);
+   ids.push_back(2);
+   ids.push_back(1);
+
+   REQUIRE_THROWS_AS(db.executeMany("INSERT INTO t VALUES (?)", ids.begin(), ids.end()), const be::bed::Db::error&);
+   REQUIRE(db.getInt("SELECT count(*) FROM t", -1) == 0);
+}
+
+TEST_CASE("./bench/bed/Stmt/rows", "Decodes 100k sw_map_entities rows by index, by name, and with rows<T>() [hide]")
+{
+   const int entities = 100000;
+
+   be::bed::Db db;
+   db.exec("CREATE TABLE sw_map_entities (map_id INTEGER, entity_id INTEGER, entity_type INTEGER, rotation REAL, "
+           "pos_x REAL, pos_y REAL, scale_x REAL, scale_y REAL, material_sw_id INTEGER, material_id INTEGER)");
+
+   db.begin();
+   {
+      be::bed::Stmt insert(db, "INSERT INTO sw_map_entities VALUES (1, ?, 1, ?, ?, ?, 1, 1, NULL, 42)");
+      for (int i = 0; i < entities; ++i)
+      {
+         insert.bind(1, i);
+         insert.bind(2, i * 0.01);
+         insert.bind(3, i * 2.0);
+         insert.bind(4, i * 3.0);
+         insert.step();
+         insert.reset();
+      }
+   }
+   db.commit();
+
+   const char* sql = "SELECT entity_type, rotation, pos_x, pos_y, scale_x, scale_y, material_sw_id, material_id "
+                     "FROM sw_map_entities WHERE map_id = 1";
+   be::bed::Stmt stmt(db, sql);
+
+   typedef std::chrono::high_resolution_clock clock;
+   typedef std::chrono::duration<double, std::milli> ms;
+   double sum;
+
+   sum = 0;
+   size_t before = getAllocations();
+   clock::time_point start = clock::now();
+   while (stmt.step())
+   {
+      unsigned int type = stmt.getUInt(0);
+      float rotation = float(stmt.getDouble(1));
+      glm::vec2 position(float(stmt.getDouble(2)), float(stmt.getDouble(3)));
+      glm::vec2 scale(float(stmt.getDouble(4)), float(stmt.getDouble(5)));
+      be::Id material(stmt.getUInt64(7));
+      sum += type + rotation + position.x + position.y + scale.x + scale.y + material.value();
+   }
+   double by_index = ms(clock::now() - start).count();
+   size_t by_index_allocations = getAllocations() - before;
+   stmt.reset();
+   double expected = sum;
+
+   sum = 0;
+   start = clock::now();
+   while (stmt.step())
+   {
+      unsigned int type = stmt.getUInt(stmt.column("entity_type"));
+      float rotation = float(stmt.getDouble(stmt.column("rotation")));
+      glm::vec2 position(float(stmt.getDouble(stmt.column("pos_x"))), float(stmt.getDouble(stmt.column("pos_y"))));
+      glm::vec2 scale(float(stmt.getDouble(stmt.column("scale_x"))), float(stmt.getDouble(stmt.column("scale_y"))));
+      be::Id material(stmt.getUInt64(stmt.column("material_id")));
+      sum += type + rotation + position.x + position.y + scale.x + scale.y + material.value();
+   }
+   double by_name = ms(clock::now() - start).count();
+   stmt.reset();
+   REQUIRE(sum == expected);
+
+   sum = 0;
+   before = getAllocations();
+   start = clock::now();
+   typedef std::tuple<unsigned int, float, glm::vec2, glm::vec2> EntityRow;
+   for (auto& row : stmt.rows<EntityRow>())
+   {
+      be::Id material(stmt.get<be::Id>(7));
+      sum += std::get<0>(row) + std::get<1>(row) + std::get<2>(row).x + std::get<2>(row).y
+           + std::get<3>(row).x + std::get<3>(row).y + material.value();
+   }
+   double by_rows = ms(clock::now() - start).count();
+   size_t by_rows_allocations = getAllocations() - before;
+   stmt.reset();
+   REQUIRE(sum == expected);
+
+   // Neither way of decoding by index allocates anything per row.
+   REQUIRE(by_index_allocations == 0);
+   REQUIRE(by_rows_allocations == 0);
+
+   std::cout << "sw_map_entities rows: " << entities << std::endl
+             << "   by index:  " << by_index << " ms" << std::endl
+             << "   by name:   " << by_name << " ms" << std::endl
+             << "   rows<T>(): " << by_rows << " ms" << std::endl;
+}
+
+TEST_CASE("./bench/bed/Stmt/loaders", "Runs the loadEntity() and loadWindowSettings() queries 10k times each through a StmtCache [hide]")
+{
+   const int loads = 10000;
+
+   be::bed::Db db;
+   db.exec("CREATE TABLE sw_map_entities (map_id INTEGER NOT NULL, entity_id INTEGER NOT NULL, entity_type INTEGER NOT NULL, "
+           "rotation REAL NOT NULL, pos_x REAL NOT NULL, pos_y REAL NOT NULL, scale_x REAL NOT NULL, scale_y REAL NOT NULL, "
+           "material_sw_id INTEGER, material_id INTEGER, PRIMARY KEY (map_id, entity_id))");
+   db.exec("CREATE TABLE sw_window_settings (id INTEGER NOT NULL, history_index INTEGER NOT NULL, window_mode INTEGER, "
+           "system_positioned INTEGER, save_pos_on_close INTEGER, position_x INTEGER, position_y INTEGER, size_x INTEGER, size_y INTEGER, "
+           "monitor_index INTEGER, refresh_rate INTEGER, v_sync INTEGER, msaa_level INTEGER, red_bits INTEGER, green_bits INTEGER, "
+           "blue_bits INTEGER, alpha_bits INTEGER, depth_bits INTEGER, stencil_bits INTEGER, srgb_capable INTEGER, "
+           "use_custom_gamma INTEGER, custom_gamma REAL, PRIMARY KEY (id, history_index))");
+
+   db.begin();
+   {
+      be::bed::Stmt insert(db, "INSERT INTO sw_map_entities VALUES (1, ?, 1, ?, ?, ?, 1, 1, NULL, 42)");
+      for (int i = 0; i < loads; ++i)
+      {
+         insert.bind(1, i);
+         insert.bind(2, i * 0.01);
+         insert.bind(3, i * 2.0);
+         insert.bind(4, i * 3.0);
+         insert.step();
+         insert.reset();
+      }
+      for (int i = 0; i < 3; ++i)
+      {
+         be::bed::Stmt ws(db, "INSERT INTO sw_window_settings VALUES (7, ?, 0, 1, 1, 0, 0, 1280, 720, 0, 60, 1, 4, 8, 8, 8, 8, 24, 8, 1, 0, 2.2)");
+         ws.bind(1, i);
+         ws.step();
+      }
+   }
+   db.commit();
+
+   // The SQL used by pbj::scene::loadEntity() and pbj::loadWindowSettings().
+   // Release builds hold them with precomputed Ids, so their Ids are only
+   // hashed once here.
+   const char* load_entity_sql = "SELECT entity_type, rotation, "
+      "pos_x, pos_y, scale_x, scale_y, material_sw_id, material_id "
+      "FROM sw_map_entities WHERE map_id = ? AND entity_id = ?";
+   const char* load_window_settings_sql = "SELECT window_mode, "
+      "system_positioned, save_pos_on_close, position_x, position_y, "
+      "size_x, size_y, monitor_index, refresh_rate, v_sync, "
+      "msaa_level, red_bits, green_bits, blue_bits, alpha_bits, "
+      "depth_bits, stencil_bits, "
+      "srgb_capable, use_custom_gamma, custom_gamma "
+      "FROM sw_window_settings WHERE id = ? "
+      "ORDER BY history_index DESC LIMIT 1";
+   const be::Id load_entity_id(load_entity_sql);
+   const be::Id load_window_settings_id(load_window_settings_sql);
+
+   be::bed::StmtCache cache(db);
+
+   typedef std::chrono::high_resolution_clock clock;
+   typedef std::chrono::duration<double, std::milli> ms;
+
+   // Each load is timed from hold() to release, like the loaders; the first
+   // pass compiles the statements and sizes the cache's free lists.
+   double entity_ms = 0;
+   size_t entity_allocations = 0;
+   double entity_sum = 0;
+   for (int pass = 0; pass < 2; ++pass)
+   {
+      entity_sum = 0;
+      size_t before = getAllocations();
+      clock::time_point start = clock::now();
+      for (int i = 0; i < loads; ++i)
+      {
+         be::bed::CachedStmt stmt = cache.hold(load_entity_id, load_entity_sql);
+         stmt.bind(1, 1);
+         stmt.bind(2, i);
+         if (stmt.step())
+         {
+            unsigned int type = stmt.get<unsigned int>(0);
+            float rotation = stmt.get<float>(1);
+            glm::vec2 position = stmt.get<glm::vec2>(2);
+            glm::vec2 scale = stmt.get<glm::vec2>(4);
+            be::Id material;
+            if (stmt.getType(7) != SQLITE_NULL)
+               material = stmt.get<be::Id>(7);
+
+            entity_sum += type + rotation + position.x + position.y + scale.x + scale.y + material.value();
+         }
+      }
+      entity_ms = ms(clock::now() - start).count();
+      entity_allocations = getAllocations() - before;
+   }
+
+   double window_settings_ms = 0;
+   size_t window_settings_allocations = 0;
+   int window_settings_sum = 0;
+   for (int pass = 0; pass < 2; ++pass)
+   {
+      window_settings_sum = 0;
+      size_t before = getAllocations();
+      clock::time_point start = clock::now();
+      for (int i = 0; i < loads; ++i)
+      {
+         be::bed::CachedStmt stmt = cache.hold(load_window_settings_id, load_window_settings_sql);
+         stmt.bind(1, 7);
+         if (stmt.step())
+         {
+            int mode = stmt.get<int>(0);
+            bool system_positioned = stmt.get<bool>(1);
+            glm::ivec2 position = stmt.get<glm::ivec2>(3);
+            glm::ivec2 size = stmt.get<glm::ivec2>(5);
+            unsigned int refresh_rate = stmt.get<unsigned int>(8);
+            unsigned int depth_bits = stmt.get<unsigned int>(15);
+            float gamma = stmt.get<float>(19);
+
+            window_settings_sum += mode + system_positioned + position.x + size.x + size.y
+                                 + refresh_rate + depth_bits + int(gamma * 10);
+         }
+      }
+      window_settings_ms = ms(clock::now() - start).count();
+      window_settings_allocations = getAllocations() - before;
+   }
+
+   REQUIRE(entity_sum > 0);
+   REQUIRE(window_settings_sum == loads * (1 + 1280 + 720 + 60 + 24 + 22));
+
+   // Once the statements are cached, loading allocates nothing.
+   REQUIRE(entity_allocations == 0);
+   REQUIRE(window_settings_allocations == 0);
+
+   std::cout << "loader queries: " << loads << " loads each" << std::endl
+             << "   loadEntity():         " << entity_ms << " ms" << std::endl
+             << "   loadWindowSettings(): " << window_settings_ms << " ms" << std::endl;
+}
+
+TEST_CASE("./bench/bed/Stmt/executeMany", "Saves 10k sw_map_entities rows one transaction per row, and with executeMany() [hide]")
+{
+   const int entities = 10000;
+   const char* path = "bench_execute_many.sqlite";
+
+   typedef std::chrono::high_resolution_clock clock;
+   typedef std::chrono::duration<double, std::milli> ms;
+   typedef std::tuple<int, float, glm::vec2, glm::vec2> EntityRow;
+
+   std::vector<EntityRow> rows;
+   rows.reserve(entities);
+   for (int i = 0; i < entities; ++i)
+      rows.push_back(EntityRow(i, i * 0.01f, glm::vec2(i * 2.0f, i * 3.0f), glm::vec2(1, 1)));
+
+   const char* sql = "INSERT INTO sw_map_entities (map_id, entity_id, rotation, pos_x, pos_y, scale_x, scale_y) "
+                     "VALUES (1, ?, ?, ?, ?, ?, ?)";
+
+   double per_row;
+   double batched;
+   for (int batch = 0; batch < 2; ++batch)
+   {
+      std::remove(path);
+      be::bed::Db db(path);
+      db.exec("CREATE TABLE sw_map_entities (map_id INTEGER, entity_id INTEGER, entity_type INTEGER, rotation REAL, "
+              "pos_x REAL, pos_y REAL, scale_x REAL, scale_y REAL, material_sw_id INTEGER, material_id INTEGER)");
+
+      clock::time_point start = clock::now();
+      if (batch)
+      {
+         db.executeMany(sql, rows.begin(), rows.end());
+         batched = ms(clock::now() - start).count();
+      }
+      else
+      {
+         be::bed::Stmt insert(db, sql);
+         for (auto i(rows.begin()), end(rows.end()); i != end; ++i)
+         {
+            db.exec("BEGIN IMMEDIATE");
+            insert.bindRow(*i);
+            insert.step();
+            insert.reset();
+            db.commit();
+         }
+         per_row = ms(clock::now() - start).count();
+      }
+
+      REQUIRE(db.getInt("SELECT count(*) FROM sw_map_entities", 0) == entities);
+   }
+   std::remove(path);
+
+   std::cout << "sw_map_entities rows: " << entities << std::endl
+             << "   transaction per row: " << per_row << " ms" << std::endl
+             << "   executeMany():       " << batched << " ms" << std::endl;
+}
+
+#endif
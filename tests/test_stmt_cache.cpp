@@ -0,0 +1,421 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "be/bed/stmt_cache.h"
+#include "be/bed/db.h"
+#include "pbj/_pbj.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef BE_TEST
+#include "catch.hpp"
+
+TEST_CASE("bengine/bed/StmtCache", "Holds, releases, and reuses cached statements")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 2);
+
+   {
+      be::bed::CachedStmt a = cache.hold("SELECT 1");
+      REQUIRE(a.step());
+      REQUIRE(a.getInt(0) == 1);
+
+      be::bed::CachedStmt b = cache.hold("SELECT 1");   // a is held, so a new statement is compiled
+      REQUIRE(cache.getSize() == 2);
+      REQUIRE(cache.getHeldSize() == 2);
+   }
+
+   REQUIRE(cache.getSize() == 2);
+   REQUIRE(cache.getHeldSize() == 0);
+   REQUIRE(cache.getHits() == 0);
+   REQUIRE(cache.getMisses() == 2);
+   REQUIRE(cache.getCompiles() == 2);
+
+   {
+      be::bed::CachedStmt a = cache.hold("SELECT 1");
+      REQUIRE(a.step());   // released statements are reset
+      REQUIRE(a.getInt(0) == 1);
+   }
+
+   REQUIRE(cache.getHits() == 1);
+   REQUIRE(cache.getMisses() == 2);
+   REQUIRE(cache.getEvictions() == 0);
+
+   cache.resetStats();
+   REQUIRE(cache.getHits() == 0);
+   REQUIRE(cache.getMisses() == 0);
+   REQUIRE(cache.getCompiles() == 0);
+}
+
+TEST_CASE("bengine/bed/StmtCache/Eviction", "Least recently released statements are evicted first")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 2);
+
+   cache.hold("SELECT 1");
+   cache.hold("SELECT 2");
+   cache.hold("SELECT 1");   // "SELECT 2" is now the least recently released
+
+   REQUIRE(cache.getSize() == 2);
+
+   cache.hold("SELECT 3");   // evicts "SELECT 2"
+   REQUIRE(cache.getSize() == 2);
+   REQUIRE(cache.getEvictions() == 1);
+
+   cache.hold("SELECT 1");
+   REQUIRE(cache.getHits() == 2);
+
+   cache.hold("SELECT 2");
+   REQUIRE(cache.getCompiles() == 4);
+   REQUIRE(cache.getEvictions() == 2);
+
+   {
+      // held statements are never evicted
+      be::bed::CachedStmt a = cache.hold("SELECT 4");
+      be::bed::CachedStmt b = cache.hold("SELECT 5");
+      be::bed::CachedStmt c = cache.hold("SELECT 6");
+      REQUIRE(cache.getSize() == 3);
+      REQUIRE(cache.getHeldSize() == 3);
+   }
+
+   REQUIRE(cache.getSize() == 2);
+
+   cache.setCapacity(0);
+   REQUIRE(cache.getSize() == 0);
+}
+
+TEST_CASE("bengine/bed/StmtCache/Sharded", "Released statements are kept in per-thread front caches")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 2, 4, 1);
+
+   REQUIRE(cache.getShards() == 4);
+   REQUIRE(cache.getShardSize() == 1);
+
+   cache.hold("SELECT 1");
+   cache.hold("SELECT 1");   // served from this thread's shard
+   REQUIRE(cache.getHits() == 1);
+   REQUIRE(cache.getCompiles() == 1);
+
+   cache.hold("SELECT 2");   // pushes "SELECT 1" out of the shard
+   cache.hold("SELECT 1");   // served from the shared cache
+   REQUIRE(cache.getHits() == 2);
+   REQUIRE(cache.getSize() == 2);
+
+   cache.hold("SELECT 3");
+   REQUIRE(cache.getSize() == 2);
+   REQUIRE(cache.getEvictions() == 1);
+
+   {
+      be::bed::CachedStmt a = cache.hold("SELECT 3");
+      REQUIRE(a.step());
+      REQUIRE(a.getInt(0) == 3);
+      REQUIRE(cache.getHeldSize() == 1);
+   }
+
+   cache.setCapacity(0);
+   REQUIRE(cache.getSize() == 0);
+   REQUIRE(cache.getHeldSize() == 0);
+}
+
+TEST_CASE("bengine/bed/StmtCache/Sharded/Threads", "Threads share the front cache their ids hash to, even after other threads exit")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 8, 1, 4);
+
+   // With a single shard, every thread uses the same front cache, so a
+   // statement released by a thread which has exited is still found there.
+   std::thread first([&cache]()
+   {
+      cache.hold("SELECT 1");
+   });
+   first.join();
+
+   for (int i = 0; i < 4; ++i)
+   {
+      std::thread next([&cache]()
+      {
+         cache.hold("SELECT 1");
+      });
+      next.join();
+   }
+
+   cache.hold("SELECT 1");
+
+   REQUIRE(cache.getCompiles() == 1);
+   REQUIRE(cache.getHits() == 5);
+   REQUIRE(cache.getSize() == 1);
+}
+
+TEST_CASE("bengine/bed/StmtCache/Sharded/ManyThreads", "More threads than shards can use the cache at once")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 4, 2, 2);
+   const char* queries[] = { "SELECT 1", "SELECT 2", "SELECT 3" };
+
+   std::vector<std::thread> workers;
+   for (int t = 0; t < 8; ++t)
+   {
+      workers.push_back(std::thread([&cache, &queries]()
+      {
+         for (int i = 0; i < 1000; ++i)
+         {
+            be::bed::CachedStmt a = cache.hold(queries[i % 3]);
+            be::bed::CachedStmt b = cache.hold(queries[(i + 1) % 3]);
+            a.step();
+            b.step();
+         }
+      }));
+   }
+
+   for (auto i(workers.begin()), end(workers.end()); i != end; ++i)
+      i->join();
+
+   REQUIRE(cache.getHeldSize() == 0);
+   REQUIRE(cache.getSize() <= cache.getCapacity());
+   size_t holds = cache.getHits() + cache.getMisses();
+   REQUIRE(holds == 8 * 1000 * 2);
+}
+
+TEST_CASE("bengine/bed/StmtCache/Sharded/Capacity", "Statements in front caches are evicted to stay within capacity")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 2, 4, 4);
+
+   cache.hold("SELECT 1");
+   cache.hold("SELECT 2");
+   cache.hold("SELECT 3");   // evicts "SELECT 1" from this thread's shard
+   REQUIRE(cache.getSize() == 2);
+   REQUIRE(cache.getEvictions() == 1);
+
+   cache.hold("SELECT 2");
+   REQUIRE(cache.getHits() == 1);
+
+   {
+      be::bed::CachedStmt a = cache.hold("SELECT 4");
+      be::bed::CachedStmt b = cache.hold("SELECT 5");
+      REQUIRE(cache.getSize() == 2);
+      REQUIRE(cache.getHeldSize() == 2);
+   }
+
+   // Releasing into the shard brings the cache back within capacity.
+   REQUIRE(cache.getSize() == 2);
+   REQUIRE(cache.getHeldSize() == 0);
+}
+
+TEST_CASE("bengine/bed/StmtCache/prepare", "Statements can be compiled ahead of time and recorded")
+{
+   be::bed::Db db;
+   be::bed::StmtCache cache(db, 3);
+
+   REQUIRE(cache.prepare(be::Id("one"), "SELECT 1"));
+   REQUIRE(!cache.prepare(be::Id("one"), "SELECT 1"));   // already cached
+   REQUIRE(cache.getSize() == 1);
+   REQUIRE(cache.getHeldSize() == 0);
+   REQUIRE(cache.getCompiles() == 1);
+
+   REQUIRE_THROWS_AS(cache.prepare(be::Id("bad"), "SELECT * FROM nonexistent"), const be::bed::Db::error&);
+   REQUIRE(cache.getSize() == 1);
+
+   {
+      be::bed::CachedStmt a = cache.hold(be::Id("one"), "SELECT 1");
+      REQUIRE(cache.getHits() == 1);
+      REQUIRE(cache.getMisses() == 0);
+      REQUIRE(a.step());
+      REQUIRE(a.getInt(0) == 1);
+
+      REQUIRE(cache.prepare(be::Id("one"), "SELECT 1"));   // the cached statement is held
+   }
+
+   REQUIRE(cache.prepare(be::Id("two"), "SELECT 2"));
+   REQUIRE(cache.getSize() == 3);
+   REQUIRE(!cache.prepare(be::Id("three"), "SELECT 3"));   // cache is full
+   REQUIRE(cache.getSize() == 3);
+   REQUIRE(cache.getEvictions() == 0);
+
+   cache.hold("SELECT 4");
+   std::vector<std::pair<be::Id, std::string> > compiled(cache.getCompiledStatements());
+   std::sort(compiled.begin(), compiled.end(), [](const std::pair<be::Id, std::string>& a, const std::pair<be::Id, std::string>& b) { return a.second < b.second; });
+   REQUIRE(compiled.size() == 3);
+   REQUIRE(compiled[0].first == be::Id("one"));
+   REQUIRE(compiled[0].second == "SELECT 1");
+   REQUIRE(compiled[1].first == be::Id("two"));
+   REQUIRE(compiled[2].first == be::Id("SELECT 4"));
+}
+
+namespace {
+
+// The StmtCache algorithm from before the intrusive LRU list and per-thread
+// front caches were added: a single mutex, a multimap searched on every hold
+// and release, and a linear scan for the least recently released statement
+// when the cache is over capacity.  Only used as the baseline for the
+// contention benchmark.
+class BaselineStmtCache
+{
+public:
+   BaselineStmtCache(be::bed::Db& db, size_t capacity)
+      : db_(db), capacity_(capacity), held_size_(0), next_index_(1)
+   {
+   }
+
+   be::bed::Stmt& hold(const char* sql)
+   {
+      be::Id id(sql);
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (held_size_ < cache_.size())
+      {
+         auto range(cache_.equal_range(id));
+         for (auto i(range.first); i != range.second; ++i)
+         {
+            if (!i->second.held)
+            {
+               hold_(i->second);
+               return *i->second.stmt;
+            }
+         }
+      }
+      lock.unlock();
+
+      std::shared_ptr<be::bed::Stmt> stmt(new be::bed::Stmt(db_, id, sql));
+
+      lock.lock();
+      Entry entry;
+      entry.stmt = stmt;
+      hold_(cache_.insert(std::make_pair(id, entry))->second);
+      checkSize_();
+      return *stmt;
+   }
+
+   void release(be::bed::Stmt& stmt)
+   {
+      stmt.reset();
+      stmt.bind();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto range(cache_.equal_range(stmt.getId()));
+      for (auto i(range.first); i != range.second; ++i)
+      {
+         if (i->second.stmt.get() == &stmt && i->second.held)
+         {
+            i->second.held = false;
+            --held_size_;
+            checkSize_();
+            return;
+         }
+      }
+   }
+
+private:
+   struct Entry
+   {
+      std::shared_ptr<be::bed::Stmt> stmt;
+      bool held;
+      size_t access_index;
+   };
+
+   void hold_(Entry& entry)
+   {
+      entry.held = true;
+      entry.access_index = next_index_++;
+      ++held_size_;
+   }
+
+   void checkSize_()
+   {
+      while (cache_.size() > capacity_ && held_size_ < cache_.size())
+      {
+         auto oldest = cache_.end();
+         for (auto i(cache_.begin()), end(cache_.end()); i != end; ++i)
+            if (!i->second.held && (oldest == end || i->second.access_index < oldest->second.access_index))
+               oldest = i;
+
+         cache_.erase(oldest);
+      }
+   }
+
+   std::mutex mutex_;
+   be::bed::Db& db_;
+   size_t capacity_;
+   size_t held_size_;
+   size_t next_index_;
+   std::multimap<be::Id, Entry> cache_;
+};
+
+} // namespace (anon)
+
+TEST_CASE("./bench/bed/StmtCache/contention", "Measures hold()/release throughput with multiple threads, compared to the original StmtCache [hide]")
+{
+   const int iterations = 100000;
+   const char* queries[] = { "SELECT 1", "SELECT 2", "SELECT 3", "SELECT 4" };
+   const char* names[] = { "baseline  ", "unsharded ", "sharded   ", "4 shards  " };
+
+   // The last mode uses 4 shards however many threads there are, so most of
+   // its runs have more threads than shards.
+   for (int mode = 0; mode < 4; ++mode)
+   {
+      for (size_t threads = 1; threads <= 16; threads *= 2)
+      {
+         be::bed::Db db;
+         BaselineStmtCache baseline(db, 64);
+         size_t shards = mode == 3 ? 4 : mode == 2 ? threads : 0;
+         be::bed::StmtCache cache(db, 64, shards, 4);
+
+         auto start = std::chrono::high_resolution_clock::now();
+
+         std::vector<std::thread> workers;
+         for (size_t t = 0; t < threads; ++t)
+         {
+            workers.push_back(std::thread([&cache, &baseline, &queries, iterations, mode]()
+            {
+               for (int i = 0; i < iterations; ++i)
+               {
+                  if (mode == 0)
+                     baseline.release(baseline.hold(queries[i & 3]));
+                  else
+                     cache.hold(queries[i & 3]);
+               }
+            }));
+         }
+
+         for (auto i(workers.begin()), end(workers.end()); i != end; ++i)
+            i->join();
+
+         double seconds = std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::high_resolution_clock::now() - start).count();
+         double ops = threads * iterations / seconds;
+
+         std::cout << names[mode] << "  threads: " << threads
+                   << "  holds/sec: " << static_cast<long long>(ops);
+         if (mode != 0)
+            std::cout << "  hits: " << cache.getHits() << "  misses: " << cache.getMisses();
+         std::cout << std::endl;
+
+         REQUIRE(cache.getHeldSize() == 0);
+      }
+   }
+}
+
+#endif
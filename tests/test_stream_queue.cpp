@@ -0,0 +1,156 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "pbj/_pbj.h"
+#include "pbj/sw/detail/stream_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef PBJ_TEST
+#include "catch.hpp"
+
+TEST_CASE("pbj/sw/detail/StreamQueue", "Upload tasks run on the thread which processes uploads, in the order their loads finished")
+{
+   const int loads = 20;
+   pbj::sw::detail::StreamQueue queue(1);
+   REQUIRE(queue.getWorkerCount() == 1);
+
+   std::thread::id main_thread = std::this_thread::get_id();
+   std::vector<int> uploaded;
+   std::vector<std::thread::id> upload_threads;
+   std::vector<std::thread::id> load_threads(loads);
+
+   for (int i = 0; i < loads; ++i)
+   {
+      pbj::sw::detail::StreamQueue* q = &queue;
+      queue.queueLoad([=, &uploaded, &upload_threads, &load_threads]()
+      {
+         load_threads[i] = std::this_thread::get_id();
+         q->queueUpload([=, &uploaded, &upload_threads]()
+         {
+            uploaded.push_back(i);
+            upload_threads.push_back(std::this_thread::get_id());
+         });
+      });
+   }
+
+   REQUIRE(queue.getStreamingCount() == size_t(loads));
+
+   while (queue.getStreamingCount() > 0)
+      queue.waitForUpload();
+
+   // With one worker, loads finish in the order they were queued.
+   REQUIRE(uploaded.size() == size_t(loads));
+   for (int i = 0; i < loads; ++i)
+   {
+      INFO("load " << i);
+      REQUIRE(uploaded[i] == i);
+      REQUIRE(upload_threads[i] == main_thread);
+      REQUIRE(load_threads[i] != main_thread);
+   }
+
+   REQUIRE(queue.processUploads(std::chrono::microseconds(0)) == 0);
+}
+
+TEST_CASE("pbj/sw/detail/StreamQueue/budget", "processUploads() runs at least one upload, and stops once its budget is spent")
+{
+   pbj::sw::detail::StreamQueue queue(2);
+
+   std::mutex mutex;
+   int loaded = 0;
+   int uploaded = 0;
+   for (int i = 0; i < 3; ++i)
+   {
+      pbj::sw::detail::StreamQueue* q = &queue;
+      queue.queueLoad([=, &mutex, &loaded, &uploaded]()
+      {
+         {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++loaded;
+         }
+         q->queueUpload([&uploaded]() { ++uploaded; });
+      });
+   }
+
+   // Uploads are never run by the workers, no matter how long they wait.
+   while (true)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (loaded == 3)
+         break;
+   }
+   std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   REQUIRE(uploaded == 0);
+   REQUIRE(queue.getStreamingCount() == 3);
+
+   REQUIRE(queue.processUploads(std::chrono::microseconds(0)) == 2);
+   REQUIRE(uploaded == 1);
+
+   REQUIRE(queue.processUploads(std::chrono::hours(1)) == 0);
+   REQUIRE(uploaded == 3);
+}
+
+TEST_CASE("pbj/sw/detail/StreamQueue/stop", "Stopping waits for running loads, and abandons loads which haven't started")
+{
+   pbj::sw::detail::StreamQueue queue(1);
+
+   std::promise<void> started;
+   std::promise<void> release;
+   std::shared_future<void> released(release.get_future().share());
+   std::atomic<int> loaded(0);
+
+   pbj::sw::detail::StreamQueue* q = &queue;
+   for (int i = 0; i < 3; ++i)
+   {
+      queue.queueLoad([&, i, q, released]()
+      {
+         if (i == 0)
+         {
+            started.set_value();
+            released.wait();
+         }
+
+         ++loaded;
+         q->queueUpload([]() { });
+      });
+   }
+
+   // The worker is stuck in the first load, so the other two are still
+   // queued when stop() is called.
+   started.get_future().wait();
+   std::thread unblock([&]()
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      release.set_value();
+   });
+   queue.stop();
+   unblock.join();
+
+   int count = loaded;
+   REQUIRE(count == 1);
+}
+
+#endif
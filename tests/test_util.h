@@ -0,0 +1,47 @@
+// Copyright (c) 2013 Benjamin Crist
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+///////////////////////////////////////////////////////////////////////////////
+/// \file   test_util.h
+/// \author Benjamin Crist
+///
+/// \brief  Helpers shared by several test files.
+
+#ifndef TEST_UTIL_H_
+#define TEST_UTIL_H_
+
+#include <cstdio>
+#include <string>
+
+namespace test {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Deletes a database file, along with its WAL and shared memory
+///         files if it was left in WAL mode.
+inline void removeDb(const std::string& path)
+{
+   std::remove(path.c_str());
+   std::remove((path + "-wal").c_str());
+   std::remove((path + "-shm").c_str());
+}
+
+} // namespace test
+
+#endif
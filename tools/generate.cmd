@@ -1,2 +1,17 @@
-@idgen < builtins.txt > ids.builtins.txt
-@idgen < resource_types.txt > ids.resource_types.txt
\ No newline at end of file
+@rem vc11\idgen copies its build to ..\stage; the idgen.exe in this directory
+@rem predates --table, so prefer the fresh build when there is one
+@set idgen=idgen
+@if exist ..\stage\idgen.exe set idgen=..\stage\idgen.exe
+@%idgen% < builtins.txt > ids.builtins.txt
+@%idgen% < resource_types.txt > ids.resource_types.txt
+@%idgen% < sql.txt > ids.sql.txt
+@%idgen% < editor_modes.txt > ids.editor_modes.txt
+@rem perfect hash table of editor modes (see Editor::setMode())
+@if not exist ..\stage\idgen.exe goto no_table
+@%idgen% --table pbj::ids::editor_modes pbj/ids/editor_modes.h < editor_modes.txt > ..\include\pbj\ids\editor_modes.h
+@goto check
+:no_table
+@echo Build vc11\idgen to regenerate pbj\ids\editor_modes.h 1>&2
+:check
+@rem check for collisions between all precalculated ids (warnings are written to STDERR)
+@(type builtins.txt & echo. & type resource_types.txt & echo. & type editor_modes.txt & echo. & type sql.txt) | %idgen% > nul
\ No newline at end of file
@@ -4,11 +4,280 @@
 ///
 /// \brief  Command-line utility for calculating be::Id values from strings
 
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
 #include <iostream>
+#include <random>
+#include <set>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "be/id.h"
 
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Determines which slot of a perfect hash table an Id value is
+///         placed in.
+///
+/// \details This must match the find() function emitted by writeTable().
+///         The high 32 bits of the product are scaled to the size of the
+///         table, so the table's size doesn't need to be a power of two.
+size_t getSlot(uint64_t value, uint64_t multiplier, size_t size)
+{
+   return static_cast<size_t>((((value * multiplier) >> 32) * size) >> 32);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Searches for a multiplier which maps each of the provided values
+///         to a different slot of a table with the specified size.
+///
+/// \param  values The values which must be placed in the table.
+/// \param  size The number of slots in the table.
+/// \param  attempts The number of multipliers to try.
+/// \param  rng The source of candidate multipliers.
+/// \return A suitable multiplier, or 0 if none was found.
+uint64_t findMultiplier(const std::vector<uint64_t>& values, size_t size, int attempts, std::mt19937_64& rng)
+{
+   std::vector<int> used(size, -1);
+
+   for (int attempt = 0; attempt < attempts; ++attempt)
+   {
+      uint64_t multiplier = rng() | 1;
+
+      bool ok = true;
+      for (size_t i = 0; i < values.size() && ok; ++i)
+      {
+         int& slot = used[getSlot(values[i], multiplier, size)];
+         ok = slot != attempt;
+         slot = attempt;
+      }
+
+      if (ok)
+         return multiplier;
+   }
+
+   return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Converts a string into something which can be used as part of a
+///         C++ identifier.
+///
+/// \details Any runs of characters other than letters and digits are
+///         replaced by a single underscore, and underscores at the beginning
+///         and end are removed.
+std::string toIdentifier(const std::string& str)
+{
+   std::string result;
+   for (auto i(str.begin()), end(str.end()); i != end; ++i)
+   {
+      if (isalnum(static_cast<unsigned char>(*i)))
+         result.push_back(*i);
+      else if (!result.empty() && result.back() != '_')
+         result.push_back('_');
+   }
+
+   while (!result.empty() && result.back() == '_')
+      result.pop_back();
+
+   return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/// \brief  Reads a list of names from STDIN and writes a C++ header to STDOUT
+///         containing a perfect hash table of their Ids.
+///
+/// \details The search for a multiplier starts with one slot per name (a
+///         minimal perfect hash) and gradually adds slots until a multiplier
+///         is found, so tables are rarely more than a few slots larger than
+///         necessary.  The header defines, in the namespace specified:
+///
+///         - enum Index: the slot of each name, as id_<name>, and none (-1).
+///         - count: the number of names in the table.
+///         - size: the number of slots in the table.
+///         - multiplier: used to map Id values to slots.
+///         - values[size]: the Id value in each slot.
+///         - names[size]: the name in each slot (or nullptr).
+///         - find(): returns the Index of an Id, or none.
+///
+///         Blank lines in the input are ignored.  The search for a
+///         multiplier is seeded with a constant, so the same input always
+///         generates the same header.
+///
+/// \param  ns The fully qualified namespace to place the table in, e.g.
+///         pbj::ids::editor_modes.
+/// \param  path The path to the header, relative to the include directory.
+/// \return 0 if the header was generated successfully, or 1 otherwise.
+int writeTable(const std::string& ns, const std::string& path)
+{
+   std::vector<std::string> names;
+   std::vector<uint64_t> values;
+   std::set<uint64_t> unique_values;
+
+   while (std::cin)
+   {
+      std::string str;
+      std::getline(std::cin, str);
+
+      if (str.length() == 0)
+         continue;
+
+      be::Id id(str);
+      if (!unique_values.insert(id.value()).second)
+         continue;   // duplicate (or colliding) name
+
+      names.push_back(str);
+      values.push_back(id.value());
+   }
+
+   if (names.empty())
+   {
+      std::cerr << "No names to place in table!" << std::endl;
+      return 1;
+   }
+
+   std::mt19937_64 rng(0x5eed5eed5eed5eedULL);
+   size_t size = names.size();
+   uint64_t multiplier = 0;
+   while ((multiplier = findMultiplier(values, size, 1 << 20, rng)) == 0)
+      size += std::max(size_t(1), size / 16);
+
+   std::vector<int> slots(size, -1);
+   for (size_t i = 0; i < values.size(); ++i)
+      slots[getSlot(values[i], multiplier, size)] = static_cast<int>(i);
+
+   std::vector<std::string> namespaces;
+   std::string guard(path);
+   for (size_t begin = 0, end; begin < ns.length(); begin = end + 2)
+   {
+      end = std::min(ns.find("::", begin), ns.length());
+      namespaces.push_back(ns.substr(begin, end - begin));
+   }
+   std::transform(guard.begin(), guard.end(), guard.begin(), toupper);
+   guard = toIdentifier(guard) + "_";
+
+   std::ostream& os = std::cout;
+   os << "///////////////////////////////////////////////////////////////////////////////\n"
+      << "/// \\file   " << path << "\n"
+      << "/// \\author Benjamin Crist\n"
+      << "///\n"
+      << "/// \\brief  Perfect hash table of precalculated Ids.\n"
+      << "/// \\details Generated by idgen --table (see tools/generate.cmd); do not\n"
+      << "///         edit.  Looking up an Id takes two multiplications and a single\n"
+      << "///         comparison.\n"
+      << "\n"
+      << "#ifndef " << guard << "\n"
+      << "#define " << guard << "\n"
+      << "\n"
+      << "#include \"be/id.h\"\n"
+      << "\n"
+      << "#include <cstddef>\n"
+      << "\n";
+
+   for (auto& n : namespaces)
+      os << "namespace " << n << " {\n";
+
+   os << "\n"
+      << "///////////////////////////////////////////////////////////////////////////////\n"
+      << "/// \\brief  The slot containing each Id.\n"
+      << "enum Index\n"
+      << "{\n"
+      << "   none = -1,\n";
+
+   std::set<std::string> identifiers;
+   for (size_t slot = 0; slot < size; ++slot)
+   {
+      if (slots[slot] < 0)
+         continue;
+
+      std::string identifier("id_" + toIdentifier(names[slots[slot]]));
+      while (!identifiers.insert(identifier).second)
+         identifier += "_";
+
+      os << "   " << identifier << " = " << slot << ",\n";
+   }
+
+   os << "};\n"
+      << "\n"
+      << "const size_t count = " << names.size() << ";   ///< The number of Ids in the table.\n"
+      << "const size_t size = " << size << ";    ///< The number of slots in the table.\n"
+      << "const uint64_t multiplier = 0x" << std::hex << std::setfill('0') << std::setw(16) << multiplier << std::dec << "ULL;\n"
+      << "\n"
+      << "///////////////////////////////////////////////////////////////////////////////\n"
+      << "/// \\brief  The Id value in each slot.  Empty slots contain a value which\n"
+      << "///         belongs in a different slot.\n"
+      << "const uint64_t values[size] =\n"
+      << "{\n";
+
+   for (size_t slot = 0; slot < size; ++slot)
+      os << "   0x" << std::hex << std::setfill('0') << std::setw(16) << values[slots[slot] < 0 ? 0 : slots[slot]] << std::dec << "ULL,\n";
+
+   os << "};\n"
+      << "\n"
+      << "///////////////////////////////////////////////////////////////////////////////\n"
+      << "/// \\brief  The name hashed to create the Id in each slot.\n"
+      << "const char* const names[size] =\n"
+      << "{\n";
+
+   for (size_t slot = 0; slot < size; ++slot)
+   {
+      if (slots[slot] < 0)
+      {
+         os << "   nullptr,\n";
+         continue;
+      }
+
+      os << "   \"";
+      for (auto c : names[slots[slot]])
+      {
+         if (c == '\\' || c == '"')
+            os << '\\';
+         os << c;
+      }
+      os << "\",\n";
+   }
+
+   os << "};\n"
+      << "\n"
+      << "///////////////////////////////////////////////////////////////////////////////\n"
+      << "/// \\brief  Finds the slot containing an Id value.\n"
+      << "/// \\return The slot's Index, or none if the value is not in the table.\n"
+      << "inline Index find(uint64_t value)\n"
+      << "{\n"
+      << "   size_t slot = static_cast<size_t>((((value * multiplier) >> 32) * size) >> 32);\n"
+      << "   return values[slot] == value ? static_cast<Index>(slot) : none;\n"
+      << "}\n"
+      << "\n"
+      << "///////////////////////////////////////////////////////////////////////////////\n"
+      << "/// \\brief  Finds the slot containing an Id.\n"
+      << "/// \\return The slot's Index, or none if the Id is not in the table.\n"
+      << "inline Index find(const be::Id& id)\n"
+      << "{\n"
+      << "   return find(id.value());\n"
+      << "}\n"
+      << "\n";
+
+   std::string qualified;
+   for (size_t i = namespaces.size(); i > 0; --i)
+   {
+      qualified.clear();
+      for (size_t j = 0; j < i; ++j)
+         qualified += (j > 0 ? "::" : "") + namespaces[j];
+
+      os << "} // namespace " << qualified << "\n";
+   }
+
+   os << "\n"
+      << "#endif\n";
+
+   return 0;
+}
+
+} // namespace (anon)
+
 ///////////////////////////////////////////////////////////////////////////////
 /// \brief  Utility for generating FNV-1a hashes of arbitrary strings.
 ///
@@ -33,14 +302,28 @@
 ///         different, previously processed input string) a warning will be
 ///         output to STDERR.
 ///
+///         If the first argument is --table, the strings read from STDIN are
+///         instead used to generate a header containing a perfect hash table
+///         (see writeTable()).  The second argument is the namespace to place
+///         the table in, and the third is the path of the header (used for
+///         the include guard and file comment), i.e:
+///
+/// \code
+///         idgen --table pbj::ids::editor_modes pbj/ids/editor_modes.h < editor_modes.txt
+/// \endcode
+///
 /// \param  argc The number of command-line arguments (including the program
 ///         name).
 /// \param  argv An array of c-strings representing the command-line arguments
 ///
-/// \return Always returns 0 to the operating system.
+/// \return 0 to the operating system, unless a table could not be generated.
 int main(int argc, char** argv)
 {
-   if (argc > 1)
+   if (argc == 4 && std::string(argv[1]) == "--table")
+   {
+      return writeTable(argv[2], argv[3]);
+   }
+   else if (argc > 1)
    {
       for (int i = 1; i < argc; ++i)
       {
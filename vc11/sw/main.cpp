@@ -29,11 +29,13 @@
 #include "pbj/_pbj.h"
 
 #include "pbj/gfx/texture.h"
+#include "be/bed/pack_vfs.h"
 #include "be/bed/transaction.h"
 #include "pbj/sw/sandwich.h"
 #include "pbj/gfx/texture_font_character.h"
 #include "pbj/sw/sandwich_open.h"
 #include "pbj/sw/resource_id.h"
+#include "pbj/sw/schema.h"
 
 // global variables
 std::string cmd_name;
@@ -54,6 +56,7 @@ enum ListType
 
 // function prototypes
 int create(const std::string& filename);
+int pack(const std::string& filename, const std::vector<std::string>& sandwiches);
 int list(ListType type);
 int prop(const std::string& prop, const std::string& value);
 int texture(const std::string& texture, const std::string& filename, const char** extra, int extra_count);
@@ -113,6 +116,18 @@ int main(int argc, char** argv)
         return create(argv[3]);
     }
 
+    // packing operates on sandwich files, not an existing sandwich.
+    if (operation == "pack")
+    {
+        if (argc < 4)
+        {
+            PBJ_LOG(pbj::VError) << "No sandwich files specified!" << PBJ_LOG_END;
+            displayUsage();
+            return -1;
+        }
+        return pack(argv[1], std::vector<std::string>(argv + 3, argv + argc));
+    }
+
     pbj::sw::readDirectory("./");
     sw = pbj::sw::openWritable(sw_id);
     if (!sw)
@@ -253,6 +268,11 @@ int main(int argc, char** argv)
     {
         sw->getDb().vacuum();
     }
+    else if (operation == "plans")
+    {
+        size_t scans = pbj::sw::checkQueryPlans(*sw);
+        std::cout << scans << " queries require a full scan." << std::endl;
+    }
     else 
     {
         PBJ_LOG(pbj::VError) << "Unrecognized operation!" << PBJ_LOG_END;
@@ -271,6 +291,9 @@ void displayUsage()
     if (operation == "" || operation == "create")
         std::cout << "    " << cmd_name << " " << sw_name << " create <filename>" << std::endl;
 
+    if (operation == "" || operation == "pack")
+        std::cout << "    " << cmd_name << " <pack filename> pack <sandwich filename> [sandwich filename...]" << std::endl;
+
     if (operation == "" || operation == "list")
         std::cout << "    " << cmd_name << " " << sw_name << " list [all|properties|textures]" << std::endl;
 
@@ -291,6 +314,30 @@ void displayUsage()
 
     if (operation == "" || operation == "vacuum")
         std::cout << "    " << cmd_name << " " << sw_name << " vacuum" << std::endl;
+
+    if (operation == "" || operation == "plans")
+        std::cout << "    " << cmd_name << " " << sw_name << " plans" << std::endl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int pack(const std::string& filename, const std::vector<std::string>& sandwiches)
+{
+    try
+    {
+        pbj::db::PackVfs::write(filename, sandwiches);
+    }
+    catch (const pbj::db::Db::error& e)
+    {
+        PBJ_LOG(pbj::VError) << "Error while creating sandwich pack!" << PBJ_LOG_NL
+                             << " Filename: " << filename << PBJ_LOG_NL
+                             << "Exception: " << e.what() << PBJ_LOG_END;
+        return 1;
+    }
+
+    PBJ_LOG(pbj::VInfo) << "Created sandwich pack." << PBJ_LOG_NL
+                        << "  Filename: " << filename << PBJ_LOG_NL
+                        << "Sandwiches: " << sandwiches.size() << PBJ_LOG_END;
+    return 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -362,187 +409,12 @@ int create(const std::string& filename)
     {
         sw = std::shared_ptr<pbj::sw::Sandwich>(new pbj::sw::Sandwich(filename, false));
 
-        pbj::db::Stmt table_exists(sw->getDb(), "SELECT name FROM sqlite_master WHERE type = 'table' AND name = ? LIMIT 1");
-
-        table_exists.bind(1, "sw_sounds");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_sounds\n"
-                             "(\n"
-                             "   id INTEGER PRIMARY KEY,\n"
-                             "   data NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_sounds'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_textures");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_textures\n"
-                             "(\n"
-                             "   id              INTEGER PRIMARY KEY,\n"
-                             "   data            NOT NULL,\n"
-                             "   internal_format INTEGER NOT NULL,\n"
-                             "   srgb            INTEGER NOT NULL,\n"
-                             "   mag_filter      INTEGER NOT NULL,\n"
-                             "   min_filter      INTEGER NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_textures'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_texture_fonts");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_texture_fonts\n"
-                             "(\n"
-                             "   id         INTEGER PRIMARY KEY,\n"
-                             "   texture_id NOT NULL,\n"
-                             "   cap_height INTEGER NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_texture_fonts'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_texture_font_chars");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_texture_font_chars\n"
-                             "(\n"
-                             "   font_id   INTEGER NOT NULL,\n"
-                             "   codepoint INTEGER NOT NULL,\n"
-                             "   tc_x      INTEGER NOT NULL,\n"
-                             "   tc_y      INTEGER NOT NULL,\n"
-                             "   tc_width  INTEGER NOT NULL,\n"
-                             "   tc_height INTEGER NOT NULL,\n"
-                             "   offset_x  INTEGER NOT NULL,\n"
-                             "   offset_y  INTEGER NOT NULL,\n"
-                             "   advance   INTEGER NOT NULL,\n"
-                             "   PRIMARY KEY (font_id, codepoint)\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_texture_font_chars'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_ui_panel_styles");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_ui_panel_styles\n"
-                             "(\n"
-                             "   id              INTEGER PRIMARY KEY,\n"
-                             "   bg_color_top    INTEGER NOT NULL,\n"
-                             "   bg_color_bottom INTEGER NOT NULL,\n"
-                             "   border_color    INTEGER NOT NULL,\n"
-                             "   margin_color    INTEGER NOT NULL,\n"
-                             "   margin_left     REAL NOT NULL,\n"
-                             "   margin_right    REAL NOT NULL,\n"
-                             "   margin_top      REAL NOT NULL,\n"
-                             "   margin_bottom   REAL NOT NULL,\n"
-                             "   border_left     REAL NOT NULL,\n"
-                             "   border_right    REAL NOT NULL,\n"
-                             "   border_top      REAL NOT NULL,\n"
-                             "   border_bottom   REAL NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_ui_panel_styles'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_ui_button_styles");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_ui_button_styles\n"
-                             "(\n"
-                             "   id             INTEGER PRIMARY KEY,\n"
-                             "   font_id        INTEGER NOT NULL,\n"
-                             "   text_color     INTEGER NOT NULL,\n"
-                             "   text_scale_x   INTEGER NOT NULL,\n"
-                             "   text_scale_y   INTEGER NOT NULL,\n"
-                             "   panel_style_id INTEGER NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_ui_button_styles'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_window_settings");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_window_settings\n"
-                             "(\n"
-                             "   id                INTEGER NOT NULL,\n"
-                             "   history_index     INTEGER NOT NULL,\n"
-                             "   window_mode       INTEGER NOT NULL,\n"
-                             "   system_positioned INTEGER NOT NULL,\n"
-                             "   maximized         INTEGER NOT NULL,\n"
-                             "   save_pos_on_close INTEGER NOT NULL,\n"
-                             "   position_x        INTEGER NOT NULL,\n"
-                             "   position_y        INTEGER NOT NULL,\n"
-                             "   size_x            INTEGER NOT NULL,\n"
-                             "   size_y            INTEGER NOT NULL,\n"
-                             "   monitor_index     INTEGER NOT NULL,\n"
-                             "   refresh_rate      INTEGER NOT NULL,\n"
-                             "   v_sync            INTEGER NOT NULL,\n"
-                             "   msaa_level        INTEGER NOT NULL,\n"
-                             "   red_bits          INTEGER NOT NULL,\n"
-                             "   green_bits        INTEGER NOT NULL,\n"
-                             "   blue_bits         INTEGER NOT NULL,\n"
-                             "   alpha_bits        INTEGER NOT NULL,\n"
-                             "   depth_bits        INTEGER NOT NULL,\n"
-                             "   stencil_bits      INTEGER NOT NULL,\n"
-                             "   srgb_capable      INTEGER NOT NULL,\n"
-                             "   use_custom_gamma  INTEGER NOT NULL,\n"
-                             "   custom_gamma      REAL NOT NULL,\n"
-                             "   PRIMARY KEY (id, history_index)\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_window_settings'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_materials");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_materials\n"
-                             "(\n"
-                             "   id           INTEGER PRIMARY KEY,\n"
-                             "   color        INTEGER NOT NULL,\n"
-                             "   texture_id   INTEGER,\n"
-                             "   texture_mode INTEGER NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_materials'." << PBJ_LOG_END;
-        }
-        
-        table_exists.reset();
-        table_exists.bind(1, "sw_maps");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_maps\n"
-                             "(\n"
-                             "   id   INTEGER PRIMARY KEY,\n"
-                             "   name TEXT NOT NULL\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_maps'." << PBJ_LOG_END;
-        }
-
-        table_exists.reset();
-        table_exists.bind(1, "sw_map_entities");
-        if (!table_exists.step())
-        {
-            sw->getDb().exec("CREATE TABLE sw_map_entities\n"
-                             "(\n"
-                             "   map_id      INTEGER NOT NULL,\n"
-                             "   entity_id   INTEGER NOT NULL,\n"
-                             "   entity_type INTEGER NOT NULL,\n"
-                             "   rotation    REAL NOT NULL,\n"
-                             "   pos_x       REAL NOT NULL,\n"
-                             "   pos_y       REAL NOT NULL,\n"
-                             "   scale_x     REAL NOT NULL,\n"
-                             "   scale_y     REAL NOT NULL,\n"
-                             "   material_sw_id INTEGER,\n"
-                             "   material_id INTEGER,\n"
-                             "   PRIMARY KEY (map_id, entity_id)\n"
-                             ");");
-            PBJ_LOG(pbj::VInfo) << "Created table 'sw_map_entities'." << PBJ_LOG_END;
-        }
+        // Tables and indexes are created (or upgraded, if the file is an
+        // existing sandwich) by applying each schema migration in turn.
+        int applied = pbj::sw::migrateSchema(*sw);
+        PBJ_LOG(pbj::VInfo) << "Sandwich schema is up to date." << PBJ_LOG_NL
+                            << "           Version: " << pbj::sw::getSchemaVersion(sw->getDb()) << PBJ_LOG_NL
+                            << "Migrations Applied: " << applied << PBJ_LOG_END;
     }
     catch (const pbj::db::Db::error& e)
     {
@@ -734,7 +606,7 @@ int texture(const std::string& texture, const std::string& filename, const char*
             //throw std::runtime_error("Could not load file!");
 
         pbj::db::Transaction transaction(sw->getDb());
-        pbj::db::Stmt update(sw->getDb(), "INSERT OR REPLACE INTO sw_textures (id, data, internal_format, srgb, mag_filter, min_filter) VALUES (?, ?, ?, ?, ?, ?);");
+        pbj::db::Stmt update(sw->getDb(), "INSERT OR REPLACE INTO sw_textures (id, data, internal_format, srgb, mag_filter, min_filter, content_hash) VALUES (?, ?, ?, ?, ?, ?, ?);");
       
         update.bind(1, tex_id.value());
         update.bindBlob(2, image_data.data(), image_data.size());
@@ -742,6 +614,7 @@ int texture(const std::string& texture, const std::string& filename, const char*
         update.bind(4, srgb ? 1 : 0);
         update.bind(5, filter);
         update.bind(6, filter);
+        update.bind(7, pbj::sw::hashContent(image_data.data(), image_data.size()));
         update.step();
 
         transaction.commit();
@@ -902,20 +775,17 @@ int textureFont(const std::string& font, const std::string& filename)
 
         pbj::db::Stmt insert_char(sw->getDb(), "INSERT INTO sw_texture_font_chars (font_id, codepoint, tc_x, tc_y, tc_width, tc_height, offset_x, offset_y, advance) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);");
         insert_char.bind(1, font_id.value());
-        for (auto i(chars.begin()), end(chars.end()); i != end; ++i)
-        {
-            const pbj::gfx::TextureFontCharacter& ch = *i;
-            insert_char.bind(2, ch.codepoint);
-            insert_char.bind(3, ch.texture_offset.x);
-            insert_char.bind(4, ch.texture_offset.y);
-            insert_char.bind(5, ch.texture_dimensions.x);
-            insert_char.bind(6, ch.texture_dimensions.y);
-            insert_char.bind(7, ch.character_offset.x);
-            insert_char.bind(8, ch.character_offset.y);
-            insert_char.bind(9, ch.character_advance);
-            insert_char.step();
-            insert_char.reset();
-        }
+        insert_char.executeMany(chars.begin(), chars.end(), [](pbj::db::Stmt& stmt, const pbj::gfx::TextureFontCharacter& ch)
+        {
+            stmt.bind(2, ch.codepoint);
+            stmt.bind(3, ch.texture_offset.x);
+            stmt.bind(4, ch.texture_offset.y);
+            stmt.bind(5, ch.texture_dimensions.x);
+            stmt.bind(6, ch.texture_dimensions.y);
+            stmt.bind(7, ch.character_offset.x);
+            stmt.bind(8, ch.character_offset.y);
+            stmt.bind(9, ch.character_advance);
+        });
 
         transaction.commit();
 
@@ -1031,10 +901,11 @@ int audio(const std::string& audio, const std::string& filename)
         }
 
         pbj::db::Transaction transaction(sw->getDb());
-        pbj::db::Stmt update(sw->getDb(), "INSERT OR REPLACE INTO sw_sounds (id, data) VALUES (?, ?);");
+        pbj::db::Stmt update(sw->getDb(), "INSERT OR REPLACE INTO sw_sounds (id, data, content_hash) VALUES (?, ?, ?);");
       
         update.bind(1, audio_id.value());
         update.bindBlob(2, audio_data.data(), audio_data.size());
+        update.bind(3, pbj::sw::hashContent(audio_data.data(), audio_data.size()));
         update.step();
 
         transaction.commit();